@@ -0,0 +1,142 @@
+/*!
+ \file   BERHistory.cpp
+ \brief  BER History - Multi-resolution store of ED readings for plotting long runs
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include "BERHistory.h"
+
+
+BERHistory::BERHistory()
+{
+    for (int level = 0; level < LEVEL_COUNT; level++) levels[level].ring.resize(LEVEL_CAPACITY);
+}
+
+
+/*!
+ \brief Clear the history (start of a new run)
+*/
+void BERHistory::clear()
+{
+    for (int level = 0; level < LEVEL_COUNT; level++)
+    {
+        levels[level].total = 0;
+        levels[level].partial = BERHistoryBucket_t();
+        levels[level].partialParts = 0;
+    }
+    sampleCount = 0;
+}
+
+
+/*!
+ \brief Add a sample (e.g. the error ratio from one ED count)
+ \param value  Sample value
+*/
+void BERHistory::addSample(const double value)
+{
+    BERHistoryBucket_t bucket;
+    bucket.min = value;
+    bucket.max = value;
+    bucket.mean = value;
+    bucket.count = 1;
+    sampleCount++;
+    addBucket(0, bucket);
+}
+
+
+/*!
+ \brief Find the finest level which shows the whole run in a number of buckets
+ \param bucketsMax  Maximum number of (complete) buckets wanted
+ \return Level (0 to LEVEL_COUNT - 1; the top level is returned if no level fits)
+*/
+int BERHistory::levelForBuckets(const int bucketsMax) const
+{
+    for (int level = 0; level < LEVEL_COUNT; level++)
+    {
+        if (levels[level].total <= bucketsMax && levels[level].total <= LEVEL_CAPACITY) return level;
+    }
+    return LEVEL_COUNT - 1;
+}
+
+
+/*!
+ \brief Get the number of samples in each bucket at a level
+*/
+qint64 BERHistory::getBucketWidth(const int level) const
+{
+    qint64 width = 1;
+    for (int i = 0; i < level; i++) width *= LEVEL_FACTOR;
+    return width;
+}
+
+
+/*!
+ \brief Get the number of complete buckets at a level since the start of the run
+ Buckets are numbered from 0; the newest complete bucket is (total - 1).
+*/
+qint64 BERHistory::getBucketTotal(const int level) const
+{
+    Q_ASSERT(level >= 0 && level < LEVEL_COUNT);
+    return levels[level].total;
+}
+
+
+/*!
+ \brief Get the number of the oldest bucket still held at a level
+*/
+qint64 BERHistory::getBucketFirst(const int level) const
+{
+    Q_ASSERT(level >= 0 && level < LEVEL_COUNT);
+    return qMax(Q_INT64_C(0), levels[level].total - LEVEL_CAPACITY);
+}
+
+
+/*!
+ \brief Get a bucket
+ \param level   Level
+ \param number  Bucket number (getBucketFirst to getBucketTotal - 1)
+ \param bucket  Pointer to a bucket, used to return the bucket
+ \return true   Bucket found
+ \return false  Bucket isn't complete yet, or has been overwritten
+*/
+bool BERHistory::getBucket(const int level, const qint64 number, BERHistoryBucket_t *bucket) const
+{
+    Q_ASSERT(level >= 0 && level < LEVEL_COUNT);
+    if (number < getBucketFirst(level) || number >= levels[level].total) return false;
+    *bucket = levels[level].ring[static_cast<int>(number % LEVEL_CAPACITY)];
+    return true;
+}
+
+
+/*!
+ \brief Add a complete bucket to a level, and add it to the level above
+*/
+void BERHistory::addBucket(const int level, const BERHistoryBucket_t &bucket)
+{
+    BERHistoryLevel_t &thisLevel = levels[level];
+    thisLevel.ring[static_cast<int>(thisLevel.total % LEVEL_CAPACITY)] = bucket;
+    thisLevel.total++;
+
+    if (level + 1 >= LEVEL_COUNT) return;
+    BERHistoryLevel_t &nextLevel = levels[level + 1];
+    BERHistoryBucket_t &partial = nextLevel.partial;
+    if (nextLevel.partialParts == 0)
+    {
+        partial = bucket;
+    }
+    else
+    {
+        const int count = partial.count + bucket.count;
+        partial.min = qMin(partial.min, bucket.min);
+        partial.max = qMax(partial.max, bucket.max);
+        partial.mean = ((partial.mean * partial.count) + (bucket.mean * bucket.count)) / count;
+        partial.count = count;
+    }
+    nextLevel.partialParts++;
+    if (nextLevel.partialParts == LEVEL_FACTOR)
+    {
+        nextLevel.partialParts = 0;
+        addBucket(level + 1, partial);
+    }
+}
@@ -0,0 +1,77 @@
+/*!
+ \file   BERHistory.h
+ \brief  BER History - Multi-resolution store of ED readings for plotting long runs
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#ifndef BERHISTORY_H
+#define BERHISTORY_H
+
+#include <QVector>
+#include <QtGlobal>
+
+/*!
+ \brief BER History Bucket
+ Summary of the samples in one time bucket
+*/
+typedef struct BERHistoryBucket_t
+{
+    double min   = 0.0;
+    double max   = 0.0;
+    double mean  = 0.0;
+    int    count = 0;      // Number of samples in the bucket
+} BERHistoryBucket_t;
+
+/*!
+ \brief BER History Class
+ Keeps the error ratio readings of an ED channel at several resolutions,
+ in a fixed amount of memory, so that a run of any length can be plotted
+ from a bounded number of points.
+
+ Level 0 holds the raw samples. Each level above holds buckets of
+ LEVEL_FACTOR buckets from the level below (min, max and mean), i.e.
+ level n buckets cover LEVEL_FACTOR^n samples. Each level is a ring of
+ LEVEL_CAPACITY buckets, so older buckets are overwritten at the fine
+ levels while the coarse levels still cover the whole run.
+
+ Buckets are numbered from the start of the run (0 = oldest); only
+ complete buckets can be read. Use levelForBuckets to find the finest
+ level which shows the whole run in a given number of buckets.
+*/
+class BERHistory
+{
+public:
+    BERHistory();
+
+    void clear();
+    void addSample(const double value);
+
+    qint64 getSampleCount() const { return sampleCount; }
+
+    int    levelForBuckets(const int bucketsMax) const;
+    qint64 getBucketWidth(const int level) const;
+    qint64 getBucketTotal(const int level) const;
+    qint64 getBucketFirst(const int level) const;
+    bool   getBucket(const int level, const qint64 number, BERHistoryBucket_t *bucket) const;
+
+    static const int LEVEL_COUNT    = 12;     // Resolution levels (top level bucket = 4^11 samples)
+    static const int LEVEL_FACTOR   = 4;      // Buckets from the level below in each bucket
+    static const int LEVEL_CAPACITY = 1024;   // Buckets kept per level
+
+private:
+    typedef struct BERHistoryLevel_t
+    {
+        QVector<BERHistoryBucket_t> ring;   // Complete buckets; oldest overwritten first
+        qint64 total = 0;                   // Complete buckets since start of run
+        BERHistoryBucket_t partial;         // Bucket being filled
+        int partialParts = 0;               // Buckets from the level below in partial
+    } BERHistoryLevel_t;
+
+    void addBucket(const int level, const BERHistoryBucket_t &bucket);
+
+    BERHistoryLevel_t levels[LEVEL_COUNT];
+    qint64 sampleCount = 0;
+};
+
+#endif // BERHISTORY_H
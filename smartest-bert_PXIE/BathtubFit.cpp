@@ -0,0 +1,213 @@
+/*!
+ \file   BathtubFit.cpp
+ \brief  Dual-Dirac Bathtub Fit - Extrapolates bathtub scan tails to a low error ratio
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include "globals.h"
+
+#include "BathtubFit.h"
+
+
+const double BathtubFit::DEFAULT_TARGET_RATIO = 1.0e-12;
+const double BathtubFit::TRANSITION_DENSITY   = 0.5;
+const double BathtubFit::FIT_RATIO_MAX        = 0.1;
+
+
+BathtubFit::BathtubFit()
+{ }
+
+
+/*!
+ \brief Fit the dual-Dirac model to a bathtub scan result
+ The centre of the bathtub is taken to be the middle of the points with
+ no errors (or the point with fewest errors, if every point has errors).
+ Points left of the centre make up the left tail, and points right of it
+ the right tail. Only points with errors and error ratio <= FIT_RATIO_MAX
+ are used.
+ Use isValid() to check whether the fit succeeded.
+ \param result     Bathtub scan result (one row)
+ \param targetRatio  Error ratio at which to estimate eye opening / TJ (see class description)
+*/
+BathtubFit::BathtubFit(const EyeScanResult &result, const double targetRatio)
+ : result(result), targetRatio(targetRatio)
+{
+    const int nX = result.getXRes();
+    if (result.isEmpty() || result.getYRes() != 1 || nX < (2 * FIT_POINTS_MIN)) return;
+    const quint32 *counts = result.getCounts().constData();
+
+    // Find centre of bathtub:
+    int zeroFirst = -1;
+    int zeroLast  = -1;
+    int minIndex  = 0;
+    for (int i = 0; i < nX; i++)
+    {
+        if (counts[i] == 0)
+        {
+            if (zeroFirst < 0) zeroFirst = i;
+            zeroLast = i;
+        }
+        if (counts[i] < counts[minIndex]) minIndex = i;
+    }
+    const int centre = (zeroFirst >= 0) ? ((zeroFirst + zeroLast) / 2) : minIndex;
+
+    double rSquaredL, rSquaredR;
+    if (!fitTail(true,  0,          centre, &muL, &sigmaL, &rSquaredL)) return;
+    if (!fitTail(false, centre + 1, nX,     &muR, &sigmaR, &rSquaredR)) return;
+
+    const double qT = berToQ(targetRatio);
+    rj = (sigmaL + sigmaR) / 2.0;
+    dj = std::max(0.0, 1.0 - (muR - muL));
+    opening = std::max(0.0, (muR - (qT * sigmaR)) - (muL + (qT * sigmaL)));
+    tj = 1.0 - opening;
+    confidence = std::min(rSquaredL, rSquaredR);
+    valid = true;
+}
+
+
+BathtubFit::~BathtubFit()
+{}
+
+
+/*!
+ \brief Get extrapolated bathtub curve
+ Returns log10(error ratio) for each point of the scan, in the same format as
+ EyeScanResult::normalised(): measured values where errors were seen, and
+ the fitted model where the measurement was below the detection limit.
+ Model values below the target ratio are set to globals::BELOW_DETECTION_LIMIT.
+ If the fit is not valid, the measured data are returned unchanged.
+*/
+QVector<double> BathtubFit::extrapolated() const
+{
+    QVector<double> data = result.normalised();
+    if (!valid) return data;
+    const int nX = result.getXRes();
+    const quint32 *counts = result.getCounts().constData();
+    for (int i = 0; i < nX; i++)
+    {
+        if (counts[i] > 0) continue;  // Measured
+        const double ber = modelBER(static_cast<double>(i) / static_cast<double>(nX));
+        if (ber < targetRatio) data[i] = globals::BELOW_DETECTION_LIMIT;
+        else                 data[i] = log10(ber);
+    }
+    return data;
+}
+
+
+/*!
+ \brief Convert BER to Q-scale
+ q = -InvNorm(BER / rho), using the rational approximation to the
+ inverse normal CDF by P. J. Acklam (relative error < 1.15e-9).
+ \param ber  Bit error rate (0 < ber < rho)
+ \return q
+*/
+double BathtubFit::berToQ(const double ber)
+{
+    static const double a[6] = { -3.969683028665376e+01,  2.209460984245205e+02, -2.759285104469687e+02,
+                                  1.383577518672690e+02, -3.066479806614716e+01,  2.506628277459239e+00 };
+    static const double b[5] = { -5.447609879822406e+01,  1.615858368580409e+02, -1.556989798598866e+02,
+                                  6.680131188771972e+01, -1.328068155288572e+01 };
+    static const double c[6] = { -7.784894002430293e-03, -3.223964580411365e-01, -2.400758277161838e+00,
+                                 -2.549732539343734e+00,  4.374664141464968e+00,  2.938163982698783e+00 };
+    static const double d[4] = {  7.784695709041462e-03,  3.224671290700398e-01,  2.445134137142996e+00,
+                                  3.754408661907416e+00 };
+    const double pLow = 0.02425;
+    double p = ber / TRANSITION_DENSITY;
+    if (p <= 0.0) p = 1.0e-300;
+    if (p >= 1.0) p = 1.0 - 1.0e-16;
+    double x;
+    if (p < pLow)
+    {
+        const double q = sqrt(-2.0 * log(p));
+        x = (((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+             ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    }
+    else if (p <= (1.0 - pLow))
+    {
+        const double q = p - 0.5;
+        const double r = q * q;
+        x = (((((a[0]*r + a[1])*r + a[2])*r + a[3])*r + a[4])*r + a[5]) * q /
+            (((((b[0]*r + b[1])*r + b[2])*r + b[3])*r + b[4])*r + 1.0);
+    }
+    else
+    {
+        const double q = sqrt(-2.0 * log(1.0 - p));
+        x = -(((((c[0]*q + c[1])*q + c[2])*q + c[3])*q + c[4])*q + c[5]) /
+              ((((d[0]*q + d[1])*q + d[2])*q + d[3])*q + 1.0);
+    }
+    return -x;
+}
+
+
+/*!
+ \brief Convert Q-scale to BER
+ \param q
+ \return BER = rho * 0.5 * erfc(q / sqrt(2))
+*/
+double BathtubFit::qToBER(const double q)
+{
+    return TRANSITION_DENSITY * 0.5 * std::erfc(q / sqrt(2.0));
+}
+
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+/*!
+ \brief Fit a straight line to one tail in Q-scale
+ \param leftTail  True for left tail (q increases with x), false for right tail
+ \param iStart    First point index to consider
+ \param iEnd      Index after last point to consider
+ \param mu        Returns Dirac position (UI)
+ \param sigma     Returns Gaussian sigma (UI)
+ \param rSquared  Returns R-squared of fit
+ \return true     Fit OK
+ \return false    Not enough points, or slope has wrong sign
+*/
+bool BathtubFit::fitTail(const bool leftTail, const int iStart, const int iEnd, double *mu, double *sigma, double *rSquared)
+{
+    const int nX = result.getXRes();
+    const double fullScale = result.getRowFullScale(0);   // Bathtub scan: One row
+    const quint32 *counts = result.getCounts().constData();
+    double sx = 0.0, sy = 0.0, sxx = 0.0, sxy = 0.0, syy = 0.0;
+    int n = 0;
+    for (int i = iStart; i < iEnd; i++)
+    {
+        if (counts[i] == 0) continue;
+        const double ber = static_cast<double>(counts[i]) / fullScale;   // Error ratio (see EyeScanResult)
+        if (ber > FIT_RATIO_MAX) continue;
+        const double x = static_cast<double>(i) / static_cast<double>(nX);
+        const double y = berToQ(ber);
+        sx += x;  sy += y;  sxx += x * x;  sxy += x * y;  syy += y * y;
+        n++;
+    }
+    if (n < FIT_POINTS_MIN) return false;
+    const double dn  = static_cast<double>(n);
+    const double sXX = sxx - (sx * sx / dn);
+    const double sXY = sxy - (sx * sy / dn);
+    const double sYY = syy - (sy * sy / dn);
+    if (sXX <= 0.0) return false;
+    const double slope = sXY / sXX;
+    const double intercept = (sy - (slope * sx)) / dn;
+    if ( leftTail && slope <= 0.0) return false;
+    if (!leftTail && slope >= 0.0) return false;
+    *mu       = -intercept / slope;     // q = 0 at x = mu
+    *sigma    = 1.0 / fabs(slope);
+    *rSquared = (sYY > 0.0) ? ((sXY * sXY) / (sXX * sYY)) : 1.0;
+    pointsUsed += n;
+    return true;
+}
+
+
+/*!
+ \brief Model BER at position x (UI), from both tails
+*/
+double BathtubFit::modelBER(const double x) const
+{
+    return qToBER((x - muL) / sigmaL) + qToBER((muR - x) / sigmaR);
+}
@@ -0,0 +1,94 @@
+/*!
+ \file   BathtubFit.h
+ \brief  Dual-Dirac Bathtub Fit - Extrapolates bathtub scan tails to a low error ratio
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+
+#ifndef BATHTUBFIT_H
+#define BATHTUBFIT_H
+
+#include <QVector>
+
+#include "EyeScanResult.h"
+
+/*!
+  \brief Bathtub Fit Class
+  Fits a dual-Dirac jitter model to the high error ratio tails of a
+  bathtub scan, so the eye opening at a low target error ratio (e.g.
+  1e-12) can be estimated from a short scan instead of measuring down
+  to that ratio.
+
+  Units: The "error ratio" is the scan's count / full scale count (see
+  EyeScanResult): an error ratio relative to the eye monitor dwell, NOT
+  a true BER (the dwell in bits isn't known). So the target, opening and
+  TJ are at an error ratio on the same scale as the bathtub plot, and
+  are not the opening / TJ at a BER of 1e-12.
+
+  For each tail, the measured error ratio is converted to a Q-scale value:
+      ratio = rho * Q(q)  (Q = Gaussian tail function; rho = transition density)
+  In Q-scale, a Gaussian tail is a straight line:
+      Left tail:   q(x) = (x - muL) / sigmaL
+      Right tail:  q(x) = (muR - x) / sigmaR
+  A least-squares line fit to each tail gives mu (the Dirac position) and
+  sigma (the random jitter). Positions are in UI (0 to 1 across the scan).
+  From these:
+      RJ (rms)   = (sigmaL + sigmaR) / 2
+      DJ (dd)    = 1 - (muR - muL)
+      Opening    = (muR - qT * sigmaR) - (muL + qT * sigmaL)   (qT = Q-scale of target ratio)
+      TJ         = 1 - Opening
+  The fit confidence is the lower of the two tails' R-squared values.
+*/
+class BathtubFit
+{
+public:
+
+    BathtubFit();
+    explicit BathtubFit(const EyeScanResult &result, const double targetRatio = DEFAULT_TARGET_RATIO);
+    ~BathtubFit();
+
+    bool   isValid()       const { return valid;        }
+    double getTargetRatio() const { return targetRatio; }
+    double getOpening()    const { return opening;      }  // Eye opening at target error ratio (UI)
+    double getRJ()         const { return rj;           }  // Random jitter (UI rms)
+    double getDJ()         const { return dj;           }  // Deterministic jitter, dual-Dirac (UI)
+    double getTJ()         const { return tj;           }  // Total jitter at target error ratio (UI)
+    double getConfidence() const { return confidence;   }  // Min R-squared of tail fits (0 to 1)
+    int    getPointsUsed() const { return pointsUsed;   }  // Number of measured points used in fit
+
+    QVector<double> extrapolated() const;
+
+    static double berToQ(const double ber);
+    static double qToBER(const double q);
+
+    static const double DEFAULT_TARGET_RATIO; // Target error ratio for eye opening / TJ (see class description)
+    static const double TRANSITION_DENSITY;   // rho: Fraction of bits which are transitions
+    static const double FIT_RATIO_MAX;        // Highest error ratio used in the fit (higher values are not Gaussian)
+    static const int    FIT_POINTS_MIN = 3;   // Minimum points per tail for a valid fit
+
+private:
+
+    bool fitTail(const bool leftTail, const int iStart, const int iEnd, double *mu, double *sigma, double *rSquared);
+
+    double modelBER(const double x) const;
+
+    EyeScanResult result;
+
+    bool   valid      = false;
+    double targetRatio = DEFAULT_TARGET_RATIO;
+    double muL        = 0.0;
+    double sigmaL     = 0.0;
+    double muR        = 1.0;
+    double sigmaR     = 0.0;
+    double opening    = 0.0;
+    double rj         = 0.0;
+    double dj         = 0.0;
+    double tj         = 0.0;
+    double confidence = 0.0;
+    int    pointsUsed = 0;
+
+};
+
+
+#endif // BATHTUBFIT_H
@@ -8,6 +8,7 @@
 #include "widgets/BertUICDRChannel.h"
 
 #include "BertModel.h"
+#include "BERHistory.h"
 
 /*!
  \brief Bert Channel class
@@ -51,6 +52,11 @@ public:
     bool edErrorflasherOn = false;
     bool edOptionsChanged = false;
 
+    // ED BER plot history (see BertWindow::edPlotAddPoint):
+    BERHistory edHistory;
+    int    edPlotLevel = 0;       // History level shown on the plot
+    qint64 edPlotBuckets = 0;     // Buckets at edPlotLevel already on the plot
+
     // Lane to channel conversions:
     static int laneToChannel(int lane)    { if (!BertModel::UseFourChanPGMode()) return (lane / 2) + 1; else return lane + 1; }  // Horrible and hacky! Improve...
     static int laneToCore(int lane)       { return lane / 4;       }
@@ -11,8 +11,128 @@
 #include "BertComponent.h"
 
 BertComponent::BertComponent()
-{ }
+  : uiFlushTimer(this)
+{
+    // UI updates made while handling one event are sent together, when
+    // the worker thread's event loop next runs (see uiQueue):
+    uiFlushTimer.setSingleShot(true);
+    uiFlushTimer.setInterval(0);
+    connect(&uiFlushTimer, SIGNAL(timeout()), this, SLOT(uiFlush()));
+}
 
 BertComponent::~BertComponent()
 { }
 
+
+/*!
+ \brief Get the name of a UI item
+ \param item  UI item (UI_xxx)
+ \return Item name (as used for the UI widget, e.g. "listPGPattern"), or "" if the item isn't valid
+*/
+QString BertComponent::uiItemName(int item)
+{
+    static const char *names[UI_ITEM_COUNT] =
+    {
+        "MacroVersion",
+        "CoreTemperature",
+        "boolPGLaneOn",
+        "boolPGInverted",
+        "boolEDPatternInvert",
+        "boolEDEnable",
+        "listPGPattern",
+        "listPGAmplitude",
+        "listPGDeemphLevel",
+        "listPGDeemphCursor",
+        "listPGCrossPoint",
+        "listPGCDRBypass",
+        "listEDPattern",
+        "listEDEQBoost"
+    };
+    if (item < 0 || item >= UI_ITEM_COUNT) return QString("");
+    return QString(names[item]);
+}
+
+
+/*!
+ \brief Get the type of a UI item
+ \param item  UI item (UI_xxx)
+ \return UI_TYPE_STRING, UI_TYPE_BOOLEAN or UI_TYPE_SELECT
+*/
+int BertComponent::uiItemType(int item)
+{
+    if (item == UI_MACRO_VERSION || item == UI_CORE_TEMPERATURE) return UI_TYPE_STRING;
+    if (item >= UI_PG_LANE_ON && item <= UI_ED_ENABLE)             return UI_TYPE_BOOLEAN;
+    return UI_TYPE_SELECT;
+}
+
+
+/*!
+ \brief Update a list (select) UI item
+ \param item   UI item (UI_xxx; must be a select item)
+ \param lane   Lane
+ \param index  Index of item to select
+*/
+void BertComponent::uiSelect(int item, int lane, int index)
+{
+    uiQueue({ item, lane, index, QString() });
+}
+
+
+/*!
+ \brief Update a boolean (check box) UI item
+ \param item   UI item (UI_xxx; must be a boolean item)
+ \param lane   Lane
+ \param value  New value
+*/
+void BertComponent::uiBoolean(int item, int lane, bool value)
+{
+    uiQueue({ item, lane, (value ? 1 : 0), QString() });
+}
+
+
+/*!
+ \brief Update a string (label) UI item
+ \param item   UI item (UI_xxx; must be a string item)
+ \param lane   Lane
+ \param text   New text
+ \param value  Numeric value, if any (e.g. temperature in degrees), for clients which don't want to parse the text
+*/
+void BertComponent::uiString(int item, int lane, const QString &text, int value)
+{
+    uiQueue({ item, lane, value, text });
+}
+
+
+/*!
+ \brief Queue a UI update
+ Updates are held until the current event has been handled, then sent
+ to clients in one UIUpdate signal (see uiFlush). If the same item and
+ lane is updated more than once in the meantime, only the last value
+ is sent.
+*/
+void BertComponent::uiQueue(const BertUIUpdate_t &update)
+{
+    for (BertUIUpdate_t &pending : uiPending)
+    {
+        if (pending.item == update.item && pending.lane == update.lane)
+        {
+            pending = update;
+            return;
+        }
+    }
+    uiPending.append(update);
+    if (!uiFlushTimer.isActive()) uiFlushTimer.start();
+}
+
+
+/*!
+ \brief Send queued UI updates
+*/
+void BertComponent::uiFlush()
+{
+    if (uiPending.isEmpty()) return;
+    QList<BertUIUpdate_t> updates;
+    updates.swap(uiPending);
+    emit UIUpdate(updates);
+}
+
@@ -4,9 +4,25 @@
 #include <QObject>
 #include <QString>
 #include <QStringList>
+#include <QList>
+#include <QTimer>
 
 #include "globals.h"
 
+/*!
+ \brief UI Update
+ One update for a UI item, as sent in a UIUpdate batch. Items are
+ identified by BertComponent::UIItem and lane, so the client can resolve
+ each target widget once and keep it, instead of looking it up by name.
+*/
+typedef struct BertUIUpdate_t
+{
+    int     item;    // BertComponent::UIItem
+    int     lane;    // Lane, or globals::ALL_LANES
+    int     value;   // List index (select), 0 / 1 (boolean), or numeric value of a string (e.g. degrees)
+    QString text;    // Text (string items only)
+} BertUIUpdate_t;
+
 class BertComponent : public QObject
 {
     Q_OBJECT
@@ -14,25 +30,51 @@ public:
     BertComponent();
     ~BertComponent();
 
+    // UI items updated by components (see UIUpdate):
+    enum UIItem
+    {
+        UI_MACRO_VERSION,        // String:  "MacroVersion"
+        UI_CORE_TEMPERATURE,     // String:  "CoreTemperature" (value: degrees C)
+        UI_PG_LANE_ON,           // Boolean: "boolPGLaneOn"
+        UI_PG_INVERTED,          // Boolean: "boolPGInverted"
+        UI_ED_PATTERN_INVERT,    // Boolean: "boolEDPatternInvert"
+        UI_ED_ENABLE,            // Boolean: "boolEDEnable"
+        UI_PG_PATTERN,           // Select:  "listPGPattern"
+        UI_PG_AMPLITUDE,         // Select:  "listPGAmplitude"
+        UI_PG_DEEMPH_LEVEL,      // Select:  "listPGDeemphLevel"
+        UI_PG_DEEMPH_CURSOR,     // Select:  "listPGDeemphCursor"
+        UI_PG_CROSS_POINT,       // Select:  "listPGCrossPoint"
+        UI_PG_CDR_BYPASS,        // Select:  "listPGCDRBypass"
+        UI_ED_PATTERN,           // Select:  "listEDPattern"
+        UI_ED_EQ_BOOST,          // Select:  "listEDEQBoost"
+        UI_ITEM_COUNT
+    };
+
+    enum UIItemType
+    {
+        UI_TYPE_STRING,          // QLabel: Set text
+        UI_TYPE_BOOLEAN,         // QCheckBox: Set checked
+        UI_TYPE_SELECT           // QComboBox: Set current index
+    };
+
+    static QString uiItemName(int item);
+    static int     uiItemType(int item);
+
    // These are general signals, not specific to a hardware component
 
 #define BERT_COMPONENT_SIGNALS \
     void Result(int result, int lane);                                               \
     void ListPopulate(QString name, int lane, QStringList items, int defaultIndex);  \
-    void ListSelect(QString name, int lane, int index);                              \
-    void UpdateBoolean(QString name, int lane, bool value);                          \
     void SetPGLedStatus(int lane, bool laneOn);                                      \
-    void UpdateString(QString name, int lane, QString value);                        \
+    void UIUpdate(QList<BertUIUpdate_t> updates);                                    \
     void ShowMessage(QString message, bool append = false);
 
 
 #define BERT_COMPONENT_CONNECT_SIGNALS(CLIENT, COMPONENT) \
     connect(COMPONENT, SIGNAL(Result(int, int)),                             CLIENT, SLOT(Result(int, int)));                             \
     connect(COMPONENT, SIGNAL(ListPopulate(QString, int, QStringList, int)), CLIENT, SLOT(ListPopulate(QString, int, QStringList, int))); \
-    connect(COMPONENT, SIGNAL(ListSelect(QString, int, int)),                CLIENT, SLOT(ListSelect(QString, int, int)));                \
-    connect(COMPONENT, SIGNAL(UpdateBoolean(QString, int, bool)),            CLIENT, SLOT(UpdateBoolean(QString, int, bool)));            \
     connect(COMPONENT, SIGNAL(SetPGLedStatus(int, bool)),                    CLIENT, SLOT(SetPGLedStatus(int, bool)));                    \
-    connect(COMPONENT, SIGNAL(UpdateString(QString, int, QString)),          CLIENT, SLOT(UpdateString(QString, int, QString)));          \
+    connect(COMPONENT, SIGNAL(UIUpdate(QList<BertUIUpdate_t>)),              CLIENT, SLOT(UIUpdate(QList<BertUIUpdate_t>)));              \
     connect(COMPONENT, SIGNAL(ShowMessage(QString, bool)),                   CLIENT, SLOT(ShowMessage(QString, bool)));
 
 
@@ -41,7 +83,19 @@ signals:
 
 public slots:
 
+protected:
+    void uiSelect(int item, int lane, int index);
+    void uiBoolean(int item, int lane, bool value);
+    void uiString(int item, int lane, const QString &text, int value = 0);
+
+private slots:
+    void uiFlush();
+
+private:
+    void uiQueue(const BertUIUpdate_t &update);
 
+    QList<BertUIUpdate_t> uiPending;   // Updates not sent yet (one per item and lane)
+    QTimer uiFlushTimer;
 };
 
 #endif // BERTCOMPONENT_H
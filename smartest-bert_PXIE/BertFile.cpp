@@ -8,7 +8,11 @@
 #include <QDebug>
 #include <QFile>
 #include <QDir>
+#include <QFileInfo>
 #include <QDateTime>
+#include <QDataStream>
+#include <QTextStream>
+#include <string.h>
 
 #include "globals.h"
 #include "BertFile.h"
@@ -112,3 +116,341 @@ void BertFile::debug(const QString &msg)
 }
 
 
+/*!
+ \brief Convert a binary ED log (see BertEDLog) to a CSV text file
+ \param logFileName  Binary ED log file to read
+ \param csvFileName  CSV file to write (overwritten if it exists)
+ \param recordCount  Optional: Used to return number of records exported
+ \return globals::OK
+ \return globals::FILE_ERROR    Couldn't open or write a file
+ \return globals::INVALID_DATA  Log file header not recognised
+*/
+int BertFile::exportEDLog(const QString &logFileName, const QString &csvFileName, quint64 *recordCount)
+{
+    if (recordCount) *recordCount = 0;
+
+    QFile logFile(logFileName);
+    if (!logFile.open(QIODevice::ReadOnly)) return globals::FILE_ERROR;
+    QDataStream in(&logFile);
+    in.setByteOrder(QDataStream::LittleEndian);
+    in.setFloatingPointPrecision(QDataStream::DoublePrecision);
+
+    char magic[8];
+    quint16 version, recordSize;
+    quint32 reserved;
+    qint64 created;
+    if (in.readRawData(magic, 8) != 8 || memcmp(magic, "BERTEDLG", 8) != 0) return globals::INVALID_DATA;
+    in >> version >> recordSize >> reserved >> created;
+    if (in.status() != QDataStream::Ok
+     || version != BertEDLog::EDLOG_VERSION
+     || recordSize != BertEDLog::EDLOG_RECORD_SIZE) return globals::INVALID_DATA;
+
+    QFile csvFile(csvFileName);
+    if (!csvFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return globals::FILE_ERROR;
+    QTextStream out(&csvFile);
+    out << "# ED Log: " << logFileName << "\n";
+    out << "# Created: " << QDateTime::fromMSecsSinceEpoch(created).toString("yyyy-MM-dd hh:mm:ss") << "\n";
+    out << "Timestamp,Time (s),Lane,Locked,LOS,LOL,Core Temp (C),Bits,Bits Total,Errors,Errors Total\n";
+    out.setRealNumberNotation(QTextStream::SmartNotation);
+    out.setRealNumberPrecision(15);
+
+    EDLogRecord_t record;
+    quint64 count = 0;
+    // Nb: A partial record at the end of the file (e.g. log not closed cleanly) is ignored.
+    while (logFile.bytesAvailable() >= BertEDLog::EDLOG_RECORD_SIZE)
+    {
+        in >> record.timestamp >> record.lane >> record.flags >> record.coreTemp
+           >> record.bits >> record.bitsTotal >> record.errors >> record.errorsTotal;
+        if (in.status() != QDataStream::Ok) break;
+        out << QDateTime::fromMSecsSinceEpoch(record.timestamp).toString("yyyy-MM-dd hh:mm:ss.zzz") << ","
+            << (static_cast<double>(record.timestamp - created) / 1000.0) << ","
+            << record.lane << ","
+            << ((record.flags & BertEDLog::EDLOG_FLAG_LOCKED) ? 1 : 0) << ","
+            << ((record.flags & BertEDLog::EDLOG_FLAG_LOS) ? 1 : 0) << ","
+            << ((record.flags & BertEDLog::EDLOG_FLAG_LOL) ? 1 : 0) << ",";
+        if (record.flags & BertEDLog::EDLOG_FLAG_TEMP_VALID) out << record.coreTemp;
+        out << "," << record.bits << "," << record.bitsTotal
+            << "," << record.errors << "," << record.errorsTotal << "\n";
+        count++;
+    }
+    out.flush();
+    csvFile.close();
+    logFile.close();
+    if (recordCount) *recordCount = count;
+    qDebug() << "BertFile: Exported " << count << " ED log records from " << logFileName << " to " << csvFileName;
+    return (out.status() == QTextStream::Ok) ? globals::OK : globals::FILE_ERROR;
+}
+
+
+
+
+/*!
+ \brief Get the frequency profile cache file name for an EEPROM
+ Cache files are kept in "ProfileCache" under the application directory,
+ one per EEPROM serial number.
+ \param eepromSerial  Serial number string read from the EEPROM
+ \return File name (path); Empty if the serial number is empty
+*/
+QString BertFile::profileCacheFileName(const QString &eepromSerial)
+{
+    QString safeSerial;
+    foreach (QChar ch, eepromSerial.trimmed())
+    {
+        safeSerial.append(ch.isLetterOrNumber() ? ch : QChar('_'));
+    }
+    if (safeSerial.isEmpty()) return QString();
+    QDir cacheDir(QDir(globals::getAppPath()).absoluteFilePath("ProfileCache"));
+    return cacheDir.absoluteFilePath(QString("Profiles_%1.bin").arg(safeSerial));
+}
+
+
+/*!
+ \brief Read frequency profiles from a profile cache file
+ The file is memory-mapped where possible (otherwise read in one go) and
+ parsed from memory. Layout (little endian):
+   Header:   "BERTPRFC", version (u16), profile count (u16),
+             synth config version (QString)
+   Profile:  frequency (f32 bits as u32), checksum (u16), register count (u16),
+             register values (u16 x register count)
+ The checksum is the one stored with the profile in the EEPROM (see
+ M24M02::loadFrequencyProfile); the caller uses it to validate the cache.
+ \param fileName            Cache file (see profileCacheFileName)
+ \param synthConfigVersion  Set to synth config version string stored in the cache
+ \param profiles            Set to the cached profiles (marked valid)
+ \param checksums           Set to the EEPROM checksum for each profile
+ \return globals::OK
+ \return globals::FILE_ERROR    File not found / couldn't be read
+ \return globals::INVALID_DATA  File header or data not recognised
+*/
+int BertFile::readProfileCache(const QString &fileName,
+                               QString &synthConfigVersion,
+                               QList<LMXFrequencyProfile> &profiles,
+                               QList<quint16> &checksums)
+{
+    profiles.clear();
+    checksums.clear();
+
+    QFile cacheFile(fileName);
+    if (!cacheFile.open(QIODevice::ReadOnly)) return globals::FILE_ERROR;
+    QByteArray fileData;
+    const uchar *mapped = cacheFile.map(0, cacheFile.size());
+    if (mapped) fileData = QByteArray::fromRawData(reinterpret_cast<const char *>(mapped), static_cast<int>(cacheFile.size()));
+    else        fileData = cacheFile.readAll();
+
+    QDataStream in(fileData);
+    in.setByteOrder(QDataStream::LittleEndian);
+
+    int result = globals::OK;
+    char magic[8];
+    quint16 version = 0, profileCount = 0;
+    if (in.readRawData(magic, 8) != 8 || memcmp(magic, "BERTPRFC", 8) != 0) result = globals::INVALID_DATA;
+    if (result == globals::OK)
+    {
+        in >> version >> profileCount >> synthConfigVersion;
+        if (in.status() != QDataStream::Ok || version != PROFILE_CACHE_VERSION) result = globals::INVALID_DATA;
+    }
+    for (int index = 0; result == globals::OK && index < profileCount; index++)
+    {
+        quint32 frequencyBits;
+        quint16 checksum, registerCount, value;
+        in >> frequencyBits >> checksum >> registerCount;
+        if (in.status() != QDataStream::Ok || registerCount > LMXFrequencyProfile::MAX_REGISTER_COUNT)
+        {
+            result = globals::INVALID_DATA;
+            break;
+        }
+        float frequency;
+        memcpy(&frequency, &frequencyBits, 4);
+        LMXFrequencyProfile profile(registerCount);
+        profile.setFrequency(frequency);
+        for (int address = 0; address < registerCount; address++)
+        {
+            in >> value;
+            profile.setRegisterValue(static_cast<uint8_t>(address), value);
+        }
+        if (in.status() != QDataStream::Ok)
+        {
+            result = globals::INVALID_DATA;
+            break;
+        }
+        profile.setValid();
+        profiles.append(profile);
+        checksums.append(checksum);
+    }
+
+    if (mapped) cacheFile.unmap(const_cast<uchar *>(mapped));
+    cacheFile.close();
+    if (result != globals::OK)
+    {
+        profiles.clear();
+        checksums.clear();
+    }
+    return result;
+}
+
+
+/*!
+ \brief Write frequency profiles to a profile cache file
+ See readProfileCache for the file layout. The cache directory is created if needed.
+ \param fileName            Cache file (see profileCacheFileName); Overwritten if it exists
+ \param synthConfigVersion  Synth config version string read from the EEPROM
+ \param profiles            Profiles to cache
+ \param checksums           EEPROM checksum for each profile (same order as profiles)
+ \return globals::OK
+ \return globals::FILE_ERROR  Couldn't write the file
+*/
+int BertFile::writeProfileCache(const QString &fileName,
+                                const QString &synthConfigVersion,
+                                const QList<LMXFrequencyProfile> &profiles,
+                                const QList<quint16> &checksums)
+{
+    Q_ASSERT(profiles.count() == checksums.count());
+    if (profiles.count() != checksums.count()) return globals::INVALID_DATA;
+    QDir().mkpath(QFileInfo(fileName).absolutePath());
+
+    QByteArray fileData;
+    QDataStream out(&fileData, QIODevice::WriteOnly);
+    out.setByteOrder(QDataStream::LittleEndian);
+    out.writeRawData("BERTPRFC", 8);
+    out << PROFILE_CACHE_VERSION << static_cast<quint16>(profiles.count()) << synthConfigVersion;
+    for (int index = 0; index < profiles.count(); index++)
+    {
+        const LMXFrequencyProfile &profile = profiles.at(index);
+        float frequency = profile.getFrequency();
+        quint32 frequencyBits;
+        memcpy(&frequencyBits, &frequency, 4);
+        out << frequencyBits << checksums.at(index) << static_cast<quint16>(profile.getRegisterCount());
+        for (int address = 0; address < profile.getRegisterCount(); address++)
+        {
+            out << profile.getRegisterValue(static_cast<uint8_t>(address), nullptr);
+        }
+    }
+
+    QFile cacheFile(fileName);
+    if (!cacheFile.open(QIODevice::WriteOnly | QIODevice::Truncate)) return globals::FILE_ERROR;
+    const qint64 written = cacheFile.write(fileData);
+    cacheFile.close();
+    if (written != fileData.size())
+    {
+        cacheFile.remove();
+        return globals::FILE_ERROR;
+    }
+    qDebug() << "BertFile: Wrote " << profiles.count() << " profiles to cache " << fileName;
+    return globals::OK;
+}
+
+
+
+
+/************* BertEDLog: ED Measurement Log Writer ***************************/
+
+BertEDLog::BertEDLog()
+{}
+
+BertEDLog::~BertEDLog()
+{
+    close();
+}
+
+
+/*!
+ \brief Create a new log file and write the file header
+ Any log which is already open is closed first.
+ \param fileName  Log file to create (overwritten if it exists)
+ \return globals::OK
+ \return globals::FILE_ERROR  Couldn't create the file
+*/
+int BertEDLog::open(const QString &fileName)
+{
+    close();
+    buffer.clear();
+    recordCount = 0;
+    logFile.setFileName(fileName);
+    if (!logFile.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        qDebug() << "BertEDLog: ERROR creating log file " << fileName;
+        return globals::FILE_ERROR;
+    }
+    buffer.reserve(EDLOG_BUFFER_MAX + EDLOG_RECORD_SIZE);
+    QDataStream header(&buffer, QIODevice::WriteOnly);
+    header.setByteOrder(QDataStream::LittleEndian);
+    header.writeRawData("BERTEDLG", 8);
+    header << EDLOG_VERSION << EDLOG_RECORD_SIZE << static_cast<quint32>(0)
+           << static_cast<qint64>(QDateTime::currentMSecsSinceEpoch());
+    Q_ASSERT(buffer.size() == EDLOG_HEADER_SIZE);
+    qDebug() << "BertEDLog: Logging to " << fileName;
+    return flush(true);
+}
+
+
+/*!
+ \brief Write any buffered records and close the log file
+*/
+void BertEDLog::close()
+{
+    if (!logFile.isOpen()) return;
+    flush(true);
+    logFile.close();
+    qDebug() << "BertEDLog: Closed " << logFile.fileName() << "; " << recordCount << " records.";
+}
+
+
+/*!
+ \brief Add a record to the log
+ The record is buffered; buffered data is written to disk if the buffer is full.
+ \return globals::OK
+ \return globals::NOT_INITIALISED  Log not open
+ \return globals::FILE_ERROR       Error writing to file
+*/
+int BertEDLog::append(const EDLogRecord_t &record)
+{
+    if (!logFile.isOpen()) return globals::NOT_INITIALISED;
+    QDataStream stream(&buffer, QIODevice::Append);
+    stream.setByteOrder(QDataStream::LittleEndian);
+    stream.setFloatingPointPrecision(QDataStream::DoublePrecision);
+    stream << record.timestamp << record.lane << record.flags << record.coreTemp
+           << record.bits << record.bitsTotal << record.errors << record.errorsTotal;
+    recordCount++;
+    if (buffer.size() >= EDLOG_BUFFER_MAX) return flush(true);
+    return globals::OK;
+}
+
+
+/*!
+ \brief Write buffered records to disk
+ \param force  If false, data is only written if EDLOG_FLUSH_INTERVAL
+               has passed since the last write; otherwise write now.
+ \return globals::OK
+ \return globals::FILE_ERROR  Error writing to file
+*/
+int BertEDLog::flush(bool force)
+{
+    if (!logFile.isOpen()) return globals::OK;
+    if (!force && lastFlush.isValid() && lastFlush.elapsed() < EDLOG_FLUSH_INTERVAL) return globals::OK;
+    lastFlush.start();
+    if (buffer.isEmpty()) return globals::OK;
+    const qint64 written = logFile.write(buffer);
+    buffer.resize(0);  // Nb: Keeps reserved capacity
+    if (written < 0 || !logFile.flush())
+    {
+        qDebug() << "BertEDLog: ERROR writing to log file " << logFile.fileName();
+        return globals::FILE_ERROR;
+    }
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Create an ED log export thread (see BertEDLogExport); call start() to run it
+ \param logFileName  Binary ED log file to read
+ \param csvFileName  CSV file to write
+*/
+BertEDLogExport::BertEDLogExport(const QString &logFileName, const QString &csvFileName, QObject *parent)
+ : QThread(parent), logFileName(logFileName), csvFileName(csvFileName)
+{}
+
+void BertEDLogExport::run()
+{
+    result = BertFile::exportEDLog(logFileName, csvFileName, &recordCount);
+}
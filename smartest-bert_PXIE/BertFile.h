@@ -11,6 +11,13 @@
 #include <QString>
 #include <QStringList>
 #include <QFile>
+#include <QByteArray>
+#include <QElapsedTimer>
+#include <QList>
+#include <QThread>
+
+#include "globals.h"
+#include "LMXFrequencyProfile.h"
 
 /*!
  \brief BERT File System Helper Class
@@ -19,6 +26,8 @@
   - Reading directory contents
   - Opening a file
   - Reading file contents
+  - Converting a binary ED measurement log to text (see BertEDLog)
+  - Reading and writing the frequency profile cache (see readProfileCache)
 */
 class BertFile
 {
@@ -32,9 +41,117 @@ public:
 
     static void debug(const QString &msg);
 
+    static int exportEDLog(const QString &logFileName, const QString &csvFileName, quint64 *recordCount = NULL);
+
+    static const quint16 PROFILE_CACHE_VERSION = 1;
+
+    static QString profileCacheFileName(const QString &eepromSerial);
+    static int readProfileCache(const QString &fileName,
+                                QString &synthConfigVersion,
+                                QList<LMXFrequencyProfile> &profiles,
+                                QList<quint16> &checksums);
+    static int writeProfileCache(const QString &fileName,
+                                 const QString &synthConfigVersion,
+                                 const QList<LMXFrequencyProfile> &profiles,
+                                 const QList<quint16> &checksums);
+
 private:
     static QFile debugFile;
 
 };
 
+
+/*!
+ \brief One ED measurement sample, as stored in an ED log file
+*/
+typedef struct EDLogRecord_t
+{
+    qint64 timestamp;     // Time of reading (ms since epoch; see GT1724::GetEDCountSnapshot)
+    qint32 lane;          // ED input lane (1 / 3 / 5 / 7 / etc)
+    quint16 flags;        // EDLOG_FLAG_xxx (see BertEDLog)
+    qint16 coreTemp;      // Last core temperature read from the GT1724 (deg C) if EDLOG_FLAG_TEMP_VALID is set
+    double bits;          // Bits since last reading
+    double bitsTotal;     // Bits since ED started
+    double errors;        // Errors since last reading
+    double errorsTotal;   // Errors since ED started
+} EDLogRecord_t;
+
+
+/*!
+ \brief ED Measurement Log Writer
+ Appends ED samples to a binary log file, for long (soak) tests.
+ Records are fixed size and little endian, after a short file header:
+   Header:  "BERTEDLG", version (u16), record size (u16), reserved (u32),
+            created (s64, ms since epoch)
+   Record:  timestamp (s64), lane (s32), flags (u16), core temp (s16),
+            bits, bits total, errors, errors total (4 x f64)
+ Records are buffered in memory and written to disk when the buffer
+ fills, or by flush (call periodically; only writes if the flush
+ interval has passed). Use BertFile::exportEDLog to convert to CSV.
+ Nb: Not thread safe; use from one thread only (e.g. BertPoller).
+*/
+class BertEDLog
+{
+public:
+    BertEDLog();
+    ~BertEDLog();
+
+    static const quint16 EDLOG_VERSION = 1;
+    static const quint16 EDLOG_RECORD_SIZE = 48;   // Bytes per record on disk
+    static const int     EDLOG_HEADER_SIZE = 24;   // Bytes in file header
+
+    static const quint16 EDLOG_FLAG_LOCKED     = 0x0001;  // ED was locked (counts valid)
+    static const quint16 EDLOG_FLAG_LOS        = 0x0002;  // Last LOS status read for this lane
+    static const quint16 EDLOG_FLAG_LOL        = 0x0004;  // Last LOL status read for this lane
+    static const quint16 EDLOG_FLAG_TEMP_VALID = 0x0008;  // coreTemp is valid
+
+    static const int EDLOG_BUFFER_MAX = 65536;      // Write to disk when this many bytes are buffered
+    static const int EDLOG_FLUSH_INTERVAL = 1000;   // Max time data is buffered before writing (ms)
+
+    int  open(const QString &fileName);
+    void close();
+    bool isOpen() const { return logFile.isOpen(); }
+
+    int  append(const EDLogRecord_t &record);
+    int  flush(bool force = false);
+
+    QString getFileName() const     { return logFile.fileName(); }
+    quint64 getRecordCount() const  { return recordCount; }
+
+private:
+    QFile logFile;
+    QByteArray buffer;
+    QElapsedTimer lastFlush;
+    quint64 recordCount = 0;
+};
+
+
+/*!
+ \brief ED Measurement Log Export Thread
+ Runs BertFile::exportEDLog on its own (low priority) thread, so that a
+ long log can be converted without holding up the caller, e.g. the status
+ poller, which shares the worker thread with the I2C components. When the
+ QThread finished() signal is emitted, the results can be read with
+ getResult, etc. Nb: Wait for the thread (wait()) before deleting it.
+*/
+class BertEDLogExport : public QThread
+{
+    Q_OBJECT
+
+public:
+    BertEDLogExport(const QString &logFileName, const QString &csvFileName, QObject *parent = nullptr);
+
+    QString getCSVFileName() const { return csvFileName; }
+    int     getResult() const      { return result; }
+    quint64 getRecordCount() const { return recordCount; }
+
+private:
+    void run();
+
+    const QString logFileName;
+    const QString csvFileName;
+    int result = globals::OK;
+    quint64 recordCount = 0;
+};
+
 #endif // BERTFILE_H
@@ -0,0 +1,248 @@
+/*!
+ \file   BertHeadless.cpp
+ \brief  Headless (no GUI) automation client for the BERT back end
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <QCoreApplication>
+#include <QJsonDocument>
+#include <QDebug>
+#include <stdio.h>
+
+#include "globals.h"
+#include "BertHeadless.h"
+#include "BertLog.h"
+
+
+BertHeadless::BertHeadless(QObject *parent)
+ : QObject(parent), manager(this), delayTimer(this), out(stdout)
+{
+    globals::setAppPath(QCoreApplication::applicationDirPath());
+
+    delayTimer.setSingleShot(true);
+    connect(&delayTimer, SIGNAL(timeout()), this, SLOT(delayFinished()));
+    connect(&manager, SIGNAL(Output(QJsonObject)),      this, SLOT(managerOutput(QJsonObject)));
+    connect(&manager, SIGNAL(InstrumentIdle(int, int)), this, SLOT(instrumentIdle(int, int)));
+}
+
+BertHeadless::~BertHeadless()
+{
+    delayTimer.stop();
+}
+
+
+/*!
+ \brief Open the command script and start processing commands
+ \param scriptFileName  Script file; empty or "-" to read commands from stdin
+ \return globals::OK
+ \return globals::FILE_ERROR  Couldn't open script file
+*/
+int BertHeadless::start(const QString &scriptFileName)
+{
+    bool opened;
+    if (scriptFileName.isEmpty() || scriptFileName == "-")
+    {
+        opened = scriptFile.open(stdin, QIODevice::ReadOnly | QIODevice::Text);
+        readingStdin = true;
+    }
+    else
+    {
+        scriptFile.setFileName(scriptFileName);
+        opened = scriptFile.open(QIODevice::ReadOnly | QIODevice::Text);
+    }
+    if (!opened)
+    {
+        QJsonObject output;
+        output["cmd"] = "start";
+        output["result"] = globals::FILE_ERROR;
+        output["message"] = QString("Couldn't open script: %1").arg(scriptFileName);
+        writeJson(output);
+        return globals::FILE_ERROR;
+    }
+    script.setDevice(&scriptFile);
+    // Start once the event loop is running (workers need to be ready first):
+    QTimer::singleShot(0, this, SLOT(nextCommand()));
+    return globals::OK;
+}
+
+
+
+
+////////////// PRIVATE SLOTS: //////////////////////////////////////////////////////
+
+/*!
+ \brief Run commands from the script until one has to wait
+ Called at start, and whenever something which a command may be
+ waiting for has finished (delay, instrument idle).
+*/
+void BertHeadless::nextCommand()
+{
+    while (!finished && !quitPending && !delayRunning)
+    {
+        if (!commandPending && readingStdin && !manager.allIdle()) return;  // Don't block while instruments are busy
+        if (!commandPending && !readCommand())
+        {
+            // End of script: Finish when all instruments are done.
+            if (manager.allIdle()) finish(0);
+            return;
+        }
+
+        const QString name = command.at(0).toLower();
+        if (name == "sync")
+        {
+            if (!manager.allIdle()) return;   // Retry when an instrument is idle
+        }
+        else if (name == "wait")
+        {
+            bool ok = false;
+            int delay = (command.count() > 1) ? command.at(1).toInt(&ok) : 0;
+            if (!ok || delay < 0)
+            {
+                QJsonObject output;
+                output["cmd"] = name;
+                output["line"] = scriptLine;
+                output["result"] = globals::INVALID_DATA;
+                writeJson(output);
+                finish(1);
+                return;
+            }
+            delayRunning = true;
+            delayTimer.start(delay);
+        }
+        else if (name == "log")
+        {
+            QJsonObject output;
+            output["cmd"] = name;
+            output["line"] = scriptLine;
+            output["result"] = BertLog::configure(command.mid(1).join(','));
+            output["levels"] = BertLog::getLevels();
+            writeJson(output);
+            if (output["result"].toInt() != globals::OK)
+            {
+                finish(1);
+                return;
+            }
+        }
+        else if (name == "quit")
+        {
+            commandPending = false;
+            quitPending = true;
+            if (manager.allIdle()) finish(0);
+            return;
+        }
+        else
+        {
+            if (!manager.isIdle(commandInstrument)) return;   // Retry when this instrument is idle
+            instrumentLines[commandInstrument] = scriptLine;
+            int result = manager.runCommand(commandInstrument, command);
+            if (result != globals::OK)
+            {
+                QJsonObject output;
+                output["cmd"] = name;
+                output["instrument"] = commandInstrument;
+                output["line"] = scriptLine;
+                output["result"] = result;
+                writeJson(output);
+                finish(1);
+                return;
+            }
+        }
+        commandPending = false;
+    }
+}
+
+
+void BertHeadless::delayFinished()
+{
+    delayRunning = false;
+    nextCommand();
+}
+
+
+void BertHeadless::managerOutput(QJsonObject output)
+{
+    output["line"] = instrumentLines.value(output["instrument"].toInt(), scriptLine);
+    writeJson(output);
+}
+
+
+void BertHeadless::instrumentIdle(int instrument, int result)
+{
+    Q_UNUSED(instrument)
+    if (finished) return;
+    if (result != globals::OK)
+    {
+        finish(1);
+        return;
+    }
+    if (quitPending)
+    {
+        // "quit" read: Exit once all instruments are done.
+        if (manager.allIdle()) finish(0);
+        return;
+    }
+    // Nb: Queued, as the instrument may still be finishing up from its last command:
+    QTimer::singleShot(0, this, SLOT(nextCommand()));
+}
+
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+/*!
+ \brief Read the next command from the script
+ Sets command, commandInstrument and commandPending.
+ A bad "@<n>" prefix is reported (with the script line), and stops the script.
+ \return true   Command read
+ \return false  End of script, or bad instrument prefix
+*/
+bool BertHeadless::readCommand()
+{
+    while (!script.atEnd())
+    {
+        QString line = script.readLine().trimmed();
+        scriptLine++;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        command = line.split(' ', QString::SkipEmptyParts);
+        commandInstrument = 0;
+        if (command.at(0).startsWith('@'))
+        {
+            const QString prefix = command.takeFirst();
+            bool ok = false;
+            commandInstrument = prefix.mid(1).toInt(&ok);
+            if (!ok || commandInstrument < 0)
+            {
+                QJsonObject output;
+                output["cmd"] = prefix;
+                output["line"] = scriptLine;
+                output["result"] = globals::INVALID_DATA;
+                writeJson(output);
+                finish(1);
+                return false;
+            }
+            if (command.isEmpty()) continue;
+        }
+        commandPending = true;
+        return true;
+    }
+    return false;
+}
+
+
+void BertHeadless::writeJson(const QJsonObject &output)
+{
+    out << QJsonDocument(output).toJson(QJsonDocument::Compact) << "\n";
+    out.flush();
+}
+
+
+void BertHeadless::finish(int exitCode)
+{
+    if (finished) return;
+    finished = true;
+    delayTimer.stop();
+    manager.cancelAll();   // E.g. command failed on one instrument: Stop the others
+    QCoreApplication::exit(exitCode);
+}
@@ -0,0 +1,91 @@
+/*!
+ \file   BertHeadless.h
+ \brief  Headless (no GUI) automation client for the BERT back end
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#ifndef BERTHEADLESS_H
+#define BERTHEADLESS_H
+
+#include <QObject>
+#include <QTimer>
+#include <QFile>
+#include <QTextStream>
+#include <QJsonObject>
+#include <QStringList>
+
+#include "BertInstrument.h"
+
+/*!
+ \brief Headless Automation Client
+ Runs a command script against one or more instruments (see
+ BertInstrumentManager), instead of the BertWindow UI, so that
+ instruments can run in a test station without a desktop session.
+ Started with:  PG3204 --headless <script file>
+ If the script file is "-", commands are read from stdin.
+
+ Instrument commands are as for BertInstrument. A command may start with
+ "@<n>" to send it to instrument n (default: instrument 0), e.g.
+   @0 connect COM3
+   @1 connect COM4
+   @0 ed 3600
+   @1 ed 3600
+   sync
+ A command for an instrument waits until that instrument has finished its
+ previous command; instruments run in parallel otherwise. Other commands:
+   wait <ms>   Delay
+   sync        Wait until all instruments are idle
+   quit        Stop processing (same as end of script)
+   log <spec>  Set log levels (see BertLog::configure), e.g. "log i2c=trace";
+               outputs the levels in use
+
+ Output is one line of JSON per result, with "instrument" and "line"
+ (script line) fields. Lines starting with '#' and blank lines are ignored.
+ Processing stops at the first command which fails.
+ Nb: When reading from stdin, the next command is only read once all
+ instruments are idle (reading blocks, and would hold up the instruments).
+*/
+class BertHeadless : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BertHeadless(QObject *parent = nullptr);
+    ~BertHeadless();
+
+    int start(const QString &scriptFileName);
+
+private slots:
+    void nextCommand();
+    void delayFinished();
+    void managerOutput(QJsonObject output);
+    void instrumentIdle(int instrument, int result);
+
+private:
+    bool readCommand();
+    void writeJson(const QJsonObject &output);
+    void finish(int exitCode);
+
+    BertInstrumentManager manager;
+
+    QFile scriptFile;
+    QTextStream script;
+    int scriptLine = 0;
+
+    // Next command (read from the script, waiting to run):
+    bool commandPending = false;
+    int commandInstrument = 0;
+    QStringList command;
+    QMap<int, int> instrumentLines;   // Script line of last command sent to each instrument
+
+    bool readingStdin = false;
+    bool delayRunning = false;
+    bool quitPending = false;   // "quit" read; finish when instruments are idle
+    bool finished = false;
+    QTimer delayTimer;
+
+    QTextStream out;
+};
+
+#endif // BERTHEADLESS_H
@@ -0,0 +1,1157 @@
+/*!
+ \file   BertInstrument.cpp
+ \brief  Instrument Session - One BERT instrument driven without the UI,
+         and a manager for several instruments connected at once
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <QCoreApplication>
+#include <QJsonArray>
+#include <QFileInfo>
+#include <QDateTime>
+#include <QDebug>
+#include <math.h>
+
+#include "globals.h"
+#include "BathtubFit.h"
+#include "BertModel.h"
+#include "BertInstrument.h"
+
+
+BertInstrument::BertInstrument(int index, QObject *parent)
+ : QObject(parent), index(index), commandTimer(this)
+{
+    commandTimer.setSingleShot(true);
+    connect(&commandTimer, SIGNAL(timeout()), this, SLOT(commandTimeout()));
+
+    // Set up worker thread (as for BertWindow):
+    bertWorker = new BertWorker();
+    bertWorker->moveToThread(bertWorker);
+    BERT_WORKER_CONNECT_SIGNALS(this, bertWorker)
+    bertWorker->start();
+}
+
+BertInstrument::~BertInstrument()
+{
+    commandTimer.stop();
+    emit WorkerStop();
+    bertWorker->wait(5000);
+    delete bertWorker;
+}
+
+
+/*!
+ \brief Start a command
+ \param command  Command name and parameters (see class description)
+ Nb: The instrument must be idle (see isIdle).
+*/
+void BertInstrument::runCommand(const QStringList &command)
+{
+    Q_ASSERT(state == IDLE);
+    if (command.isEmpty()) return;
+    commandName = command.at(0).toLower();
+    commandClock.start();
+    QList<int> params;
+    bool paramsOK = true;
+    for (int i = 1; i < command.count(); i++)
+    {
+        bool ok = false;
+        params.append(command.at(i).toInt(&ok));
+        if (!ok && !(commandName == "connect" || commandName == "busprofile" || commandName == "plan" || commandName == "firmware" || (commandName == "ed" && i == 3))) paramsOK = false;
+    }
+    if (!paramsOK)
+    {
+        commandDone(globals::INVALID_DATA);
+        return;
+    }
+    const bool needsConnection = !(commandName == "ports" || commandName == "connect" || commandName == "edtarget");
+    if (needsConnection && !commsConnected)
+    {
+        commandDone(globals::NOT_CONNECTED);
+        return;
+    }
+
+    if (commandName == "ports")
+    {
+        commandStart(WAIT_PORTS, COMMAND_TIMEOUT);
+        emit RefreshSerialPorts();
+    }
+    else if (commandName == "connect")
+    {
+        QString port;
+        if (command.count() > 1)              port = command.at(1);
+        else if (index < serialPorts.count()) port = serialPorts.at(index);
+        commsSimulated = (I2CTransport::portTransportType(port) == I2CTransport::TRANSPORT_SIMULATED);
+        commandStart(WAIT_CONNECT, CONNECT_TIMEOUT);
+        emit CommsConnect(port);
+    }
+    else if (commandName == "disconnect")
+    {
+        commandStart(WAIT_DISCONNECT, COMMAND_TIMEOUT);
+        emit CommsDisconnect();
+    }
+    else if (commandName == "profile" && params.count() >= 1)
+    {
+        if (params.at(0) < 0 || params.at(0) >= lmxProfileCount)
+        {
+            commandDone(globals::INVALID_DATA);
+            return;
+        }
+        commandStart(WAIT_PROFILE, COMMAND_TIMEOUT);
+        emit SelectProfile(params.at(0), false);  // Nb: Resync done here (see LMXInfo)
+    }
+    else if (commandName == "pattern" && params.count() >= 1)
+    {
+        if (params.at(0) < 0 || params.at(0) >= GT1724::PG_PATTERN_LIST.count())
+        {
+            commandDone(globals::INVALID_DATA);
+            return;
+        }
+        pgPattern = params.at(0);
+        pgResync();
+        QJsonObject output;
+        output["pattern"] = pgPattern;
+        commandStart(WAIT_SETTLE, PG_SETTLE_TIME);
+        commandDone(globals::OK, output);
+    }
+    else if (commandName == "ed" && params.count() >= 1 && params.at(0) > 0)
+    {
+        const int pattern = (params.count() >= 2) ? params.at(1) : pgPattern;
+        if (pattern < 0 || pattern >= GT1724::ED_PATTERN_LIST.count())
+        {
+            commandDone(globals::INVALID_DATA);
+            return;
+        }
+        edStart(params.at(0), pattern, (command.count() >= 4) ? command.at(3) : QString());
+    }
+    else if (commandName == "edtarget" && params.count() >= 1 && params.at(0) >= 0)
+    {
+        const int confidencePercent = params.value(1, 95);
+        if (confidencePercent <= 50 || confidencePercent >= 100)
+        {
+            commandDone(globals::INVALID_DATA);
+            return;
+        }
+        edTargetBER = (params.at(0) > 0) ? pow(10.0, -params.at(0)) : 0.0;
+        edTargetConfidence = confidencePercent / 100.0;
+        QJsonObject output;
+        output["targetBER"] = edTargetBER;
+        output["confidence"] = edTargetConfidence;
+        commandDone(globals::OK, output);
+    }
+    else if ((commandName == "eyescan" || commandName == "bathtub") && params.count() >= 1)
+    {
+        const int type = (commandName == "eyescan") ? GT1724::GT1724_EYE_SCAN : GT1724::GT1724_BATHTUB_SCAN;
+        if (!scanParamsValid(type, params))
+        {
+            commandDone(globals::INVALID_DATA);
+            return;
+        }
+        scanStart(type, params);
+    }
+    else if (commandName == "plan" && command.count() >= 2)
+    {
+        planStart(command.at(1), (command.count() >= 3) ? command.at(2) : QString());
+    }
+    else if (commandName == "busprofile")
+    {
+        commandStart(WAIT_BUSPROFILE, COMMAND_TIMEOUT);
+        emit I2CProfileDump((command.count() > 1) ? command.at(1) : QString());
+    }
+    else if (commandName == "busreset")
+    {
+        emit I2CProfileReset();
+        commandDone(globals::OK);
+    }
+    else if (commandName == "firmware")
+    {
+        if (command.count() >= 2 && command.at(1).toLower() == "sim" && !commsSimulated)
+        {
+            // Simulator only (e.g. benchmark): Don't rewrite a real board's EEPROM:
+            QJsonObject output;
+            output["skipped"] = true;
+            commandDone(globals::OK, output);
+            return;
+        }
+        if (eepromDeviceID < 0)
+        {
+            commandDone(globals::MISSING_EEPROM);
+            return;
+        }
+        commandStart(WAIT_FIRMWARE, FIRMWARE_TIMEOUT);
+        emit WriteFirmware(eepromDeviceID);
+    }
+    else
+    {
+        commandDone(globals::INVALID_DATA);
+    }
+}
+
+
+/*!
+ \brief Stop the current command (e.g. on exit)
+*/
+void BertInstrument::cancel()
+{
+    if (planActive) emit EDLogStop();
+    planActive = false;   // Nb: Stop the plan first, so the measurement below just finishes
+    planLogFile.close();
+    if (state == ED_RUNNING)   edStop(globals::CANCELLED);
+    if (state == WAIT_EYESCAN) emit EyeScanCancel(scanLane);
+    commandTimer.stop();
+    state = IDLE;
+}
+
+
+
+
+// ========== SLOTS - Worker thread signals ================================================
+void BertInstrument::WorkerResult(int result)
+{
+    if      (state == WAIT_INIT)       commandDone(result);
+    else if (state == WAIT_DISCONNECT) commandDone(result);
+    else if (state == WAIT_CONNECT && result != globals::OK) commandDone(result);
+}
+
+void BertInstrument::WorkerShowMessage(QString message, bool append)
+{
+    Q_UNUSED(append)
+    qDebug() << "Instrument " << index << ": " << message;
+}
+
+void BertInstrument::ListSerialPorts(QStringList ports)
+{
+    serialPorts = ports;
+    if (state != WAIT_PORTS) return;
+    QJsonObject output;
+    output["ports"] = QJsonArray::fromStringList(ports);
+    commandDone(globals::OK, output);
+}
+
+void BertInstrument::TLC59108Added(TLC59108 *tlc59108, int deviceID)
+  {  Q_UNUSED(tlc59108)  Q_UNUSED(deviceID)  }
+
+void BertInstrument::GT1724Added(GT1724 *gt1724, int laneOffset)
+{
+    GT1724_CONNECT_SIGNALS(this, gt1724)
+    if (!chipLanes.contains(laneOffset)) chipLanes.append(laneOffset);
+}
+
+void BertInstrument::LMX2594Added(LMX2594 *lmx2594, int deviceID)
+{
+    Q_UNUSED(deviceID)
+    LMX_CONNECT_SIGNALS(this, lmx2594)
+}
+
+void BertInstrument::PCA9557B_Added(PCA9557B *pca9557b, int deviceID)
+  {  Q_UNUSED(pca9557b)  Q_UNUSED(deviceID)  }
+
+void BertInstrument::PCA9557A_Added(PCA9557A *pca9557a, int deviceID)
+  {  Q_UNUSED(pca9557a)  Q_UNUSED(deviceID)  }
+
+void BertInstrument::M24M02Added(M24M02 *m24m02, int deviceID)
+{
+    M24M02_CONNECT_SIGNALS(this, m24m02)
+    eepromDeviceID = deviceID;
+}
+
+void BertInstrument::SI5340Added(SI5340 *si5340, int deviceID)
+  {  Q_UNUSED(si5340)  Q_UNUSED(deviceID)  }
+
+void BertInstrument::PollerAdded(BertPoller *poller)
+{
+    BERT_POLLER_CONNECT_SIGNALS(this, poller)
+}
+
+void BertInstrument::StatusConnect(bool connected)
+{
+    commsConnected = connected;
+    if (!connected)
+    {
+        chipLanes.clear();
+        eepromDeviceID = -1;
+        lmxProfileCount = 0;
+    }
+    if (state != WAIT_CONNECT) return;
+    if (connected)
+    {
+        // Components have been added: Get options, then init (see OptionsSent).
+        state = WAIT_OPTIONS;
+        emit GetOptions();
+    }
+    else
+    {
+        commandDone(globals::NOT_CONNECTED);
+    }
+}
+
+void BertInstrument::OptionsSent()
+{
+    if (state != WAIT_OPTIONS) return;
+    state = WAIT_INIT;
+    emit InitComponents();
+}
+
+void BertInstrument::I2CProfileReport(int result, QString fileName, QString report)
+{
+    if (state != WAIT_BUSPROFILE) return;
+    QJsonObject output;
+    output["file"] = fileName;
+    output["report"] = report;
+    commandDone(result, output);
+}
+
+
+// ========== SLOTS - Component signals ====================================================
+void BertInstrument::Result(int result, int lane)
+{
+    if (state == WAIT_FIRMWARE)
+    {
+        commandDone(result);   // Nb: Only the EEPROM reports while writing firmware
+        return;
+    }
+    if (planActive)
+    {
+        if (result != globals::OK) planErrors++;   // E.g. a setting couldn't be written (reported with the point)
+        return;
+    }
+    if (result == globals::OK) return;
+    qDebug() << "Instrument " << index << ": Component result " << result << " (lane " << lane << ")";
+    if (state == WAIT_PROFILE) commandDone(result);  // Couldn't select frequency profile
+}
+
+void BertInstrument::ListPopulate(QString name, int lane, QStringList items, int defaultIndex)
+{
+    Q_UNUSED(lane)
+    Q_UNUSED(defaultIndex)
+    if (name == "listLMXFreq") lmxProfileCount = items.count();   // For range checks (see profile)
+}
+
+void BertInstrument::SetPGLedStatus(int lane, bool laneOn)
+  {  Q_UNUSED(lane)  Q_UNUSED(laneOn)  }
+
+void BertInstrument::UIUpdate(QList<BertUIUpdate_t> updates)
+  {  Q_UNUSED(updates)  }
+
+void BertInstrument::ShowMessage(QString message, bool append)
+  {  WorkerShowMessage(message, append);  }
+
+
+void BertInstrument::EDLosLol(int lane, bool los, bool lol)
+  {  Q_UNUSED(lane)  Q_UNUSED(los)  Q_UNUSED(lol)  }
+
+void BertInstrument::EDCount(int lane, bool locked, double bits, double bitsTotal, double errors, double errorsTotal)
+  {  Q_UNUSED(lane)  Q_UNUSED(locked)  Q_UNUSED(bits)  Q_UNUSED(bitsTotal)  Q_UNUSED(errors)  Q_UNUSED(errorsTotal)  }
+
+void BertInstrument::EDCountSnapshot(int metaLane, qint64 timestamp, QList<EDCountReading_t> readings)
+{
+    Q_UNUSED(metaLane)
+    if (state != ED_RUNNING) return;
+    edReadings++;
+    foreach (const EDCountReading_t &reading, readings)
+    {
+        EDLaneResult_t &laneResult = edResults[reading.lane];
+        laneResult.locked = reading.locked;
+        laneResult.bitsTotal = reading.bitsTotal;
+        laneResult.errorsTotal = reading.errorsTotal;
+
+        QJsonObject sample;
+        sample["event"] = "ed_sample";
+        sample["timestamp"] = static_cast<double>(timestamp);
+        sample["lane"] = reading.lane;
+        sample["locked"] = reading.locked;
+        sample["bits"] = reading.bits;
+        sample["errors"] = reading.errors;
+        sample["bitsTotal"] = reading.bitsTotal;
+        sample["errorsTotal"] = reading.errorsTotal;
+        output(sample);
+    }
+}
+
+void BertInstrument::EyeScanProgressUpdate(int lane, int type, int percent)
+  {  Q_UNUSED(lane)  Q_UNUSED(type)  Q_UNUSED(percent)  }
+
+void BertInstrument::EyeScanError(int lane, int type, int code)
+{
+    Q_UNUSED(type)
+    if (state != WAIT_EYESCAN || lane != scanLane) return;
+    QJsonObject output;
+    output["lane"] = lane;
+    commandDone(code, output);
+}
+
+void BertInstrument::EyeScanPartial(int lane, int type, EyeScanResult result, int rowsDone)
+  {  Q_UNUSED(lane)  Q_UNUSED(type)  Q_UNUSED(result)  Q_UNUSED(rowsDone)  }
+
+void BertInstrument::EyeScanFinished(int lane, int type, EyeScanResult result)
+{
+    if (state != WAIT_EYESCAN || lane != scanLane) return;
+    QJsonObject output;
+    output["lane"] = lane;
+    output["xRes"] = result.getXRes();
+    output["yRes"] = result.getYRes();
+    output["countFullScale"] = result.getCountFullScale();
+    if (result.hasRowFullScale())
+    {
+        QJsonArray rowFullScale;
+        foreach (double fullScale, result.getRowFullScales()) rowFullScale.append(fullScale);
+        output["rowFullScale"] = rowFullScale;
+    }
+    QJsonArray counts;
+    foreach (quint32 count, result.getCounts()) counts.append(static_cast<double>(count));
+    output["counts"] = counts;
+    if (type == GT1724::GT1724_BATHTUB_SCAN)
+    {
+        BathtubFit fit(result);
+        if (fit.isValid())
+        {
+            QJsonObject fitOutput;
+            fitOutput["targetErrorRatio"] = fit.getTargetRatio();   // Not a true BER (see BathtubFit)
+            fitOutput["opening"] = fit.getOpening();
+            fitOutput["rj"] = fit.getRJ();
+            fitOutput["dj"] = fit.getDJ();
+            fitOutput["tj"] = fit.getTJ();
+            fitOutput["confidence"] = fit.getConfidence();
+            output["fit"] = fitOutput;
+        }
+    }
+    commandDone(globals::OK, output);
+}
+
+
+void BertInstrument::LMXInfo(int deviceID, int indexProfile, int indexTrigOutputPower, int indexFOutOutputPower, int indexTriggerDivide, bool outputsOn, float frequency)
+{
+    Q_UNUSED(indexTrigOutputPower)
+    Q_UNUSED(indexFOutOutputPower)
+    Q_UNUSED(indexTriggerDivide)
+    Q_UNUSED(outputsOn)
+    // Update the system-wide bit rate (as for BertWindow::LMXInfo):
+    bitRate = static_cast<double>(frequency) * 2.0 * 1e6;
+    if (state == PLAN_SETUP)
+    {
+        planApply(true);
+        return;
+    }
+    if (state != WAIT_PROFILE) return;
+    // New profile selected: Resync the PG, and allow time to settle.
+    pgResync();
+    QJsonObject output;
+    output["clock"] = deviceID;
+    output["profile"] = indexProfile;
+    output["bitRate"] = bitRate;
+    commandStart(WAIT_SETTLE, PG_SETTLE_TIME);
+    commandDone(globals::OK, output);   // Nb: Reported now; instrument is idle after settle time
+}
+
+void BertInstrument::LMXVTuneLock(int deviceID, bool isLocked)
+  {  Q_UNUSED(deviceID)  Q_UNUSED(isLocked)  }
+
+void BertInstrument::LMXSettingsChanged(int deviceID)
+  {  Q_UNUSED(deviceID)  }
+
+
+void BertInstrument::EEPROMStringData(int deviceID, QString model, QString serial, QString productionDate, QString calibrationDate, QString warrantyStart, QString warrantyEnd, QString synthConfigVersion)
+{
+    Q_UNUSED(deviceID)  Q_UNUSED(model)  Q_UNUSED(serial)  Q_UNUSED(productionDate)  Q_UNUSED(calibrationDate)
+    Q_UNUSED(warrantyStart)  Q_UNUSED(warrantyEnd)  Q_UNUSED(synthConfigVersion)
+}
+
+
+void BertInstrument::EDConfidenceUpdate(int lane, int verdict, double confidence, double bitsTotal, double errorsTotal)
+{
+    Q_UNUSED(bitsTotal)
+    Q_UNUSED(errorsTotal)
+    if (state != ED_RUNNING) return;
+    EDLaneResult_t &laneResult = edResults[lane];
+    laneResult.verdict = verdict;
+    laneResult.confidence = confidence;
+    if (verdict == EDConfidence::VERDICT_PENDING) return;
+    laneResult.elapsedMs = measureClock.elapsed();
+
+    // Finish early once every ED lane (two per GT1724) has a verdict:
+    if (edResults.count() < chipLanes.count() * 2) return;
+    foreach (const EDLaneResult_t &result, edResults)
+    {
+        if (result.verdict == EDConfidence::VERDICT_PENDING) return;
+    }
+    edStop(globals::OK);
+}
+
+void BertInstrument::EDLogStatus(int result, QString fileName, quint64 records)
+{
+    QJsonObject logOutput;
+    logOutput["event"] = "ed_log";
+    logOutput["result"] = result;
+    logOutput["file"] = fileName;
+    logOutput["records"] = static_cast<double>(records);
+    output(logOutput);
+}
+
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+/*!
+ \brief Set the state for an asynchronous command, and start the timeout
+ For WAIT_SETTLE and ED_RUNNING, the "timeout" is the end of the
+ command rather than an error.
+*/
+void BertInstrument::commandStart(CommandState state, int timeoutMs)
+{
+    this->state = state;
+    commandTimer.start(timeoutMs);
+}
+
+
+/*!
+ \brief Command timer expired
+*/
+void BertInstrument::commandTimeout()
+{
+    switch (state)
+    {
+    case WAIT_SETTLE:
+        state = IDLE;        // Result already reported
+        emit InstrumentIdle(index, globals::OK);
+        break;
+    case ED_RUNNING:
+        edStop(globals::OK);
+        break;
+    case PLAN_SETTLE:
+        planMeasure();
+        break;
+    case PLAN_SETUP:
+        planFinish(globals::TIMEOUT);   // Profile change didn't finish
+        break;
+    case WAIT_EYESCAN:
+        emit EyeScanCancel(scanLane);
+        commandDone(globals::TIMEOUT);
+        break;
+    case IDLE:
+        break;
+    default:
+        commandDone(globals::TIMEOUT);
+        break;
+    }
+}
+
+
+/*!
+ \brief Start the ED on all ED lanes (see edStop for results)
+ \param seconds   Run time (the run may end sooner if a confidence target is set)
+ \param pattern   ED pattern (list index)
+ \param logFile   If not empty: Also log readings to this binary log file
+*/
+void BertInstrument::edStart(int seconds, int pattern, const QString &logFile)
+{
+    edResults.clear();
+    edReadings = 0;
+    measureClock.start();
+    emit EDSetConfidenceTarget(edTargetBER, edTargetConfidence);
+    foreach (int chipLane, chipLanes) emit SetEDOptions(chipLane, pattern, false, true, pattern, false, true);
+    edLogging = !logFile.isEmpty();
+    if (edLogging)
+    {
+        emit EDLogStart(logFile);
+        edLogStatusPolling(true);
+    }
+    emit PollerSetBitRate(bitRate);
+    emit PollerSetTargets(BertPoller::POLL_ED_COUNT, chipLanes);
+    emit PollerSetInterval(BertPoller::POLL_ED_COUNT, ED_POLL_INTERVAL);
+    commandStart(ED_RUNNING, seconds * 1000);
+}
+
+
+/*!
+ \brief Start an eye or bathtub scan (see EyeScanFinished for results)
+ \param type    GT1724::GT1724_EYE_SCAN or GT1724::GT1724_BATHTUB_SCAN
+ \param params  Lane, then: hStep, vStep, countRes (eye scan) or vOffset, countRes (bathtub)
+*/
+void BertInstrument::scanStart(int type, const QList<int> &params)
+{
+    scanLane = params.at(0);
+    measureClock.start();
+    commandStart(WAIT_EYESCAN, EYESCAN_TIMEOUT);
+    if (type == GT1724::GT1724_EYE_SCAN)
+    {
+        emit EyeScanStart(scanLane, GT1724::GT1724_EYE_SCAN,
+                          params.value(1, 0),   // hStep
+                          params.value(2, 0),   // vStep
+                          0,                    // vOffset: Unused for Eye Plot
+                          params.value(3, 0),   // countRes
+                          false,                // adaptive
+                          false);               // converge
+    }
+    else
+    {
+        emit EyeScanStart(scanLane, GT1724::GT1724_BATHTUB_SCAN,
+                          0,                    // hStep: Always 1 for Bathtub Plot
+                          0,                    // vStep: Unused for Bathtub Plot
+                          params.value(1, 0),   // vOffset
+                          params.value(2, 0),   // countRes
+                          false,                // adaptive
+                          false);               // converge
+    }
+}
+
+
+/*!
+ \brief Start or stop polling LOS / LOL and core temperature for the ED log
+ The log records the last values read for each lane (see BertPoller).
+*/
+void BertInstrument::edLogStatusPolling(bool enable)
+{
+    if (enable) emit PollerSetTargets(BertPoller::POLL_LOS_LOL, chipLanes);
+    emit PollerSetInterval(BertPoller::POLL_LOS_LOL,     enable ? ED_LOG_STATUS_INTERVAL : 0);
+    emit PollerSetInterval(BertPoller::POLL_TEMPERATURE, enable ? ED_LOG_TEMP_INTERVAL : 0);
+}
+
+
+/*!
+ \brief Check that a lane is an ED lane of one of the GT1724s found
+ \param lane  Lane number (ED lanes are 1 and 3 on each GT1724)
+*/
+bool BertInstrument::edLaneValid(int lane) const
+{
+    if (lane < 0 || (lane % 2) != 1) return false;
+    return chipLanes.contains(lane - (lane % 4));
+}
+
+
+/*!
+ \brief Check eye or bathtub scan parameters (see scanStart) against the option lists
+ Nb: Out of range indexes would read past the end of the GT1724 lookup tables.
+*/
+bool BertInstrument::scanParamsValid(int type, const QList<int> &params) const
+{
+    if (params.isEmpty() || !edLaneValid(params.at(0))) return false;
+    int hStep = 0, vStep = 0, vOffset = 0, countRes;
+    if (type == GT1724::GT1724_EYE_SCAN)
+    {
+        hStep    = params.value(1, 0);
+        vStep    = params.value(2, 0);
+        countRes = params.value(3, 0);
+    }
+    else
+    {
+        vOffset  = params.value(1, 0);
+        countRes = params.value(2, 0);
+    }
+    return (hStep >= 0)    && (hStep < GT1724::EYESCAN_VHSTEP_LOOKUP.size())
+        && (vStep >= 0)    && (vStep < GT1724::EYESCAN_VHSTEP_LOOKUP.size())
+        && (vOffset >= 0)  && (vOffset < GT1724::EYESCAN_VOFF_LOOKUP.size())
+        && (countRes >= 0) && (countRes < GT1724::EYESCAN_COUNTRES_LIST.count());
+}
+
+
+/*!
+ \brief Stop the ED, and report totals for each lane
+*/
+void BertInstrument::edStop(int result)
+{
+    emit PollerSetInterval(BertPoller::POLL_ED_COUNT, 0);
+    foreach (int chipLane, chipLanes) emit SetEDOptions(chipLane, 0, false, false, 0, false, false);
+    if (edLogging)
+    {
+        emit EDLogStop();
+        edLogStatusPolling(false);
+    }
+    edLogging = false;
+
+    QJsonArray lanes;
+    QMapIterator<int, EDLaneResult_t> it(edResults);
+    while (it.hasNext())
+    {
+        it.next();
+        QJsonObject laneOutput;
+        laneOutput["lane"] = it.key();
+        laneOutput["locked"] = it.value().locked;
+        laneOutput["bitsTotal"] = it.value().bitsTotal;
+        laneOutput["errorsTotal"] = it.value().errorsTotal;
+        laneOutput["ber"] = (it.value().bitsTotal > 0) ? (it.value().errorsTotal / it.value().bitsTotal) : 0.0;
+        if (edTargetBER > 0.0)
+        {
+            laneOutput["verdict"] = EDConfidence::verdictName(it.value().verdict);
+            laneOutput["confidence"] = it.value().confidence;
+            if (it.value().verdict != EDConfidence::VERDICT_PENDING) laneOutput["verdictMs"] = static_cast<double>(it.value().elapsedMs);
+        }
+        lanes.append(laneOutput);
+    }
+    QJsonObject output;
+    output["lanes"] = lanes;
+    output["readings"] = edReadings;
+    const qint64 elapsedMs = measureClock.elapsed();
+    output["readingsPerSecond"] = (elapsedMs > 0) ? (edReadings * 1000.0 / elapsedMs) : 0.0;
+    commandDone(result, output);
+}
+
+
+/*!
+ \brief Reconfigure the PG on all GT1724s (e.g. after a clock change)
+*/
+void BertInstrument::pgResync()
+{
+    foreach (int chipLane, chipLanes) emit ConfigPG(chipLane, pgPattern, bitRate);
+}
+
+
+/*!
+ \brief Load a test plan, open the results file and start the first point
+ \param fileName     Test plan file (see BertTestPlan)
+ \param csvFileName  Results file; empty = Plan file name + time + ".csv"
+*/
+void BertInstrument::planStart(const QString &fileName, const QString &csvFileName)
+{
+    QJsonObject output;
+    output["file"] = fileName;
+    // Option counts for range checks (Nb: the pattern is used for the PG and the ED):
+    QList<int> valueCounts;
+    valueCounts << lmxProfileCount
+                << qMin(GT1724::PG_PATTERN_LIST.count(), GT1724::ED_PATTERN_LIST.count())
+                << GT1724::PG_OUTPUT_SWING_LOOKUP.size()
+                << GT1724::PG_EQ_DEEMPH_LIST.count()
+                << GT1724::PG_EQ_CURSOR_LIST.count()
+                << GT1724::ED_EQ_BOOST_LOOKUP.size();
+    Q_ASSERT(valueCounts.count() == BertTestPlan::PARAM_COUNT);
+    int result = plan.load(fileName, valueCounts);
+    if (result == globals::OK && (plan.getPointCount() == 0 || plan.getMeasurements().isEmpty())) result = globals::INVALID_DATA;
+    if (result != globals::OK)
+    {
+        if (plan.getErrorLine() > 0) output["line"] = plan.getErrorLine();
+        commandDone(result, output);
+        return;
+    }
+    // Scans: Check the lane (needs a GT1724) and options now, rather than part way through:
+    foreach (const BertTestPlan::PlanMeasurement_t &measurement, plan.getMeasurements())
+    {
+        int scanType = -1;
+        if      (measurement.type == BertTestPlan::MEASURE_EYESCAN) scanType = GT1724::GT1724_EYE_SCAN;
+        else if (measurement.type == BertTestPlan::MEASURE_BATHTUB) scanType = GT1724::GT1724_BATHTUB_SCAN;
+        if (scanType >= 0 && !scanParamsValid(scanType, measurement.params))
+        {
+            output["line"] = measurement.line;
+            commandDone(globals::INVALID_DATA, output);
+            return;
+        }
+    }
+
+    QString logFileName = csvFileName;
+    if (logFileName.isEmpty())
+    {
+        const QFileInfo planInfo(fileName);
+        logFileName = QString("%1/%2_%3.csv")
+                        .arg(planInfo.absolutePath())
+                        .arg(planInfo.completeBaseName())
+                        .arg(QDateTime::currentDateTime().toString("yyyyMMddThhmmss"));
+    }
+    planLogFile.setFileName(logFileName);
+    if (!planLogFile.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        output["log"] = logFileName;
+        commandDone(globals::FILE_ERROR, output);
+        return;
+    }
+    planLog.setDevice(&planLogFile);
+    planLog.setRealNumberNotation(QTextStream::SmartNotation);
+    planLog.setRealNumberPrecision(15);
+    planLog << "# Test Plan: " << fileName << "\n";
+    planLog << "# Created: " << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss") << "\n";
+    planLog << "Point,";
+    for (int parameter = 0; parameter < BertTestPlan::PARAM_COUNT; parameter++)
+    {
+        if (plan.usesParameter(parameter)) planLog << BertTestPlan::parameterName(parameter) << ",";
+    }
+    planLog << "Bit Rate,Measure,Start Time,Lane,Result,Bits Total,Errors Total,BER,Verdict,"
+               "Open Fraction,Opening,RJ,DJ,TJ\n";
+
+    // Every ED reading made by the plan also goes into the ED measurement log (see
+    // BertPoller; exported to <name>_ed.csv at the end); "Start Time" in the results
+    // file matches the log timestamps:
+    const QFileInfo logInfo(logFileName);
+    planEDLogFileName = QString("%1/%2_ed.bin").arg(logInfo.absolutePath()).arg(logInfo.completeBaseName());
+    emit EDLogStart(planEDLogFileName);
+    edLogStatusPolling(true);
+
+    planActive = true;
+    planPointIndex = 0;
+    planSettings = BertTestPlan::PlanPoint_t();   // Nb: Current settings unknown, so the first point writes all of them
+    planSetup();
+}
+
+
+/*!
+ \brief Start setting up the current plan point
+ A profile change is made first (see LMXInfo), as the PG must be resynced
+ afterwards; the other settings are then sent by planApply.
+*/
+void BertInstrument::planSetup()
+{
+    planMeasureIndex = 0;
+    planErrors = 0;
+    planPointResults = QJsonArray();
+    const int profile = plan.getPoint(planPointIndex).values[BertTestPlan::PARAM_PROFILE];
+    if (profile >= 0 && profile != planSettings.values[BertTestPlan::PARAM_PROFILE])
+    {
+        planSettings.values[BertTestPlan::PARAM_PROFILE] = profile;
+        commandStart(PLAN_SETUP, COMMAND_TIMEOUT);
+        emit SelectProfile(profile, false);
+        return;
+    }
+    planApply(false);
+}
+
+
+/*!
+ \brief Send the settings for the current plan point, and start the settle time
+ \param clockChanged  true: Profile was changed, so the PG must be resynced
+ Only settings which differ from the last point are sent. All of them are
+ queued at once; the settle timer starts straight away, so it runs while
+ the worker thread is still writing.
+*/
+void BertInstrument::planApply(bool clockChanged)
+{
+    const BertTestPlan::PlanPoint_t point = plan.getPoint(planPointIndex);
+    int settleMs = 0;
+    bool resync = clockChanged;
+
+    const int pattern = point.values[BertTestPlan::PARAM_PATTERN];
+    if (pattern >= 0 && pattern != planSettings.values[BertTestPlan::PARAM_PATTERN])
+    {
+        planSettings.values[BertTestPlan::PARAM_PATTERN] = pattern;
+        pgPattern = pattern;
+        resync = true;
+    }
+    if (resync)
+    {
+        pgResync();
+        settleMs = PG_SETTLE_TIME;
+    }
+
+    // PG lanes: 0 and 2 on each GT1724 (all four lanes in four channel PG mode):
+    QList<int> pgLanes, edLanes;
+    foreach (int chipLane, chipLanes)
+    {
+        pgLanes << chipLane + 0 << chipLane + 2;
+        if (BertModel::UseFourChanPGMode()) pgLanes << chipLane + 1 << chipLane + 3;
+        edLanes << chipLane + 1 << chipLane + 3;
+    }
+
+    const int swing = point.values[BertTestPlan::PARAM_SWING];
+    if (swing >= 0 && swing != planSettings.values[BertTestPlan::PARAM_SWING])
+    {
+        planSettings.values[BertTestPlan::PARAM_SWING] = swing;
+        foreach (int lane, pgLanes) emit SetOutputSwing(lane, swing);
+        settleMs = qMax(settleMs, plan.getSettleMs());
+    }
+
+    // De-emphasis level and cursor are set together; one which isn't in the plan is left at 0:
+    const int level = point.values[BertTestPlan::PARAM_DEEMPH_LEVEL];
+    const int cursor = point.values[BertTestPlan::PARAM_DEEMPH_CURSOR];
+    if ((level >= 0 && level != planSettings.values[BertTestPlan::PARAM_DEEMPH_LEVEL])
+     || (cursor >= 0 && cursor != planSettings.values[BertTestPlan::PARAM_DEEMPH_CURSOR]))
+    {
+        if (level >= 0)  planSettings.values[BertTestPlan::PARAM_DEEMPH_LEVEL] = level;
+        if (cursor >= 0) planSettings.values[BertTestPlan::PARAM_DEEMPH_CURSOR] = cursor;
+        const int levelIndex = qMax(0, planSettings.values[BertTestPlan::PARAM_DEEMPH_LEVEL]);
+        const int cursorIndex = qMax(0, planSettings.values[BertTestPlan::PARAM_DEEMPH_CURSOR]);
+        foreach (int lane, pgLanes) emit SetDeEmphasis(lane, levelIndex, cursorIndex);
+        settleMs = qMax(settleMs, plan.getSettleMs());
+    }
+
+    const int eqBoost = point.values[BertTestPlan::PARAM_EQ_BOOST];
+    if (eqBoost >= 0 && eqBoost != planSettings.values[BertTestPlan::PARAM_EQ_BOOST])
+    {
+        planSettings.values[BertTestPlan::PARAM_EQ_BOOST] = eqBoost;
+        foreach (int lane, edLanes) emit SetEQBoost(lane, eqBoost);
+        settleMs = qMax(settleMs, plan.getSettleMs());
+    }
+
+    commandStart(PLAN_SETTLE, settleMs);   // Nb: Measurement starts from commandTimeout
+}
+
+
+/*!
+ \brief Start the next measurement for the current plan point
+*/
+void BertInstrument::planMeasure()
+{
+    if (planMeasureIndex >= plan.getMeasurements().count())
+    {
+        planPointDone();
+        return;
+    }
+    const BertTestPlan::PlanMeasurement_t &measurement = plan.getMeasurements().at(planMeasureIndex);
+    planMeasureStartMs = QDateTime::currentMSecsSinceEpoch();
+    switch (measurement.type)
+    {
+    case BertTestPlan::MEASURE_ED:
+        edStart(measurement.params.value(0, 1), pgPattern, QString());
+        break;
+    case BertTestPlan::MEASURE_EYESCAN:
+        scanStart(GT1724::GT1724_EYE_SCAN, measurement.params);
+        break;
+    case BertTestPlan::MEASURE_BATHTUB:
+        scanStart(GT1724::GT1724_BATHTUB_SCAN, measurement.params);
+        break;
+    default:
+        planMeasureDone(globals::INVALID_DATA, QJsonObject());
+        break;
+    }
+}
+
+
+/*!
+ \brief A measurement for the current plan point has finished
+ \param result  globals:: result code
+ \param output  Measurement output (as for the matching command)
+*/
+void BertInstrument::planMeasureDone(int result, QJsonObject output)
+{
+    commandTimer.stop();
+    output["measure"] = BertTestPlan::measurementName(plan.getMeasurements().at(planMeasureIndex).type);
+    output["result"] = result;
+    output["elapsedMs"] = static_cast<double>(measureClock.elapsed());
+    output["startTime"] = static_cast<double>(planMeasureStartMs);
+    planPointResults.append(output);
+    if (result == globals::CANCELLED || result == globals::NOT_CONNECTED)
+    {
+        planFinish(result);
+        return;
+    }
+    planMeasureIndex++;
+    planMeasure();
+}
+
+
+/*!
+ \brief All measurements for the current plan point have finished
+ The next point is set up before this one is reported and logged, so that
+ its settings are being written in the meantime.
+*/
+void BertInstrument::planPointDone()
+{
+    const int point = planPointIndex;
+    const BertTestPlan::PlanPoint_t settings = plan.getPoint(point);
+    const double pointBitRate = bitRate;
+    const int errors = planErrors;
+    const QJsonArray measurements = planPointResults;
+
+    planPointIndex++;
+    const bool finished = (planPointIndex >= plan.getPointCount());
+    if (!finished) planSetup();
+    planReportPoint(point, settings, pointBitRate, errors, measurements);
+    if (finished) planFinish(globals::OK);
+}
+
+
+/*!
+ \brief Send the results for a plan point, and write them to the results file
+ The file has a row for each lane measured by the ED, and for each scan.
+*/
+void BertInstrument::planReportPoint(int point, const BertTestPlan::PlanPoint_t &settings, double pointBitRate,
+                                     int errors, const QJsonArray &measurements)
+{
+    QJsonObject pointOutput;
+    pointOutput["event"] = "plan_point";
+    pointOutput["point"] = point;
+    QJsonObject settingsOutput;
+    QString settingsColumns;
+    for (int parameter = 0; parameter < BertTestPlan::PARAM_COUNT; parameter++)
+    {
+        if (!plan.usesParameter(parameter)) continue;
+        if (settings.values[parameter] >= 0)
+        {
+            settingsOutput[BertTestPlan::parameterName(parameter)] = settings.values[parameter];
+            settingsColumns += QString::number(settings.values[parameter]);
+        }
+        settingsColumns += ",";
+    }
+    pointOutput["settings"] = settingsOutput;
+    pointOutput["bitRate"] = pointBitRate;
+    pointOutput["errors"] = errors;
+    pointOutput["measurements"] = measurements;
+    output(pointOutput);
+
+    foreach (const QJsonValue &value, measurements)
+    {
+        const QJsonObject measurement = value.toObject();
+        const QString rowStart = QString("%1,%2").arg(point).arg(settingsColumns);
+        const QString startTime = QDateTime::fromMSecsSinceEpoch(static_cast<qint64>(measurement["startTime"].toDouble()))
+                                    .toString("yyyy-MM-dd hh:mm:ss.zzz");
+        if (measurement.contains("lanes"))
+        {
+            // ED: One row per lane:
+            foreach (const QJsonValue &laneValue, measurement["lanes"].toArray())
+            {
+                const QJsonObject lane = laneValue.toObject();
+                planLog << rowStart << pointBitRate << "," << measurement["measure"].toString() << ","
+                        << startTime << "," << lane["lane"].toInt() << "," << measurement["result"].toInt() << ","
+                        << lane["bitsTotal"].toDouble() << "," << lane["errorsTotal"].toDouble() << ","
+                        << lane["ber"].toDouble() << "," << lane["verdict"].toString() << ",,,,,\n";
+            }
+            continue;
+        }
+        // Scan (or a measurement which failed before giving any lanes):
+        planLog << rowStart << pointBitRate << "," << measurement["measure"].toString() << ","
+                << startTime << ",";
+        if (measurement.contains("lane")) planLog << measurement["lane"].toInt();
+        planLog << "," << measurement["result"].toInt() << ",,,,,";
+        const QJsonArray counts = measurement["counts"].toArray();
+        if (!counts.isEmpty())
+        {
+            int open = 0;
+            foreach (const QJsonValue &count, counts) if (count.toDouble() == 0.0) open++;
+            planLog << (static_cast<double>(open) / counts.count());
+        }
+        planLog << ",";
+        if (measurement.contains("fit"))
+        {
+            const QJsonObject fit = measurement["fit"].toObject();
+            planLog << fit["opening"].toDouble() << "," << fit["rj"].toDouble() << ","
+                    << fit["dj"].toDouble() << "," << fit["tj"].toDouble();
+        }
+        else
+        {
+            planLog << ",,,";
+        }
+        planLog << "\n";
+    }
+    planLog.flush();
+}
+
+
+/*!
+ \brief End the test plan, and report the plan result
+*/
+void BertInstrument::planFinish(int result)
+{
+    const bool logOK = (planLog.status() == QTextStream::Ok);
+    planActive = false;
+    planLogFile.close();
+    emit EDLogStop();   // Nb: The poller exports the ED log to CSV, and reports it with EDLogStatus
+    edLogStatusPolling(false);
+    QJsonObject output;
+    output["file"] = plan.getFileName();
+    output["log"] = planLogFile.fileName();
+    output["edLog"] = planEDLogFileName;
+    output["points"] = planPointIndex;
+    commandDone((result == globals::OK && !logOK) ? globals::FILE_ERROR : result, output);
+}
+
+
+/*!
+ \brief Report the result of the current command
+ \param result  globals:: result code
+ \param output  Command specific output values
+ The instrument is idle afterwards, except after WAIT_SETTLE is started
+ (the result is reported straight away, but the instrument isn't ready
+ until the settle time has passed).
+*/
+void BertInstrument::commandDone(int result, QJsonObject output)
+{
+    if (planActive)
+    {
+        planMeasureDone(result, output);   // Measurement for a test plan point
+        return;
+    }
+    if (state != WAIT_SETTLE || result != globals::OK)
+    {
+        commandTimer.stop();
+        state = IDLE;
+    }
+    output["cmd"] = commandName;
+    output["result"] = result;
+    output["elapsedMs"] = static_cast<double>(commandClock.elapsed());
+    this->output(output);
+    if (state == IDLE) emit InstrumentIdle(index, result);
+}
+
+
+void BertInstrument::output(QJsonObject output)
+{
+    output["instrument"] = index;
+    emit InstrumentOutput(index, output);
+}
+
+
+
+
+/************* BertInstrumentManager ******************************************/
+
+BertInstrumentManager::BertInstrumentManager(QObject *parent)
+ : QObject(parent)
+{}
+
+BertInstrumentManager::~BertInstrumentManager()
+{
+    foreach (BertInstrument *instrument, instruments)
+    {
+        disconnect(instrument, 0, this, 0);  // Nb: Client may already be gone; don't forward output
+        instrument->cancel();
+    }
+    qDeleteAll(instruments);
+    instruments.clear();
+}
+
+
+/*!
+ \brief Send a command to an instrument
+ The instrument is created if it doesn't exist yet.
+ \param index    Instrument index (0 to MAX_INSTRUMENTS - 1)
+ \param command  Command and parameters (see BertInstrument)
+ \return globals::OK          Command started (result will follow via Output)
+ \return globals::OVERFLOW    Instrument index out of range
+ \return globals::BUSY_ERROR  Instrument is running another command
+*/
+int BertInstrumentManager::runCommand(int index, const QStringList &command)
+{
+    if (index < 0 || index >= MAX_INSTRUMENTS) return globals::OVERFLOW;
+    BertInstrument *instrument = instruments.value(index, NULL);
+    if (!instrument)
+    {
+        instrument = new BertInstrument(index);
+        connect(instrument, SIGNAL(InstrumentOutput(int, QJsonObject)), this, SLOT(instrumentOutput(int, QJsonObject)));
+        connect(instrument, SIGNAL(InstrumentIdle(int, int)),           this, SLOT(instrumentIdle(int, int)));
+        instruments.insert(index, instrument);
+    }
+    if (!instrument->isIdle()) return globals::BUSY_ERROR;
+    instrument->runCommand(command);
+    return globals::OK;
+}
+
+
+bool BertInstrumentManager::isIdle(int index) const
+{
+    BertInstrument *instrument = instruments.value(index, NULL);
+    return (!instrument || instrument->isIdle());
+}
+
+
+bool BertInstrumentManager::allIdle() const
+{
+    foreach (BertInstrument *instrument, instruments)
+    {
+        if (!instrument->isIdle()) return false;
+    }
+    return true;
+}
+
+
+void BertInstrumentManager::cancelAll()
+{
+    foreach (BertInstrument *instrument, instruments) instrument->cancel();
+}
+
+
+void BertInstrumentManager::instrumentOutput(int instrument, QJsonObject output)
+{
+    Q_UNUSED(instrument)
+    emit Output(output);
+}
+
+void BertInstrumentManager::instrumentIdle(int instrument, int result)
+{
+    emit InstrumentIdle(instrument, result);
+}
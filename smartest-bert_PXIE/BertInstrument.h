@@ -0,0 +1,275 @@
+/*!
+ \file   BertInstrument.h
+ \brief  Instrument Session - One BERT instrument driven without the UI,
+         and a manager for several instruments connected at once
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#ifndef BERTINSTRUMENT_H
+#define BERTINSTRUMENT_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QJsonObject>
+#include <QJsonArray>
+#include <QFile>
+#include <QTextStream>
+#include <QStringList>
+#include <QList>
+#include <QMap>
+
+#include "BertWorker.h"
+#include "BertPoller.h"
+#include "GT1724.h"
+#include "LMX2594.h"
+#include "EyeScanResult.h"
+#include "BertTestPlan.h"
+
+/*!
+ \brief Instrument Session
+ One BERT instrument (chassis): owns a BertWorker (with its own comms,
+ component set and status poller) and runs commands on it, in place of
+ the BertWindow UI. Commands are run one at a time; results are sent as
+ JSON objects with InstrumentOutput, and InstrumentIdle is emitted when
+ the instrument is ready for the next command.
+
+   ports                          List serial ports
+   connect [port]                 Connect and initialise (default: port at
+                                  this instrument's index in the port list)
+   disconnect                     Disconnect
+   profile <index>                Select LMX frequency profile, and resync PG
+   pattern <index>                Set PG pattern (all lanes)
+   ed <seconds> [pattern] [log]   Run the ED for a time on all ED lanes;
+                                  optionally also log readings to a binary file
+   edtarget <exp> [confidence]    Set ED confidence target for later ed runs:
+                                  BER < 1E-<exp> at confidence % (default 95).
+                                  Each lane stops as soon as it passes or fails,
+                                  and the run ends when all lanes have a verdict
+                                  (<seconds> is then the longest run). 0 = Off
+   eyescan <lane> [hStep] [vStep] [countRes]   Eye scan on ED lane (1, 3, ...)
+   bathtub <lane> [vOffset] [countRes]         Bathtub scan on ED lane
+   plan <file> [csv]              Run a test plan (sweep; see BertTestPlan):
+                                  set up each point, then make the plan's
+                                  measurements. Results are sent for each
+                                  point ("plan_point") and written to a CSV
+                                  file (default: <file>_<time>.csv); ED
+                                  readings also go to the ED measurement
+                                  log (<name>_ed.bin; see BertEDLog)
+   busprofile [file]              Append I2C bus profile report to a file
+                                  (default: BusProfile.txt in app directory)
+   busreset                       Clear I2C bus profile statistics
+   firmware [sim]                 Write and verify the GT firmware image in
+                                  the EEPROM (see M24M02::WriteFirmware).
+                                  "sim": Only if connected to the simulator;
+                                  skipped ("skipped": true) on a real board
+
+ Each command produces one output object with its result ("result" is a
+ globals:: code, 0 = OK) and the time the command took ("elapsedMs"; for
+ profile, not including the PG settle time). While the ED is running, an
+ "ed_sample" object is sent for each reading; the ED result includes the
+ reading rate. Option values are list indexes, as for the UI.
+ During a plan, only settings which change from one point to the next are
+ written, and the next point's settings are sent as soon as the last
+ measurement of a point finishes, so the I2C writes overlap the settle
+ time and the reporting of the finished point.
+ Nb: Connecting to port "SIM" uses the simulated adaptor (I2CSimulator),
+ so a script such as benchmark.txt can time the back end without hardware.
+*/
+class BertInstrument : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BertInstrument(int index, QObject *parent = nullptr);
+    ~BertInstrument();
+
+    int  getIndex() const { return index; }
+    bool isIdle() const   { return state == IDLE; }
+
+    void runCommand(const QStringList &command);
+    void cancel();
+
+    static const int CONNECT_TIMEOUT  = 70000;  // Max time for connect + init (ms)
+    static const int COMMAND_TIMEOUT  = 10000;  // Max time for most other commands (ms)
+    static const int EYESCAN_TIMEOUT  = 600000; // Max time for an eye / bathtub scan (ms)
+    static const int FIRMWARE_TIMEOUT = 300000; // Max time to write and verify EEPROM firmware (ms)
+    static const int PG_SETTLE_TIME   = 2000;   // Time allowed for PG resync after clock change (ms)
+    static const int ED_POLL_INTERVAL = 250;    // ED counter read interval (ms)
+    static const int ED_LOG_STATUS_INTERVAL = 1000;  // LOS / LOL read interval while logging the ED (ms)
+    static const int ED_LOG_TEMP_INTERVAL   = 5000;  // Core temperature read interval while logging the ED (ms)
+
+signals:
+    void InstrumentOutput(int instrument, QJsonObject output);
+    void InstrumentIdle(int instrument, int result);
+
+    // Signals for worker thread:
+    BERT_WORKER_SLOTS
+
+    // Signals for GT1724:
+    GT1724_SLOTS
+
+    // Signals for LMX Clock IC:
+    LMX2594_SLOTS
+
+    // Signals for EEPROM:
+    M24M02_SLOTS
+
+    // Signals for the status poller:
+    BERT_POLLER_SLOTS
+
+private slots:
+    // Signals from worker:
+    BERT_WORKER_SIGNALS
+
+    // General signals from device components:
+    BERT_COMPONENT_SIGNALS
+
+    // Signals from GT1724:
+    GT1724_SIGNALS
+
+    // Signals from LMX clock IC:
+    LMX2594_SIGNALS
+
+    // Signals from EEPROM:
+    M24M02_SIGNALS
+
+    // Signals from status poller:
+    BERT_POLLER_RESULT_SIGNALS
+
+    void commandTimeout();
+
+private:
+    enum CommandState
+    {
+        IDLE,
+        WAIT_PORTS,
+        WAIT_CONNECT,
+        WAIT_OPTIONS,
+        WAIT_INIT,
+        WAIT_DISCONNECT,
+        WAIT_PROFILE,
+        WAIT_SETTLE,
+        ED_RUNNING,
+        WAIT_EYESCAN,
+        WAIT_BUSPROFILE,
+        WAIT_FIRMWARE,
+        PLAN_SETUP,        // Plan: Waiting for a profile change
+        PLAN_SETTLE        // Plan: Settings sent, waiting to settle before measuring
+    };
+
+    typedef struct EDLaneResult_t
+    {
+        bool   locked = false;
+        double bitsTotal = 0.0;
+        double errorsTotal = 0.0;
+        int    verdict = EDConfidence::VERDICT_PENDING;
+        double confidence = 0.0;
+        qint64 elapsedMs = 0;       // Run time when the verdict was reached
+    } EDLaneResult_t;
+
+    void commandStart(CommandState state, int timeoutMs);
+    void commandDone(int result, QJsonObject output = QJsonObject());
+    void output(QJsonObject output);
+    void edStart(int seconds, int pattern, const QString &logFile);
+    void edStop(int result);
+    void edLogStatusPolling(bool enable);
+    void scanStart(int type, const QList<int> &params);
+    bool scanParamsValid(int type, const QList<int> &params) const;
+    bool edLaneValid(int lane) const;
+    void pgResync();
+
+    void planStart(const QString &fileName, const QString &csvFileName);
+    void planSetup();
+    void planApply(bool clockChanged);
+    void planMeasure();
+    void planMeasureDone(int result, QJsonObject output);
+    void planPointDone();
+    void planReportPoint(int point, const BertTestPlan::PlanPoint_t &settings, double pointBitRate,
+                         int errors, const QJsonArray &measurements);
+    void planFinish(int result);
+
+    const int index;
+    BertWorker *bertWorker = NULL;
+
+    CommandState state = IDLE;
+    QString commandName;
+    QTimer commandTimer;
+    QElapsedTimer commandClock;   // Time since the command started (for "elapsedMs")
+    QElapsedTimer measureClock;   // Time since the ED run or scan started (same as commandClock, except in a plan)
+
+    // Instrument state:
+    QStringList serialPorts;
+    QList<int> chipLanes;   // Lane offset of each GT1724 (0, 4, ...)
+    bool commsConnected = false;
+    bool commsSimulated = false;   // Last connect was to the simulated adaptor (port "SIM")
+    int eepromDeviceID = -1;   // -1: No EEPROM
+    int lmxProfileCount = 0;   // Size of the LMX frequency profile list (see ListPopulate)
+    double bitRate = 0.0;
+    int pgPattern = 0;
+
+    // ED run:
+    QMap<int, EDLaneResult_t> edResults;  // By ED lane
+    bool edLogging = false;
+    int edReadings = 0;                   // Count reading snapshots received
+    double edTargetBER = 0.0;             // Confidence target (see edtarget); 0 = Off
+    double edTargetConfidence = 0.95;
+
+    // Scan in progress:
+    int scanLane = 0;
+
+    // Test plan in progress:
+    BertTestPlan plan;
+    bool planActive = false;
+    int planPointIndex = 0;
+    int planMeasureIndex = 0;
+    int planErrors = 0;                     // Component errors while setting up / measuring this point
+    BertTestPlan::PlanPoint_t planSettings; // Settings written so far (-1 = Not written yet)
+    QJsonArray planPointResults;            // Measurement results for this point
+    QFile planLogFile;
+    QTextStream planLog;
+    QString planEDLogFileName;              // ED measurement log for the plan (see BertPoller)
+    qint64 planMeasureStartMs = 0;          // Start of the current measurement (ms since epoch)
+};
+
+
+/*!
+ \brief Instrument Manager
+ Owns a BertInstrument for each connected instrument (created on demand,
+ by index) and gives one control surface for all of them: commands are
+ sent to an instrument by index, and output from all instruments comes
+ out of one Output signal (each object has an "instrument" field).
+ Instruments run independently, so e.g. ED runs on several instruments
+ can proceed at once.
+ Nb: Instruments connected at the same time must be the same model
+ (see BertModel::AcquireModel).
+*/
+class BertInstrumentManager : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BertInstrumentManager(QObject *parent = nullptr);
+    ~BertInstrumentManager();
+
+    static const int MAX_INSTRUMENTS = 16;
+
+    int  runCommand(int index, const QStringList &command);
+    bool isIdle(int index) const;
+    bool allIdle() const;
+    void cancelAll();
+
+signals:
+    void Output(QJsonObject output);
+    void InstrumentIdle(int instrument, int result);
+
+private slots:
+    void instrumentOutput(int instrument, QJsonObject output);
+    void instrumentIdle(int instrument, int result);
+
+private:
+    QMap<int, BertInstrument *> instruments;
+};
+
+#endif // BERTINSTRUMENT_H
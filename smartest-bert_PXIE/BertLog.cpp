@@ -0,0 +1,415 @@
+/*!
+ \file   BertLog.cpp
+ \brief  Asynchronous Log - Lock-free message ring with a background writer
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <chrono>
+#include <cstdlib>
+#include <cstring>
+#include <stdio.h>
+#include <QThread>
+#include <QFile>
+#include <QDateTime>
+#include <QStringList>
+
+#include "globals.h"
+#include "BertLog.h"
+
+namespace
+{
+    const char *SUBSYSTEM_NAMES[BertLog::LOG_SUBSYSTEM_COUNT] =
+        { "general", "i2c", "register", "gt1724", "ed", "eyescan", "lmx", "eeprom" };
+    const char *LEVEL_NAMES[] =
+        { "off", "error", "warning", "info", "debug", "trace" };
+    const int LEVEL_COUNT = sizeof(LEVEL_NAMES) / sizeof(LEVEL_NAMES[0]);
+
+    /*!
+     \brief Ring slot
+     The sequence number says who may use the slot next (see BertLogRing).
+    */
+    struct BertLogEntry
+    {
+        std::atomic<quint64> sequence;
+        qint64   timeUs;
+        quintptr thread;
+        quint8   subsystem;
+        quint8   level;
+        quint16  length;
+        char     text[BertLog::MESSAGE_MAX];
+    };
+
+    /*!
+     \brief Bounded lock-free ring: Any number of writers, one reader
+     A slot is free for the writer claiming position n when its sequence
+     is n, and holds a message for the reader at position n when its
+     sequence is n + 1. The reader hands the slot back for the next lap
+     by setting its sequence to n + RING_SIZE.
+    */
+    class BertLogRing
+    {
+    public:
+        BertLogRing()
+        {
+            for (int i = 0; i < BertLog::RING_SIZE; i++) entries[i].sequence.store(static_cast<quint64>(i), std::memory_order_relaxed);
+        }
+
+        BertLogEntry *claim()
+        {
+            quint64 position = writeIndex.load(std::memory_order_relaxed);
+            for (;;)
+            {
+                BertLogEntry &entry = entries[position & MASK];
+                const qint64 diff = static_cast<qint64>(entry.sequence.load(std::memory_order_acquire) - position);
+                if (diff == 0)
+                {
+                    if (writeIndex.compare_exchange_weak(position, position + 1, std::memory_order_relaxed)) return &entry;
+                }
+                else if (diff < 0)
+                {
+                    dropped.fetch_add(1, std::memory_order_relaxed);   // Full
+                    return nullptr;
+                }
+                else
+                {
+                    position = writeIndex.load(std::memory_order_relaxed);
+                }
+            }
+        }
+
+        void publish(BertLogEntry *entry)
+        {
+            const quint64 position = entry->sequence.load(std::memory_order_relaxed);
+            entry->sequence.store(position + 1, std::memory_order_release);
+        }
+
+        // Reader only:
+        BertLogEntry *front()
+        {
+            BertLogEntry &entry = entries[readIndex & MASK];
+            if (entry.sequence.load(std::memory_order_acquire) != readIndex + 1) return nullptr;
+            return &entry;
+        }
+
+        void release(BertLogEntry *entry)
+        {
+            entry->sequence.store(readIndex + BertLog::RING_SIZE, std::memory_order_release);
+            readIndex++;
+        }
+
+        std::atomic<quint64> dropped { 0 };
+
+    private:
+        static const quint64 MASK = BertLog::RING_SIZE - 1;
+        BertLogEntry entries[BertLog::RING_SIZE];
+        std::atomic<quint64> writeIndex { 0 };
+        quint64 readIndex = 0;
+    };
+
+    /*!
+     \brief Log writer thread: Empties the ring every FLUSH_INTERVAL
+    */
+    class BertLogWriter : public QThread
+    {
+    public:
+        BertLogWriter(const QString &fileName, QtMessageHandler handler)
+         : fileName(fileName), handler(handler) {}
+
+        std::atomic<bool> stopRequested { false };
+
+        bool openFile()
+        {
+            if (fileName.isEmpty()) return true;
+            file.setFileName(fileName);
+            if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) return false;
+            file.write(QString("---- Log started %1 ----\n")
+                       .arg(QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss")).toUtf8());
+            return true;
+        }
+
+    protected:
+        void run() override
+        {
+            while (!stopRequested.load())
+            {
+                flush();
+                msleep(BertLog::FLUSH_INTERVAL);
+            }
+            flush();
+            if (file.isOpen()) file.close();
+        }
+
+    private:
+        void flush();
+
+        const QString fileName;
+        const QtMessageHandler handler;
+        QFile file;
+        quint64 droppedReported = 0;
+    };
+
+    BertLogRing ring;
+    BertLogWriter *writer = nullptr;
+    QtMessageHandler previousHandler = nullptr;
+    qint64 startTimeUs = 0;
+
+    qint64 nowUs()
+    {
+        return std::chrono::duration_cast<std::chrono::microseconds>(
+                   std::chrono::steady_clock::now().time_since_epoch()).count();
+    }
+
+    QtMsgType levelMessageType(const int level)
+    {
+        switch (level)
+        {
+        case BertLog::LEVEL_ERROR:   return QtCriticalMsg;
+        case BertLog::LEVEL_WARNING: return QtWarningMsg;
+        case BertLog::LEVEL_INFO:    return QtInfoMsg;
+        default:                     return QtDebugMsg;
+        }
+    }
+
+
+    /*!
+     \brief Pass messages in the ring on to the previous handler and the log file
+    */
+    void BertLogWriter::flush()
+    {
+        const QMessageLogContext context;
+        BertLogEntry *entry;
+        while ((entry = ring.front()) != nullptr)
+        {
+            const QString message = QString::fromUtf8(entry->text, entry->length);
+            if (handler) handler(levelMessageType(entry->level), context, message);
+            if (file.isOpen())
+            {
+                file.write(QString("%1 %2 [%3] %4\n")
+                           .arg(static_cast<double>(entry->timeUs - startTimeUs) / 1e6, 12, 'f', 6)
+                           .arg(static_cast<qulonglong>(entry->thread), 0, 16)
+                           .arg(SUBSYSTEM_NAMES[entry->subsystem])
+                           .arg(message).toUtf8());
+            }
+            ring.release(entry);
+        }
+        const quint64 dropped = ring.dropped.load(std::memory_order_relaxed);
+        if (dropped != droppedReported)
+        {
+            const QString message = QString("BertLog: %1 messages dropped (log ring full)").arg(dropped - droppedReported);
+            if (handler) handler(QtWarningMsg, context, message);
+            if (file.isOpen()) file.write((message + "\n").toUtf8());
+            droppedReported = dropped;
+        }
+        if (file.isOpen()) file.flush();
+    }
+}
+
+
+// Default levels: See class description.
+std::atomic<int> BertLog::levels[LOG_SUBSYSTEM_COUNT] =
+{
+    { LEVEL_DEBUG },   // LOG_GENERAL
+  #ifdef BERT_I2C_EXTRA_DEBUG
+    { LEVEL_TRACE },   // LOG_I2C
+  #elif defined(BERT_I2C_DEBUG)
+    { LEVEL_DEBUG },
+  #else
+    { LEVEL_INFO },
+  #endif
+  #ifdef BERT_REGISTER_DEBUG
+    { LEVEL_TRACE },   // LOG_REGISTER
+  #else
+    { LEVEL_INFO },
+  #endif
+    { LEVEL_DEBUG },   // LOG_GT1724
+  #ifdef BERT_ED_DEBUG
+    { LEVEL_DEBUG },   // LOG_ED
+  #else
+    { LEVEL_INFO },
+  #endif
+    { LEVEL_INFO },    // LOG_EYESCAN
+    { LEVEL_DEBUG },   // LOG_LMX
+  #ifdef BERT_EEPROM_DEBUG
+    { LEVEL_DEBUG }    // LOG_EEPROM
+  #else
+    { LEVEL_INFO }
+  #endif
+};
+
+
+/*!
+ \brief Add a message to the log
+ Nb: Use BERT_LOG, so that messages are only formatted if they will be
+     logged. Safe to call from any thread; never blocks.
+ \param subsystem  BertLog::LOG_xxx
+ \param level      BertLog::LEVEL_xxx
+ \param message    Message text
+*/
+void BertLog::write(const int subsystem, const int level, const QString &message)
+{
+    Q_ASSERT(subsystem >= 0 && subsystem < LOG_SUBSYSTEM_COUNT);
+    BertLogEntry *entry = ring.claim();
+    if (!entry) return;
+    const QByteArray text = message.toUtf8();
+    const int length = qMin(text.size(), static_cast<int>(MESSAGE_MAX));
+    memcpy(entry->text, text.constData(), static_cast<size_t>(length));
+    entry->length = static_cast<quint16>(length);
+    entry->timeUs = nowUs();
+    entry->thread = reinterpret_cast<quintptr>(QThread::currentThreadId());
+    entry->subsystem = static_cast<quint8>(subsystem);
+    entry->level = static_cast<quint8>(level);
+    ring.publish(entry);
+}
+
+
+void BertLog::setLevel(const int subsystem, const int level)
+{
+    if (subsystem < 0 || subsystem >= LOG_SUBSYSTEM_COUNT) return;
+    levels[subsystem].store(qBound(static_cast<int>(LEVEL_OFF), level, static_cast<int>(LEVEL_TRACE)), std::memory_order_relaxed);
+}
+
+int BertLog::getLevel(const int subsystem)
+{
+    if (subsystem < 0 || subsystem >= LOG_SUBSYSTEM_COUNT) return LEVEL_OFF;
+    return levels[subsystem].load(std::memory_order_relaxed);
+}
+
+
+/*!
+ \brief Set levels from a text spec
+ \param spec  Comma separated list of subsystem=level, e.g. "i2c=trace,eyescan=debug".
+              Subsystem "all" sets every subsystem. Names as for getLevels.
+ \return globals::OK
+ \return globals::INVALID_DATA  Unknown subsystem or level (levels before
+                                 the bad entry are still set)
+*/
+int BertLog::configure(const QString &spec)
+{
+    foreach (const QString &item, spec.split(',', QString::SkipEmptyParts))
+    {
+        const QString name = item.section('=', 0, 0).trimmed().toLower();
+        const int level = parseLevel(item.section('=', 1).trimmed().toLower());
+        if (level < 0) return globals::INVALID_DATA;
+        if (name == "all")
+        {
+            for (int i = 0; i < LOG_SUBSYSTEM_COUNT; i++) setLevel(i, level);
+            continue;
+        }
+        const int subsystem = parseSubsystem(name);
+        if (subsystem < 0) return globals::INVALID_DATA;
+        setLevel(subsystem, level);
+    }
+    return globals::OK;
+}
+
+
+/*!
+ \brief Get the current levels, in the format used by configure
+*/
+QString BertLog::getLevels()
+{
+    QStringList items;
+    for (int i = 0; i < LOG_SUBSYSTEM_COUNT; i++) items.append(QString("%1=%2").arg(SUBSYSTEM_NAMES[i]).arg(LEVEL_NAMES[getLevel(i)]));
+    return items.join(',');
+}
+
+
+/*!
+ \brief Get the number of messages dropped because the ring was full
+*/
+quint64 BertLog::getDropped()
+{
+    return ring.dropped.load(std::memory_order_relaxed);
+}
+
+
+/*!
+ \brief Start the writer thread, and send qDebug() etc. through the log
+ Messages are written to the message handler which was installed before
+ start (e.g. the debugOutput console handler), and to fileName if set.
+ \param fileName  Log file (appended to); empty for no log file
+ \return globals::OK
+ \return globals::FILE_ERROR  Couldn't open log file (log is still started, without file)
+*/
+int BertLog::start(const QString &fileName)
+{
+    if (writer) return globals::OK;   // Already started
+    startTimeUs = nowUs();
+    previousHandler = qInstallMessageHandler(messageHandler);
+    writer = new BertLogWriter(fileName, previousHandler);
+    int result = globals::OK;
+    if (!writer->openFile())
+    {
+        result = globals::FILE_ERROR;
+        write(LOG_GENERAL, LEVEL_ERROR, QString("BertLog: Couldn't open log file %1").arg(fileName));
+    }
+    writer->start(QThread::LowPriority);
+    return result;
+}
+
+
+/*!
+ \brief Write out any messages still in the ring, and stop the writer
+ qDebug() etc. go back to the previous message handler.
+*/
+void BertLog::stop()
+{
+    if (!writer || QThread::currentThread() == writer) return;
+    qInstallMessageHandler(previousHandler);
+    writer->stopRequested.store(true);
+    writer->wait();
+    delete writer;
+    writer = nullptr;
+}
+
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+/*!
+ \brief Qt message handler: Queue qDebug() etc. as LOG_GENERAL messages
+ Fatal messages are written straight away (after the queue) as the
+ previous handler will abort.
+*/
+void BertLog::messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message)
+{
+    int level = LEVEL_DEBUG;
+    switch (type)
+    {
+    case QtDebugMsg:    level = LEVEL_DEBUG;   break;
+    case QtInfoMsg:     level = LEVEL_INFO;    break;
+    case QtWarningMsg:  level = LEVEL_WARNING; break;
+    case QtCriticalMsg: level = LEVEL_ERROR;   break;
+    default:
+    {
+        QtMessageHandler handler = previousHandler;
+        stop();
+        if (handler) handler(type, context, message);
+        else         fprintf(stderr, "%s\n", message.toLocal8Bit().constData());
+        abort();
+    }
+    }
+    if (enabled(LOG_GENERAL, level)) write(LOG_GENERAL, level, message);
+}
+
+
+int BertLog::parseSubsystem(const QString &name)
+{
+    for (int i = 0; i < LOG_SUBSYSTEM_COUNT; i++)
+    {
+        if (name == SUBSYSTEM_NAMES[i]) return i;
+    }
+    return -1;
+}
+
+
+int BertLog::parseLevel(const QString &name)
+{
+    for (int i = 0; i < LEVEL_COUNT; i++)
+    {
+        if (name == LEVEL_NAMES[i]) return i;
+    }
+    return -1;
+}
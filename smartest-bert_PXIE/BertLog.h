@@ -0,0 +1,109 @@
+/*!
+ \file   BertLog.h
+ \brief  Asynchronous Log - Lock-free message ring with a background writer
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#ifndef BERTLOG_H
+#define BERTLOG_H
+
+#include <QString>
+#include <QDebug>
+#include <QtGlobal>
+#include <atomic>
+
+/*!
+ \brief Log a message for a subsystem, if the subsystem's level allows it
+ MSG is streamed as for qDebug(), e.g.
+   BERT_LOG(LOG_I2C, LEVEL_TRACE, "Write " << nBytes << " bytes")
+ If the level is off, the cost is one atomic load (MSG isn't evaluated).
+*/
+#define BERT_LOG(SUBSYSTEM, LEVEL, MSG)                                            \
+    do {                                                                           \
+        if (BertLog::enabled(BertLog::SUBSYSTEM, BertLog::LEVEL))                 \
+        {                                                                          \
+            QString bertLogMessage;                                                \
+            QDebug(&bertLogMessage) << MSG;                                        \
+            BertLog::write(BertLog::SUBSYSTEM, BertLog::LEVEL, bertLogMessage);   \
+        }                                                                          \
+    } while (0);
+
+/*!
+ \brief Asynchronous Log
+
+ Messages are formatted by whichever thread logs them (BERT_LOG builds a
+ QString, which allocates, then converts it to UTF-8) and copied into a
+ fixed-size ring (no locks; the ring itself never allocates). A
+ background writer thread takes them out every FLUSH_INTERVAL and passes them on to the previous Qt message
+ handler (console / debugger, or the debugOutput handler in main.cpp)
+ and, optionally, a log file. So logging never waits for console or file
+ output, and debug output can stay on without slowing acquisition or the
+ UI. If the ring fills up, new messages are dropped and counted (a
+ "messages dropped" line is written when space is available again).
+
+ Once started, qDebug() etc. also go through the ring (as LOG_GENERAL).
+ Each subsystem has its own level, which can be changed at any time
+ (setLevel, configure). Messages above the subsystem's level are not
+ formatted at all (see BERT_LOG).
+
+ The default levels keep the output the same as before: subsystems whose
+ debug output used to be compiled out (e.g. I2C, registers) default to
+ LEVEL_INFO unless the matching BERT_xxx_DEBUG flag is defined for the
+ build (see main.cpp).
+*/
+class BertLog
+{
+public:
+    enum Subsystem
+    {
+        LOG_GENERAL,     // qDebug() etc.
+        LOG_I2C,         // I2C comms (per transaction)
+        LOG_REGISTER,    // GT1724 register read / write
+        LOG_GT1724,      // GT1724 general
+        LOG_ED,          // Error detector
+        LOG_EYESCAN,     // Eye / bathtub scans
+        LOG_LMX,         // LMX clock synth
+        LOG_EEPROM,      // M24M02 EEPROM
+        LOG_SUBSYSTEM_COUNT
+    };
+
+    enum Level
+    {
+        LEVEL_OFF,
+        LEVEL_ERROR,
+        LEVEL_WARNING,
+        LEVEL_INFO,
+        LEVEL_DEBUG,
+        LEVEL_TRACE
+    };
+
+    static const int RING_SIZE      = 4096;   // Messages (power of 2)
+    static const int MESSAGE_MAX    = 240;    // Longest message kept (bytes of UTF-8; longer messages are cut)
+    static const int FLUSH_INTERVAL = 50;     // Writer thread interval (ms)
+
+    static inline bool enabled(const int subsystem, const int level)
+    {
+        return level <= levels[subsystem].load(std::memory_order_relaxed);
+    }
+
+    static void write(const int subsystem, const int level, const QString &message);
+
+    static void setLevel(const int subsystem, const int level);
+    static int  getLevel(const int subsystem);
+    static int  configure(const QString &spec);
+    static QString getLevels();
+    static quint64 getDropped();
+
+    static int  start(const QString &fileName = QString());
+    static void stop();
+
+private:
+    static std::atomic<int> levels[LOG_SUBSYSTEM_COUNT];
+
+    static void messageHandler(QtMsgType type, const QMessageLogContext &context, const QString &message);
+    static int  parseSubsystem(const QString &name);
+    static int  parseLevel(const QString &name);
+};
+
+#endif // BERTLOG_H
@@ -6,6 +6,7 @@
 */
 
 #include "BertModel.h"
+#include "globals.h"
 #include <QDebug>
 
 const QString BertModel::BUILD_VERSION = QString( "3.4.5" );
@@ -64,6 +65,9 @@ const QStringList BertModel::BERT_FIRMWARES =
 // Defaults:
 QString BertModel::modelCode = "Unknown";
 
+int BertModel::modelUsers = 0;
+QMutex BertModel::modelMutex;
+
 // For all models: Define only ONE EEPROM IC, base address 0x50:
 QList<uint8_t> BertModel::i2cAddresses_M24M02   = { 0x50 };  // If slave board were present, second EEPROM would appear at 0x54.
 
@@ -165,6 +169,51 @@ bool BertModel::SelectModel(const QString &code)
 }
 
 
+/*!
+ \brief Select Bert Model for a connected instrument
+  The model settings (I2C addresses, etc) are shared by all instruments,
+  so when several instruments are connected at once (one BertWorker each),
+  they must all be the same model. The first instrument to connect selects
+  the model (see SelectModel); others must match it. Call ReleaseModel
+  when the instrument disconnects.
+  Nb: Thread safe; may be called from each worker thread.
+
+ \param code  Model code read from the instrument EEPROM
+ \return globals::OK             Model selected (or already selected)
+ \return globals::UNKNOWN_MODEL  Model not found; 'NONE' selected
+ \return globals::BUSY_ERROR     A different model is in use by another
+                                 instrument. Model NOT acquired.
+*/
+int BertModel::AcquireModel(const QString &code)
+{
+    QMutexLocker locker(&modelMutex);
+    if (modelUsers > 0)
+    {
+        if (code != modelCode)
+        {
+            qDebug() << "Model " << code << " doesn't match model in use (" << modelCode << ", "
+                     << modelUsers << " instruments)";
+            return globals::BUSY_ERROR;
+        }
+        modelUsers++;
+        return globals::OK;
+    }
+    bool validModel = SelectModel(code);
+    modelUsers = 1;
+    return validModel ? globals::OK : globals::UNKNOWN_MODEL;
+}
+
+
+/*!
+ \brief Release the model selected by AcquireModel
+*/
+void BertModel::ReleaseModel()
+{
+    QMutexLocker locker(&modelMutex);
+    if (modelUsers > 0) modelUsers--;
+}
+
+
 // DEPRECATED
 
 // Define the following for SLAVE TEST mode: This simulates a master and slave using only
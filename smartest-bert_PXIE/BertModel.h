@@ -12,6 +12,7 @@
 #include <QStringList>
 #include <QList>
 #include <QString>
+#include <QMutex>
 
 class BertModel
 {
@@ -19,6 +20,10 @@ public:
 
     static bool SelectModel(const QString &code);
 
+    // Model selection for connected instruments (see AcquireModel):
+    static int  AcquireModel(const QString &code);
+    static void ReleaseModel();
+
     // Available model codes (for displaying list of factory options to write to EEPROM)
     static const QStringList BERT_MODELS;
     static const QStringList BERT_FIRMWARES;
@@ -46,6 +51,10 @@ private:
     // Selected Model
     static QString modelCode;
 
+    // Number of connected instruments using the selected model (see AcquireModel):
+    static int modelUsers;
+    static QMutex modelMutex;
+
     // Component I2C Addresses:
     static QList<uint8_t> i2cAddresses_GT1724;  // GetI2CAddresses_GT1724;
     static QList<uint8_t> i2cAddresses_LMX2594;
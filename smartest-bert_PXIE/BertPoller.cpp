@@ -0,0 +1,324 @@
+/*!
+ \file   BertPoller.cpp
+ \brief  Status Poller - Back end scheduler for periodic ED / status reads
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <QDebug>
+#include <QFileInfo>
+
+#include "globals.h"
+#include "BertLog.h"
+#include "BertPoller.h"
+
+// Poller debug: Goes through the ED log subsystem (e.g. "--log ed=debug"):
+#define DEBUG_POLLER(MSG) BERT_LOG(LOG_ED, LEVEL_DEBUG, "\t" << MSG)
+
+
+BertPoller::BertPoller(QObject *parent)
+ : QObject(parent), pollTimer(this)
+{
+    // ED count: Allow a second snapshot to be queued while the first is being read,
+    // so that a slow read doesn't cause a missed update:
+    metrics[POLL_ED_COUNT].maxPending = 2;
+
+    pollClock.start();
+    pollTimer.setInterval(POLL_TICK_MS);
+    connect(&pollTimer, SIGNAL(timeout()), this, SLOT(pollTick()));
+    pollTimer.start();
+}
+
+BertPoller::~BertPoller()
+{
+    pollTimer.stop();
+    edLog.close();
+    foreach (BertEDLogExport *exporter, edLogExports) exporter->wait();   // Nb: Deleted as children
+}
+
+
+/*!
+ \brief Add a GT1724 to be polled
+ Connects the poll request signals to the chip, and its results back
+ to the poller so that outstanding requests can be tracked.
+ \param gt1724  GT1724 object (may be running on another thread)
+*/
+void BertPoller::addGT1724(GT1724 *gt1724)
+{
+    connect(this,   SIGNAL(GetEDCountSnapshot(int, double)), gt1724, SLOT(GetEDCountSnapshot(int, double)));
+    connect(this,   SIGNAL(GetLosLol(int)),                  gt1724, SLOT(GetLosLol(int)));
+    connect(this,   SIGNAL(GetTemperature(int)),             gt1724, SLOT(GetTemperature(int)));
+    connect(this,   SIGNAL(EDStopLane(int)),                 gt1724, SLOT(EDStopLane(int)));
+    connect(gt1724, SIGNAL(EDCountSnapshot(int, qint64, QList<EDCountReading_t>)),
+                                                             this,   SLOT(EDCountSnapshot(int, qint64, QList<EDCountReading_t>)));
+    connect(gt1724, SIGNAL(EDLosLol(int, bool, bool)),       this,   SLOT(EDLosLol(int, bool, bool)));
+    connect(gt1724, SIGNAL(UIUpdate(QList<BertUIUpdate_t>)), this,   SLOT(UIUpdate(QList<BertUIUpdate_t>)));
+}
+
+
+/*!
+ \brief Add a PCA9557A to be polled (LMX lock detect)
+*/
+void BertPoller::addPCA9557A(PCA9557A *pca9557a)
+{
+    connect(this, SIGNAL(ReadLMXLockDetect()), pca9557a, SLOT(ReadLMXLockDetect()));
+}
+
+
+/*!
+ \brief Forget about outstanding requests
+ Called when components are removed (e.g. on disconnect). Nb: Signal
+ connections are removed automatically when the components are deleted.
+*/
+void BertPoller::clearComponents()
+{
+    for (int metric = 0; metric < POLL_METRIC_COUNT; metric++)
+    {
+        metrics[metric].pending.clear();
+        metrics[metric].issuedMs.clear();
+    }
+    edLaneStatus.clear();
+    coreTemps.clear();
+    edVerdicts.clear();
+    edChipLanes.clear();
+    EDLogStop();  // Close and export the ED log if it was running
+}
+
+
+/*!
+ \brief Set poll interval for a metric
+ \param metric      POLL_ED_COUNT, etc
+ \param intervalMs  Interval between polls (ms). 0 = Don't poll.
+*/
+void BertPoller::PollerSetInterval(int metric, int intervalMs)
+{
+    Q_ASSERT(metric >= 0 && metric < POLL_METRIC_COUNT);
+    if (metric < 0 || metric >= POLL_METRIC_COUNT) return;
+    PollMetric_t &m = metrics[metric];
+    if (intervalMs < 0) intervalMs = 0;
+    if (m.intervalMs == 0 && intervalMs > 0) m.lastPollMs = -1;  // Newly enabled: Poll on next tick
+    m.intervalMs = intervalMs;
+    DEBUG_POLLER("BertPoller: Metric " << metric << " interval: " << intervalMs << " ms")
+}
+
+
+/*!
+ \brief Set targets (chips) for a per-chip metric
+ \param metric  POLL_ED_COUNT or POLL_LOS_LOL
+ \param lanes   Lane offsets of GT1724 chips to poll (0, 4, ...)
+*/
+void BertPoller::PollerSetTargets(int metric, QList<int> lanes)
+{
+    Q_ASSERT(metric >= 0 && metric < POLL_METRIC_COUNT);
+    if (metric < 0 || metric >= POLL_METRIC_COUNT) return;
+    PollMetric_t &m = metrics[metric];
+    m.targets = lanes;
+    m.pending.clear();   // New target list: Don't wait for results of requests under the old list
+    m.issuedMs.clear();
+    m.lastPollMs = -1;
+    DEBUG_POLLER("BertPoller: Metric " << metric << " targets: " << lanes)
+}
+
+
+void BertPoller::PollerSetBitRate(double bitRate)
+  {  this->bitRate = bitRate;  }
+
+
+/*!
+ \brief Start logging ED readings to a binary log file
+ Emits EDLogStatus with an error code if the file can't be created.
+ \param fileName  Log file to create
+*/
+void BertPoller::EDLogStart(QString fileName)
+{
+    int result = edLog.open(fileName);
+    if (result != globals::OK) emit EDLogStatus(result, fileName, 0);
+}
+
+
+/*!
+ \brief Stop logging ED readings
+ Closes the log file, then starts exporting it to a CSV file with the same
+ name. The export runs on its own thread (see BertEDLogExport); once it has
+ finished, EDLogStatus is emitted with the result and the name of the CSV file.
+*/
+void BertPoller::EDLogStop()
+{
+    if (!edLog.isOpen()) return;
+    const QString logFileName = edLog.getFileName();
+    edLog.close();
+    QFileInfo logInfo(logFileName);
+    const QString csvFileName = logInfo.path() + "/" + logInfo.completeBaseName() + ".csv";
+    BertEDLogExport *exporter = new BertEDLogExport(logFileName, csvFileName, this);
+    connect(exporter, SIGNAL(finished()), this, SLOT(EDLogExportFinished()));
+    edLogExports.append(exporter);
+    exporter->start(QThread::LowPriority);
+}
+
+
+/*!
+ \brief Private Slot: An ED log export (see EDLogStop) has finished
+*/
+void BertPoller::EDLogExportFinished()
+{
+    BertEDLogExport *exporter = qobject_cast<BertEDLogExport *>(sender());
+    if (!exporter || !edLogExports.contains(exporter)) return;
+    edLogExports.removeAll(exporter);
+    emit EDLogStatus(exporter->getResult(), exporter->getCSVFileName(), exporter->getRecordCount());
+    exporter->deleteLater();
+}
+
+
+/*!
+ \brief Set the ED confidence target
+ Lanes are judged from the next reading on; any verdicts from an
+ earlier run are forgotten (call this when the ED is started).
+ \param targetBER        Target BER (e.g. 1e-12); 0 = Off (ED runs until stopped)
+ \param confidenceLevel  Confidence needed for a verdict (0.5 to 1, e.g. 0.95)
+*/
+void BertPoller::EDSetConfidenceTarget(double targetBER, double confidenceLevel)
+{
+    edTargetBER = (targetBER > 0.0) ? targetBER : 0.0;
+    edTargetConfidence = qBound(0.5, confidenceLevel, 0.999999);
+    edVerdicts.clear();
+    edChipLanes.clear();
+    DEBUG_POLLER("BertPoller: ED confidence target: BER " << edTargetBER << " at " << edTargetConfidence)
+}
+
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+/*!
+ \brief Scheduler tick: Issue any polls which are due
+*/
+void BertPoller::pollTick()
+{
+    const qint64 nowMs = pollClock.elapsed();
+    for (int metric = 0; metric < POLL_METRIC_COUNT; metric++)
+    {
+        PollMetric_t &m = metrics[metric];
+        if (m.intervalMs <= 0) continue;
+        if (m.lastPollMs >= 0 && (nowMs - m.lastPollMs) < m.intervalMs) continue;
+        m.lastPollMs = nowMs;
+
+        switch (metric)
+        {
+        case POLL_ED_COUNT:
+        case POLL_LOS_LOL:
+            foreach (int chipLane, m.targets)
+            {
+                // A component doesn't send a result if its read fails (e.g. GetLosLol);
+                // don't wait for ever, or the chip would never be polled again:
+                if (m.pending.value(chipLane, 0) >= m.maxPending
+                 && (nowMs - m.issuedMs.value(chipLane, nowMs)) >= POLL_PENDING_TIMEOUT_MS)
+                {
+                    DEBUG_POLLER("BertPoller: Metric " << metric << ": No result from chip " << chipLane << "; request dropped")
+                    m.pending.remove(chipLane);
+                }
+                // Coalesce: Don't add more requests for a chip which is still busy:
+                if (m.pending.value(chipLane, 0) >= m.maxPending) continue;
+                if (metric == POLL_ED_COUNT && edChipDecided(chipLane)) continue;
+                m.pending[chipLane]++;
+                m.issuedMs[chipLane] = nowMs;
+                if (metric == POLL_ED_COUNT) emit GetEDCountSnapshot(chipLane, bitRate);
+                else                         emit GetLosLol(chipLane);
+            }
+            break;
+        case POLL_TEMPERATURE:
+            emit GetTemperature(globals::ALL_LANES);
+            break;
+        case POLL_LMX_LOCK:
+            emit ReadLMXLockDetect();
+            break;
+        }
+    }
+    // Write buffered ED log records to disk (only if the flush interval has passed):
+    if (edLog.flush() != globals::OK)
+    {
+        emit EDLogStatus(globals::FILE_ERROR, edLog.getFileName(), edLog.getRecordCount());
+        edLog.close();
+    }
+}
+
+
+// Results from components: Update outstanding request counts.
+void BertPoller::EDCountSnapshot(int metaLane, qint64 timestamp, QList<EDCountReading_t> readings)
+{
+    QMap<int, int> &pending = metrics[POLL_ED_COUNT].pending;
+    if (pending.value(metaLane, 0) > 0) pending[metaLane]--;
+
+    // Judge each undecided lane against the confidence target:
+    if (edTargetBER > 0.0)
+    {
+        foreach (const EDCountReading_t &reading, readings)
+        {
+            QList<int> &chipLanes = edChipLanes[metaLane];
+            if (!chipLanes.contains(reading.lane)) chipLanes.append(reading.lane);
+            if (!reading.locked || edVerdicts.contains(reading.lane)) continue;
+            double confidence = 0.0;
+            const int verdict = EDConfidence::verdict(reading.bitsTotal, reading.errorsTotal,
+                                                      edTargetBER, edTargetConfidence, &confidence);
+            if (verdict != EDConfidence::VERDICT_PENDING)
+            {
+                edVerdicts[reading.lane] = verdict;
+                emit EDStopLane(reading.lane);
+            }
+            emit EDConfidenceUpdate(reading.lane, verdict, confidence, reading.bitsTotal, reading.errorsTotal);
+        }
+    }
+
+    if (!edLog.isOpen()) return;
+    EDLogRecord_t record;
+    record.timestamp = timestamp;
+    record.coreTemp = static_cast<qint16>(coreTemps.value(metaLane, 0));
+    foreach (const EDCountReading_t &reading, readings)
+    {
+        record.lane = reading.lane;
+        record.flags = edLaneStatus.value(reading.lane, 0);
+        if (reading.locked) record.flags |= BertEDLog::EDLOG_FLAG_LOCKED;
+        if (coreTemps.contains(metaLane)) record.flags |= BertEDLog::EDLOG_FLAG_TEMP_VALID;
+        record.bits = reading.bits;
+        record.bitsTotal = reading.bitsTotal;
+        record.errors = reading.errors;
+        record.errorsTotal = reading.errorsTotal;
+        if (edLog.append(record) != globals::OK)
+        {
+            emit EDLogStatus(globals::FILE_ERROR, edLog.getFileName(), edLog.getRecordCount());
+            edLog.close();
+            return;
+        }
+    }
+}
+
+/*!
+ \brief Check whether all ED lanes on a chip have a verdict
+ Only applies when a confidence target is set, and once the chip has
+ sent readings (so the lanes which are running are known).
+*/
+bool BertPoller::edChipDecided(int chipLane) const
+{
+    if (edTargetBER <= 0.0 || !edChipLanes.contains(chipLane)) return false;
+    foreach (int lane, edChipLanes.value(chipLane))
+    {
+        if (!edVerdicts.contains(lane)) return false;
+    }
+    return true;
+}
+
+void BertPoller::EDLosLol(int lane, bool los, bool lol)
+{
+    edLaneStatus[lane] = (los ? BertEDLog::EDLOG_FLAG_LOS : 0) | (lol ? BertEDLog::EDLOG_FLAG_LOL : 0);
+    // Nb: One GetLosLol request produces an EDLosLol signal for each ED lane on the chip.
+    metrics[POLL_LOS_LOL].pending.remove((lane / 4) * 4);
+}
+
+void BertPoller::UIUpdate(QList<BertUIUpdate_t> updates)
+{
+    // Core temperature (see GT1724::GetTemperature): Value is in degrees C
+    for (const BertUIUpdate_t &update : updates)
+    {
+        if (update.item == BertComponent::UI_CORE_TEMPERATURE) coreTemps[(update.lane / 4) * 4] = update.value;
+    }
+}
@@ -0,0 +1,152 @@
+/*!
+ \file   BertPoller.h
+ \brief  Status Poller - Back end scheduler for periodic ED / status reads
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#ifndef BERTPOLLER_H
+#define BERTPOLLER_H
+
+#include <QObject>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QList>
+#include <QMap>
+
+#include "GT1724.h"
+#include "PCA9557A.h"
+#include "BertFile.h"
+#include "EDConfidence.h"
+
+/*!
+ \brief Status Poller
+ Runs on the worker thread and issues the periodic hardware reads which
+ used to be driven by the UI update timer: ED counter snapshots, LOS / LOL
+ status, core temperature and LMX lock detect. Results are sent to the UI
+ by the components' own signals (EDCountSnapshot, EDLosLol, etc), so the UI
+ only has to render them; UI repaint delays (or a minimised window) don't
+ change the acquisition rate.
+
+ Each metric has its own poll interval and list of targets (GT1724 lane
+ offsets), both set by the client:
+   PollerSetInterval(metric, intervalMs)  - 0 disables the metric
+   PollerSetTargets(metric, lanes)        - lane offsets of GT1724s to poll
+   PollerSetBitRate(bitRate)              - bit rate used for ED counts
+ Requests are coalesced per chip: a new request is not issued for a chip
+ while the maximum number of requests for that chip are still outstanding.
+
+ ED Log: If started (EDLogStart), every ED count reading is also written
+ to a binary log file (see BertEDLog), with the last LOS / LOL status and
+ core temperature read for the lane. EDLogStop closes the log and exports
+ it to CSV (same name, ".csv") on a separate thread (BertEDLogExport), so
+ the I2C components sharing this thread aren't held up; the result is sent
+ with EDLogStatus when the export has finished.
+
+ ED Confidence Target: If set (EDSetConfidenceTarget), each ED reading
+ is judged against the target BER (see EDConfidence), and the result is
+ sent with EDConfidenceUpdate. As soon as a lane passes or fails, its ED
+ is no longer read (EDStopLane), and chips with no undecided lanes are
+ no longer polled, so the bus is left to the lanes still running.
+*/
+class BertPoller : public QObject
+{
+    Q_OBJECT
+
+public:
+    explicit BertPoller(QObject *parent = nullptr);
+    ~BertPoller();
+
+    // Metrics:
+    static const int POLL_ED_COUNT    = 0;  // GetEDCountSnapshot for each target chip
+    static const int POLL_LOS_LOL     = 1;  // GetLosLol for each target chip
+    static const int POLL_TEMPERATURE = 2;  // GetTemperature (all lanes)
+    static const int POLL_LMX_LOCK    = 3;  // ReadLMXLockDetect
+    static const int POLL_METRIC_COUNT = 4;
+
+    static const int POLL_TICK_MS = 25;     // Scheduler resolution
+    static const int POLL_PENDING_TIMEOUT_MS = 2000;  // Per-chip request with no result after this long is given up
+
+    void addGT1724(GT1724 *gt1724);
+    void addPCA9557A(PCA9557A *pca9557a);
+    void clearComponents();
+
+#define BERT_POLLER_SIGNALS \
+    void GetEDCountSnapshot(int metaLane, double bitRate); \
+    void GetLosLol(int metaLane);                          \
+    void GetTemperature(int metaLane);                     \
+    void ReadLMXLockDetect();                              \
+    void EDStopLane(int lane);
+
+#define BERT_POLLER_RESULT_SIGNALS \
+    void EDLogStatus(int result, QString fileName, quint64 records);      \
+    void EDConfidenceUpdate(int lane, int verdict, double confidence,   \
+                            double bitsTotal, double errorsTotal);
+
+#define BERT_POLLER_SLOTS \
+    void PollerSetInterval(int metric, int intervalMs);    \
+    void PollerSetTargets(int metric, QList<int> lanes);   \
+    void PollerSetBitRate(double bitRate);                 \
+    void EDLogStart(QString fileName);                     \
+    void EDLogStop();                                      \
+    void EDSetConfidenceTarget(double targetBER, double confidenceLevel);
+
+#define BERT_POLLER_CONNECT_SIGNALS(CLIENT, POLLER) \
+    connect(POLLER, SIGNAL(EDLogStatus(int, QString, quint64)), CLIENT, SLOT(EDLogStatus(int, QString, quint64))); \
+    connect(POLLER, SIGNAL(EDConfidenceUpdate(int, int, double, double, double)),                                 \
+                                                              CLIENT, SLOT(EDConfidenceUpdate(int, int, double, double, double))); \
+    connect(CLIENT, SIGNAL(EDSetConfidenceTarget(double, double)), POLLER, SLOT(EDSetConfidenceTarget(double, double))); \
+    connect(CLIENT, SIGNAL(EDLogStart(QString)),              POLLER, SLOT(EDLogStart(QString)));              \
+    connect(CLIENT, SIGNAL(EDLogStop()),                      POLLER, SLOT(EDLogStop()));                      \
+    connect(CLIENT, SIGNAL(PollerSetInterval(int, int)),      POLLER, SLOT(PollerSetInterval(int, int)));      \
+    connect(CLIENT, SIGNAL(PollerSetTargets(int, QList<int>)), POLLER, SLOT(PollerSetTargets(int, QList<int>))); \
+    connect(CLIENT, SIGNAL(PollerSetBitRate(double)),         POLLER, SLOT(PollerSetBitRate(double)));
+
+signals:
+    BERT_POLLER_SIGNALS
+    BERT_POLLER_RESULT_SIGNALS
+
+public slots:
+    BERT_POLLER_SLOTS
+
+private slots:
+    void pollTick();
+    void EDCountSnapshot(int metaLane, qint64 timestamp, QList<EDCountReading_t> readings);
+    void EDLosLol(int lane, bool los, bool lol);
+    void UIUpdate(QList<BertUIUpdate_t> updates);
+    void EDLogExportFinished();
+
+private:
+    typedef struct PollMetric_t
+    {
+        int intervalMs = 0;           // Poll interval; 0 = disabled
+        qint64 lastPollMs = -1;       // Time of last poll (pollClock); -1 = never
+        QList<int> targets;           // GT1724 lane offsets (per-chip metrics only)
+        QMap<int, int> pending;       // Outstanding requests, by GT1724 lane offset
+        QMap<int, qint64> issuedMs;   // Time the last request was issued (pollClock), by GT1724 lane offset
+        int maxPending = 1;           // Max outstanding requests per chip
+    } PollMetric_t;
+
+    PollMetric_t metrics[POLL_METRIC_COUNT];
+
+    bool edChipDecided(int chipLane) const;
+
+    double bitRate = 0.0;
+
+    // ED Log, and latest status used to fill in log records:
+    BertEDLog edLog;
+    QList<BertEDLogExport *> edLogExports;   // Exports in progress (see EDLogStop)
+    QMap<int, quint16> edLaneStatus;  // EDLOG_FLAG_LOS / EDLOG_FLAG_LOL, by ED lane
+    QMap<int, int> coreTemps;         // Last core temperature read, by GT1724 lane offset
+
+    // ED confidence target (see EDSetConfidenceTarget); targetBER 0 = Off:
+    double edTargetBER = 0.0;
+    double edTargetConfidence = 0.0;
+    QMap<int, int> edVerdicts;            // EDConfidence::VERDICT_PASS / _FAIL, by ED lane (decided lanes only)
+    QMap<int, QList<int> > edChipLanes;   // ED lanes seen in readings, by GT1724 lane offset
+
+    QTimer pollTimer;
+    QElapsedTimer pollClock;
+};
+
+#endif // BERTPOLLER_H
@@ -0,0 +1,233 @@
+/*!
+ \file   BertTestPlan.cpp
+ \brief  Test Plan - Parameter grid / point list and measurements for a sweep
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <QFile>
+#include <QTextStream>
+#include <QDebug>
+
+#include "globals.h"
+#include "BertTestPlan.h"
+
+
+BertTestPlan::BertTestPlan()
+{}
+
+
+/*!
+ \brief Read a plan file
+ \param fileName     Plan file (see class description)
+ \param valueCounts  Number of options for each parameter, by Parameter
+                     (e.g. LMX profiles for PARAM_PROFILE): values must be
+                     below this. A parameter with no entry can't be used.
+ \return globals::OK            Plan read
+ \return globals::FILE_ERROR    Couldn't open file
+ \return globals::INVALID_DATA  Bad line or value out of range (see getErrorLine),
+                                no points or no measurements, or too many points
+*/
+int BertTestPlan::load(const QString &fileName, const QList<int> &valueCounts)
+{
+    this->fileName = fileName;
+    this->valueCounts = valueCounts;
+    errorLine = 0;
+    lineNumber = 0;
+    gridParameters.clear();
+    gridValues.clear();
+    points.clear();
+    measurements.clear();
+    settleMs = SETTLE_DEFAULT;
+
+    QFile planFile(fileName);
+    if (!planFile.open(QIODevice::ReadOnly | QIODevice::Text))
+    {
+        qDebug() << "Test plan: Couldn't open " << fileName;
+        return globals::FILE_ERROR;
+    }
+    QTextStream plan(&planFile);
+    while (!plan.atEnd())
+    {
+        const QString line = plan.readLine().trimmed();
+        lineNumber++;
+        if (line.isEmpty() || line.startsWith('#')) continue;
+        if (parseLine(line.split(' ', QString::SkipEmptyParts)) != globals::OK)
+        {
+            qDebug() << "Test plan: Error at line " << lineNumber << ": " << line;
+            errorLine = lineNumber;
+            return globals::INVALID_DATA;
+        }
+    }
+    // Grid and point list can't be mixed; need at least one point and measurement:
+    if (!gridParameters.isEmpty() && !points.isEmpty()) return globals::INVALID_DATA;
+    if (measurements.isEmpty()) return globals::INVALID_DATA;
+    const int pointCount = getPointCount();
+    if (pointCount < 1 || pointCount > POINTS_MAX) return globals::INVALID_DATA;
+    return globals::OK;
+}
+
+
+/*!
+ \brief Get the number of points in the plan
+ \return Points; 0 if the grid is empty, or POINTS_MAX + 1 if there are too many
+*/
+int BertTestPlan::getPointCount() const
+{
+    if (!points.isEmpty()) return points.count();
+    if (gridParameters.isEmpty()) return 0;
+    qint64 count = 1;
+    foreach (const QList<int> &values, gridValues)
+    {
+        count *= values.count();
+        if (count > POINTS_MAX) return POINTS_MAX + 1;
+    }
+    return static_cast<int>(count);
+}
+
+
+/*!
+ \brief Get the settings for a point
+ \param index  Point (0 to getPointCount() - 1). For a grid, the last
+               parameter changes fastest.
+*/
+BertTestPlan::PlanPoint_t BertTestPlan::getPoint(const int index) const
+{
+    if (!points.isEmpty()) return points.value(index);
+    PlanPoint_t point;
+    int remainder = index;
+    for (int axis = gridParameters.count() - 1; axis >= 0; axis--)
+    {
+        const QList<int> &values = gridValues.at(axis);
+        point.values[gridParameters.at(axis)] = values.at(remainder % values.count());
+        remainder /= values.count();
+    }
+    return point;
+}
+
+
+/*!
+ \brief Check whether any point of the plan sets a parameter
+*/
+bool BertTestPlan::usesParameter(const int parameter) const
+{
+    if (gridParameters.contains(parameter)) return true;
+    foreach (const PlanPoint_t &point, points)
+    {
+        if (point.values[parameter] >= 0) return true;
+    }
+    return false;
+}
+
+
+/*!
+ \brief Get the name of a parameter, as used in plan files ("profile", etc)
+*/
+QString BertTestPlan::parameterName(const int parameter)
+{
+    static const char *names[PARAM_COUNT] = { "profile", "pattern", "swing", "deemph", "cursor", "eqboost" };
+    if (parameter < 0 || parameter >= PARAM_COUNT) return QString("");
+    return QString(names[parameter]);
+}
+
+
+/*!
+ \brief Get the name of a measurement type ("ed", "eyescan", "bathtub")
+*/
+QString BertTestPlan::measurementName(const int type)
+{
+    switch (type)
+    {
+    case MEASURE_ED:      return QString("ed");
+    case MEASURE_EYESCAN: return QString("eyescan");
+    case MEASURE_BATHTUB: return QString("bathtub");
+    default:              return QString("");
+    }
+}
+
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+/*!
+ \brief Parse one (non-blank) line of a plan file
+ \return globals::OK or globals::INVALID_DATA
+*/
+int BertTestPlan::parseLine(const QStringList &words)
+{
+    const QString keyword = words.at(0).toLower();
+    bool ok = true;
+
+    if (keyword == "measure")
+    {
+        if (words.count() < 2) return globals::INVALID_DATA;
+        PlanMeasurement_t measurement;
+        const QString type = words.at(1).toLower();
+        if      (type == "ed")      measurement.type = MEASURE_ED;
+        else if (type == "eyescan") measurement.type = MEASURE_EYESCAN;
+        else if (type == "bathtub") measurement.type = MEASURE_BATHTUB;
+        else return globals::INVALID_DATA;
+        for (int i = 2; i < words.count() && ok; i++) measurement.params.append(words.at(i).toInt(&ok));
+        if (!ok || measurement.params.isEmpty() || measurement.params.at(0) <= 0) return globals::INVALID_DATA;
+        measurement.line = lineNumber;
+        measurements.append(measurement);
+        return globals::OK;
+    }
+    if (keyword == "settle")
+    {
+        if (words.count() != 2) return globals::INVALID_DATA;
+        settleMs = words.at(1).toInt(&ok);
+        return (ok && settleMs >= 0) ? globals::OK : globals::INVALID_DATA;
+    }
+    if (keyword == "point")
+    {
+        PlanPoint_t point;
+        for (int i = 1; i < words.count(); i++)
+        {
+            const int parameter = parseParameter(words.at(i).section('=', 0, 0));
+            const int value = words.at(i).section('=', 1, 1).toInt(&ok);
+            if (parameter < 0 || !ok || !valueValid(parameter, value)) return globals::INVALID_DATA;
+            point.values[parameter] = value;
+        }
+        points.append(point);
+        return globals::OK;
+    }
+
+    // Grid axis: <parameter> <value> [value ...]
+    const int parameter = parseParameter(keyword);
+    if (parameter < 0 || words.count() < 2 || gridParameters.contains(parameter)) return globals::INVALID_DATA;
+    QList<int> values;
+    for (int i = 1; i < words.count() && ok; i++)
+    {
+        values.append(words.at(i).toInt(&ok));
+        if (!valueValid(parameter, values.last())) ok = false;
+    }
+    if (!ok) return globals::INVALID_DATA;
+    gridParameters.append(parameter);
+    gridValues.append(values);
+    return globals::OK;
+}
+
+
+/*!
+ \brief Check a parameter value against the number of options (see load)
+*/
+bool BertTestPlan::valueValid(const int parameter, const int value) const
+{
+    return (value >= 0 && value < valueCounts.value(parameter, 0));
+}
+
+
+/*!
+ \brief Get a parameter from its name
+ \return PARAM_xxx, or -1 if the name isn't a parameter
+*/
+int BertTestPlan::parseParameter(const QString &name)
+{
+    for (int parameter = 0; parameter < PARAM_COUNT; parameter++)
+    {
+        if (name.toLower() == parameterName(parameter)) return parameter;
+    }
+    return -1;
+}
@@ -0,0 +1,119 @@
+/*!
+ \file   BertTestPlan.h
+ \brief  Test Plan - Parameter grid / point list and measurements for a sweep
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#ifndef BERTTESTPLAN_H
+#define BERTTESTPLAN_H
+
+#include <QString>
+#include <QStringList>
+#include <QList>
+
+/*!
+ \brief Test Plan
+ Reads a test plan (sweep) file, and gives the settings for each point
+ and the measurements to make at each point (see BertInstrument "plan").
+
+ A plan is a text file; blank lines and lines starting with '#' are
+ ignored. Points are given EITHER as a grid, with one line per parameter
+ listing its values (all combinations are run; the first line changes
+ slowest, the last fastest):
+   profile 0 3
+   swing   0 2 4
+   eqboost 0 3
+ OR as a list of points, one per line:
+   point profile=0 swing=2
+   point profile=3 swing=4 eqboost=3
+ Parameters (values are list indexes, as for the UI):
+   profile       LMX frequency profile (clock change: PG resync + settle)
+   pattern       PG pattern, all lanes (PG resync + settle)
+   swing         PG output swing, all PG lanes
+   deemph        PG de-emphasis level, all PG lanes
+   cursor        PG de-emphasis cursor (pre / post), all PG lanes
+   eqboost       ED EQ boost, all ED lanes
+ Measurements, made at each point in the order given:
+   measure ed <seconds>                          (see also edtarget)
+   measure eyescan <lane> [hStep] [vStep] [countRes]
+   measure bathtub <lane> [vOffset] [countRes]
+ Other:
+   settle <ms>   Time allowed after changing swing / de-emphasis / EQ
+                 boost (default SETTLE_DEFAULT)
+ Parameter values are checked against the option lists when the plan is
+ read, so a bad value is reported with its line before anything runs.
+*/
+class BertTestPlan
+{
+public:
+    BertTestPlan();
+
+    enum Parameter
+    {
+        PARAM_PROFILE,
+        PARAM_PATTERN,
+        PARAM_SWING,
+        PARAM_DEEMPH_LEVEL,
+        PARAM_DEEMPH_CURSOR,
+        PARAM_EQ_BOOST,
+        PARAM_COUNT
+    };
+
+    enum MeasurementType
+    {
+        MEASURE_ED,
+        MEASURE_EYESCAN,
+        MEASURE_BATHTUB
+    };
+
+    // Settings for one point, by Parameter. Values are list indexes, as
+    // for the UI; -1 = Not set by the plan (the setting is left as it is):
+    typedef struct PlanPoint_t
+    {
+        int values[PARAM_COUNT] = { -1, -1, -1, -1, -1, -1 };
+    } PlanPoint_t;
+
+    // A measurement made at each point. Parameters are as for the matching
+    // instrument command (see BertInstrument), e.g. for MEASURE_ED: seconds:
+    typedef struct PlanMeasurement_t
+    {
+        int type;
+        QList<int> params;
+        int line;          // Line in the plan file (for error reports)
+    } PlanMeasurement_t;
+
+    static const int SETTLE_DEFAULT = 100;   // Settle time after a swing / de-emphasis / EQ change (ms)
+    static const int POINTS_MAX = 100000;    // Most points in one plan (guards against a mistyped grid)
+
+    int  load(const QString &fileName, const QList<int> &valueCounts);
+
+    QString getFileName() const   { return fileName;  }
+    int     getErrorLine() const  { return errorLine; }
+    int     getPointCount() const;
+    PlanPoint_t getPoint(const int index) const;
+    const QList<PlanMeasurement_t> &getMeasurements() const { return measurements; }
+    int     getSettleMs() const   { return settleMs;  }
+    bool    usesParameter(const int parameter) const;
+
+    static QString parameterName(const int parameter);
+    static QString measurementName(const int type);
+
+private:
+    int parseLine(const QStringList &words);
+    bool valueValid(const int parameter, const int value) const;
+    static int parseParameter(const QString &name);
+
+    QString fileName;
+    int errorLine = 0;
+    int lineNumber = 0;                  // Line being parsed
+    QList<int> valueCounts;              // Number of options for each parameter (see load)
+
+    QList<int> gridParameters;           // Grid: Parameter for each axis (first = slowest)
+    QList<QList<int> > gridValues;       // Grid: Values for each axis
+    QList<PlanPoint_t> points;           // Point list (used instead of the grid if not empty)
+    QList<PlanMeasurement_t> measurements;
+    int settleMs = SETTLE_DEFAULT;
+};
+
+#endif // BERTTESTPLAN_H
@@ -11,6 +11,7 @@
 #include <QDebug>
 #include <QEventLoop>
 #include <QStringList>
+#include <QDir>
 
 #include "globals.h"
 #include "I2CComms.h"
@@ -18,6 +19,10 @@
 #include "BertWorker.h"
 
 
+QMap<QString, BertWorker::BertTopology_t> BertWorker::topologyCache;
+QMutex BertWorker::topologyMutex;
+
+
 BertWorker::BertWorker()
 {
     qDebug() << "BertWorker Constructor on thread " << QThread::currentThreadId();
@@ -55,7 +60,7 @@ void BertWorker::CommsConnect(QString port)
         return;
     }
 
-    result = comms->open(port);   // Connect...
+    result = comms->open(port, I2CTransport::portTransportType(port));   // Connect...
     if (result != globals::OK)
     {
         emit WorkerResult(result);
@@ -72,9 +77,23 @@ void BertWorker::CommsConnect(QString port)
         qDebug() << "Worker: EEPROM found; Reading model code...";
         QString modelCode = m24m02Set[0]->ReadModelCode();
         qDebug() << "Worker: Model code: " << modelCode;
-        bool validModel = BertModel::SelectModel(modelCode);
-        result = findComponents();
-        if (result == globals::OK && !validModel) result = globals::UNKNOWN_MODEL;
+        int modelResult = BertModel::AcquireModel(modelCode);
+        modelAcquired = (modelResult != globals::BUSY_ERROR);
+        if (modelResult == globals::BUSY_ERROR)
+        {
+            // Another instrument of a different model is connected; component
+            // addresses would be wrong, so don't look for other components.
+            emit WorkerShowMessage("Model doesn't match other connected instruments!");
+            result = globals::UNKNOWN_MODEL;
+        }
+        else
+        {
+            QList<uint8_t> found;
+            result = discoverAddresses(modelCode, found);
+            if (result == globals::OK) setProfileNames(found);
+            if (result == globals::OK) result = findComponents(found);
+            if (result == globals::OK && modelResult != globals::OK) result = globals::UNKNOWN_MODEL;
+        }
     }
 
     // Check hardware set up result:
@@ -170,6 +189,31 @@ void BertWorker::InitComponents()
 }
 
 
+/*!
+ \brief Write the I2C bus profile report (see I2CProfiler)
+ The report is appended to the file, and also sent to the client with
+ I2CProfileReport. Counts are NOT reset (see I2CProfileReset).
+ \param fileName  File to append the report to; if empty, BusProfile.txt
+                  in the application directory is used.
+*/
+void BertWorker::I2CProfileDump(QString fileName)
+{
+    if (fileName.isEmpty()) fileName = QDir(globals::getAppPath()).absoluteFilePath("BusProfile.txt");
+    const QString report = comms->getProfileReport();
+    int result = comms->writeProfileReport(fileName);
+    emit I2CProfileReport(result, fileName, report);
+}
+
+
+/*!
+ \brief Clear the I2C bus profile statistics
+*/
+void BertWorker::I2CProfileReset()
+{
+    comms->resetProfile();
+}
+
+
 /*!
  \brief Signal the worker thread to stop.
 */
@@ -258,21 +302,119 @@ int BertWorker::findAndInitEEPROM()
 
 
 
+/*!
+ \brief Discover I2C Addresses
+        Probes all of the component addresses for the current model (see
+        BertModel::GetI2CAddresses_XXX) in one bus sweep (I2CComms::probeAddresses).
+
+        The addresses found are cached against the adaptor serial number. If the
+        same adaptor is connected again with the same model code, only the cached
+        addresses are probed; if they all respond, the cached topology is used.
+        Nb: A component fitted since the last discovery won't be picked up until
+        a cached address stops responding (or the application is restarted).
+ \param modelCode  Model code read from the EEPROM
+ \param found      Set to the list of addresses which responded
+ \return globals::OK   Sweep completed
+ \return [error code]  Comms error
+*/
+int BertWorker::discoverAddresses(const QString &modelCode, QList<uint8_t> &found)
+{
+    int result;
+    found.clear();
+
+    QString serialNumber;
+    if (comms->getAdaptorSerial(serialNumber) != globals::OK) serialNumber.clear();
+    qDebug() << "BertWorker: Adaptor serial number: " << serialNumber;
+
+    if (!serialNumber.isEmpty())
+    {
+        QMutexLocker locker(&topologyMutex);
+        if (topologyCache.contains(serialNumber) && topologyCache[serialNumber].modelCode == modelCode)
+        {
+            const QList<uint8_t> cachedAddresses = topologyCache[serialNumber].addresses;
+            locker.unlock();
+            QList<uint8_t> cachedFound;
+            result = comms->probeAddresses(cachedAddresses, cachedFound);
+            if (result == globals::OK && cachedFound.count() == cachedAddresses.count())
+            {
+                qDebug() << "BertWorker: Cached topology validated (" << cachedFound.count() << " addresses)";
+                found = cachedFound;
+                return globals::OK;
+            }
+            qDebug() << "BertWorker: Cached topology didn't match; Full sweep...";
+        }
+    }
+
+    QList<uint8_t> candidates;
+    candidates << BertModel::GetI2CAddresses_TLC59108()
+               << BertModel::GetI2CAddresses_GT1724()
+               << BertModel::GetI2CAddresses_LMX2594()
+               << BertModel::GetI2CAddresses_PCA9557B()
+               << BertModel::GetI2CAddresses_PCA9557A()
+               << BertModel::GetI2CAddresses_SI5340();
+    result = comms->probeAddresses(candidates, found);
+    if (result != globals::OK)
+    {
+        qDebug() << "BertWorker: Error probing component addresses (" << result << ")";
+        return result;
+    }
+    qDebug() << "BertWorker: Address sweep found " << found.count() << " components";
+
+    if (!serialNumber.isEmpty() && !found.isEmpty())
+    {
+        QMutexLocker locker(&topologyMutex);
+        topologyCache[serialNumber].modelCode = modelCode;
+        topologyCache[serialNumber].addresses = found;
+    }
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Set component names for the I2C bus profile report
+ Names are set for the addresses found by the discovery sweep, and for each
+ page address of the EEPROM(s).
+ \param found  Addresses which responded to the discovery sweep (see discoverAddresses)
+*/
+void BertWorker::setProfileNames(const QList<uint8_t> &found)
+{
+    int core = 1;
+    foreach (uint8_t address, BertModel::GetI2CAddresses_GT1724())
+    {
+        if (found.contains(address)) comms->setProfileSourceName(address, QString("GT1724 Core %1").arg(core++));
+    }
+    foreach (uint8_t address, BertModel::GetI2CAddresses_LMX2594())  comms->setProfileSourceName(address, "LMX2594");
+    foreach (uint8_t address, BertModel::GetI2CAddresses_PCA9557A()) comms->setProfileSourceName(address, "PCA9557A");
+    foreach (uint8_t address, BertModel::GetI2CAddresses_PCA9557B()) comms->setProfileSourceName(address, "PCA9557B");
+    foreach (uint8_t address, BertModel::GetI2CAddresses_SI5340())   comms->setProfileSourceName(address, "SI5340");
+    foreach (uint8_t address, BertModel::GetI2CAddresses_TLC59108()) comms->setProfileSourceName(address, "TLC59108");
+    foreach (uint8_t address, BertModel::GetI2CAddresses_M24M02())
+    {
+        for (uint8_t page = 0; page < 4; page++)
+        {
+            comms->setProfileSourceName(address + page, QString("M24M02 Page %1").arg(page));
+        }
+    }
+}
+
+
 /*!
  \brief Find Instrument Components
         This method checks for hardware components of the system, e.g. GT1724 ICs
         and LMX clock interface. It instantiates objects as needed to represent the
         hardware components.
+ \param found  Addresses which responded to the discovery sweep (see discoverAddresses)
  \return globals::OK   Enough components were detected to make up a working instrument!
  \return [error code]  A critical component was not detected.
  Emits: ShowWorkerMessage to show progress / errors
         XXXXAdded to inform clients of hardware components which have been added
 */
-int BertWorker::findComponents()
+int BertWorker::findComponents(const QList<uint8_t> &found)
 {
     qDebug() << "BertWorker: Search for hardware components...";
     int deviceID = 0;
-//    int laneOffset = 0;
+    int laneOffset = 0;
 
 /*
     // ====== TLC59108 ICs: =========================================================
@@ -282,7 +424,7 @@ int BertWorker::findComponents()
     TLC59108 *tlc59108;
     foreach(uint8_t address, BertModel::GetI2CAddresses_TLC59108())
     {
-        if (TLC59108::ping(comms, address))
+        if (found.contains(address))
         {
             qDebug() << "BertWorker: TLC59108 IC Found on address " << INT_AS_HEX(address,2) << ", Lane Offset " << laneOffset;
             tlc59108 = new TLC59108(comms, address, deviceID);
@@ -298,19 +440,24 @@ int BertWorker::findComponents()
         emit WorkerShowMessage("LED not found!");
         return globals::MISSING_TLC59108;
     }
+*/
 
     // ====== GT1724 ICs: =========================================================
     // Ping to see if there are GT1724 ICs:
     // 2019-07-25 REMOVED for Federico to test boards:
+    // Oct 2026 Restored: A missing core is still fatal for a known model. Boards
+    // with no model code ("Unknown", e.g. test boards) carry on without one.
 
     GT1724 *gt1724;
     foreach(uint8_t address, BertModel::GetI2CAddresses_GT1724())
     {
-        if (GT1724::ping(comms, address))
+        if (found.contains(address))
         {
             qDebug() << "BertWorker: GT1724 IC Found on address " << INT_AS_HEX(address,2) << ", Lane Offset " << laneOffset;
             gt1724 = new GT1724(comms, address, static_cast<uint8_t>(laneOffset));
             gt1724Set.append(gt1724);
+            startComponentThread(gt1724, QString("GT1724 Core %1").arg(laneOffset/4 + 1));
+            poller->addGT1724(gt1724);
             emit GT1724Added(gt1724, laneOffset);
             laneOffset += 4;
         }
@@ -318,11 +465,14 @@ int BertWorker::findComponents()
     if (gt1724Set.count() == 0)
     {
         // No GT1724 ICs found!
-        qDebug() << "BertWorker: At least ONE GT1724 IC must be present, but none were found!";
-        emit WorkerShowMessage("Core module not found!");
-        return globals::MISSING_GT1724;
+        if (BertModel::GetModelCode() != "Unknown")
+        {
+            qDebug() << "BertWorker: At least ONE GT1724 IC must be present, but none were found!";
+            emit WorkerShowMessage("Core module not found!");
+            return globals::MISSING_GT1724;
+        }
+        qDebug() << "BertWorker: No GT1724 IC found (no model code; continuing without core module)";
     }
-*/
 
     // ====== LMX Clock Modules: ==================================================
     // Ping to see if there are LMX2594 ICs:
@@ -330,7 +480,7 @@ int BertWorker::findComponents()
     deviceID = 0;
     foreach(uint8_t address, BertModel::GetI2CAddresses_LMX2594())
     {
-        if (LMX2594::ping(comms, address))
+        if (found.contains(address))
         {
             qDebug() << "BertWorker: LMX2594 Clock found on address " << INT_AS_HEX(address,2) << ", ID " << deviceID;
             lmxClock = new LMX2594(comms, address, deviceID, m24m02Set.at(0));
@@ -353,7 +503,7 @@ int BertWorker::findComponents()
     deviceID = 0;
     foreach(uint8_t address, BertModel::GetI2CAddresses_PCA9557B())
     {
-        if (PCA9557B::ping(comms, address))
+        if (found.contains(address))
         {
             qDebug() << "BertWorker: PCA9557B IO Controller found on address " << INT_AS_HEX(address,2) << ", ID " << deviceID;
             pca9557b = new PCA9557B(comms, address, deviceID);
@@ -378,11 +528,12 @@ int BertWorker::findComponents()
     deviceID = 0;
     foreach(uint8_t address, BertModel::GetI2CAddresses_PCA9557A())
     {
-        if (PCA9557A::ping(comms, address))
+        if (found.contains(address))
         {
             qDebug() << "BertWorker: PCA9557A IO Controller found on address " << INT_AS_HEX(address,2) << ", ID " << deviceID;
             pca9557a = new PCA9557A(comms, address, deviceID);
             pca9557aSet.append(pca9557a);
+            poller->addPCA9557A(pca9557a);
             emit PCA9557A_Added(pca9557a, deviceID);
             deviceID++;
 
@@ -403,7 +554,7 @@ int BertWorker::findComponents()
     deviceID = 0;
     foreach(uint8_t address, BertModel::GetI2CAddresses_SI5340())
     {
-        if (SI5340::ping(comms, address))
+        if (found.contains(address))
         {
             qDebug() << "BertWorker: SI5340 Ref Clock generator found on address " << INT_AS_HEX(address,2) << ", ID " << deviceID;
             si5340 = new SI5340(comms, address, deviceID);
@@ -502,7 +653,8 @@ void BertWorker::getComponentOptions()
 int BertWorker::initComponents()
 {
     qDebug() << "BertWorker: Initialise hardware components...";
-    int result;
+    int result = globals::OK;
+    QList<GT1724 *> gt1724Pending;
 
     // Initialisation Order:
     //  -SI5340 Clock Ref generator (if present)
@@ -514,6 +666,21 @@ int BertWorker::initComponents()
     //      Controls various GPIO pins, including (possibly) a clock divider
     //      part which comes after the LMX2594
     //  -GT1724 BERT IC
+    //      The GT1724 macro download doesn't need the clock, so it is started
+    //      first on each chip's own thread and runs while the other components
+    //      are set up. The rest of the GT1724 init (defaults and PG resync)
+    //      needs the clock running, so it is done last.
+
+    // ====== GT1724 ICs (start init): ============================================
+    foreach(GT1724 *gt1724, gt1724Set)
+    {
+        if (gt1724->thread() != QThread::currentThread())
+        {
+            qDebug() << "BertWorker: Start macro download for GT1724";
+            QMetaObject::invokeMethod(gt1724, "initAsync", Qt::QueuedConnection);
+            gt1724Pending.append(gt1724);
+        }
+    }
 
     // ====== TLC59108 LED : ==============================
     // Call init for each TLC59108 LED:
@@ -526,7 +693,7 @@ int BertWorker::initComponents()
             qDebug() << "BertWorker: Error setting up TLC59108 (" << result << ")";
             emit WorkerShowMessage("Error configuring system!");
             // REMOVE for testing:
-            return result;
+            goto InitGT1724;
         }
     }
 
@@ -541,7 +708,7 @@ int BertWorker::initComponents()
             qDebug() << "BertWorker: Error setting up SI5340 (" << result << ")";
             emit WorkerShowMessage("Error configuring system!");
             // REMOVE for testing:
-            return result;
+            goto InitGT1724;
         }
     }
 
@@ -555,7 +722,7 @@ int BertWorker::initComponents()
         {
             qDebug() << "BertWorker: Error setting up LMX clock module (" << result << ")";
             emit WorkerShowMessage("Frequency synthesizer set up error!");
-            return result;
+            goto InitGT1724;
         }
     }
 
@@ -569,7 +736,7 @@ int BertWorker::initComponents()
         {
             qDebug() << "BertWorker: Error setting up PCA9557B (" << result << ")";
             emit WorkerShowMessage("IO Controller set up error!");
-            return result;
+            goto InitGT1724;
         }
     }
 
@@ -584,27 +751,48 @@ int BertWorker::initComponents()
         {
             qDebug() << "BertWorker: Error setting up PCA9557B (" << result << ")";
             emit WorkerShowMessage("IO Controller set up error!");
-            return result;
+            goto InitGT1724;
         }
     }
 
 
+  InitGT1724:
+
     // ====== GT1724 ICs: =========================================================
-    // Call init for each GT1724 IC:
+    // Wait for each GT1724 macro download started above (these must finish even if
+    // another component failed, so the chips aren't shut down mid-download). Then,
+    // if everything else was set up OK (clocks running), finish the init on the
+    // chip's own thread. A GT1724 on the worker thread is initialised here.
     foreach(GT1724 *gt1724, gt1724Set)
     {
-        qDebug() << "BertWorker: Initialise GT1724";
-        result = gt1724->init();
-        if (result != globals::OK)
+        int gt1724Result;
+        if (gt1724Pending.contains(gt1724))
+        {
+            gt1724Result = gt1724->initWait();
+            if (gt1724Result == globals::OK)
+            {
+                if (result != globals::OK) continue;
+                qDebug() << "BertWorker: Finish init for GT1724";
+                QMetaObject::invokeMethod(gt1724, "initSettingsAsync", Qt::QueuedConnection);
+                gt1724Result = gt1724->initWait();
+            }
+        }
+        else
         {
-            qDebug() << "BertWorker: Error setting up GT1724 (" << result << ")";
+            if (result != globals::OK) continue;
+            qDebug() << "BertWorker: Initialise GT1724";
+            gt1724Result = gt1724->init();
+        }
+        if (gt1724Result != globals::OK && result == globals::OK)
+        {
+            qDebug() << "BertWorker: Error setting up GT1724 (" << gt1724Result << ")";
             emit WorkerShowMessage("Error configuring system!");
-            return result;
+            result = gt1724Result;
         }
     }
 
-    // Hardware set up OK!
-    return globals::OK;
+    // Hardware set up OK?
+    return result;
 }
 
 
@@ -615,6 +803,15 @@ int BertWorker::initComponents()
 void BertWorker::shutdownComponents()
 {
     qDebug() << "BertWorker: hardware clean up...";
+    if (poller) poller->clearComponents();
+    if (modelAcquired)
+    {
+        BertModel::ReleaseModel();
+        modelAcquired = false;
+    }
+    // Stop the per-component threads first, so that the components can be deleted here:
+    stopComponentThreads();
+
     // ====== GT1724 ICs: =========================================================
     qDebug() << "BertWorker: REMOVE Core modules...";
     GT1724 *gt1724;
@@ -683,6 +880,48 @@ void BertWorker::shutdownComponents()
 
 
 
+/*!
+ \brief Start a thread for a component
+ The component is moved to a new thread with its own event loop, so its slots
+ are run independently of the worker thread and other components. Signals from
+ clients are queued to the component's thread automatically.
+ The thread is stopped by stopComponentThreads (called by shutdownComponents).
+ \param component  Component to move to the new thread
+ \param name       Name for the thread (for debug)
+*/
+void BertWorker::startComponentThread(QObject *component, const QString &name)
+{
+    QThread *componentThread = new QThread();
+    componentThread->setObjectName(name);
+    component->moveToThread(componentThread);
+    componentThreads.append(componentThread);
+    componentThread->start();
+    qDebug() << "BertWorker: Started thread for " << name;
+}
+
+
+/*!
+ \brief Stop all component threads
+ Each thread's event loop is stopped, and we wait for the thread to finish
+ (including any operation in progress). Components which were running on
+ the threads are left with no thread, and may be deleted from this thread.
+*/
+void BertWorker::stopComponentThreads()
+{
+    while (componentThreads.count() > 0)
+    {
+        QThread *componentThread = componentThreads.last();
+        qDebug() << "BertWorker: Stopping thread for " << componentThread->objectName();
+        componentThread->quit();
+        componentThread->wait();
+        delete componentThread;
+        componentThreads.removeLast();
+    }
+}
+
+
+
+
 void BertWorker::run()
 {
     qDebug() << "=== Bert Worker START ===";
@@ -698,6 +937,10 @@ void BertWorker::run()
     // Comms Layer: I2C Comms class
     comms = new I2CComms();
 
+    // Status poller: Runs on this thread; the client configures it (see BertPoller):
+    poller = new BertPoller();
+    emit PollerAdded(poller);
+
     // Get a list of serial ports:
     RefreshSerialPorts();
 
@@ -717,6 +960,8 @@ void BertWorker::run()
     flagWorkerReady = false;
 
     shutdownComponents();
+    delete poller;
+    poller = NULL;
     if (comms->portIsOpen()) comms->close();
     delete comms;
 }
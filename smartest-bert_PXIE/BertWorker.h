@@ -23,6 +23,8 @@
 #include <QEventLoop>
 #include <QTimer>
 #include <QList>
+#include <QMap>
+#include <QMutex>
 
 #include "I2CComms.h"
 #include "TLC59108.h"
@@ -32,6 +34,7 @@
 #include "PCA9557A.h"
 #include "M24M02.h"
 #include "SI5340.h"
+#include "BertPoller.h"
 
 
 class BertWorker : public QThread
@@ -84,8 +87,10 @@ public:
     void PCA9557A_Added(PCA9557A *pca9557a, int deviceID);         \
     void M24M02Added(M24M02 *m24m02, int deviceID);                \
     void SI5340Added(SI5340 *si5340, int deviceID );         \
+    void PollerAdded(BertPoller *poller);                          \
     void StatusConnect(bool connected);                            \
     void OptionsSent();                                            \
+    void I2CProfileReport(int result, QString fileName, QString report); \
 
 
 #define BERT_WORKER_SLOTS \
@@ -94,6 +99,8 @@ public:
     void CommsDisconnect();          \
     void GetOptions();               \
     void InitComponents();           \
+    void I2CProfileDump(QString fileName); \
+    void I2CProfileReset();          \
     void WorkerStop();
 
 #define BERT_WORKER_CONNECT_SIGNALS(CLIENT, WORKER) \
@@ -107,13 +114,17 @@ public:
     connect(WORKER, SIGNAL(PCA9557A_Added(PCA9557A *, int)),  CLIENT, SLOT(PCA9557A_Added(PCA9557A *, int)));   \
     connect(WORKER, SIGNAL(M24M02Added(M24M02 *, int)),       CLIENT, SLOT(M24M02Added(M24M02 *, int)));       \
     connect(WORKER, SIGNAL(SI5340Added(SI5340 *, int)),       CLIENT, SLOT(SI5340Added(SI5340 *, int)));       \
+    connect(WORKER, SIGNAL(PollerAdded(BertPoller *)),        CLIENT, SLOT(PollerAdded(BertPoller *)));        \
     connect(WORKER, SIGNAL(StatusConnect(bool)),              CLIENT, SLOT(StatusConnect(bool)));              \
     connect(WORKER, SIGNAL(OptionsSent()),                    CLIENT, SLOT(OptionsSent()));                    \
+    connect(WORKER, SIGNAL(I2CProfileReport(int, QString, QString)), CLIENT, SLOT(I2CProfileReport(int, QString, QString))); \
     connect(CLIENT, SIGNAL(RefreshSerialPorts()),             WORKER, SLOT(RefreshSerialPorts()));             \
     connect(CLIENT, SIGNAL(CommsConnect(QString)),            WORKER, SLOT(CommsConnect(QString)));            \
     connect(CLIENT, SIGNAL(CommsDisconnect()),                WORKER, SLOT(CommsDisconnect()));                \
     connect(CLIENT, SIGNAL(GetOptions()),                     WORKER, SLOT(GetOptions()));                     \
     connect(CLIENT, SIGNAL(InitComponents()),                 WORKER, SLOT(InitComponents()));                 \
+    connect(CLIENT, SIGNAL(I2CProfileDump(QString)),          WORKER, SLOT(I2CProfileDump(QString)));          \
+    connect(CLIENT, SIGNAL(I2CProfileReset()),                WORKER, SLOT(I2CProfileReset()));                \
     connect(CLIENT, SIGNAL(WorkerStop()),                     WORKER, SLOT(WorkerStop()));
 
 signals:
@@ -128,13 +139,19 @@ private slots:
 private:
     void run();
     int  findAndInitEEPROM();
-    int  findComponents();
+    int  discoverAddresses(const QString &modelCode, QList<uint8_t> &found);
+    int  findComponents(const QList<uint8_t> &found);
+    void setProfileNames(const QList<uint8_t> &found);
     void getComponentOptions();
     int  initComponents();
     void shutdownComponents();
 
+    void startComponentThread(QObject *component, const QString &name);
+    void stopComponentThreads();
+
     bool flagStop;
     bool flagWorkerReady;
+    bool modelAcquired = false;   // BertModel::AcquireModel called for this instrument
 
     // Comms Layer: I2C Comms class
     I2CComms *comms = NULL;
@@ -147,6 +164,27 @@ private:
     QList<PCA9557A *> pca9557aSet;   // There will be 1 x PCA9557A IC per board
     QList<SI5340 *>  si5340Set;    // There may be 1 x SI5340 IC per board (selected models only)
     QList<TLC59108 *>  tlc59108Set;    // There may be 1 x SI5340 IC per board (selected models only)
+
+    // Execution contexts: Each GT1724 runs on its own thread, so that a long operation
+    // on one chip (e.g. eye scan) doesn't hold up status polling on the others.
+    // Access to the I2C bus from all threads is arbitrated by the I2CComms op queue.
+    QList<QThread *> componentThreads;
+
+    // Status poller: Issues periodic ED / status reads to the components (see BertPoller).
+    // Created on the worker thread in run().
+    BertPoller *poller = NULL;
+
+    // Topology cache: I2C addresses found at the last successful discovery,
+    // for each adaptor serial number (see discoverAddresses). Shared by all
+    // workers (one per instrument), so access is protected by topologyMutex.
+    typedef struct BertTopology_t
+    {
+        QString        modelCode;   // Model code read from EEPROM
+        QList<uint8_t> addresses;   // Component addresses which responded
+    } BertTopology_t;
+
+    static QMap<QString, BertTopology_t> topologyCache;
+    static QMutex topologyMutex;
 };
 
 #endif // BERTWORKER_H
@@ -0,0 +1,135 @@
+/*!
+ \file   EDConfidence.cpp
+ \brief  ED Confidence - Statistical pass / fail judgement of ED counts against a target BER
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <cmath>
+#include <algorithm>
+
+#include "EDConfidence.h"
+
+const double EDConfidence::GAMMA_EPSILON = 1e-12;
+
+
+/*!
+ \brief Get the confidence that the BER is below a target
+ \param bits       Bits counted
+ \param errors     Errors counted
+ \param targetBER  Target BER
+ \return Confidence (0 to 1)
+*/
+double EDConfidence::confidenceBelow(const double bits, const double errors, const double targetBER)
+{
+    if (bits <= 0.0 || targetBER <= 0.0) return 0.0;
+    return gammaP(std::floor(errors) + 1.0, bits * targetBER);
+}
+
+
+/*!
+ \brief Get the confidence that the BER is above a target
+ \param bits       Bits counted
+ \param errors     Errors counted
+ \param targetBER  Target BER
+ \return Confidence (0 to 1)
+*/
+double EDConfidence::confidenceAbove(const double bits, const double errors, const double targetBER)
+{
+    if (errors < 1.0 || targetBER <= 0.0) return 0.0;
+    return 1.0 - gammaP(std::floor(errors), bits * targetBER);
+}
+
+
+/*!
+ \brief Decide whether counts pass or fail a target BER
+ \param bits             Bits counted
+ \param errors           Errors counted
+ \param targetBER        Target BER
+ \param confidenceLevel  Confidence needed for a verdict (e.g. 0.95)
+ \param confidence       If not null, used to return the confidence of the verdict
+                         (for VERDICT_PENDING: confidence that BER < target so far)
+ \return VERDICT_PENDING, VERDICT_PASS or VERDICT_FAIL
+*/
+int EDConfidence::verdict(const double bits, const double errors,
+                          const double targetBER, const double confidenceLevel,
+                          double *confidence)
+{
+    const double below = confidenceBelow(bits, errors, targetBER);
+    const double above = confidenceAbove(bits, errors, targetBER);
+    int result = VERDICT_PENDING;
+    double resultConfidence = below;
+    if (below >= confidenceLevel)
+    {
+        result = VERDICT_PASS;
+    }
+    else if (above >= confidenceLevel)
+    {
+        result = VERDICT_FAIL;
+        resultConfidence = above;
+    }
+    if (confidence) *confidence = resultConfidence;
+    return result;
+}
+
+
+/*!
+ \brief Get a short name for a verdict ("pass", "fail", "pending")
+*/
+QString EDConfidence::verdictName(const int verdict)
+{
+    switch (verdict)
+    {
+    case VERDICT_PASS: return QString("pass");
+    case VERDICT_FAIL: return QString("fail");
+    default:           return QString("pending");
+    }
+}
+
+
+/*!
+ \brief Regularised lower incomplete gamma function P(a, x)
+ Uses the series expansion for x < a + 1, and the continued fraction
+ for Q(a, x) = 1 - P(a, x) otherwise (both converge quickly there).
+ \param a  a > 0
+ \param x  x >= 0
+ \return P(a, x) (0 to 1)
+*/
+double EDConfidence::gammaP(const double a, const double x)
+{
+    if (x <= 0.0 || a <= 0.0) return 0.0;
+    const double logPrefix = (a * std::log(x)) - x - std::lgamma(a);
+    if (x < a + 1.0)
+    {
+        // Series:
+        double term = 1.0 / a;
+        double sum = term;
+        for (int n = 1; n < GAMMA_ITERATIONS_MAX; n++)
+        {
+            term *= x / (a + n);
+            sum += term;
+            if (std::fabs(term) < std::fabs(sum) * GAMMA_EPSILON) break;
+        }
+        return std::min(1.0, sum * std::exp(logPrefix));
+    }
+    // Continued fraction (modified Lentz):
+    const double tiny = 1e-300;
+    double b = x + 1.0 - a;
+    double c = 1.0 / tiny;
+    double d = 1.0 / b;
+    double h = d;
+    for (int i = 1; i < GAMMA_ITERATIONS_MAX; i++)
+    {
+        const double an = -i * (i - a);
+        b += 2.0;
+        d = (an * d) + b;
+        if (std::fabs(d) < tiny) d = tiny;
+        c = b + (an / c);
+        if (std::fabs(c) < tiny) c = tiny;
+        d = 1.0 / d;
+        const double delta = d * c;
+        h *= delta;
+        if (std::fabs(delta - 1.0) < GAMMA_EPSILON) break;
+    }
+    return std::max(0.0, 1.0 - (std::exp(logPrefix) * h));
+}
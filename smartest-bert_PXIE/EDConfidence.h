@@ -0,0 +1,56 @@
+/*!
+ \file   EDConfidence.h
+ \brief  ED Confidence - Statistical pass / fail judgement of ED counts against a target BER
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#ifndef EDCONFIDENCE_H
+#define EDCONFIDENCE_H
+
+#include <QString>
+
+/*!
+ \brief ED Confidence Class
+ Decides, from the bits and errors counted so far on a lane, whether
+ the lane's BER is below a target BER (pass) or above it (fail), to a
+ given confidence level, so that a run can stop as soon as the answer
+ is known instead of after a fixed time.
+
+ Errors are taken to be Poisson distributed. If the true BER were equal
+ to the target, the expected number of errors in N bits would be
+     lambda = N * targetBER
+ With k errors counted:
+     Confidence (BER < target) = P(X > k | lambda)  = P(k + 1, lambda)
+     Confidence (BER > target) = P(X < k | lambda)  = 1 - P(k, lambda)
+ where P is the regularised lower incomplete gamma function. E.g. with
+ no errors, 95% confidence of BER < target needs about 3 / targetBER bits.
+ The two confidences can't both be over 50%, so for a confidence level
+ above 50% the verdict is never ambiguous.
+*/
+class EDConfidence
+{
+public:
+    enum Verdict
+    {
+        VERDICT_PENDING,    // Not enough bits counted to decide yet
+        VERDICT_PASS,       // BER < target (to the confidence level)
+        VERDICT_FAIL        // BER > target (to the confidence level)
+    };
+
+    static double confidenceBelow(const double bits, const double errors, const double targetBER);
+    static double confidenceAbove(const double bits, const double errors, const double targetBER);
+    static int    verdict(const double bits, const double errors,
+                          const double targetBER, const double confidenceLevel,
+                          double *confidence = nullptr);
+
+    static QString verdictName(const int verdict);
+
+    static double gammaP(const double a, const double x);
+
+private:
+    static const int    GAMMA_ITERATIONS_MAX = 1000;
+    static const double GAMMA_EPSILON;
+};
+
+#endif // EDCONFIDENCE_H
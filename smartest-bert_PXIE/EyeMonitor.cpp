@@ -6,6 +6,7 @@
 */
 
 #include <cstdlib>
+#include <algorithm>
 #include <QMutex>
 #include <QDebug>
 
@@ -18,6 +19,14 @@
 #include "globals.h"
 
 #include "EyeMonitor.h"
+#include "BertLog.h"
+
+// Debug macros for eye scans (BertLog::LOG_EYESCAN): Scan set up and summary (debug),
+// and details for each part of the scan (trace), e.g. "--log eyescan=trace".
+#define DEBUG_EYESCAN(MSG)      BERT_LOG(LOG_EYESCAN, LEVEL_DEBUG, MSG)
+#define DEBUG_EYESCAN_PART(MSG) BERT_LOG(LOG_EYESCAN, LEVEL_TRACE, MSG)
+
+const double EyeMonitor::EYESCAN_CONVERGE_DELTA = 0.02;
 
 
 EyeMonitor::EyeMonitor(GT1724 *parent, int laneOffset, int lane)
@@ -42,7 +51,9 @@ EyeMonitor::~EyeMonitor()
  operations to check for the "EyeScanCancel" signal (see
  GT1724.cpp). It is essential that no other signals (particularly
  those which require the serial port) be received by the worker,
- as these could interrupt the eye scan process.
+ as these could interrupt the eye scan process. Start / repeat
+ requests for other lanes which arrive during a scan are queued
+ by GT1724::eyeScanQueueService and run when this scan finishes.
 
  The caller should lock all UI functions, leaving only a
  "Cancel Scan" button. This is connected to the "EyeScanCancel" signal
@@ -57,19 +68,35 @@ EyeMonitor::~EyeMonitor()
                          1 = 2 bit
                          2 = 4 bit
                          3 = 8 bit
+ \param adaptive      If true, use a coarse-to-fine scan (see eyeScanAdaptive): only
+                      the region around the eye boundary is scanned at the selected
+                      resolution. Ignored if the step size is already coarse.
+ \param converge      If true, track the convergence of each band of the scan (see
+                      bandConvergenceUpdate): repeats only re-scan bands which haven't
+                      converged, and the result is flagged when all bands have.
 
  \return globals::OK
+ \return globals::INVALID_DATA  A step, offset or resolution index is out of range
  \return [error code]
 */
 int EyeMonitor::startScan(int type,
                           int hStepIndex,
                           int vStepIndex,
                           int vOffsetIndex,
-                          int countResIndex)
+                          int countResIndex,
+                          bool adaptive,
+                          bool converge)
 {
-    Q_ASSERT( (hStepIndex >= 0)    && (hStepIndex < GT1724::EYESCAN_VHSTEP_LOOKUP.size()) &&
-              (vStepIndex >= 0)    && (vStepIndex < GT1724::EYESCAN_VHSTEP_LOOKUP.size()) &&
-              (countResIndex >= 0) && (countResIndex <= 3) );
+    const bool paramsValid = (hStepIndex >= 0)    && (hStepIndex < GT1724::EYESCAN_VHSTEP_LOOKUP.size()) &&
+                             (vStepIndex >= 0)    && (vStepIndex < GT1724::EYESCAN_VHSTEP_LOOKUP.size()) &&
+                             (vOffsetIndex >= 0)  && (vOffsetIndex < GT1724::EYESCAN_VOFF_LOOKUP.size()) &&
+                             (countResIndex >= 0) && (countResIndex <= 3);
+    Q_ASSERT(paramsValid);
+    if (!paramsValid)
+    {
+        parent->emitEyeScanError(laneOffset + scanLane, type, globals::INVALID_DATA);  // Client is waiting for the scan
+        return globals::INVALID_DATA;
+    }
 
     stopFlag     = false;
     scanType     = type;
@@ -81,14 +108,22 @@ int EyeMonitor::startScan(int type,
     scanCountResBits  = static_cast<uint8_t>(1 << countResIndex); // Converted to number of bits (1, 2, 4 or 8), for size calcs.
 
     scanRepeatCount = 1;
-
-    qDebug() << "Eye Scan Configuration:";
-    qDebug() << " Type:       " << ((scanType == GT1724::GT1724_EYE_SCAN) ? "Eye Scan" : "Bathtub Scan");
-    qDebug() << " Lane:       " << scanLane;
-    qDebug() << " H Step:     " << scanHStep;
-    qDebug() << " V Step:     " << scanVStep;
-    qDebug() << " V Offset:   " << scanVOffset;
-    qDebug() << " Resolution: " << scanCountResBits << " (index " << scanCountResIndex << ")";
+    scanConverge = converge;
+
+    // Adaptive scan only helps if the fine step is smaller than the coarse step:
+    scanAdaptive = adaptive &&
+                   (scanHStep < EYESCAN_ADAPTIVE_COARSE_STEP) &&
+                   ((scanType != GT1724::GT1724_EYE_SCAN) || (scanVStep < EYESCAN_ADAPTIVE_COARSE_STEP));
+
+    DEBUG_EYESCAN("Eye Scan Configuration:")
+    DEBUG_EYESCAN(" Type:       " << ((scanType == GT1724::GT1724_EYE_SCAN) ? "Eye Scan" : "Bathtub Scan"))
+    DEBUG_EYESCAN(" Lane:       " << scanLane)
+    DEBUG_EYESCAN(" H Step:     " << scanHStep)
+    DEBUG_EYESCAN(" V Step:     " << scanVStep)
+    DEBUG_EYESCAN(" V Offset:   " << scanVOffset)
+    DEBUG_EYESCAN(" Resolution: " << scanCountResBits << " (index " << scanCountResIndex << ")")
+    DEBUG_EYESCAN(" Adaptive:   " << scanAdaptive)
+    DEBUG_EYESCAN(" Converge:   " << scanConverge)
 
     return eyeScanRun(true);
 }
@@ -99,6 +134,9 @@ int EyeMonitor::startScan(int type,
  \brief Repeat Scan
         The previous scan is repeated with the same parameters.
         New data are added to the existing data, then normalised.
+        In converge mode, bands which have converged are skipped; if
+        all bands have converged, the whole scan is repeated and each
+        band has to converge again.
         NOTE: If a scan has not previously been run, an error is
         returned.
         See notes above re: slots / signals
@@ -110,6 +148,11 @@ int EyeMonitor::repeatScan()
     Q_ASSERT(scanRepeatCount > 0);
     if (scanRepeatCount == 0) return globals::GEN_ERROR;
     scanRepeatCount++;
+    if (scanConverge && !bandConverged.contains(false))
+    {
+        bandConverged.fill(false);
+        bandStable.fill(0);
+    }
     return eyeScanRun(false);
 }
 
@@ -140,7 +183,9 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
 {
     int scanResult = globals::OK;
     uint8_t *rawDataBuffer = NULL;
-    QVector<double> eyeDataBufferTmp;
+    QVector<uint8_t> eyeDataBufferTmp;   // Raw samples from this scan (max 8 bits per sample)
+    QVector<quint32> eyeDataPrevious;    // Converge mode: Accumulated counts before this scan
+    int band;
 
     int numSamples = 1;
     int eyeDataBufferIndexMax = 1;
@@ -164,11 +209,11 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
     }
     imageStartAddress = static_cast<uint16_t>(static_cast<uint16_t>(imageAddressMSB) << 8) + static_cast<uint16_t>(imageAddressLSB);
     imageMaximumSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
-    qDebug() << "Eye Scan - Image Start Address: " << imageStartAddress
-             << "; Size: " << imageMaximumSize;
+    DEBUG_EYESCAN("Eye Scan - Image Start Address: " << imageStartAddress
+               << "; Size: " << imageMaximumSize)
 
     /**** Eye Scan: *****************************************************/
-    qDebug() << "**Starting Eye Scan**";
+    DEBUG_EYESCAN("**Starting Eye Scan**")
 
     uint8_t numPhaseSteps;
     uint8_t numOffsetStepsMax;
@@ -210,9 +255,9 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
                );
     */
 
-    qDebug() << " numPhaseSteps: " << numPhaseSteps
-             << "; bytesPerLine: " << bytesPerLine
-             << "; numOffsetStepsMax: " << numOffsetStepsMax;
+    DEBUG_EYESCAN(" numPhaseSteps: " << numPhaseSteps
+               << "; bytesPerLine: " << bytesPerLine
+               << "; numOffsetStepsMax: " << numOffsetStepsMax)
 
     // Calculate the number of lines in the full scan:
     if (scanType == GT1724::GT1724_EYE_SCAN)
@@ -234,7 +279,7 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
         */
 
         scanVRes = numOffsetSteps;
-        qDebug() << "Eye Scan - Total number of lines: " << numOffsetSteps;
+        DEBUG_EYESCAN("Eye Scan - Total number of lines: " << numOffsetSteps)
     }
     else
     {
@@ -246,9 +291,18 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
         numOffsetSteps = 1;
         scanVRes = 1;
         scanVStep = 1;
-        qDebug() << "Bathtub Scan - One line at specified offset.";
+        DEBUG_EYESCAN("Bathtub Scan - One line at specified offset.")
     }
 
+    // Bands: Rows read back by each sweep of the loop below. Nb: An adaptive
+    // scan sweeps regions rather than rows, so it is handled as one band.
+    if (resetFlag)
+    {
+        if (scanAdaptive || numOffsetSteps <= numOffsetStepsMax) bandReset(numOffsetSteps, numOffsetSteps);
+        else                                                      bandReset(numOffsetStepsMax, numOffsetSteps);
+    }
+    bandScanned.fill(false);
+
     // Calculate total number of samples, and allocate buffer for data:
     numSamples = numPhaseSteps * numOffsetSteps;
     bufferReset(eyeDataBufferTmp, numSamples);
@@ -274,9 +328,38 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
     if (numOffsetSteps > numOffsetStepsMax) thisOffsetStop = offsetStart + (numOffsetStepsMax - 1) * scanVStep;
     else                                    thisOffsetStop = offsetStop;
 
+#define BERT_EYESCAN_SHIFT 1    // Define this to enable eye / bathtub "Shift" (make sure eye starts at left edge for visual appeal)
+// #define BERT_EYESCAN_EXTEND 1   // Define this to enable eye "Extend" (copy some data from start of eye and place it at end for visual appeal; i.e. width of plot is greater than 1 UI)
+
+    // Shift used for partial results streamed to the UI during the scan (see emitPartialResult).
+    // After a reset this isn't known until the centre row has been scanned.
+#ifdef BERT_EYESCAN_SHIFT
+    if (resetFlag) partialShift = 0;
+    else           partialShift = nShift;
+#else
+    partialShift = 0;
+#endif
+    partialShiftFound = !resetFlag;
+
     parent->emitEyeScanProgressUpdate(laneOffset + scanLane, scanType, 0);
 
-    while (thisOffsetStart <= offsetStop)
+    if (scanAdaptive)
+    {
+        // Coarse-to-fine scan: Fills eyeDataBufferTmp; the full scan loop below is skipped.
+        scanResult = eyeScanAdaptive(eyeDataBufferTmp,
+                                     numPhaseSteps,
+                                     numOffsetSteps,
+                                     rawDataBuffer,
+                                     imageAddressMSB,
+                                     imageAddressLSB,
+                                     imageMaximumSize,
+                                     resetFlag);
+        if (scanResult != globals::OK) goto finished;
+        eyeDataBufferIndex = numSamples;
+        bandScanned.fill(true);
+    }
+
+    while (!scanAdaptive && (thisOffsetStart <= offsetStop))
     {
         parent->eyeScanCheckForCancel();
         if (stopFlag)
@@ -285,15 +368,30 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
             scanResult = globals::CANCELLED;
             goto finished;
         }
+        //// SKIP CONVERGED BAND: //////////////////////////////
+        // Converge mode: The rows of a converged band are left at zero in this
+        // scan's data (see bandRowFullScale):
+        band = eyeDataBufferIndex / (numPhaseSteps * bandRows);
+        if (scanConverge && bandConverged.value(band, false))
+        {
+            DEBUG_EYESCAN_PART("--Band " << band << " converged: Skipped--")
+            eyeDataBufferIndex += numPhaseSteps * (((thisOffsetStop - thisOffsetStart) / scanVStep) + 1);
+            // Advance start and stop offsets (as below):
+            thisOffsetStart = thisOffsetStop + scanVStep;
+            thisOffsetStop = thisOffsetStart + ( (numOffsetStepsMax - 1) * scanVStep );
+            if (thisOffsetStop > offsetStop) thisOffsetStop = offsetStop;
+            continue;
+        }
+        bandScanned[band] = true;
         //// SCAN: /////////////////////////////////////////////
-        qDebug() << "** Starting part scan: **\n"
-                 << "   phaseStart: " << 0
-                 << "   phaseStop: " << 127
-                 << "   phaseStep: " << scanHStep << "\n"
-                 << "   thisOffsetStart: " << thisOffsetStart
-                 << "   thisOffsetStop: " << thisOffsetStop
-                 << "   offsetStep: " << scanVStep << "\n"
-                 << "   resolution: " << scanCountResBits;
+        DEBUG_EYESCAN_PART("** Starting part scan: **\n"
+                        << "   phaseStart: " << 0
+                        << "   phaseStop: " << 127
+                        << "   phaseStep: " << scanHStep << "\n"
+                        << "   thisOffsetStart: " << thisOffsetStart
+                        << "   thisOffsetStop: " << thisOffsetStop
+                        << "   offsetStep: " << scanVStep << "\n"
+                        << "   resolution: " << scanCountResBits)
 
         scanResult = controlEyeSweep(0,        // phaseStart
                                      127,      // phaseStop
@@ -304,7 +402,7 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
                                      scanCountResIndex,
                                      &outputSizeMSB,
                                      &outputSizeLSB);
-        qDebug() << "** Part scan finished. Result: " << scanResult;
+        DEBUG_EYESCAN_PART("** Part scan finished. Result: " << scanResult)
         if (scanResult != globals::OK)
         {
             qDebug() << "Error running scan: " << scanResult;
@@ -321,7 +419,7 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
 
         outputSize = static_cast<uint16_t>(static_cast<uint16_t>(outputSizeMSB) << 8) + static_cast<uint16_t>(outputSizeLSB);
         //// READ DATA: /////////////////////////////////////////////
-        qDebug() << "--Reading back scan data: " << outputSize << " bytes --";
+        DEBUG_EYESCAN_PART("--Reading back scan data: " << outputSize << " bytes --")
 
         scanResult = parent->rawRead24(0xFC,
                                        imageAddressMSB,
@@ -334,53 +432,47 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
             goto finished;
         }
         //// UNPACK DATA: //////////////////////////////////////////
-        qDebug() << "--Unpacking scan data...\n"
-                 << "  Tot Num Samples:  " << numSamples << "\n"
-                 << "  THIS block size:  " << outputSize << "\n"
-                 << "  Buffer Remaining: " << eyeDataBufferIndexMax - eyeDataBufferIndex + 1;
+        DEBUG_EYESCAN_PART("--Unpacking scan data...\n"
+                        << "  Tot Num Samples:  " << numSamples << "\n"
+                        << "  THIS block size:  " << outputSize << "\n"
+                        << "  Buffer Remaining: " << eyeDataBufferIndexMax - eyeDataBufferIndex + 1)
 
 
 
-        for (size_t sampleIndex = 0; sampleIndex < static_cast<size_t>(outputSize); sampleIndex++)
         {
-            // Sanity check: Make sure we aren't about to overflow the output buffer:
-            Q_ASSERT(eyeDataBufferIndex <= eyeDataBufferIndexMax);
-            if (eyeDataBufferIndex > eyeDataBufferIndexMax) { scanResult = globals::OVERFLOW; goto finished; }
+            // Sanity check: Make sure the whole block will fit in the output buffer:
+            const int nBlockSamples = static_cast<int>(outputSize) * (8 / scanCountResBits);
+            Q_ASSERT(eyeDataBufferIndex + nBlockSamples <= eyeDataBufferIndexMax + 1);
+            if (eyeDataBufferIndex + nBlockSamples > eyeDataBufferIndexMax + 1) { scanResult = globals::OVERFLOW; goto finished; }
+
+            unpackSamples(rawDataBuffer,
+                          static_cast<size_t>(outputSize),
+                          scanCountResBits,
+                          eyeDataBufferTmp.data() + eyeDataBufferIndex);
+            eyeDataBufferIndex += nBlockSamples;
+        }
 
-            switch (scanCountResBits)
+        //// STREAM PARTIAL RESULT: ////////////////////////////////
+        // If there are more parts to scan, send the rows received so far to
+        // the UI, so the plot fills in as the scan runs:
+        if (thisOffsetStop < offsetStop)
+        {
+            const int rowsDone = eyeDataBufferIndex / numPhaseSteps;
+#ifdef BERT_EYESCAN_SHIFT
+            if (!partialShiftFound && rowsDone > (numOffsetSteps / 2))
             {
-            case 1: // 1  bit per sample:
-                for (int bitIndex = 0; bitIndex < 8; bitIndex++)
-                {
-                    // For each bit, shift and mask, and store to output as uint8_t:
-                    eyeDataBufferTmp[eyeDataBufferIndex] = static_cast<double>((rawDataBuffer[sampleIndex] >> (7-bitIndex)) & 0x01);
-                    eyeDataBufferIndex++;
-                }
-                break;
-            case 2: // 2  bits per sample:
-                for (int bitIndex = 0; bitIndex < 8; bitIndex+=2)
-                {
-                    // For each bit, shift and mask, and store to output as uint8_t:
-                    eyeDataBufferTmp[eyeDataBufferIndex] = static_cast<double>((rawDataBuffer[sampleIndex] >> (6-bitIndex)) & 0x03);
-                    eyeDataBufferIndex++;
-                }
-                break;
-            case 4: // 4  bits per sample:
-                for (int bitIndex = 0; bitIndex < 8; bitIndex+=4)
-                {
-                    // For each bit, shift and mask, and store to output as uint8_t:
-                    eyeDataBufferTmp[eyeDataBufferIndex] = static_cast<double>((rawDataBuffer[sampleIndex] >> (4-bitIndex)) & 0x0F);
-                    eyeDataBufferIndex++;
-                }
-                break;
-            case 8: // 8  bits per sample:
-                eyeDataBufferTmp[eyeDataBufferIndex] = static_cast<double>(rawDataBuffer[sampleIndex]);
-                eyeDataBufferIndex++;
+                // Centre row (used by peakFind) is now available: Find shift
+                uint8_t peakIndex = peakFind(eyeDataBufferTmp, numPhaseSteps, numOffsetSteps);
+                if (peakIndex <= (numPhaseSteps / 2)) partialShift = static_cast<int>(peakIndex);
+                else                                  partialShift = static_cast<int>(peakIndex - numPhaseSteps);
+                partialShiftFound = true;
             }
+#endif
+            emitPartialResult(eyeDataBufferTmp, numPhaseSteps, numOffsetSteps, rowsDone, resetFlag);
         }
 
         //// Advance start and stop offsets: ///////////////////////
-        qDebug() << "--Adjusting offsets for next part...";
+        DEBUG_EYESCAN_PART("--Adjusting offsets for next part...")
         //Start = Stop + OffsetStep:
         thisOffsetStart = thisOffsetStop + scanVStep;
         //Stop = Start + (NumOffsetStepsMax - 1) * OffsetStep:
@@ -392,13 +484,10 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
         parent->emitEyeScanProgressUpdate(laneOffset + scanLane, scanType, (eyeDataBufferIndex * 100) / numSamples);
     }
 
-#define BERT_EYESCAN_SHIFT 1    // Define this to enable eye / bathtub "Shift" (make sure eye starts at left edge for visual appeal)
-// #define BERT_EYESCAN_EXTEND 1   // Define this to enable eye "Extend" (copy some data from start of eye and place it at end for visual appeal; i.e. width of plot is greater than 1 UI)
-
     if (scanResult == globals::OK)
     {
         // Finished successfully.
-        QVector<double> eyeDataBufferTmpAdj;  // Vector for adjusted data (shift / extend)
+        QVector<uint8_t> eyeDataBufferTmpAdj;  // Vector for adjusted data (shift / extend)
 
         if (scanType == GT1724::GT1724_EYE_SCAN)
         {
@@ -431,7 +520,7 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
         #endif
             }
             qDebug() << "SHIFT: Rotate eye plot " << nShift << " samples";
-            QVector<double> eyeDataBufferTmpShf;  // Vector for shifted data
+            QVector<uint8_t> eyeDataBufferTmpShf;  // Vector for shifted data
             scanResult = dataShift(eyeDataBufferTmp,
                                    eyeDataBufferTmpShf,
                                    numPhaseSteps,
@@ -439,7 +528,7 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
                                    nShift);
             if (scanResult != globals::OK) goto finished;
     #else   // No Shift:
-            QVector<double> eyeDataBufferTmpShf;  // Vector for shifted data
+            QVector<uint8_t> eyeDataBufferTmpShf;  // Vector for shifted data
             eyeDataBufferTmpShf = eyeDataBufferTmp;
     #endif  // Shift ?
 
@@ -454,7 +543,7 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
             size_t numSamplesExt = numPhaseStepsExt * numOffsetSteps;
             eyeDataBufferTmpAdj.clear();
             eyeDataBufferTmpAdj.resize((int)numSamplesExt);
-            eyeDataBufferTmpAdj.fill(0.0);
+            eyeDataBufferTmpAdj.fill(0);
 
             size_t x, y, sampleIndex, storeIndex;
             storeIndex = 0;
@@ -517,7 +606,6 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
         {
             // New Scan... reset the global scan data buffer.
             bufferReset(eyeDataBuffer, eyeDataBufferTmpAdj.size());
-            bufferReset(eyeDataBufferNorm, eyeDataBufferTmpAdj.size());
         }
         // Ensure that global scan data buffer is the same size as the results from this scan:
         Q_ASSERT(eyeDataBuffer.size() == eyeDataBufferTmpAdj.size());
@@ -525,19 +613,22 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
         {
             // For production, if the size changes for some reason, throw away the old data:
             bufferReset(eyeDataBuffer, eyeDataBufferTmpAdj.size());
-            bufferReset(eyeDataBufferNorm, eyeDataBufferTmpAdj.size());
         }
 
-        ////// ACCUMULATE / NORMALISE: ////////////////////////////////////////////////
-        double nBitsAnalysed = (double)((uint16_t)(1 << scanCountResBits)) * (double)scanRepeatCount;
-        const double eyeScanLogFloor = 1.0 / (double)nBitsAnalysed;
+        ////// ACCUMULATE: ////////////////////////////////////////////////////////////
+        // Nb: Normalisation is done by EyeScanResult when the data are plotted.
+        if (scanConverge) eyeDataPrevious = eyeDataBuffer;   // Copied when eyeDataBuffer is changed below
+        double countFullScale = (double)((uint16_t)(1 << scanCountResBits)) * (double)scanRepeatCount;
+        const int nAccumulate = eyeDataBufferTmpAdj.size();
+        const uint8_t *scanData = eyeDataBufferTmpAdj.constData();
+        quint32 *accData = eyeDataBuffer.data();
 
         // For debugging eye scan data as CSV: #define DEBUG_EYE_DATA(MSG) qDebug() << MSG;
         #define DEBUG_EYE_DATA(MSG)  // No debug.
-        DEBUG_EYE_DATA("Repeats Done: " << scanRepeatCount << "; Bits Analysed: " << nBitsAnalysed << "; Log Floor: " << eyeScanLogFloor)
+        DEBUG_EYE_DATA("Repeats Done: " << scanRepeatCount << "; Full Scale: " << countFullScale << "; Log Floor: " << (1.0 / countFullScale))
         DEBUG_EYE_DATA("-----------------------------------------")
-        DEBUG_EYE_DATA("Repeats,TotalBits,Floor")
-        DEBUG_EYE_DATA(scanRepeatCount << "," << nBitsAnalysed << "," << eyeScanLogFloor)
+        DEBUG_EYE_DATA("Repeats,FullScale,Floor")
+        DEBUG_EYE_DATA(scanRepeatCount << "," << countFullScale << "," << (1.0 / countFullScale))
         DEBUG_EYE_DATA("")
         DEBUG_EYE_DATA("i,Errors,BER")
 
@@ -546,12 +637,12 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
 // Note this is a quick fix which introduces an opposite error, i.e. dropping some valid error counts.
 //#define EYE_DATA_QUANTISATION_QUICKFIX 1
 
-        for (int i = 0; i < eyeDataBufferTmpAdj.size(); i++)
+        for (int i = 0; i < nAccumulate; i++)
         {
 #ifdef EYE_DATA_QUANTISATION_QUICKFIX
-            if (eyeDataBufferTmpAdj[i] > 1)
+            if (scanData[i] > 1)
             {
-                eyeDataBuffer[i] += eyeDataBufferTmpAdj[i];   // Add most recent scan to all previous scans
+                accData[i] += scanData[i];   // Add most recent scan to all previous scans
             }
             /* EXPERIMENTAL AND HACKY.
             else if (eyeDataBufferTmpAdj[i] == 1)
@@ -562,29 +653,21 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
             }
             */
 #else
-            eyeDataBuffer[i] += eyeDataBufferTmpAdj[i];   // Add most recent scan to all previous scans
+            accData[i] += scanData[i];   // Add most recent scan to all previous scans
 #endif
-            // Normalise the data point (using log 10):
-            double thisValue = eyeDataBuffer[i] / nBitsAnalysed;
-            if (thisValue < eyeScanLogFloor)
-            {
-                DEBUG_EYE_DATA("," << eyeDataBuffer[i] << "," << eyeScanLogFloor << ", V")
-                if (scanType == GT1724::GT1724_EYE_SCAN) eyeDataBufferNorm[i] = log10(eyeScanLogFloor);
-                else                                     eyeDataBufferNorm[i] = globals::BELOW_DETECTION_LIMIT;
-                    // For Bathtub Plot Only: Set "floor" of plot (= error rate below detection limit) to a very negative value.
-                    // Used by bathtub plot widget to hide invalid values at the bottom of the plot curve.
-            }
-            else
-            {
-                DEBUG_EYE_DATA("," << eyeDataBuffer[i] << "," << thisValue << ", ")
-                eyeDataBufferNorm[i] = log10(thisValue);
-            }
+            DEBUG_EYE_DATA(i << "," << accData[i] << "," << (accData[i] / countFullScale))
         }
         DEBUG_EYE_DATA("-----------------------------------------")
         ////////////////////////////////////////////////////////////////////////////////
 
+        if (scanConverge)
+        {
+            bandConvergenceUpdate(eyeDataPrevious, scanHRes);
+            DEBUG_EYESCAN("CONVERGE: " << bandConverged.count(true) << " of " << bandConverged.size() << " bands converged")
+        }
+
         // Data successfully aquired!
-        qDebug() << "--Scan data aquired! Transmitting results...";
+        DEBUG_EYESCAN("--Scan data aquired! Transmitting results...")
 
 //#define BERT_EYESCAN_EXTRA_DEBUG
 #ifdef BERT_EYESCAN_EXTRA_DEBUG
@@ -608,10 +691,15 @@ int EyeMonitor::eyeScanRun(bool resetFlag)
         //////////////////////////////////////////////////////
 #endif
 
-        parent->emitEyeScanFinished(laneOffset + scanLane, scanType, eyeDataBufferNorm, scanHRes, scanVRes);
-qDebug() << "--Transmitting data. scanHRes: " << scanHRes << "; scanVRes: " << scanVRes;
+        // Nb: The result shares eyeDataBuffer (implicitly shared); no copy is made
+        // unless a repeat scan modifies the buffer while the UI still holds the result.
+        EyeScanResult result(scanType, scanHRes, scanVRes, eyeDataBuffer, countFullScale);
+        result.setRowFullScale(bandRowFullScale(scanVRes, false));
+        result.setConverged(scanConverge && !bandConverged.contains(false));
+        parent->emitEyeScanFinished(laneOffset + scanLane, scanType, result);
+DEBUG_EYESCAN("--Transmitting data. scanHRes: " << scanHRes << "; scanVRes: " << scanVRes)
     }
-    qDebug() << "**Eye Scan finshed OK. **";
+    DEBUG_EYESCAN("**Eye Scan finshed OK. **")
 
   finished:
     // Clean up temp buffer:
@@ -626,9 +714,389 @@ qDebug() << "--Transmitting data. scanHRes: " << scanHRes << "; scanVRes: " << s
 
 
 
+/*!
+ \brief Run a coarse-to-fine (adaptive) scan
+
+ Most of a fine eye scan is spent on the open centre of the eye and on the
+ closed region outside it, neither of which tells us much. Instead:
+  1) Scan the whole eye at a coarse step (EYESCAN_ADAPTIVE_COARSE_STEP);
+  2) Fill the fine grid with the nearest coarse sample;
+  3) Re-scan only the coarse "cells" where the error count crosses
+     EYESCAN_ADAPTIVE_THRESHOLD (i.e. the eye boundary) at the selected
+     (fine) step, and copy the results into the fine grid.
+
+ For a bathtub scan the same method is used along the single row.
+ Nb: Features smaller than one coarse cell which don't touch the coarse
+ sample points (e.g. a small closed island inside the eye) may be missed.
+
+ \param output           Buffer for results (numPhaseSteps * numOffsetSteps samples)
+ \param numPhaseSteps    Number of fine points per row
+ \param numOffsetSteps   Number of fine rows
+ \param rawDataBuffer    Buffer for raw data read back from chip (imageMaximumSize bytes)
+ \param imageAddressMSB  Eye scan output memory address (see queryEyeScanMem)
+ \param imageAddressLSB  Eye scan output memory address (see queryEyeScanMem)
+ \param imageMaximumSize Eye scan output memory size (see queryEyeScanMem)
+ \param resetFlag        True if this is the first scan after a reset (for partial results)
+
+ \return globals::OK
+ \return globals::CANCELLED  Scan cancelled
+ \return [error code]
+*/
+int EyeMonitor::eyeScanAdaptive(QVector<uint8_t> &output,
+                                const uint8_t numPhaseSteps,
+                                const uint8_t numOffsetSteps,
+                                uint8_t *rawDataBuffer,
+                                const uint8_t imageAddressMSB,
+                                const uint8_t imageAddressLSB,
+                                const uint16_t imageMaximumSize,
+                                const bool resetFlag)
+{
+    const bool eye = (scanType == GT1724::GT1724_EYE_SCAN);
+    const int  C   = EYESCAN_ADAPTIVE_COARSE_STEP;
+    const int  nCX = 128 / C;                   // Coarse points per row (phase 0, C, 2C, ...)
+    const int  nCY = eye ? ((126 / C) + 1) : 1; // Coarse rows (offset 1, 1+C, 1+2C, ... up to 127)
+    const int  pointsPerCell = C / scanHStep;   // Fine points per coarse cell (horizontal)
+    int result;
+
+    Q_ASSERT(output.size() == numPhaseSteps * numOffsetSteps);
+    if (output.size() != numPhaseSteps * numOffsetSteps) return globals::OVERFLOW;
+
+    // Refined regions must be a whole number of bytes wide (each row of
+    // data from the chip starts on a byte boundary): find the minimum
+    // number of cells to scan at once:
+    int cellStep = 1;
+    while (((cellStep * pointsPerCell * scanCountResBits) % 8) != 0) cellStep++;
+
+    //// COARSE PASS: ////////////////////////////////////////////
+    QVector<uint8_t> coarse(nCX * nCY);
+    result = sweepRegion(0, C, nCX,
+                         eye ? 1 : scanVOffset, eye ? C : 1, nCY,
+                         rawDataBuffer, imageAddressMSB, imageAddressLSB, imageMaximumSize,
+                         coarse.data());
+    if (result != globals::OK) return result;
+    int pointsMeasured = nCX * nCY;
+
+    // Fill the fine grid from the nearest coarse sample:
+    uint8_t *out = output.data();
+    for (int j = 0; j < numOffsetSteps; j++)
+    {
+        const int cy = eye ? std::min((j * scanVStep) / C, nCY - 1) : 0;
+        for (int i = 0; i < numPhaseSteps; i++) out[(j * numPhaseSteps) + i] = coarse[(cy * nCX) + ((i * scanHStep) / C)];
+    }
+    emitPartialResult(output, numPhaseSteps, numOffsetSteps, numOffsetSteps, resetFlag);
+
+    //// REFINE: /////////////////////////////////////////////////
+    QVector<uint8_t> region;
+    for (int cy = 0; cy < nCY; cy++)
+    {
+        parent->eyeScanCheckForCancel();
+        if (stopFlag) return globals::CANCELLED;
+
+        // Fine rows which lie in this coarse row band:
+        int jStart = 0;
+        int jEnd   = 0;
+        if (eye)
+        {
+            jStart = ((cy * C) + scanVStep - 1) / scanVStep;
+            if (cy == (nCY - 1)) jEnd = numOffsetSteps - 1;
+            else                 jEnd = std::min((((cy + 1) * C) - 1) / scanVStep, numOffsetSteps - 1);
+        }
+        const int nRows = jEnd - jStart + 1;
+        const int cyNext = std::min(cy + 1, nCY - 1);
+
+        int cx = 0;
+        while (nRows > 0 && cx < nCX)
+        {
+            if (!adaptiveCellIsBoundary(coarse, nCX, cx, cy, cyNext)) { cx++; continue; }
+            // Find a run of adjacent boundary cells, and scan them together:
+            int cxEnd = cx;
+            while ((cxEnd + 1) < nCX && adaptiveCellIsBoundary(coarse, nCX, cxEnd + 1, cy, cyNext)) cxEnd++;
+            int nCells = (((cxEnd - cx + 1) + cellStep - 1) / cellStep) * cellStep;
+            int cxStart = cx;
+            if ((cxStart + nCells) > nCX) cxStart = nCX - nCells;
+
+            const int nPoints = nCells * pointsPerCell;
+            region.resize(nPoints * nRows);
+            result = sweepRegion(static_cast<uint8_t>(cxStart * C), scanHStep, nPoints,
+                                 eye ? static_cast<uint8_t>(1 + (jStart * scanVStep)) : scanVOffset, eye ? scanVStep : 1, nRows,
+                                 rawDataBuffer, imageAddressMSB, imageAddressLSB, imageMaximumSize,
+                                 region.data());
+            if (result != globals::OK) return result;
+            for (int r = 0; r < nRows; r++)
+            {
+                std::copy(region.constData() + (r * nPoints),
+                          region.constData() + ((r + 1) * nPoints),
+                          out + ((jStart + r) * numPhaseSteps) + (cxStart * pointsPerCell));
+            }
+            pointsMeasured += nPoints * nRows;
+            cx = cxStart + nCells;
+
+            parent->eyeScanCheckForCancel();
+            if (stopFlag) return globals::CANCELLED;
+        }
+        parent->emitEyeScanProgressUpdate(laneOffset + scanLane, scanType, ((cy + 1) * 100) / nCY);
+    }
+    DEBUG_EYESCAN("Adaptive Scan: Measured " << pointsMeasured << " points (full scan: "
+               << (numPhaseSteps * numOffsetSteps) << ")")
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Check whether a coarse cell lies on the eye boundary
+ A cell is on the boundary if its corner samples include counts both at or
+ below and above EYESCAN_ADAPTIVE_THRESHOLD. The cell to the right of the
+ last column wraps around to column 0 (the eye scan covers one UI).
+ \param coarse  Coarse scan samples (nCX * number of rows)
+ \param nCX     Number of coarse points per row
+ \param cx      Cell column
+ \param cy      Cell row (top corners)
+ \param cyNext  Row of lower corners (= cy for a single row scan)
+ \return true   Cell needs to be refined
+*/
+bool EyeMonitor::adaptiveCellIsBoundary(const QVector<uint8_t> &coarse,
+                                        const int nCX,
+                                        const int cx,
+                                        const int cy,
+                                        const int cyNext)
+{
+    const int cxNext = (cx + 1) % nCX;
+    const uint8_t a = coarse[(cy * nCX) + cx];
+    const uint8_t b = coarse[(cy * nCX) + cxNext];
+    const uint8_t c = coarse[(cyNext * nCX) + cx];
+    const uint8_t d = coarse[(cyNext * nCX) + cxNext];
+    const uint8_t lo = std::min(std::min(a, b), std::min(c, d));
+    const uint8_t hi = std::max(std::max(a, b), std::max(c, d));
+    return (lo <= EYESCAN_ADAPTIVE_THRESHOLD) && (hi > EYESCAN_ADAPTIVE_THRESHOLD);
+}
+
+
+
+/*!
+ \brief Scan a rectangular region of the eye
+ Runs the "Control Eye Sweep" macro over the region (split into several
+ sweeps if it doesn't fit in the eye scan memory), reads back the data
+ and unpacks the samples, row by row, into output.
+ Nb: nPoints * scanCountResBits must be a multiple of 8, so that
+ each row starts on a byte boundary.
+ \param phaseStart       First phase (0-127)
+ \param phaseStep        Phase step
+ \param nPoints          Number of points per row
+ \param offsetStart      First offset (1-127)
+ \param offsetStep       Offset step
+ \param nRows            Number of rows
+ \param rawDataBuffer    Buffer for raw data (imageMaximumSize bytes)
+ \param imageAddressMSB  Eye scan output memory address
+ \param imageAddressLSB  Eye scan output memory address
+ \param imageMaximumSize Eye scan output memory size
+ \param output           Destination for samples (nPoints * nRows)
+ \return globals::OK
+ \return globals::OVERFLOW  Region too large or unexpected data size
+ \return [error code]
+*/
+int EyeMonitor::sweepRegion(const uint8_t phaseStart,
+                            const uint8_t phaseStep,
+                            const int nPoints,
+                            const uint8_t offsetStart,
+                            const uint8_t offsetStep,
+                            const int nRows,
+                            uint8_t *rawDataBuffer,
+                            const uint8_t imageAddressMSB,
+                            const uint8_t imageAddressLSB,
+                            const uint16_t imageMaximumSize,
+                            uint8_t *output)
+{
+    Q_ASSERT(((nPoints * scanCountResBits) % 8) == 0);
+    const int bytesPerRow = (nPoints * scanCountResBits) / 8;
+    if (bytesPerRow < 1 || bytesPerRow > imageMaximumSize) return globals::OVERFLOW;
+    const int rowsPerSweep = imageMaximumSize / bytesPerRow;
+    const uint8_t phaseStop = static_cast<uint8_t>(phaseStart + ((nPoints - 1) * phaseStep));
+
+    int result;
+    uint8_t sizeMSB, sizeLSB;
+    for (int row = 0; row < nRows; row += rowsPerSweep)
+    {
+        const int rows = std::min(rowsPerSweep, nRows - row);
+        const uint8_t thisOffsetStart = static_cast<uint8_t>(offsetStart + (row * offsetStep));
+        const uint8_t thisOffsetStop  = static_cast<uint8_t>(thisOffsetStart + ((rows - 1) * offsetStep));
+        result = controlEyeSweep(phaseStart, phaseStop, phaseStep,
+                                 thisOffsetStart, thisOffsetStop, offsetStep,
+                                 scanCountResIndex, &sizeMSB, &sizeLSB);
+        if (result != globals::OK) return result;
+        const uint16_t outputSize = static_cast<uint16_t>(static_cast<uint16_t>(sizeMSB) << 8) + static_cast<uint16_t>(sizeLSB);
+        if (outputSize != (rows * bytesPerRow))
+        {
+            qDebug() << "Eye Scan: Unexpected data size for region: " << outputSize << " (expected " << (rows * bytesPerRow) << ")";
+            return globals::OVERFLOW;
+        }
+        result = parent->rawRead24(0xFC, imageAddressMSB, imageAddressLSB, rawDataBuffer, static_cast<size_t>(outputSize));
+        if (result != globals::OK) return result;
+        unpackSamples(rawDataBuffer, static_cast<size_t>(outputSize), scanCountResBits, output + (row * nPoints));
+    }
+    return globals::OK;
+}
+
+
+
+/*!
+ \brief Send a partial scan result to the UI
+ Called after each part of a multi-part scan. The rows scanned so far
+ (shifted by partialShift) are added to the counts from previous repeats,
+ and sent using the EyeScanPartial signal. Rows which haven't been scanned
+ yet in this pass contain counts from the previous repeats only (or 0
+ after a reset).
+ Nb: This is only a preview; the EyeScanFinished signal at the end of the
+ scan still carries the complete result.
+ \param scanData        Samples for this pass (sizeX * sizeY; unscanned rows are 0)
+ \param sizeX           Number of sample points horizontally
+ \param sizeY           Number of rows
+ \param rowsDone        Number of rows scanned so far in this pass
+ \param resetFlag       True if this is the first scan after a reset
+*/
+void EyeMonitor::emitPartialResult(QVector<uint8_t> &scanData,
+                                   const uint8_t sizeX,
+                                   const uint8_t sizeY,
+                                   const int rowsDone,
+                                   const bool resetFlag)
+{
+    QVector<uint8_t> shifted;
+    if (dataShift(scanData, shifted, sizeX, sizeY, partialShift) != globals::OK) return;
+
+    QVector<quint32> counts;
+    if (!resetFlag && eyeDataBuffer.size() == shifted.size()) counts = eyeDataBuffer;  // Detached below; eyeDataBuffer unchanged
+    else                                                      bufferReset(counts, shifted.size());
+    const uint8_t *src = shifted.constData();
+    quint32 *dst = counts.data();
+    for (int i = 0; i < shifted.size(); i++) dst[i] += src[i];
+
+    const double countFullScale = (double)((uint16_t)(1 << scanCountResBits)) * (double)scanRepeatCount;
+    EyeScanResult result(scanType, sizeX, sizeY, counts, countFullScale);
+    result.setRowFullScale(bandRowFullScale(sizeY, true));
+    parent->emitEyeScanPartial(laneOffset + scanLane, scanType, result, rowsDone);
+}
+
+
+
+
+/*!
+ \brief Reset the convergence state of the bands (new scan)
+ \param rowsPerBand  Rows read back by each sweep
+ \param numRows      Rows in the whole scan
+*/
+void EyeMonitor::bandReset(const int rowsPerBand, const int numRows)
+{
+    bandRows = qMax(1, rowsPerBand);
+    const int nBands = (numRows + bandRows - 1) / bandRows;
+    bandRepeats.fill(0, nBands);
+    bandStable.fill(0, nBands);
+    bandConverged.fill(false, nBands);
+    bandScanned.fill(false, nBands);
+}
+
+
+
+
+/*!
+ \brief Update the convergence state of the bands scanned in this pass
+ A band has converged when the change in its normalised contour
+ (see bandContourChange) has been below EYESCAN_CONVERGE_DELTA for
+ EYESCAN_CONVERGE_STABLE repeats in a row, and it has been scanned
+ at least EYESCAN_CONVERGE_REPEATS_MIN times. E.g. the band through
+ the centre of a deep eye needs more repeats before its few error
+ counts settle down than the bands at the top and bottom.
+ \param previous  Accumulated counts before this pass (empty after a reset)
+ \param rowWidth  Points per row
+*/
+void EyeMonitor::bandConvergenceUpdate(const QVector<quint32> &previous, const int rowWidth)
+{
+    for (int band = 0; band < bandRepeats.size(); band++)
+    {
+        if (!bandScanned[band]) continue;
+        bandRepeats[band]++;
+        if (previous.size() != eyeDataBuffer.size() || bandRepeats[band] < 2) continue;
+        if (bandContourChange(previous, band, rowWidth) < EYESCAN_CONVERGE_DELTA) bandStable[band]++;
+        else                                                                     bandStable[band] = 0;
+        if (bandRepeats[band] >= EYESCAN_CONVERGE_REPEATS_MIN && bandStable[band] >= EYESCAN_CONVERGE_STABLE)
+        {
+            bandConverged[band] = true;
+        }
+    }
+}
+
+
+
+
+/*!
+ \brief Change in the normalised contour of a band, from the last scan to this one
+ \param previous  Accumulated counts before this scan of the band
+ \param band      Band (bandRepeats must include this scan)
+ \param rowWidth  Points per row
+ \return Mean absolute change of log10 BER, over the points of the band
+          which have errors (as plotted: a point with no errors is at the
+          floor, 1 / bits). Points with no errors in either scan are below
+          the detection limit, so aren't included.
+*/
+double EyeMonitor::bandContourChange(const QVector<quint32> &previous, const int band, const int rowWidth) const
+{
+    const double fullScaleRepeat = (double)((uint16_t)(1 << scanCountResBits));   // As for countFullScale
+    const double logBitsNow = log10(fullScaleRepeat * bandRepeats[band]);
+    const double logBitsPrevious = log10(fullScaleRepeat * (bandRepeats[band] - 1));
+    const int iStart = band * bandRows * rowWidth;
+    const int iStop = qMin((band + 1) * bandRows * rowWidth, eyeDataBuffer.size());
+    const quint32 *now = eyeDataBuffer.constData();
+    const quint32 *before = previous.constData();
+    double change = 0.0;
+    int points = 0;
+    for (int i = iStart; i < iStop; i++)
+    {
+        if (now[i] == 0 && before[i] == 0) continue;
+        const double berNow = log10((double)qMax(now[i], 1u)) - logBitsNow;
+        const double berPrevious = log10((double)qMax(before[i], 1u)) - logBitsPrevious;
+        change += fabs(berNow - berPrevious);
+        points++;
+    }
+    return (points > 0) ? (change / points) : 0.0;
+}
+
+
+
+
+/*!
+ \brief Get the full scale count of each row, for bands scanned fewer times than the scan
+ In converge mode, converged bands aren't re-scanned, so their rows have
+ a smaller full scale count than the result. The counts are left as
+ measured (not extrapolated); the result carries each row's full scale
+ count instead (see EyeScanResult::setRowFullScale).
+ \param numRows   Rows in the result
+ \param inPass    true: Counts include the scan in progress (partial
+                  result), i.e. bands which aren't converged will have
+                  one more scan than bandRepeats at the end of this pass
+ \return Full scale count for each row, or an empty vector if every
+         band has had every repeat (all rows use the result's full scale)
+*/
+QVector<double> EyeMonitor::bandRowFullScale(const int numRows, const bool inPass) const
+{
+    QVector<double> rowFullScale;
+    if (!scanConverge) return rowFullScale;
+    const double fullScaleRepeat = (double)((uint16_t)(1 << scanCountResBits));   // As for countFullScale
+    for (int band = 0; band < bandRepeats.size(); band++)
+    {
+        const int repeats = bandRepeats[band] + ((inPass && !bandConverged[band]) ? 1 : 0);
+        if (repeats <= 0 || repeats >= scanRepeatCount) continue;
+        if (rowFullScale.isEmpty()) rowFullScale.fill(fullScaleRepeat * (double)scanRepeatCount, numRows);
+        const int rowStop = qMin((band + 1) * bandRows, numRows);
+        for (int row = band * bandRows; row < rowStop; row++) rowFullScale[row] = fullScaleRepeat * (double)repeats;
+    }
+    return rowFullScale;
+}
+
+
+
+
 /*!
  \brief Find the location of the "peak" in the centre row of the eye scan
- \param data   Reference to vector of scan data (doubles)
+ \param data   Reference to vector of scan data (raw samples)
                The array pointed to by data must contain
                sizeX * sizeY elements
  \param sizeX  Number of sample points horizontally (minimum 2)
@@ -638,24 +1106,22 @@ qDebug() << "--Transmitting data. scanHRes: " << scanHRes << "; scanVRes: " << s
                 the row through the vertical centre of the plot
                 This is a value between 0 and sizeX inclusive.
 */
-uint8_t EyeMonitor::peakFind(QVector<double> &data,
+uint8_t EyeMonitor::peakFind(QVector<uint8_t> &data,
                              const size_t sizeX,
                              const size_t sizeY)
 {
 qDebug() << "PEAK FIND:";
-    double zMax = 0.0;
+    uint8_t zMax = 0;
     size_t maxIndex = 0;
     const size_t yMid = sizeY / 2;
-    const size_t startIndex = (yMid * sizeX);
-    size_t sampleIndex = startIndex;
+    const uint8_t *row = data.constData() + (yMid * sizeX);
     for (size_t x = 0; x < sizeX; x++)
     {
-        if (data[sampleIndex] >= zMax)
+        if (row[x] >= zMax)
         {
-            maxIndex = (sampleIndex - startIndex);
-            zMax = data[sampleIndex];
+            maxIndex = x;
+            zMax = row[x];
         }
-        sampleIndex++;
     }
     return maxIndex;
 }
@@ -674,7 +1140,7 @@ qDebug() << "PEAK FIND:";
  the end of the row being 'wrapped' around, according to the
  value of nShift
 
- \param data         Reference to array of raw scan data (doubles)
+ \param data         Reference to array of raw scan data (samples)
                      The array pointed to by data must contain
                      sizeX * sizeY elements
 
@@ -690,10 +1156,10 @@ qDebug() << "PEAK FIND:";
                and sizeX (inclusive)
 
  \return globals::OK          Data shifted OK
- \return globals::GEN_ERROR   Couldn't shift (shift size too big?)
+ \return globals::GEN_ERROR   Couldn't shift (shift size too big, or no samples per row?)
 */
-int EyeMonitor::dataShift(QVector<double> &data,
-                          QVector<double> &dataShifted,
+int EyeMonitor::dataShift(QVector<uint8_t> &data,
+                          QVector<uint8_t> &dataShifted,
                           const size_t sizeX,
                           const size_t sizeY,
                           const int nShift)
@@ -701,6 +1167,8 @@ int EyeMonitor::dataShift(QVector<double> &data,
     // SHIFT: Cut one side off the array and place it on the other side.
     // A negative shift (shift plot to RIGHT) is actually a
     // complimentary positive shift, i.e. (size - abs(shift))
+    // Nb: sizeX is unsigned; an empty row would divide by zero below.
+    if (sizeX == 0) return globals::GEN_ERROR;
     size_t nShiftAbs;
     if (nShift >= 0)
       {  nShiftAbs = (size_t)nShift;  }
@@ -712,18 +1180,15 @@ int EyeMonitor::dataShift(QVector<double> &data,
     const size_t nSamples = (sizeX * sizeY);
     Q_ASSERT(nSamples == (size_t)data.size());
     if (nSamples != (size_t)data.size()) return globals::GEN_ERROR;
-    bufferReset(dataShifted, (int)nSamples);
-    size_t x, y, sampleIndex, storeIndex;
-    storeIndex = 0;
-    for (y = 0; y < sizeY; y++)
+    dataShifted.resize((int)nSamples);
+    // Each row is a rotation: samples [nShiftAbs..sizeX) followed by [0..nShiftAbs):
+    const uint8_t *src = data.constData();
+    uint8_t *dst = dataShifted.data();
+    for (size_t y = 0; y < sizeY; y++)
     {
-        for (x = 0; x < sizeX; x++)
-        {
-            sampleIndex = (y * sizeX) + x;
-            if (x < nShiftAbs) storeIndex = (y * sizeX) + x + (sizeX - nShiftAbs);
-            else               storeIndex = (y * sizeX) + x - nShiftAbs;
-            dataShifted[storeIndex] = data[sampleIndex];
-        }
+        std::rotate_copy(src, src + (nShiftAbs % sizeX), src + sizeX, dst);
+        src += sizeX;
+        dst += sizeX;
     }
     return globals::OK;
 }
@@ -846,16 +1311,83 @@ int EyeMonitor::controlEyeSweep(const uint8_t phaseStart,
 
 
 /*!
- \brief Clear a buffer of double values, and set to a new size.
-        The new vector is filled with 0.0
+ \brief Clear a buffer of sample / count values, and set to a new size.
+        The new vector is filled with 0
  \param buffer
  \param newSize
 */
-void EyeMonitor::bufferReset(QVector<double> &buffer, int newSize)
+void EyeMonitor::bufferReset(QVector<uint8_t> &buffer, int newSize)
+{
+    buffer.clear();
+    buffer.resize(newSize);
+    buffer.fill(0);
+}
+
+void EyeMonitor::bufferReset(QVector<quint32> &buffer, int newSize)
 {
     buffer.clear();
     buffer.resize(newSize);
-    buffer.fill(0.0);
+    buffer.fill(0);
+}
+
+
+
+
+/*!
+ \brief Expansion tables for packed eye scan samples
+ For each count resolution below 8 bits, maps a raw data byte to the
+ samples it contains (MSB first), so that unpacking is a table copy
+ with no per-sample shift / mask / branch.
+ Tables are built once on first use (3.5 kB).
+*/
+struct EyeScanUnpackTables
+{
+    uint8_t lut1[256][8];   // 1 bit per sample:  8 samples per byte
+    uint8_t lut2[256][4];   // 2 bits per sample: 4 samples per byte
+    uint8_t lut4[256][2];   // 4 bits per sample: 2 samples per byte
+
+    EyeScanUnpackTables()
+    {
+        for (int byte = 0; byte < 256; byte++)
+        {
+            for (int i = 0; i < 8; i++) lut1[byte][i] = static_cast<uint8_t>((byte >> (7 - i))     & 0x01);
+            for (int i = 0; i < 4; i++) lut2[byte][i] = static_cast<uint8_t>((byte >> (6 - 2 * i)) & 0x03);
+            for (int i = 0; i < 2; i++) lut4[byte][i] = static_cast<uint8_t>((byte >> (4 - 4 * i)) & 0x0F);
+        }
+    }
+};
+
+
+
+/*!
+ \brief Unpack raw eye scan data into samples
+ \param raw           Raw data read back from the eye scan memory
+ \param nBytes        Number of bytes of raw data
+ \param countResBits  Bits per sample (1, 2, 4 or 8)
+ \param output        Destination for samples. Must have room for
+                      nBytes * (8 / countResBits) values.
+*/
+void EyeMonitor::unpackSamples(const uint8_t *raw,
+                               const size_t nBytes,
+                               const uint8_t countResBits,
+                               uint8_t *output)
+{
+    static const EyeScanUnpackTables tables;  // Nb: Thread-safe initialisation (C++11)
+    size_t i;
+    switch (countResBits)
+    {
+    case 1:
+        for (i = 0; i < nBytes; i++, output += 8) std::copy(tables.lut1[raw[i]], tables.lut1[raw[i]] + 8, output);
+        break;
+    case 2:
+        for (i = 0; i < nBytes; i++, output += 4) std::copy(tables.lut2[raw[i]], tables.lut2[raw[i]] + 4, output);
+        break;
+    case 4:
+        for (i = 0; i < nBytes; i++, output += 2) std::copy(tables.lut4[raw[i]], tables.lut4[raw[i]] + 2, output);
+        break;
+    default:  // 8 bits per sample:
+        std::copy(raw, raw + nBytes, output);
+    }
 }
 
 
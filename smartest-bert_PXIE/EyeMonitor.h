@@ -9,6 +9,7 @@
 #define EYEMONITOR_H
 
 #include "GT1724.h"
+#include "EyeScanResult.h"
 
 /*!
  \brief Eye Monitor Functions
@@ -29,7 +30,9 @@ public:
                   int hStepIndex,
                   int vStepIndex,      // Nb: Eye scan only; use 0 for Bathtub scan
                   int vOffsetIndex,    // Nb: Bathtub scan only; use 0 for Eye scan
-                  int countResIndex);
+                  int countResIndex,
+                  bool adaptive = false,
+                  bool converge = false);
 
     int repeatScan();  // Repeats the previous scan, and adds the new data to the existing data
 
@@ -57,19 +60,77 @@ private:
 
     int scanRepeatCount = 0;
 
+    bool scanAdaptive = false;  // Coarse-to-fine scan? (see eyeScanAdaptive)
+
+    static const int EYESCAN_ADAPTIVE_COARSE_STEP = 8;  // Phase / offset step for coarse pass of adaptive scan
+    static const int EYESCAN_ADAPTIVE_THRESHOLD   = 0;  // Error count which defines the eye boundary for adaptive scan
+
+    // Converge mode (see bandConvergenceUpdate): Bands are the rows read by one
+    // sweep (thisOffsetStart..thisOffsetStop); converged bands aren't re-scanned.
+    bool scanConverge = false;
+    int  bandRows = 1;             // Rows in each band (the last band may have fewer)
+    QVector<int>  bandRepeats;     // Scans accumulated in each band
+    QVector<int>  bandStable;      // Consecutive repeats with contour change below EYESCAN_CONVERGE_DELTA
+    QVector<bool> bandConverged;   // Band has converged
+    QVector<bool> bandScanned;     // Band was scanned in this pass
+
+    static const int    EYESCAN_CONVERGE_REPEATS_MIN = 5;  // Fewest scans of a band before it can converge
+    static const int    EYESCAN_CONVERGE_STABLE      = 3;  // Repeats in a row below EYESCAN_CONVERGE_DELTA to converge
+    static const double EYESCAN_CONVERGE_DELTA;            // Contour change limit (mean change of log10 BER per point)
+
     bool stopFlag = false;
 
-    QVector<double> eyeDataBuffer;
-    QVector<double> eyeDataBufferNorm;
+    QVector<quint32> eyeDataBuffer;  // Error counts accumulated over repeated scans
+
+    int  partialShift      = 0;      // Shift applied to partial results sent during a scan
+    bool partialShiftFound = false;  // False until partialShift is known (after reset)
 
     int eyeScanRun(bool resetFlag);
 
-    uint8_t peakFind( QVector<double> &data,
+    void bandReset(const int rowsPerBand, const int numRows);
+    void bandConvergenceUpdate(const QVector<quint32> &previous, const int rowWidth);
+    double bandContourChange(const QVector<quint32> &previous, const int band, const int rowWidth) const;
+    QVector<double> bandRowFullScale(const int numRows, const bool inPass) const;
+
+    int eyeScanAdaptive( QVector<uint8_t> &output,
+                         const uint8_t numPhaseSteps,
+                         const uint8_t numOffsetSteps,
+                         uint8_t *rawDataBuffer,
+                         const uint8_t imageAddressMSB,
+                         const uint8_t imageAddressLSB,
+                         const uint16_t imageMaximumSize,
+                         const bool resetFlag );
+
+    static bool adaptiveCellIsBoundary( const QVector<uint8_t> &coarse,
+                                        const int nCX,
+                                        const int cx,
+                                        const int cy,
+                                        const int cyNext );
+
+    int sweepRegion( const uint8_t phaseStart,
+                     const uint8_t phaseStep,
+                     const int nPoints,
+                     const uint8_t offsetStart,
+                     const uint8_t offsetStep,
+                     const int nRows,
+                     uint8_t *rawDataBuffer,
+                     const uint8_t imageAddressMSB,
+                     const uint8_t imageAddressLSB,
+                     const uint16_t imageMaximumSize,
+                     uint8_t *output );
+
+    void emitPartialResult( QVector<uint8_t> &scanData,
+                            const uint8_t sizeX,
+                            const uint8_t sizeY,
+                            const int rowsDone,
+                            const bool resetFlag );
+
+    uint8_t peakFind( QVector<uint8_t> &data,
                       const size_t sizeX,
                       const size_t sizeY );
 
-    int dataShift( QVector<double> &data,
-                   QVector<double> &dataShifted,
+    int dataShift( QVector<uint8_t> &data,
+                   QVector<uint8_t> &dataShifted,
                    const size_t sizeX,
                    const size_t sizeY,
                    const int nShift );
@@ -89,7 +150,13 @@ private:
                          uint8_t *sizeMSB,
                          uint8_t *sizeLSB );
 
-    void bufferReset(QVector<double> &buffer, int newSize);
+    void bufferReset(QVector<uint8_t> &buffer, int newSize);
+    void bufferReset(QVector<quint32> &buffer, int newSize);
+
+    static void unpackSamples( const uint8_t *raw,
+                               const size_t nBytes,
+                               const uint8_t countResBits,
+                               uint8_t *output );
 
 };
 
@@ -0,0 +1,83 @@
+/*!
+ \file   EyeScanResult.cpp
+ \brief  Eye Scan Result - Accumulated error counts from an eye or bathtub scan
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <math.h>
+
+#include "globals.h"
+#include "GT1724.h"
+
+#include "EyeScanResult.h"
+
+
+EyeScanResult::EyeScanResult()
+{ }
+
+EyeScanResult::EyeScanResult(const int type,
+                             const int xRes,
+                             const int yRes,
+                             const QVector<quint32> &counts,
+                             const double countFullScale)
+ : type(type), xRes(xRes), yRes(yRes), countFullScale(countFullScale), counts(counts)
+{
+    Q_ASSERT(counts.size() == xRes * yRes);
+}
+
+EyeScanResult::~EyeScanResult()
+{}
+
+
+/*!
+ \brief Set the full scale count of each row
+ Used in converge mode, where rows of converged bands have been
+ scanned fewer times than the result (see class description).
+ \param rowFullScale  Full scale count for each row (yRes values), or
+                      an empty vector: All rows use countFullScale
+*/
+void EyeScanResult::setRowFullScale(const QVector<double> &rowFullScale)
+{
+    Q_ASSERT(rowFullScale.isEmpty() || rowFullScale.size() == yRes);
+    this->rowFullScale = rowFullScale;
+}
+
+
+/*!
+ \brief Get normalised scan data
+ Converts each accumulated error count to log10(count / full scale), the
+ error ratio (see class description). Points
+ with no errors are below the detection limit: for an eye scan these
+ are set to log10(1 / full scale) (the plot "floor"); for a bathtub
+ scan they are set to globals::BELOW_DETECTION_LIMIT, which the bathtub
+ plot widget uses to hide invalid values at the bottom of the curve.
+ \return Vector of normalised values (xRes * yRes values, row by row),
+         or an empty vector if there are no data.
+ Nb: Rows with their own full scale count (see setRowFullScale) are
+ normalised by that count, so each row has its own floor.
+*/
+QVector<double> EyeScanResult::normalised() const
+{
+    QVector<double> data;
+    if (counts.isEmpty() || countFullScale <= 0.0) return data;
+
+    const bool eyeScan = (type == GT1724::GT1724_EYE_SCAN);
+    const int nPoints = counts.size();
+    data.resize(nPoints);
+    const quint32 *src = counts.constData();
+    double *dst = data.data();
+    for (int row = 0; row < yRes; row++)
+    {
+        const double fullScale = getRowFullScale(row);
+        const double logFullScale = (fullScale > 0.0) ? log10(fullScale) : log10(countFullScale);
+        const double floorValue = eyeScan ? -logFullScale : globals::BELOW_DETECTION_LIMIT;
+        const int iStop = qMin((row + 1) * xRes, nPoints);
+        for (int i = row * xRes; i < iStop; i++)
+        {
+            if (src[i] == 0) dst[i] = floorValue;
+            else             dst[i] = log10(static_cast<double>(src[i])) - logFullScale;
+        }
+    }
+    return data;
+}
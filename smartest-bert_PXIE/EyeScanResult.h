@@ -0,0 +1,83 @@
+/*!
+ \file   EyeScanResult.h
+ \brief  Eye Scan Result - Accumulated error counts from an eye or bathtub scan
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+
+#ifndef EYESCANRESULT_H
+#define EYESCANRESULT_H
+
+#include <QVector>
+#include <QMetaType>
+#include <stdint.h>
+
+/*!
+  \brief Eye Scan Result Class
+  Stores the accumulated error count at each point of an eye or
+  bathtub scan, along with the full scale count per point.
+
+  Units: The eye monitor counts errors over a fixed dwell at each point,
+  into a counter of 2^(count resolution bits). The full scale count is
+  that counter range times the number of repeats. The "BER" used by the
+  plots and BathtubFit is count / full scale: an error ratio relative to
+  the dwell, not errors per bit analysed (the dwell in bits isn't known).
+
+  In converge mode, converged bands aren't re-scanned, so some rows may
+  have fewer repeats than the result. Those rows carry their own full
+  scale count (see setRowFullScale); their counts are never scaled up.
+
+  Counts are stored as 32 bit integers in an implicitly shared
+  QVector, so results can be passed between the worker and UI threads
+  (and kept as history) without copying the data. Normalised (log10 BER)
+  values are only calculated when requested by normalised(), i.e. when
+  the data are plotted or exported.
+*/
+class EyeScanResult
+{
+public:
+
+    EyeScanResult();
+    EyeScanResult(const int type,
+                  const int xRes,
+                  const int yRes,
+                  const QVector<quint32> &counts,
+                  const double countFullScale);
+    ~EyeScanResult();
+
+    int    getType()         const { return type;         }
+    int    getXRes()         const { return xRes;         }
+    int    getYRes()         const { return yRes;         }
+    double getCountFullScale() const { return countFullScale; }
+    bool   isEmpty()         const { return counts.isEmpty(); }
+    bool   isConverged()     const { return converged;    }
+
+    bool   hasRowFullScale() const { return !rowFullScale.isEmpty(); }
+    double getRowFullScale(const int row) const { return rowFullScale.value(row, countFullScale); }
+    const QVector<double> &getRowFullScales() const { return rowFullScale; }
+
+    void   setConverged(const bool converged) { this->converged = converged; }
+    void   setRowFullScale(const QVector<double> &rowFullScale);
+
+    const QVector<quint32> &getCounts() const { return counts; }
+
+    QVector<double> normalised() const;
+
+private:
+
+    int type = 0;               // Scan type: GT1724::GT1724_EYE_SCAN or GT1724::GT1724_BATHTUB_SCAN
+    int xRes = 0;               // Number of sample points horizontally
+    int yRes = 0;               // Number of rows (1 for bathtub scan)
+    double countFullScale = 0.0;  // Full scale count at each point: counter range x repeats (see class description)
+    bool converged = false;     // Repeats in converge mode: All bands have converged (see EyeMonitor)
+
+    QVector<quint32> counts;    // Accumulated error count at each point (xRes * yRes values, row by row)
+    QVector<double> rowFullScale;  // Full scale count for each row (yRes values), or empty: All rows use countFullScale
+
+};
+
+Q_DECLARE_METATYPE(EyeScanResult)
+
+
+#endif // EYESCANRESULT_H
@@ -11,24 +11,23 @@
 #include <QFile>
 #include <QDir>
 #include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QDateTime>
 #include <cmath>
+#include <cstring>
 
 #include "EyeMonitor.h"
 
 #include "GT1724.h"
 #include "BertModel.h"
+#include "BertLog.h"
 
-// Debug Macro for Register Read / Write:
-//#define BERT_REGISTER_DEBUG
-#ifdef BERT_REGISTER_DEBUG
-  #define DEBUG_REG(MSG) qDebug() << "\t\t\t" << MSG;
-#endif
-#ifndef DEBUG_REG
-  #define DEBUG_REG(MSG)
-#endif
+// Debug Macro for Register Read / Write: BertLog::LOG_REGISTER (trace); on by
+// default if the build defines BERT_REGISTER_DEBUG
+#define DEBUG_REG(MSG) BERT_LOG(LOG_REGISTER, LEVEL_TRACE, "\t\t\t" << MSG)
 
 // Debug macro for general debug mesages from GT1724
-#define DEBUG_GT1724(MSG) qDebug() << "\t\t" << MSG;
+#define DEBUG_GT1724(MSG) BERT_LOG(LOG_GT1724, LEVEL_DEBUG, "\t\t" << MSG)
 
 
 
@@ -60,6 +59,8 @@ GT1724::GT1724(I2CComms *comms, const uint8_t i2cAddress, const uint8_t laneOffs
 
     eyeMonitor01 = new EyeMonitor(this, laneOffset, 1);  // Create eye monitor instances for
     eyeMonitor23 = new EyeMonitor(this, laneOffset, 3);  // each ED input
+
+    connect(comms, SIGNAL(I2COpFinished(int, int, QByteArray)), this, SLOT(commsOpFinished(int, int, QByteArray)));
 }
 
 
@@ -142,12 +143,30 @@ void GT1724::getOptions()
 
 /*!
  \brief GT1724 Initialisation
+        Loads the macros (initMacros) then sets up the chip (initSettings).
  \return globals::OK    Success!
  \return [error code]   Error connecting or downloading macros. Comms problem or invalid I2C address?
  SIGNALS:
   emits ShowMessage(...) to show progress messages to user
 */
 int GT1724::init()
+{
+    int result = initMacros();
+    if (result != globals::OK) return result;
+    return initSettings();
+}
+
+
+/*!
+ \brief GT1724 Initialisation: Check and download extension macros
+        Doesn't need the reference clock, so BertWorker can run this while
+        the clock parts are being set up (see initAsync).
+ \return globals::OK    Macros loaded (coldBoot shows whether they were downloaded)
+ \return [error code]   Error connecting or downloading macros. Comms problem or invalid I2C address?
+ SIGNALS:
+  emits ShowMessage(...) to show progress messages to user
+*/
+int GT1724::initMacros()
 {
     qDebug() << "GT1724: Init for GT1724 at lane " << laneOffset << "; I2C Address " << INT_AS_HEX(i2cAddress,2);
     emit ShowMessage(QString("Configuring Instrument (Core %1)...").arg(coreNumber));
@@ -171,10 +190,21 @@ int GT1724::init()
     forceCDRBypass2 = CDR_BYPASS_OPTIONS_DEFAULT;
     forceCDRBypass3 = CDR_BYPASS_OPTIONS_DEFAULT;
 
+#ifdef BERT_MACRO_VERSION
+    // Macros are resident, but not the version this build uses: Reload.
+    if (result == globals::MACROS_LOADED && macroVersion->macroVersionString != QString(XSTR(BERT_MACRO_VERSION)))
+    {
+        qDebug() << "GT1724: Resident macro version " << macroVersion->macroVersionString
+                 << " doesn't match build version " << XSTR(BERT_MACRO_VERSION) << "; Reloading.";
+        result = globals::MACROS_NOT_LOADED;
+    }
+#endif
+
     if (result == globals::MACROS_LOADED)
     {
         qDebug() << "GT1724: Extension macros already loaded. Connected OK!";
-        goto WarmBoot;  // Don't need to load default config (warm boot!). Fall out.
+        coldBoot = false;  // Don't need to load default config (warm boot!).
+        return globals::OK;
     }
 
     result = downloadHexFile();
@@ -194,13 +224,29 @@ int GT1724::init()
         emit ShowMessage("Error downloading macros!");
         return globals::GEN_ERROR;
     }
+    coldBoot = true;
+    return globals::OK;
+}
 
-    // Cold Boot: Set default settings:
-    emit ShowMessage(QString("Configuring Instrument (Core %1)...").arg(coreNumber));
-    qDebug() << "GT1724: Cold Boot. Setting defaults for GT1724 at lane " << laneOffset;
-    configSetDefaults(25e9);  // Nb: Bitrate shouldn't matter here because CDR Bypass defaults to OFF.
 
-  WarmBoot:
+/*!
+ \brief GT1724 Initialisation: Set up the chip once the macros are loaded
+        Sets defaults (cold boot only) and resyncs the PG, so the reference
+        clock must be running: BertWorker calls this after the SI5340 and
+        LMX2594 are set up.
+ \return globals::OK    Success!
+ SIGNALS:
+  emits ShowMessage(...) to show progress messages to user
+*/
+int GT1724::initSettings()
+{
+    if (coldBoot)
+    {
+        // Cold Boot: Set default settings:
+        emit ShowMessage(QString("Configuring Instrument (Core %1)...").arg(coreNumber));
+        qDebug() << "GT1724: Cold Boot. Setting defaults for GT1724 at lane " << laneOffset;
+        configSetDefaults(25e9);  // Nb: Bitrate shouldn't matter here because CDR Bypass defaults to OFF.
+    }
 
     // Get current instrument config, and send the info to clients:
     int pattern;
@@ -214,6 +260,42 @@ int GT1724::init()
 }
 
 
+/*!
+ \brief Run initMacros without blocking the caller
+        Queued to this chip's own thread by BertWorker, so that the macro
+        download runs while other components are being configured. The
+        caller collects the result with initWait.
+*/
+void GT1724::initAsync()
+{
+    initResult = initMacros();
+    initFinished.release();
+}
+
+
+/*!
+ \brief Run initSettings on this chip's own thread
+        Queued by BertWorker once the clocks are up. The caller collects
+        the result with initWait.
+*/
+void GT1724::initSettingsAsync()
+{
+    initResult = initSettings();
+    initFinished.release();
+}
+
+
+/*!
+ \brief Wait for initAsync or initSettingsAsync to finish
+ \return [result]  Result from init
+*/
+int GT1724::initWait()
+{
+    initFinished.acquire();
+    return initResult;
+}
+
+
 
 /*!
  \brief Get Current Settings
@@ -377,6 +459,14 @@ void GT1724::CommsCheck(int metaLane)
         setRegister(lane, 1, initValue[lane]);
     }
 
+    // Check the register shadow against the chip:
+    int shadowChecked = 0;
+    int shadowMismatch = 0;
+    result = verifyRegisterShadow(shadowChecked, shadowMismatch);
+    qDebug() << "Register shadow check: " << shadowChecked << " checked; " << shadowMismatch << " mismatched; Result: " << result;
+    if (result == globals::OK) countError += shadowMismatch;
+    else                       countError++;
+
     emit ShowMessage(QString("Comms Check Finished. %1 OK; %2 ERRORS.").arg(countGood).arg(countError));
     emit Result(countError, metaLane);
 }
@@ -438,7 +528,7 @@ int GT1724::commsCheckOneRegister(int lane, uint8_t value, int &countGood, int &
                    globals::MACROS_NOT_LOADED  Macros not loaded yet.
                    globals::MACRO_ERROR        Error running macro - not connected?
 
- Emits:  UpdateString "MacroVersion" containing macro version string
+ Emits:  UIUpdate UI_MACRO_VERSION containing macro version string
 */
 int GT1724::macroCheck(int metaLane)
 {
@@ -464,7 +554,7 @@ int GT1724::macroCheck(int metaLane)
                 macroVersion = &(globals::MACRO_FILES[macroIndex]);
                 macroStatus = globals::MACROS_LOADED;
                 DEBUG_GT1724("GT1724: Found extension macros version " << macroVersion->macroVersionString)
-                emit UpdateString("MacroVersion", metaLane, macroVersion->macroVersionString);
+                uiString(UI_MACRO_VERSION, metaLane, macroVersion->macroVersionString);
                 break;
             }
         }
@@ -478,7 +568,7 @@ int GT1724::macroCheck(int metaLane)
                              .arg(resultData[2], 2, 16, QChar('0'))
                              .arg(resultData[3], 2, 16, QChar('0')))
             DEBUG_GT1724("This probably means extension macros haven't been downloaded yet.")
-            emit UpdateString("MacroVersion", metaLane, QString("Unknown"));
+            uiString(UI_MACRO_VERSION, metaLane, QString("Unknown"));
         }
     return macroStatus;
 }
@@ -497,7 +587,7 @@ int GT1724::macroCheck(int metaLane)
  \brief Get IC Temperature from Gennum GTxxxx chip
  SLOT
   Emits Result    [globals::OK] or [error code], lane
-  Emits UpdateString "CoreTemperature", lane, degrees (Success only)
+  Emits UIUpdate UI_CORE_TEMPERATURE, lane, degrees (Success only)
 
  \param temperatureDegrees  Pointer to an int, used to return temperature in degrees C
  \return [Error Code]       Error from hardware/comms functions
@@ -510,10 +600,18 @@ void GT1724::GetTemperature(int metaLane)
     DEBUG_GT1724("GT1724 [" << this << "]: Received Sig GetTemperature with lane " << metaLane << " on thread " << QThread::currentThreadId())
 #endif
 
+    // Superseded request: Last reading is still current, so don't use the bus:
+    if (temperatureTimer.isValid() && temperatureTimer.elapsed() < TEMPERATURE_REPEAT_MS)
+    {
+        uiString(UI_CORE_TEMPERATURE, metaLane, QString("%1 ºC").arg(temperatureDegrees), temperatureDegrees);
+        emit Result(globals::OK, metaLane);
+        return;
+    }
+
+    I2CPriorityScope priority(I2CComms::PRIORITY_COSMETIC);
     uint8_t output[2] = { 0, 0 };
     int result;
     // Read the on-chip temperature sensor:
-    int temperatureDegrees = 0;  // Default if read fails.
     result = runMacro(0x28, NULL, 0, output, 2);
     if (result != globals::OK)
     {
@@ -528,6 +626,7 @@ void GT1724::GetTemperature(int metaLane)
         return;  // Improbable result!
     }
     temperatureDegrees = (int)( ((float)tempRaw * 0.415) - 277.565 );
+    temperatureTimer.start();
 #define BERT_EXTRA_DEBUG
 #ifdef BERT_EXTRA_DEBUG
     DEBUG_GT1724("Read Chip Temperature OK for lane: " << metaLane)
@@ -538,7 +637,7 @@ void GT1724::GetTemperature(int metaLane)
                 .arg(tempRaw)
                 .arg(temperatureDegrees); */
 #endif
-    emit UpdateString(QString("CoreTemperature"), metaLane, QString("%1 ºC").arg(temperatureDegrees));
+    uiString(UI_CORE_TEMPERATURE, metaLane, QString("%1 ºC").arg(temperatureDegrees), temperatureDegrees);
     emit Result(globals::OK, metaLane);
 }
 
@@ -581,6 +680,7 @@ int GT1724::configSetDefaults(double bitRate)
     forceCDRBypass2 = CDR_BYPASS_OPTIONS_DEFAULT;
     forceCDRBypass3 = CDR_BYPASS_OPTIONS_DEFAULT;
 
+    pgSetupValid = false;                                          // Full PG set up (not just an update)
     result = configPG(2, bitRate);                                 // --- Set up pattern generator (default pattern PRBS31)
     RETURN_ON_ERROR("GT1724: Config Set Defaults: PG may not be correctly set up!");
 
@@ -645,6 +745,11 @@ int GT1724::configSetDefaults(double bitRate)
   pattern inversion, or De-Emphasis controls. These are set to default values
   by config Set Defaults and are NOT reset on pattern change.
 
+  Once the lanes have been set up, later calls (e.g. after a bit rate
+  change) only do what configPGUpdate does; the lane routing and power
+  settings are only sent again after something resets the device
+  configuration (configCDR), after an error, or from configSetDefaults.
+
  \param pattern          Index of selected pattern in the combo list.
  \param bitRate          Instrument bit rate (bits/sec)
 
@@ -660,12 +765,12 @@ void GT1724::ConfigPG(int metaLane, int pattern, double bitRate)
     int result = configPG(pattern, bitRate);
     // Echo back the new pattern to the client
     // Nb: Only one pattern for all PG lanes, so send a list select for both lanes:
-    emit ListSelect("listPGPattern", laneOffset + 0, pattern);
-    emit ListSelect("listPGPattern", laneOffset + 2, pattern);
+    uiSelect(UI_PG_PATTERN, laneOffset + 0, pattern);
+    uiSelect(UI_PG_PATTERN, laneOffset + 2, pattern);
     if (BertModel::UseFourChanPGMode())
     {
-        emit ListSelect("listPGPattern", laneOffset + 1, pattern);
-        emit ListSelect("listPGPattern", laneOffset + 3, pattern);
+        uiSelect(UI_PG_PATTERN, laneOffset + 1, pattern);
+        uiSelect(UI_PG_PATTERN, laneOffset + 3, pattern);
     }
     if (result == globals::OK) emit ShowMessage("OK.");
     // Send the results:
@@ -677,6 +782,13 @@ int GT1724::configPG(int pattern, double bitRate)
     DEBUG_GT1724("GT1724: Configure PG on Lane " << laneOffset)
     int result;
 
+    if (pgSetupValid)
+    {
+        result = configPGUpdate(pattern, bitRate);
+        if (result != globals::OK) pgSetupValid = false;  // Do the full set up next time
+        return result;
+    }
+
     // REMOVED! Shouldn't need?
     //result = runVerySimpleMacro(0x65);       // --- RESET the PG (Macro 0x65)
     //RETURN_ON_ERROR("GT1724: Config PG: Reset failed");
@@ -764,12 +876,43 @@ int GT1724::configPG(int pattern, double bitRate)
         RETURN_ON_ERROR("GT1724: Config PG: Error setting CDR Bypass");
     }
 
+    pgSetupValid = true;
     DEBUG_GT1724("GT1724: PG Configured OK!")
     return globals::OK;
 
 }
 
 
+/*!
+ \brief Update the pattern generator after a clock or pattern change
+ Lanes are already routed and powered for PG mode by configPG. Selects
+ the pattern (the PRBS generator macro also restarts the generator, so
+ it resyncs to the new clock), and rewrites the CDR bypass bit only for
+ lanes where the bit rate change moves it (see checkForceCDRBypass).
+ \param pattern  Index of selected pattern in the combo list.
+ \param bitRate  Instrument bit rate (bits/sec)
+ \return globals::OK    Success
+ \return [error code]   Error setting register or running macro
+*/
+int GT1724::configPGUpdate(int pattern, double bitRate)
+{
+    DEBUG_GT1724("GT1724: Update PG on Lane " << laneOffset << "; pattern " << pattern)
+    int result = setPRBSOptions(pattern, 0, 0, 1);   // --- Select PG pattern (Macro 0x58)
+    RETURN_ON_ERROR("GT1724: Config PG: Error setting PG pattern");
+
+    const int forceCDRBypass[4] = { forceCDRBypass0, forceCDRBypass1, forceCDRBypass2, forceCDRBypass3 };
+    for (int lane = 0; lane < 4; lane++)
+    {
+        if (!BertModel::UseFourChanPGMode() && (lane == 1 || lane == 3)) continue;  // ED lanes
+        int bypassOn = checkForceCDRBypass(forceCDRBypass[lane], bitRate) ? 1 : 0;
+        if (bypassOn == cdrBypassApplied[lane]) continue;
+        result = setForceCDRBypass(lane, forceCDRBypass[lane], bitRate);
+        RETURN_ON_ERROR("GT1724: Config PG: Error setting CDR Bypass");
+    }
+    return globals::OK;
+}
+
+
 
 
 /*!
@@ -798,6 +941,9 @@ int GT1724::configCDR(int inputLane, int freqDivider)
     DEBUG_GT1724("GT1724: Configure CDR on GT1724 at lane " << laneOffset << "; using input lane " << inputLane)
     int result;
 
+    pgSetupValid = false;   // Device config is reset; next configPG must set up the lanes again
+    for (int lane = 0; lane < 4; lane++) cdrBypassApplied[lane] = -1;
+
     result = runVerySimpleMacro(0x65);       // --- RESET device configuration (Macro 0x65)
     RETURN_ON_ERROR("GT1724: Config CDR: Reset failed");
 
@@ -860,7 +1006,7 @@ bool GT1724::getLaneOn(int lane)
     {
         if (data & 0x01) state = false; // Muted! (Off)
         else             state = true;  // Not Muted (On)
-        emit UpdateBoolean("boolPGLaneOn", lane, state);
+        uiBoolean(UI_PG_LANE_ON, lane, state);
     }
     else
     {
@@ -903,8 +1049,9 @@ int GT1724::setAutoBypassOnLOL(int lane, bool autoBypassOn)
 * UNUSED!
  \brief Read CDR Auto Bypass On LOL bit
  \param lane    Lane to read
- SLOT!
- Emits: UpdateBoolean "boolAutoBypassOnLOL"
+ \return Auto Bypass bit
+ Emits: Nothing. UI updates now go through UIUpdate (see BertComponent),
+        and there is no UIUpdate item for this bit; the value is returned.
 *
 bool GT1724::getAutoBypassOnLOL (int lane)
   {
@@ -983,6 +1130,8 @@ int GT1724::setForceCDRBypass(int lane, int forceCDRBypass, double bitRate)
     int result;
     if (forceBypassOn) result = setRegister(LANE_MOD(lane), GTREG_CDR_REG_0, (data | 0x05) );  // bypass ON; CDR power DOWN
     else               result = setRegister(LANE_MOD(lane), GTREG_CDR_REG_0, (data)        );  // bypass OFF
+    if (result == globals::OK) cdrBypassApplied[localLane] = forceBypassOn ? 1 : 0;
+    else                       cdrBypassApplied[localLane] = -1;
     return result;
 }
 
@@ -990,15 +1139,15 @@ int GT1724::setForceCDRBypass(int lane, int forceCDRBypass, double bitRate)
  \brief Emit a signal with current "Force CDR Bypass" setting
  \param lane    Lane to emit signal for. Only even lanes have "Force CDR Bypass"
                 setting; other lanes will be ignored.
-   EMITS ListSelect "listPGCDRBypass"
+   EMITS UIUpdate UI_PG_CDR_BYPASS
 */
 int GT1724::getForceCDRBypass (int lane)
 {
     int localLane = LANE_MOD(lane);
-    if (localLane == 0) emit ListSelect("listPGCDRBypass", lane, forceCDRBypass0);
-    if (localLane == 1) emit ListSelect("listPGCDRBypass", lane, forceCDRBypass1);
-    if (localLane == 2) emit ListSelect("listPGCDRBypass", lane, forceCDRBypass2);
-    if (localLane == 3) emit ListSelect("listPGCDRBypass", lane, forceCDRBypass3);
+    if (localLane == 0) uiSelect(UI_PG_CDR_BYPASS, lane, forceCDRBypass0);
+    if (localLane == 1) uiSelect(UI_PG_CDR_BYPASS, lane, forceCDRBypass1);
+    if (localLane == 2) uiSelect(UI_PG_CDR_BYPASS, lane, forceCDRBypass2);
+    if (localLane == 3) uiSelect(UI_PG_CDR_BYPASS, lane, forceCDRBypass3);
     return globals::OK;
 
     /* DEPRECATED: Don't read actual setting from device;
@@ -1009,7 +1158,7 @@ int GT1724::getForceCDRBypass (int lane)
     if (result == globals::OK)
     {
         if (data & 0x01) cdrBypassOn = true;   // Check the value of Bit 0 (Force Bypass bit)
-        emit ListSelect("listPGCDRBypass", lane, cdrBypassOn);
+        uiSelect(UI_PG_CDR_BYPASS, lane, cdrBypassOn);
     }
     else
     {
@@ -1064,11 +1213,11 @@ int GT1724::setOutputSwing(int lane, int swing)
 
 /*!
  \brief Get output swings for lanes 0 and 2 (PG Outputs),
-        and emit ListSelect signals to update clients
+        and send UIUpdate selections to update clients
  \return globals::OK  succes
  \return [error code]
 
- Emits: ListSelect for lanes 0 and 2 of this GT1724,
+ Emits: UIUpdate UI_PG_AMPLITUDE for lanes 0 and 2 of this GT1724,
         with index of current voltage swing selection
 */
 int GT1724::getOutputSwings()
@@ -1090,7 +1239,7 @@ int GT1724::getOutputSwings()
         swingIndex = PG_OUTPUT_SWING_LOOKUP.indexOf(swingData[i]);
         DEBUG_GT1724("GT1724: Get Output Swing for Lane " << i << ": Swing = " << swingData[i] << "; Index = " << swingIndex)
         if (swingIndex < 0) swingIndex = 0;
-        emit ListSelect("listPGAmplitude", laneOffset + i, swingIndex);
+        uiSelect(UI_PG_AMPLITUDE, laneOffset + i, swingIndex);
     }
     return globals::OK;
 }
@@ -1204,7 +1353,7 @@ int GT1724::getPRBSOptions(int *pattern, int *vcoFreq, int *source, int *enable)
  \brief Get Current PRBS pattern setting and send to CLIENT.
  \return globals::OK           Success
  \return [Error Code]          Error from hardware/comms functions
- Emits ListSelect for lanes 0 and 2 of this GT1724,
+ Emits UIUpdate UI_PG_PATTERN for lanes 0 and 2 of this GT1724,
        with index of current pattern selection
 */
 int GT1724::getPRBSPattern(int *pattern)
@@ -1217,12 +1366,12 @@ int GT1724::getPRBSPattern(int *pattern)
         DEBUG_GT1724("GT1724: Error getting PRBS gen pattern (" << result << ")")
         return result;
     }
-    emit ListSelect("listPGPattern", laneOffset + 0, *pattern);
-    emit ListSelect("listPGPattern", laneOffset + 2, *pattern);
+    uiSelect(UI_PG_PATTERN, laneOffset + 0, *pattern);
+    uiSelect(UI_PG_PATTERN, laneOffset + 2, *pattern);
     if (BertModel::UseFourChanPGMode())
     {
-        emit ListSelect("listPGPattern", laneOffset + 1, *pattern);
-        emit ListSelect("listPGPattern", laneOffset + 3, *pattern);
+        uiSelect(UI_PG_PATTERN, laneOffset + 1, *pattern);
+        uiSelect(UI_PG_PATTERN, laneOffset + 3, *pattern);
     }
     return globals::OK;
 }
@@ -1298,7 +1447,7 @@ bool GT1724::getLaneInverted(int lane, bool emitSignal)
     {
         dataER = (dataER & 0x01);  // Mask out bit 0
         state = (dataER != 0);
-        if (emitSignal) emit UpdateBoolean("boolPGInverted", lane, state);
+        if (emitSignal) uiBoolean(UI_PG_INVERTED, lane, state);
     }
     else
     {
@@ -1442,8 +1591,8 @@ int GT1724::getDeEmphasis(int lane)
     prePost = (data & 0x01);       // Pre / Post given by bit 0.
     if (result == globals::OK)
     {
-        emit ListSelect("listPGDeemphLevel", lane, (int)level);
-        emit ListSelect("listPGDeemphCursor", lane, (int)prePost);
+        uiSelect(UI_PG_DEEMPH_LEVEL, lane, (int)level);
+        uiSelect(UI_PG_DEEMPH_CURSOR, lane, (int)prePost);
     }
     else
     {
@@ -1503,7 +1652,7 @@ int GT1724::getCrossPoint(int lane)
     {
         int crossPointIndex = PG_CROSS_POINT_LOOKUP.indexOf((int)crossPoint);
         if(crossPointIndex < 0) crossPointIndex = 0;
-        emit ListSelect("listPGCrossPoint", lane, crossPointIndex);
+        uiSelect(UI_PG_CROSS_POINT, lane, crossPointIndex);
     }
     else
     {
@@ -1563,7 +1712,7 @@ int GT1724::getEQBoost(int lane)
     {
         int eqBoostIndex = ED_EQ_BOOST_LOOKUP.indexOf((int)eqBoost);
         if(eqBoostIndex < 0) eqBoostIndex = 0;
-        emit ListSelect("listEDEQBoost", lane, eqBoostIndex);
+        uiSelect(UI_ED_EQ_BOOST, lane, eqBoostIndex);
     }
     else
     {
@@ -1695,10 +1844,10 @@ void GT1724::SetEDOptions(int metaLane,
  \return globals::OK           Success
  \return [Error Code]          Error from hardware/comms functions
 
- Emits (on success): UpdateBoolean and ListSelect signals for ED options:
-           listEDPattern
-           boolEDPatternInvert
-           boolEDEnable
+ Emits (on success): UIUpdate selections and booleans for ED options:
+           UI_ED_PATTERN
+           UI_ED_PATTERN_INVERT
+           UI_ED_ENABLE
 */
 int GT1724::getEDOptions()
 {
@@ -1716,13 +1865,13 @@ int GT1724::getEDOptions()
     uint8_t pattern23    = (edOptionsData[0] >> 6) & 0x03;
     uint8_t enable23     = (edOptionsData[0] >> 4) & 0x01;
 
-    emit ListSelect    ("listEDPattern",       laneOffset + 1, pattern01          );
-    emit UpdateBoolean ("boolEDPatternInvert", laneOffset + 1, (invert01 != 0x00) );
-    emit UpdateBoolean ("boolEDEnable",        laneOffset + 1, (enable01 != 0x00) );
+    uiSelect  (UI_ED_PATTERN,        laneOffset + 1, pattern01          );
+    uiBoolean (UI_ED_PATTERN_INVERT, laneOffset + 1, (invert01 != 0x00) );
+    uiBoolean (UI_ED_ENABLE,         laneOffset + 1, (enable01 != 0x00) );
 
-    emit ListSelect    ("listEDPattern",       laneOffset + 3, pattern23          );
-    emit UpdateBoolean ("boolEDPatternInvert", laneOffset + 3, (invert23 != 0x00) );
-    emit UpdateBoolean ("boolEDEnable",        laneOffset + 3, (enable23 != 0x00) );
+    uiSelect  (UI_ED_PATTERN,        laneOffset + 3, pattern23          );
+    uiBoolean (UI_ED_PATTERN_INVERT, laneOffset + 3, (invert23 != 0x00) );
+    uiBoolean (UI_ED_ENABLE,         laneOffset + 3, (enable23 != 0x00) );
 
     return globals::OK;
 }
@@ -1749,9 +1898,7 @@ int GT1724::getEDOptions()
 */
 int GT1724::getEDCount(int edLane, double *bits, double *errors)
 {
-#ifdef BERT_ED_DEBUG
-    DEBUG_GT1724("GT1724: Get ED Count: ED Lane: " << edLane)
-#endif
+    BERT_LOG(LOG_ED, LEVEL_DEBUG, "\t\tGT1724: Get ED Count: ED Lane: " << edLane)
 
     uint8_t options;
     uint8_t output[2];
@@ -1810,39 +1957,41 @@ int GT1724::getEDCount(int edLane, double *bits, double *errors)
     }
     return globals::OK;
 }
-// SLOT for reading ED error and bit counters
-// On success, emits EDCount signal with counts for the specified lane
-// Nb: DOESN'T emit "Result".
-// lane should be an ED input lane, i.e. 1 / 3 / 5 / 7 / etc
-// Nb: Reads one lane at a time from ED, so doesn't support "ALL_LANES"
-void GT1724::GetEDCount(int lane, double bitRate)
+/*!
+ \brief Measure ED counts for one ED lane, and update running totals
+ Reads the error counter (and bit counter if BERT_REAL_BIT_COUNT is defined)
+ for the specified ED, and calculates the change since the last measurement.
+
+ \param lane        ED input lane (1 / 3 / 5 / 7 / etc): Returned in reading
+ \param edLane      Selects the error detector to read (0 = L01; 1 = L23)
+ \param bitRate     Current bit rate (used to estimate bit count)
+ \param elapsedNow  Time of measurement: ed->edRunTime->elapsed() (mS)
+ \param reading     Set to the ED count results. If the lane is not locked,
+                    reading.locked is false and the counts are 0.
+
+ \return globals::OK   Success (reading is valid)
+ \return [Error Code]  Error from hardware/comms functions
+*/
+int GT1724::measureEDCount(int lane, int edLane, double bitRate, int elapsedNow, EDCountReading_t &reading)
 {
-    LANE_FILTER(lane);
-    int edLane = (LANE_MOD(lane)-1) / 2;
-    Q_ASSERT(edLane == 0 || edLane == 1);
-
-    DEBUG_GT1724("GT1724 (" << this << "): GetEDCount for lane " << lane << "; edLane " << edLane)
-
-    if (edLane < 0 || edLane > 1) return;
-
     edParameters_t *ed;
     if (edLane == 0) ed = &ed01;  // Lane 0/1 counts requested.
     else             ed = &ed23;  // Lane 2/3 counts requested.
-    if (!ed->edRunning)
-    {
-        return; // Lane not enabled. No point getting ED counts.
-     }
+
+    reading.lane = lane;
+    reading.locked = false;
+    reading.bits = 0.0;
+    reading.bitsTotal = 0.0;
+    reading.errors = 0.0;
+    reading.errorsTotal = 0.0;
+
     // Don't measure errors if not locked:
-    if (ed->los || ed->lol)
-    {
-        emit EDCount(lane, false, 0.0, 0.0, 0.0, 0.0);
-        return;
-    }
+    if (ed->los || ed->lol) return globals::OK;
+
     // Calculate emapsed time since last measurement on this channel:
     // Note: "edRunTime->elapsed()" returns the number of milliseconds
     // since edRunTime timer started; BUT it wraps back to 0 every 24 hours
     // (see QT docs). We need to check whether it's gone "backwards":
-    int elapsedNow = ed->edRunTime->elapsed();
     int timeDiffMs;
     if (elapsedNow < ed->lastMeasureTimeMs)
     {
@@ -1868,10 +2017,12 @@ void GT1724::GetEDCount(int lane, double bitRate)
      */
 #ifdef BERT_REAL_BIT_COUNT
     // Get error count and bit count from GT1724 macro:
-    result = getEDCount(edLane, &currentBits, &currentErrors);
+    int result = getEDCount(edLane, &currentBits, &currentErrors);
     // Multiply the error and bit counts by 2, since ED only checks every OTHER bit.
     currentBits *= 2.0;
     currentErrors *= 2.0;
+    Q_UNUSED(bitRate)
+    Q_UNUSED(timeDiffMs)
 #else
     int result = getEDCount(edLane, NULL, &currentErrors);
     // Multiply the error count by 2, since ED only checks every OTHER bit.
@@ -1880,12 +2031,7 @@ void GT1724::GetEDCount(int lane, double bitRate)
     currentBits = ed->bitsTotal + ( ( (double)timeDiffMs * bitRate ) / 1000 );
 #endif
 
-    if (result != globals::OK)
-    {
-        DEBUG_GT1724("GT1724: GetEDCount: Error reading bit / error counter for lane " << lane << " (" << result << ")")
-        emit ShowMessage("Error reading bit / error counts.");
-        return;
-    }
+    if (result != globals::OK) return result;
 
     // Calculate CHANGE in bit and error counts: this reading - last reading:
     double deltaBits, deltaErrors;
@@ -1898,8 +2044,114 @@ void GT1724::GetEDCount(int lane, double bitRate)
     ed->bitsTotal = currentBits;
     ed->errorsTotal = currentErrors;
 
+    reading.locked = true;
+    reading.bits = deltaBits;
+    reading.bitsTotal = currentBits;
+    reading.errors = deltaErrors;
+    reading.errorsTotal = currentErrors;
+    return globals::OK;
+}
+
+
+// SLOT for reading ED error and bit counters
+// On success, emits EDCount signal with counts for the specified lane
+// Nb: DOESN'T emit "Result".
+// lane should be an ED input lane, i.e. 1 / 3 / 5 / 7 / etc
+// Nb: Reads one lane at a time from ED, so doesn't support "ALL_LANES"
+//     (see GetEDCountSnapshot to read both EDs on the chip)
+void GT1724::GetEDCount(int lane, double bitRate)
+{
+    LANE_FILTER(lane);
+    int edLane = (LANE_MOD(lane)-1) / 2;
+    Q_ASSERT(edLane == 0 || edLane == 1);
+
+    DEBUG_GT1724("GT1724 (" << this << "): GetEDCount for lane " << lane << "; edLane " << edLane)
+
+    if (edLane < 0 || edLane > 1) return;
+
+    edParameters_t *ed;
+    if (edLane == 0) ed = &ed01;  // Lane 0/1 counts requested.
+    else             ed = &ed23;  // Lane 2/3 counts requested.
+    if (!ed->edRunning)
+    {
+        return; // Lane not enabled. No point getting ED counts.
+     }
+
+    I2CPriorityScope priority(I2CComms::PRIORITY_MEASUREMENT);
+    EDCountReading_t reading;
+    int result = measureEDCount(lane, edLane, bitRate, ed->edRunTime->elapsed(), reading);
+    if (result != globals::OK)
+    {
+        DEBUG_GT1724("GT1724: GetEDCount: Error reading bit / error counter for lane " << lane << " (" << result << ")")
+        emit ShowMessage("Error reading bit / error counts.");
+        return;
+    }
+
     // Emit an ED Count signal with the results:
-    emit EDCount(lane, true, deltaBits, currentBits, deltaErrors, currentErrors);
+    emit EDCount(lane, reading.locked, reading.bits, reading.bitsTotal, reading.errors, reading.errorsTotal);
+}
+
+
+/*!
+ \brief Stop reading the ED counters for one lane
+ Used when a lane has reached a verdict against the confidence target
+ (see BertPoller): The lane's counts are no longer read (so it doesn't
+ use the bus), but the PRBS checker is left as it is until the ED is
+ stopped with SetEDOptions.
+ Nb: DOESN'T emit "Result".
+ \param lane  ED input lane (1 / 3 / 5 / 7 / etc)
+*/
+void GT1724::EDStopLane(int lane)
+{
+    LANE_FILTER(lane);
+    int edLane = (LANE_MOD(lane)-1) / 2;
+    if (edLane < 0 || edLane > 1) return;
+    DEBUG_GT1724("GT1724 (" << this << "): EDStopLane for lane " << lane)
+    if (edLane == 0) ed01.edRunning = false;
+    else             ed23.edRunning = false;
+}
+
+
+// SLOT for reading ED error and bit counters for BOTH EDs on this chip
+// (lanes 0/1 and 2/3) in one operation.
+// Emits ONE EDCountSnapshot signal containing a reading for each ED which
+// is running, all measured against the same time point (timestamp is
+// mS since epoch, taken before the counters are read).
+// The signal is always emitted (even if a counter read fails; failed
+// lanes are left out of the list) so the caller can keep track of
+// outstanding requests.
+// Nb: DOESN'T emit "Result".
+void GT1724::GetEDCountSnapshot(int metaLane, double bitRate)
+{
+    LANE_FILTER(metaLane);
+    DEBUG_GT1724("GT1724 (" << this << "): GetEDCountSnapshot for chip at lane " << laneOffset)
+    I2CPriorityScope priority(I2CComms::PRIORITY_MEASUREMENT);
+
+    // Take the time point for both EDs before reading any counters:
+    const qint64 timestamp = QDateTime::currentMSecsSinceEpoch();
+    const int elapsed01 = (ed01.edRunning) ? ed01.edRunTime->elapsed() : 0;
+    const int elapsed23 = (ed23.edRunning) ? ed23.edRunTime->elapsed() : 0;
+
+    QList<EDCountReading_t> readings;
+    EDCountReading_t reading;
+    int result = globals::OK;
+    if (ed01.edRunning)
+    {
+        result = measureEDCount(laneOffset + 1, 0, bitRate, elapsed01, reading);
+        if (result == globals::OK) readings.append(reading);
+    }
+    if (ed23.edRunning)
+    {
+        int result23 = measureEDCount(laneOffset + 3, 1, bitRate, elapsed23, reading);
+        if (result23 == globals::OK) readings.append(reading);
+        else                         result = result23;
+    }
+    if (result != globals::OK)
+    {
+        DEBUG_GT1724("GT1724: GetEDCountSnapshot: Error reading bit / error counter (" << result << ")")
+        emit ShowMessage("Error reading bit / error counts.");
+    }
+    emit EDCountSnapshot(metaLane, timestamp, readings);
 }
 
 
@@ -2019,21 +2271,17 @@ int GT1724::getLosLol(uint8_t los[4], uint8_t lol[4])
 // NB: This DOES NOT emit a "Result" signal.
 // NB: '1' in LOS and LOL data indicates LOSS of signal or lock for the corresponding lane.
 //     'true' = 1 in the generated signals (LOSS of signal / lock)
+// NB: The register read is queued as an async I2C op, so this slot returns
+//     straight away; EDLosLol signals are emitted from commsOpFinished.
+//     If a previous request is still outstanding, no new read is queued.
 void GT1724::GetLosLol(int metaLane)
 {
     LANE_FILTER(metaLane);
-    uint8_t los[4] = { 0 };
-    uint8_t lol[4] = { 0 };
-    int result = getLosLol(los, lol);
-    if (result == globals::OK)
+    if (losLolOpID > 0) return;   // Already waiting for LOS / LOL data
+    int result = comms->readAsync(i2cAddress, GTREG_LOSL_OUTPUT, 1);
+    if (result > 0)
     {
-        emit EDLosLol(laneOffset + 1, (los[1] != 0), (lol[1] != 0));
-        emit EDLosLol(laneOffset + 3, (los[3] != 0), (lol[3] != 0));
-
-        // Update the internal flags which record LOS / LOL status for each ED lane:
-        ed01.los = (los[1] != 0);  ed01.lol = (lol[1] != 0);
-        ed23.los = (los[3] != 0);  ed23.lol = (lol[3] != 0);
-
+        losLolOpID = result;
     }
     else
     {
@@ -2042,6 +2290,32 @@ void GT1724::GetLosLol(int metaLane)
 }
 
 
+// PRIVATE SLOT: Async I2C op finished. Ops which weren't queued
+// by this instance are ignored.
+void GT1724::commsOpFinished(int opID, int result, QByteArray data)
+{
+    if (opID != losLolOpID) return;
+    losLolOpID = 0;
+    if (result != globals::OK || data.size() < 1)
+    {
+        emit ShowMessage("Error getting signal status data.");
+        return;
+    }
+    uint8_t losLolData = static_cast<uint8_t>(data.at(0));
+    bool los1 = ((losLolData >> 1) & 0x01) != 0;
+    bool lol1 = ((losLolData >> 5) & 0x01) != 0;
+    bool los3 = ((losLolData >> 3) & 0x01) != 0;
+    bool lol3 = ((losLolData >> 7) & 0x01) != 0;
+
+    emit EDLosLol(laneOffset + 1, los1, lol1);
+    emit EDLosLol(laneOffset + 3, los3, lol3);
+
+    // Update the internal flags which record LOS / LOL status for each ED lane:
+    ed01.los = los1;  ed01.lol = lol1;
+    ed23.los = los3;  ed23.lol = lol3;
+}
+
+
 
 
 
@@ -2052,23 +2326,26 @@ int GT1724::debugPowerStatus(int lane)
     int result;
     uint8_t data;
     DEBUG_GT1724("GT1724: Lane Power Debug: Core " << laneOffset << "; Lane " << lane)
+    // Nb: Reads the chip directly (getRegister16), not the register shadow, so
+    // this shows the real hardware state:
+    const uint16_t page = static_cast<uint16_t>(LANE_MOD(lane)) << 8;
 
-    result = getRegister(LANE_MOD(lane), 0, &data);
+    result = getRegister16(page + 0, &data);
     DEBUG_GT1724(" -cdr_reg_0 (0) : " << result << ": " << QString("0x%1").arg(data,2,16,QChar('0')))
 
-    result = getRegister(LANE_MOD(lane), 50, &data);
+    result = getRegister16(page + 50, &data);
     DEBUG_GT1724(" -drv_reg_0 (50): " << result << ": " << QString("0x%1").arg(data,2,16,QChar('0')))
 
-    result = getRegister(LANE_MOD(lane), 60, &data);
+    result = getRegister16(page + 60, &data);
     DEBUG_GT1724(" -pd_reg_0  (60): " << result << ": " << QString("0x%1").arg(data,2,16,QChar('0')))
 
-    result = getRegister(LANE_MOD(lane), 61, &data);
+    result = getRegister16(page + 61, &data);
     DEBUG_GT1724(" -pd_reg_1  (61): " << result << ": " << QString("0x%1").arg(data,2,16,QChar('0')))
 
-    result = getRegister(LANE_MOD(lane), 63, &data);
+    result = getRegister16(page + 63, &data);
     DEBUG_GT1724(" -pd_reg_3  (63): " << result << ": " << QString("0x%1").arg(data,2,16,QChar('0')))
 
-    result = getRegister(LANE_MOD(lane), 66, &data);
+    result = getRegister16(page + 66, &data);
     DEBUG_GT1724(" -pd_reg_6  (66): " << result << ": " << QString("0x%1").arg(data,2,16,QChar('0')))
 
     return result;
@@ -2078,27 +2355,26 @@ int GT1724::debugPowerStatus(int lane)
 
 
 /*!
- \brief Load a hex file from disk and convert to binary array
- Uses Intel hex file format
+ \brief Load a hex file from disk and convert to a binary image
+ Uses Intel hex file format. The file is only parsed once; the image is
+ kept in macroImage and shared by all GT1724 instances. Records with
+ consecutive addresses are merged into a single segment so that the
+ download can use large writes (see downloadHexFile).
 
  NOTE: This is a very simple implementation of a hex file reader.
  It is designed to support the macro file used by the GT1724;
  It DOESN'T fully implement all HEX file features!
 
- \return globals::OK              Macros downloaded OK.
- \return globals::NOT_CONNECTED   Error (comms not open)
+ \return globals::OK              Image ready in macroImage
  \return globals::FILE_ERROR      Error reading macro file
- \return globals::WRITE_ERROR     Write error sending command / data to USB-I2C module
- \return globals::READ_ERROR      Read error - Error reading data back from USB-I2C module
- \return globals::OVERFLOW        Error (> 64 data bytes in a line)
-
 */
-int GT1724::downloadHexFile()
+int GT1724::loadMacroImage()
 {
+    QMutexLocker locker(&macroImageMutex);
+    if (!macroImage.isEmpty()) return globals::OK;  // Already loaded.
+
     QString fileName;
     size_t fileIndex;
-    size_t fileLines;
-    int result;
     bool isOpen = false;
     QFile hexFile;
     QString useMacroVersion;
@@ -2117,8 +2393,7 @@ int GT1724::downloadHexFile()
         if (useMacroVersion != "" && useMacroVersion != globals::MACRO_FILES[fileIndex].macroVersionString) continue;   // Not interested in this macro version!
 
         fileName = QDir( globals::getAppPath() ).absoluteFilePath(globals::MACRO_FILES[fileIndex].hexFileName);
-        fileLines = globals::MACRO_FILES[fileIndex].lineCount;
-        DEBUG_GT1724("GT1724: Hex File Download...")
+        DEBUG_GT1724("GT1724: Load Hex File...")
         DEBUG_GT1724("Opening file: " << fileName)
         hexFile.setFileName(fileName);
         isOpen = hexFile.open(QIODevice::ReadOnly | QIODevice::Text);
@@ -2139,17 +2414,13 @@ int GT1724::downloadHexFile()
     bool bytesOK;
     bool lineOK;
     uint8_t nBytes;
-    int offset;
     uint8_t dataByte;
     uint8_t addressHi;
     uint8_t addressLo;
 
-    uint8_t lineData[256];   // The lazy way to buffer line data (max hex file record length is 255)...
+    QByteArray lineData;
     size_t totalBytes = 0;
-    int percent = 0;
-    int lastPercent = 0;
-
-    emit ShowMessage(QString("Downloading utilities macro (Core %1)... ").arg(coreNumber));
+    QList<MacroSegment_t> image;
 
     while (!hexFile.atEnd()) {
         QByteArray hexLine = hexFile.readLine();
@@ -2170,9 +2441,8 @@ int GT1724::downloadHexFile()
         if (nBytes == 0) {
             continue;
         }
-        totalBytes += nBytes;
         lineOK = TRUE;
-        offset = 0;
+        lineData.clear();
         uint16_t i;
         for (i=9; i<((nBytes*2)+9); i+=2) {
             if ( i > (hexLine.size()-2) ) {
@@ -2187,38 +2457,101 @@ int GT1724::downloadHexFile()
                 lineOK = FALSE;
                 break;
             }
-            lineData[offset] = dataByte;
-            offset++;   // Added a byte from the record!
+            lineData.append(static_cast<char>(dataByte));   // Added a byte from the record!
         }  // [for...]
-
-        // Line read. Send to each board:
-        if (lineOK)
+        if (!lineOK) continue;
+
+        // Line read. Add to the image, merging with the previous segment if it follows on:
+        uint32_t address = ((uint32_t)MACRO_ADDRESS_HI << 16) |
+                           ((uint32_t)addressHi << 8) |
+                           ((uint32_t)addressLo);
+        if (!image.isEmpty()
+         && image.last().address + static_cast<uint32_t>(image.last().data.size()) == address)
         {
-            result = rawWrite24(0xFB,
-                                addressHi,
-                                addressLo,
-                                lineData,
-                                nBytes );
-            if (result != globals::OK)
-            {
-                hexFile.close();
-                return result;  // I2C command error!
-            }
+            image.last().data.append(lineData);
         }
-
-        // Update status %:
-        percent = ( (lineNo*100) / fileLines);
-        if (percent >= (lastPercent + 20) )
+        else
         {
-            lastPercent += 20;
-            emit ShowMessage(QString("%1%... ").arg(lastPercent,2,10,QChar('0')), true);
+            MacroSegment_t segment;
+            segment.address = address;
+            segment.data = lineData;
+            image.append(segment);
         }
+        totalBytes += nBytes;
 
     }  //  [while (!hexFile.atEnd())]
 
-    DEBUG_GT1724(lineNo << " lines read! (" << totalBytes << " bytes).")
+    DEBUG_GT1724(lineNo << " lines read! (" << totalBytes << " bytes in " << image.count() << " segments).")
     // Finished reading!
     hexFile.close();
+    if (image.isEmpty()) return globals::FILE_ERROR;
+    macroImage = image;
+    macroImageBytes = totalBytes;
+    return globals::OK;
+}
+
+
+/*!
+ \brief Download the extension macros to the GT1724
+ Writes the binary image prepared by loadMacroImage. Each segment of the image
+ is written in blocks of up to MACRO_WRITE_BLOCK bytes; write24 packs each block
+ into as few adaptor frames as possible.
+
+ \return globals::OK              Macros downloaded OK.
+ \return globals::NOT_CONNECTED   Error (comms not open)
+ \return globals::FILE_ERROR      Error reading macro file
+ \return globals::WRITE_ERROR     Write error sending command / data to USB-I2C module
+ \return globals::READ_ERROR      Read error - Error reading data back from USB-I2C module
+*/
+int GT1724::downloadHexFile()
+{
+    int result = loadMacroImage();
+    if (result != globals::OK) return result;
+
+    QList<MacroSegment_t> image;
+    size_t imageBytes;
+    {
+        QMutexLocker locker(&macroImageMutex);
+        image = macroImage;
+        imageBytes = macroImageBytes;
+    }
+
+    size_t totalBytes = 0;
+    int percent = 0;
+    int lastPercent = 0;
+
+    emit ShowMessage(QString("Downloading utilities macro (Core %1)... ").arg(coreNumber));
+
+    foreach (const MacroSegment_t &segment, image)
+    {
+        const uint8_t *data = reinterpret_cast<const uint8_t *>(segment.data.constData());
+        const size_t segmentBytes = static_cast<size_t>(segment.data.size());
+        size_t offset = 0;
+        while (offset < segmentBytes)
+        {
+            size_t blockBytes = segmentBytes - offset;
+            if (blockBytes > MACRO_WRITE_BLOCK) blockBytes = MACRO_WRITE_BLOCK;
+            uint32_t address = segment.address + static_cast<uint32_t>(offset);
+            result = rawWrite24(static_cast<uint8_t>(address >> 16),
+                                static_cast<uint8_t>(address >> 8),
+                                static_cast<uint8_t>(address),
+                                data + offset,
+                                blockBytes);
+            if (result != globals::OK) return result;  // I2C command error!
+            offset     += blockBytes;
+            totalBytes += blockBytes;
+
+            // Update status %:
+            percent = static_cast<int>((totalBytes * 100) / imageBytes);
+            while (percent >= (lastPercent + 20) )
+            {
+                lastPercent += 20;
+                emit ShowMessage(QString("%1%... ").arg(lastPercent,2,10,QChar('0')), true);
+            }
+        }
+    }
+
+    DEBUG_GT1724("Macro download finished (" << totalBytes << " bytes).")
     return globals::OK;
 }
 
@@ -2296,6 +2629,10 @@ bool GT1724::hexCharsToInt(uint8_t charHi, uint8_t charLo, uint8_t *result )
                     return globals::OVERFLOW.
  \param timeoutMs   Timeout in mS. If the macro doesn't complete and return a
                     result (OK or Error) in this time, TIMEOUT is returned.
+                    The macro status is polled at short intervals to start
+                    with (MACRO_POLL_INITIAL_MS), backing off exponentially up
+                    to MACRO_POLL_MAX_MS, so quick macros return promptly.
+                    Run times are recorded per macro code (see getMacroLatencyStats).
 
  \return globals::OK              Success
  \return globals::NOT_CONNECTED   No connection to BERT
@@ -2319,7 +2656,9 @@ int GT1724::runMacroStatic(I2CComms      *comms,
     if ( (dataInSize > 16) || (dataOutSize > 16) ) return globals::OVERFLOW;
 
     int result = globals::OK;
-    int pollCount;
+    int pollCount = 0;
+    QElapsedTimer macroTimer;
+    macroTimer.start();
 
     int errorCounter = 0;
     while (TRUE)
@@ -2346,28 +2685,41 @@ int GT1724::runMacroStatic(I2CComms      *comms,
         // ***** Poll the macro code register and wait for it to change to 0x00 or 0x01: ******
         // DEBUG_GT1724("  Polling Code/Status Register for result code...")
         uint8_t macroResult;
-        pollCount = timeoutMs / 100;  // Note: Polling every 100 mS (see below).
-        while (pollCount > 0)
+        bool macroTimeout = false;
+        int pollInterval = MACRO_POLL_INITIAL_MS;
+        QElapsedTimer pollTimer;
+        pollTimer.start();
+        while (true)
         {
-            globals::sleep(100);
+            // Don't sleep past the timeout:
+            qint64 timeLeft = static_cast<qint64>(timeoutMs) - pollTimer.elapsed();
+            if (timeLeft < pollInterval) pollInterval = (timeLeft > 0) ? static_cast<int>(timeLeft) : 0;
+            if (pollInterval > 0) globals::sleep(pollInterval);
             // Read back the Macro code (indicates macro status):
             result = comms->read(i2cAddress, 0x0C10, &macroResult, 1);
+            pollCount++;
             // DEBUG_GT1724("  -->Poll Read Result: " << result)
             if (result != globals::OK) goto macroFinished;  // I2C command error
             // DEBUG_GT1724("  -->Status: " << QString("{%1} (00=OK, 01=Error, xx=Still Running)").arg((int)macroResult,2,16,QChar('0') ))
             if ( (macroResult == 0x00) ||
                  (macroResult == 0x01) ) break;  // Macro finished.
-            pollCount--;
+            if (pollTimer.elapsed() >= timeoutMs)
+            {
+                macroTimeout = true;
+                break;
+            }
+            pollInterval *= 2;
+            if (pollInterval > MACRO_POLL_MAX_MS) pollInterval = MACRO_POLL_MAX_MS;
         }
 
 #ifdef BERT_MACRO_DEBUG
         // ------ DEBUG --------
-        if (pollCount == 0)      DEBUG_GT1724("  -->Macro TIMEOUT!")
+        if (macroTimeout)        DEBUG_GT1724("  -->Macro TIMEOUT!")
         if (macroResult == 0x01) DEBUG_GT1724("  -->Macro ERROR!")
         // ---------------------
 #endif
 
-        if (pollCount == 0)
+        if (macroTimeout)
         {
             //result = globals::TIMEOUT;      // Timeout! Macro didn't finish, or returned error.
             //goto macroFinished;
@@ -2392,10 +2744,77 @@ int GT1724::runMacroStatic(I2CComms      *comms,
     }
 macroFinished:
     errorCounter = 0;
+    recordMacroLatency(code, result, macroTimer.nsecsElapsed() / 1000, pollCount);
     return result;
 }
 
 
+/*!
+ \brief Record the run time of a macro (see runMacroStatic)
+ \param code    Macro code
+ \param result  Result of macro (globals::OK, globals::TIMEOUT, etc)
+ \param timeUs  Time taken, including retries (uS)
+ \param polls   Number of status polls carried out
+*/
+void GT1724::recordMacroLatency(const uint8_t code, const int result, const qint64 timeUs, const int polls)
+{
+    QMutexLocker locker(&macroLatencyStatsMutex);
+    MacroLatencyStats_t &stats = macroLatencyStats[code];
+    stats.runCount++;
+    if      (result == globals::TIMEOUT) stats.timeoutCount++;
+    else if (result != globals::OK)      stats.errorCount++;
+    stats.pollCount += static_cast<quint64>(polls);
+    stats.totalTimeUs += timeUs;
+    if (stats.runCount == 1 || timeUs < stats.minTimeUs) stats.minTimeUs = timeUs;
+    if (timeUs > stats.maxTimeUs) stats.maxTimeUs = timeUs;
+}
+
+
+/*!
+ \brief Get a copy of the macro latency statistics
+ \return Map of macro code to statistics for that code
+*/
+QMap<uint8_t, GT1724::MacroLatencyStats_t> GT1724::getMacroLatencyStats()
+{
+    QMutexLocker locker(&macroLatencyStatsMutex);
+    return macroLatencyStats;
+}
+
+
+/*!
+ \brief Clear the macro latency statistics
+*/
+void GT1724::resetMacroLatencyStats()
+{
+    QMutexLocker locker(&macroLatencyStatsMutex);
+    macroLatencyStats.clear();
+}
+
+
+/*!
+ \brief Write the macro latency statistics to the debug log
+*/
+void GT1724::logMacroLatencyStats()
+{
+    QMap<uint8_t, MacroLatencyStats_t> stats = getMacroLatencyStats();
+    qDebug() << "GT1724 Macro latency:";
+    QMap<uint8_t, MacroLatencyStats_t>::const_iterator i;
+    for (i = stats.constBegin(); i != stats.constEnd(); ++i)
+    {
+        const MacroLatencyStats_t &s = i.value();
+        qDebug() << QString("  Macro 0x%1: %2 runs (%3 timeouts, %4 errors); %5 polls; Time min/mean/max: %6 / %7 / %8 uS")
+                    .arg((int)i.key(),2,16,QChar('0'))
+                    .arg(s.runCount)
+                    .arg(s.timeoutCount)
+                    .arg(s.errorCount)
+                    .arg(s.pollCount)
+                    .arg(s.minTimeUs)
+                    .arg((s.runCount > 0) ? (s.totalTimeUs / s.runCount) : 0)
+                    .arg(s.maxTimeUs);
+    }
+}
+
+
 /*!
  \brief Execute a macro with specified timeout
  For parameters and return code, see runMacroStatic
@@ -2407,6 +2826,7 @@ int GT1724::runLongMacro(const uint8_t  code,
                          const uint8_t  dataOutSize,
                          const uint16_t timeoutMs )
 {
+    if (!isQueryMacro(code)) invalidateRegisterShadow();  // Macro may rewrite lane registers
     return runMacroStatic(comms, i2cAddress, code, dataIn, dataInSize, dataOut, dataOutSize, timeoutMs);
 }
 
@@ -2458,6 +2878,8 @@ int GT1724::runVerySimpleMacro(const uint8_t code)
 
 /*!
  \brief Set a register
+ Shadowed registers (see isShadowedRegister): The shadow is updated with
+ the new value, or cleared for this register if the write fails.
  \param lane    Lane select - 0 to 3
  \param address Register address (low byte)
  \param data    Data to write to the register
@@ -2472,6 +2894,11 @@ int GT1724::setRegister(int lane, const uint8_t address, const uint8_t data )
     int result;
     result = comms->write(i2cAddress, ((uint16_t)lane << 8) + (uint16_t)address, &data, 1);
     DEBUG_REG("[Register WRITE]: Lane: " << (int)lane << " Addr: " << (int)address << " Data: " << (int)data << " Result: " << result)
+    if (isShadowedRegister(address))
+    {
+        registerShadow[lane][address] = data;
+        registerShadowValid[lane][address] = (result == globals::OK);
+    }
     return result;
 }
 
@@ -2479,6 +2906,9 @@ int GT1724::setRegister(int lane, const uint8_t address, const uint8_t data )
 
 /*!
  \brief Get the value of a register
+ Shadowed registers (see isShadowedRegister) are answered from the
+ shadow without any I2C traffic if it holds a value; otherwise the
+ register is read from the chip and the value kept in the shadow.
  \param lane    Lane select - 0 to 3
                 Used as the upper byte of the register address ('page').
  \param address Register address (low byte)
@@ -2493,13 +2923,120 @@ int GT1724::setRegister(int lane, const uint8_t address, const uint8_t data )
 int GT1724::getRegister(int lane, const uint8_t address, uint8_t *data )
 {
     Q_ASSERT(lane >= 0 && lane < 4);
+    if (registerShadowValid[lane][address])
+    {
+        *data = registerShadow[lane][address];
+        return globals::OK;
+    }
     int result = comms->read(i2cAddress, ((uint16_t)lane << 8) + (uint16_t)address, data, 1);
     DEBUG_REG("[Register READ]: Lane: " << (int)lane << " Addr: " << (int)address << " Data: " << (int)*data << " Result: " << result)
+    if (result == globals::OK && isShadowedRegister(address))
+    {
+        registerShadow[lane][address] = *data;
+        registerShadowValid[lane][address] = true;
+    }
     return result;
 }
 
 
 
+/*!
+ \brief Is a lane register kept in the register shadow?
+ These are the lane registers which are read-modify-written by the
+ setXXX methods, and read by the getXXX methods on each UI refresh.
+ Nb: The macros don't change these registers except when configuring
+ the chip; runLongMacro clears the shadow for those (see isQueryMacro).
+*/
+bool GT1724::isShadowedRegister(const uint8_t address)
+{
+    switch (address)
+    {
+    case GTREG_CDR_REG_0:
+    case GTREG_EQ_REG_0:
+    case GTREG_EQ_REG_2:
+    case GTREG_DRV_REG_0:
+    case GTREG_DRV_REG_2:
+    case GTREG_DRV_REG_5:
+    case GTREG_PD_REG_1:
+    case GTREG_PD_REG_6:
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+/*!
+ \brief Is a macro a query which leaves the lane registers alone?
+ Any other macro clears the register shadow before it runs.
+*/
+bool GT1724::isQueryMacro(const uint8_t code)
+{
+    switch (code)
+    {
+    case 0x18:   // Query macro version
+    case 0x28:   // Read core temperature
+    case 0x51:   // Query PRBS checker options
+    case 0x53:   // Read PRBS checker error count
+    case 0x59:   // Query PRBS generator options
+    case 0x69:   // Query output driver main swing
+        return true;
+    default:
+        return false;
+    }
+}
+
+
+/*!
+ \brief Clear the register shadow
+ The next read of each shadowed register will come from the chip.
+*/
+void GT1724::invalidateRegisterShadow()
+{
+    memset(registerShadowValid, 0, sizeof(registerShadowValid));
+}
+
+
+/*!
+ \brief Check the register shadow against the chip
+ Reads each register which currently has a shadow value, and compares.
+ Mismatched registers take the value read from the chip.
+ \param countChecked   Set to the number of registers checked
+ \param countMismatch  Set to the number of registers where the shadow was wrong
+ \return globals::OK   All shadowed registers read OK
+ \return [error code]  Error reading a register; shadow entry for it is cleared
+*/
+int GT1724::verifyRegisterShadow(int &countChecked, int &countMismatch)
+{
+    countChecked = 0;
+    countMismatch = 0;
+    for (int lane = 0; lane < 4; lane++)
+    {
+        for (int address = 0; address < 256; address++)
+        {
+            if (!registerShadowValid[lane][address]) continue;
+            uint8_t data = 0;
+            int result = comms->read(i2cAddress, ((uint16_t)lane << 8) + (uint16_t)address, &data, 1);
+            if (result != globals::OK)
+            {
+                registerShadowValid[lane][address] = false;
+                return result;
+            }
+            countChecked++;
+            if (data != registerShadow[lane][address])
+            {
+                qDebug() << "GT1724: Register shadow mismatch: Lane " << lane << " Addr " << INT_AS_HEX(address,2)
+                         << " Shadow: " << INT_AS_HEX(registerShadow[lane][address],2) << " Chip: " << INT_AS_HEX(data,2);
+                registerShadow[lane][address] = data;
+                countMismatch++;
+            }
+        }
+    }
+    return globals::OK;
+}
+
+
+
 /*!
  \brief Set a register (16 bit address)
  \param address Register address (16 bit)
@@ -2561,7 +3098,7 @@ int GT1724::rawWrite24(const uint8_t addressHi,
                        const uint8_t addressMid,
                        const uint8_t addressLow,
                        const uint8_t *data,
-                       const uint8_t nBytes )
+                       const size_t  nBytes )
 {
     uint32_t address = ((uint32_t)addressHi << 16) |
                        ((uint32_t)addressMid << 8) |
@@ -2615,18 +3152,16 @@ int GT1724::rawRead24(const uint8_t addressHi,
 // ==============================================================================
 
 // **** Slots to carry out Eye Scan functons: *************
-void GT1724::EyeScanStart(int lane, int type, int hStep, int vStep, int vOffset, int countRes)
+void GT1724::EyeScanStart(int lane, int type, int hStep, int vStep, int vOffset, int countRes, bool adaptive, bool converge)
 {
     LANE_FILTER(lane);
     DEBUG_GT1724("GT1724: (" << this << ") Eye Scan START request for lane " << lane)
     int modLane = LANE_MOD(lane);
     Q_ASSERT(modLane == 1 || modLane == 3);
     if (modLane != 1 && modLane != 3) return;  // Invalid lane.
-    EyeMonitor *em;
-    if (modLane == 1) em = eyeMonitor01;
-    else              em = eyeMonitor23;
-
-    em->startScan(type, hStep, vStep, vOffset, countRes);
+    EyeScanRequest_t request = { lane, false, type, hStep, vStep, vOffset, countRes, adaptive, converge };
+    eyeScanQueue.append(request);
+    eyeScanQueueService();
 }
 
 void GT1724::EyeScanRepeat(int lane)
@@ -2636,8 +3171,9 @@ void GT1724::EyeScanRepeat(int lane)
     int modLane = LANE_MOD(lane);
     Q_ASSERT(modLane == 1 || modLane == 3);
     if (modLane != 1 && modLane != 3) return;  // Invalid lane.
-    if (modLane == 1) eyeMonitor01->repeatScan();
-    else              eyeMonitor23->repeatScan();
+    EyeScanRequest_t request = { lane, true, 0, 0, 0, 0, 0, false, false };
+    eyeScanQueue.append(request);
+    eyeScanQueueService();
 }
 
 void GT1724::EyeScanCancel(int lane)
@@ -2646,6 +3182,7 @@ void GT1724::EyeScanCancel(int lane)
     {
         // Cancel ALL eye scans on this chip:
         DEBUG_GT1724("GT1724: (" << this << ") Eye Scan CANCEL request for all lanes")
+        eyeScanQueue.clear();
         eyeMonitor01->cancelScan();
         eyeMonitor23->cancelScan();
     }
@@ -2656,36 +3193,85 @@ void GT1724::EyeScanCancel(int lane)
         int modLane = LANE_MOD(lane);
         Q_ASSERT(modLane == 1 || modLane == 3);
         if (modLane != 1 && modLane != 3) return;  // Invalid lane.
+        for (int i = eyeScanQueue.size() - 1; i >= 0; i--)
+        {
+            if (eyeScanQueue[i].lane == lane) eyeScanQueue.removeAt(i);
+        }
         if (modLane == 1) eyeMonitor01->cancelScan();
         else              eyeMonitor23->cancelScan();
     }
 }
 
+/*!
+ \brief Run queued eye scan requests
+ Scans on this chip run one at a time (the lanes share the macro
+ engine), but each GT1724 runs on its own thread, so scans on different
+ chips proceed in parallel: while one chip is sweeping (polling macro
+ status, which leaves the I2C bus mostly idle) another can read back
+ its scan data. The UI therefore starts all selected channels at once.
+
+ If a scan is already running (i.e. we have been re-entered from
+ processEvents in eyeScanCheckForCancel), the new request stays in the
+ queue and is picked up by the outer call when the current scan ends.
+*/
+void GT1724::eyeScanQueueService()
+{
+    if (eyeScanBusy) return;
+    eyeScanBusy = true;
+    I2CPriorityScope priority(I2CComms::PRIORITY_MEASUREMENT);  // Scan readback
+    while (!eyeScanQueue.isEmpty())
+    {
+        EyeScanRequest_t request = eyeScanQueue.takeFirst();
+        EyeMonitor *em;
+        if (LANE_MOD(request.lane) == 1) em = eyeMonitor01;
+        else                             em = eyeMonitor23;
+        if (request.repeat) em->repeatScan();
+        else                em->startScan(request.type, request.hStep, request.vStep, request.vOffset, request.countRes, request.adaptive, request.converge);
+    }
+    eyeScanBusy = false;
+}
+
 // ******* Emit signals on behalf of the Eye Scan module: *********
 
 void GT1724::emitEyeScanProgressUpdate(int lane, int type, int percent)                        { emit EyeScanProgressUpdate(lane, type, percent);    }
 void GT1724::emitEyeScanError(int lane, int type, int code)                                    { emit EyeScanError(lane, type, code);                }
-void GT1724::emitEyeScanFinished(int lane, int type, QVector<double> data, int xRes, int yRes) { emit EyeScanFinished(lane, type, data, xRes, yRes); }
+void GT1724::emitEyeScanPartial(int lane, int type, EyeScanResult result, int rowsDone)       { emit EyeScanPartial(lane, type, result, rowsDone);  }
+void GT1724::emitEyeScanFinished(int lane, int type, EyeScanResult result)                    { emit EyeScanFinished(lane, type, result);           }
 
 // *** Eye scanner - Call 'processEvents' to check for EyeScanCancel signal:
+// Nb: Slots run from here use the default I2C priority, not the scan's.
 void GT1724::eyeScanCheckForCancel()
 {
+    I2CPriorityScope priority(I2CComms::PRIORITY_CONTROL);
     QCoreApplication::processEvents();
 }
 
 
+// Macro latency stats, shared by all GT1724 instances (see recordMacroLatency):
+QMap<uint8_t, GT1724::MacroLatencyStats_t> GT1724::macroLatencyStats;
+QMutex GT1724::macroLatencyStatsMutex;
+
+// Parsed macro file image, shared by all GT1724 instances (see loadMacroImage):
+QList<GT1724::MacroSegment_t> GT1724::macroImage;
+size_t GT1724::macroImageBytes = 0;
+QMutex GT1724::macroImageMutex;
+
+
 
 //==============================================================================
 //  Lists and Look-up tables for Selectable Items
 //==============================================================================
+// Lookup tables are constexpr arrays with a ConstArray view (see globals.h),
+// so they need no static initialisation.
 
 
 // -- Amplitudes: ----------------------
 // This look up table maps the INDEX of items in the "Amplitude"
 // list to voltage swing value for get / set Output Swing
 // Nb: This is the register setting, i.e. mV / 5:
-const QList<int> GT1724::PG_OUTPUT_SWING_LOOKUP =
+constexpr int PG_OUTPUT_SWING_VALUES[] =
     { 40, 60, 80, 100, 120, 140, 160, 180, 200, 220 };
+const ConstArray<int> GT1724::PG_OUTPUT_SWING_LOOKUP(PG_OUTPUT_SWING_VALUES);
 const QStringList GT1724::PG_OUTPUT_SWING_LIST =
     { "200 mV", "300 mV", "400 mV", "500 mV", "600 mV", "700 mV", "800 mV", "900 mV", "1 V", "1.1 V" };
 
@@ -2706,8 +3292,9 @@ const QStringList GT1724::PG_EQ_CURSOR_LIST = { "Post-Cursor", "Pre-Cursor" };
 // -- Cross Point Lookup: -------------
 // This look-up table maps the index of items in the "Cross Point"
 // combo box to a "cross point adjust" register setting (see GT1274 data sheet section 6)
-const QList<int> GT1724::PG_CROSS_POINT_LOOKUP =
+constexpr int PG_CROSS_POINT_VALUES[] =
     { 9, 0, 3, 6, 12, 15 };
+const ConstArray<int> GT1724::PG_CROSS_POINT_LOOKUP(PG_CROSS_POINT_VALUES);
 const QStringList GT1724::PG_CROSS_POINT_LIST =
     { "50%", "35%", "40%", "45%", "55%" };
 
@@ -2719,20 +3306,23 @@ const int GT1724::ED_PATTERN_DEFAULT = 2;
 
 
 // -- EQ Boost Lookup (ED Page): ---------------
-const QList<int> GT1724::ED_EQ_BOOST_LOOKUP =
+constexpr int ED_EQ_BOOST_VALUES[] =
     { 0, 40, 59, 74, 87, 96, 105, 112, 118, 123, 127 };
+const ConstArray<int> GT1724::ED_EQ_BOOST_LOOKUP(ED_EQ_BOOST_VALUES);
 const QStringList GT1724::ED_EQ_BOOST_LIST =
     { "0dB", "1.2dB", "2.4dB", "3.6dB", "4.8dB", "6.0dB", "7.2dB", "8.4dB", "9.6dB", "10.8dB", "12.0dB" };
 
 
 // -- H-Step and V-Step for Eye Scan: -------------
-const QList<int> GT1724::EYESCAN_VHSTEP_LOOKUP = { 1, 2, 4, 8 };
+constexpr int EYESCAN_VHSTEP_VALUES[] = { 1, 2, 4, 8 };
+const ConstArray<int> GT1724::EYESCAN_VHSTEP_LOOKUP(EYESCAN_VHSTEP_VALUES);
 const QStringList GT1724::EYESCAN_VHSTEP_LIST = { "1", "2", "4", "8" };
 const int GT1724::EYESCAN_VHSTEP_DEFAULT = 1;
 
 // -- V Offset for Bathtub Scan: ----------------
-const QList<int>  GT1724::EYESCAN_VOFF_LOOKUP =
+constexpr int EYESCAN_VOFF_VALUES[] =
     { 127, 115, 103, 90, 77, 65, 52, 39, 26, 14, 1 };
+const ConstArray<int> GT1724::EYESCAN_VOFF_LOOKUP(EYESCAN_VOFF_VALUES);
 const QStringList GT1724::EYESCAN_VOFF_LIST =
     { "250 mV", "200 mV", "150 mV", "100 mV", "50 mV", "0 mV", "-50 mV", "-100 mV", "-150 mV", "-200 mV", "-250 mV" };
 const int GT1724::EYESCAN_VOFF_DEFAULT = 5;
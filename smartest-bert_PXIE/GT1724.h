@@ -14,13 +14,33 @@
 #include <QObject>
 #include <QStringList>
 #include <QTime>
+#include <QElapsedTimer>
+#include <QMap>
+#include <QMutex>
+#include <QSemaphore>
 
 #include "globals.h"
 #include "BertComponent.h"
 #include "I2CComms.h"
+#include "EyeScanResult.h"
 
 class EyeMonitor;
 
+/*!
+ \brief ED Count Reading
+ Counts for one ED lane, as returned in an EDCountSnapshot signal
+ (see GT1724::GetEDCountSnapshot). Values are as for the EDCount signal.
+*/
+typedef struct EDCountReading_t
+{
+    int    lane;          // ED input lane (1 / 3 / 5 / 7 / etc)
+    bool   locked;        // False if lane had LOS or LOL (counts are all 0)
+    double bits;          // Bits since last reading
+    double bitsTotal;     // Bits since ED started
+    double errors;        // Errors since last reading
+    double errorsTotal;   // Errors since ED started
+} EDCountReading_t;
+
 class GT1724 : public BertComponent
 {
     Q_OBJECT
@@ -54,8 +74,28 @@ public:
     // applies to ALL lanes on the chip), the parameter is labelled "metaLane".
 
     static bool ping(I2CComms *comms, const uint8_t i2cAddress);
+
+    // Macro latency statistics (per macro code; shared by all GT1724 instances):
+    typedef struct MacroLatencyStats_t
+    {
+        int     runCount = 0;        // Number of calls to runMacroStatic
+        int     timeoutCount = 0;    // ...which timed out
+        int     errorCount = 0;      // ...which failed for other reasons (macro error, I2C error)
+        quint64 pollCount = 0;       // Total number of status register polls
+        qint64  totalTimeUs = 0;     // Total time from macro start to completion (uS)
+        qint64  minTimeUs = 0;       // Fastest run (uS)
+        qint64  maxTimeUs = 0;       // Slowest run (uS)
+    } MacroLatencyStats_t;
+
+    static QMap<uint8_t, MacroLatencyStats_t> getMacroLatencyStats();
+    static void resetMacroLatencyStats();
+    static void logMacroLatencyStats();
+
     void getOptions();
-    int init();
+    Q_INVOKABLE int init();   // Nb: Q_INVOKABLE so BertWorker can run init on this component's own thread
+    Q_INVOKABLE void initAsync();
+    Q_INVOKABLE void initSettingsAsync();
+    int  initWait();
 
 #define GT1724_SIGNALS \
     void EDLosLol(int lane, bool los, bool lol);                    \
@@ -63,9 +103,13 @@ public:
                  bool locked,                                       \
                  double bits, double bitsTotal,                     \
                  double errors, double errorsTotal);                \
+    void EDCountSnapshot(int metaLane, qint64 timestamp,            \
+                         QList<EDCountReading_t> readings);         \
     void EyeScanProgressUpdate(int lane, int type, int percent);    \
     void EyeScanError(int lane, int type, int code);                \
-    void EyeScanFinished(int lane, int type, QVector<double> data, int xRes, int yRes);
+    void EyeScanPartial(int lane, int type,                         \
+                        EyeScanResult result, int rowsDone);        \
+    void EyeScanFinished(int lane, int type, EyeScanResult result);
 
 #define GT1724_SLOTS \
     void CommsCheck(int metaLane); \
@@ -83,8 +127,9 @@ public:
     void SetEDOptions(int metaLane, int pattern01, bool invert01, bool enable01, int pattern23, bool invert23, bool enable23); \
     void GetLosLol(int metaLane); \
     void GetEDCount(int lane, double bitRate); \
+    void GetEDCountSnapshot(int metaLane, double bitRate); \
     void EDErrorInject(int lane); \
-    void EyeScanStart(int lane, int type, int hStep, int vStep, int vOffset, int countRes); \
+    void EyeScanStart(int lane, int type, int hStep, int vStep, int vOffset, int countRes, bool adaptive, bool converge); \
     void EyeScanRepeat(int lane); \
     void EyeScanCancel(int lane);
 
@@ -92,11 +137,15 @@ public:
     connect(GT1724, SIGNAL(EDLosLol(int, bool, bool)),         CLIENT, SLOT(EDLosLol(int, bool, bool)));                            \
     connect(GT1724, SIGNAL(EDCount(int, bool, double, double, double, double)),                                                     \
                                                                CLIENT, SLOT(EDCount(int, bool, double, double, double, double)));   \
+    connect(GT1724, SIGNAL(EDCountSnapshot(int, qint64, QList<EDCountReading_t>)),                                                  \
+                                                               CLIENT, SLOT(EDCountSnapshot(int, qint64, QList<EDCountReading_t>)));\
     connect(GT1724, SIGNAL(EyeScanProgressUpdate(int, int, int)),                                                                   \
                                                                CLIENT, SLOT(EyeScanProgressUpdate(int, int, int)));                 \
     connect(GT1724, SIGNAL(EyeScanError(int, int, int)),       CLIENT, SLOT(EyeScanError(int, int, int)));                          \
-    connect(GT1724, SIGNAL(EyeScanFinished(int, int, QVector<double>, int, int)),                                                   \
-                                                               CLIENT, SLOT(EyeScanFinished(int, int, QVector<double>, int, int))); \
+    connect(GT1724, SIGNAL(EyeScanPartial(int, int, EyeScanResult, int)),                                                           \
+                                                               CLIENT, SLOT(EyeScanPartial(int, int, EyeScanResult, int)));         \
+    connect(GT1724, SIGNAL(EyeScanFinished(int, int, EyeScanResult)),                                                               \
+                                                               CLIENT, SLOT(EyeScanFinished(int, int, EyeScanResult)));             \
                                                                                                                                     \
     connect(CLIENT, SIGNAL(CommsCheck(int)),                   GT1724, SLOT(CommsCheck(int)));                                      \
     connect(CLIENT, SIGNAL(GetTemperature(int)),               GT1724, SLOT(GetTemperature(int)));                                  \
@@ -115,9 +164,10 @@ public:
                                                                GT1724, SLOT(SetEDOptions(int, int, bool, bool, int, bool, bool)));  \
     connect(CLIENT, SIGNAL(GetLosLol(int)),                    GT1724, SLOT(GetLosLol(int)));                                       \
     connect(CLIENT, SIGNAL(GetEDCount(int, double)),           GT1724, SLOT(GetEDCount(int, double)));                              \
+    connect(CLIENT, SIGNAL(GetEDCountSnapshot(int, double)),   GT1724, SLOT(GetEDCountSnapshot(int, double)));                      \
     connect(CLIENT, SIGNAL(EDErrorInject(int)),                GT1724, SLOT(EDErrorInject(int)));                                   \
-    connect(CLIENT, SIGNAL(EyeScanStart(int, int, int, int, int, int)),                                                             \
-                                                               GT1724, SLOT(EyeScanStart(int, int, int, int, int, int)));           \
+    connect(CLIENT, SIGNAL(EyeScanStart(int, int, int, int, int, int, bool, bool)),                                                 \
+                                                               GT1724, SLOT(EyeScanStart(int, int, int, int, int, int, bool, bool))); \
     connect(CLIENT, SIGNAL(EyeScanRepeat(int)),                GT1724, SLOT(EyeScanRepeat(int)));                                   \
     connect(CLIENT, SIGNAL(EyeScanCancel(int)),                GT1724, SLOT(EyeScanCancel(int)));                                   \
     BERT_COMPONENT_CONNECT_SIGNALS(CLIENT, GT1724)
@@ -131,9 +181,17 @@ signals:
 public slots:
     GT1724_SLOTS
 
+    // From the status poller (see BertPoller::EDSetConfidenceTarget):
+    void EDStopLane(int lane);
+
+private slots:
+    void commsOpFinished(int opID, int result, QByteArray data);   // Async I2C op results (see GetLosLol)
 
 private:
 
+    int  initMacros();     // First part of init: Check / download macros (no clock needed)
+    int  initSettings();   // Second part of init: Defaults and PG resync (clock must be running)
+
     // GT1724 Instrument Functions:
 
     // configXXX methods: These set up the GT1724 for a certain mode of operation.
@@ -142,6 +200,7 @@ private:
     int  configSetDefaults (double bitRate);                 // Set up all default settings (cold boot / resync only)
 
     int  configPG          (int pattern, double bitRate);    // Set up GT1724 for Pattern Generator mode
+    int  configPGUpdate    (int pattern, double bitRate);    // Resync PG after a clock change (lanes already set up by configPG)
     int  configCDR         (int inputLane, int freqDivider); // Set up GT1724 for Clock Data Recovery Mode
 
     // getXXX / setXXX methods: These methods get or set the state of a specific GT1724
@@ -190,6 +249,7 @@ private:
     int  setEDOptions (int pattern01, int invert01, int enable01, int pattern23, int invert23, int enable23);
     int  getEDOptions ();
     int  getEDCount   (int edLane, double *bits, double *errors);
+    int  measureEDCount (int lane, int edLane, double bitRate, int elapsedNow, EDCountReading_t &reading);
 
     int  setLosEnable(uint8_t state);
     int  getLosLol(uint8_t los[4], uint8_t lol[4]);
@@ -202,12 +262,15 @@ private:
     // Emit signals on behalf of EyeScan module:
     void emitEyeScanProgressUpdate(int lane, int type, int percent);
     void emitEyeScanError(int lane, int type, int code);
-    void emitEyeScanFinished(int lane, int type, QVector<double> data, int xRes, int yRes);
+    void emitEyeScanPartial(int lane, int type, EyeScanResult result, int rowsDone);
+    void emitEyeScanFinished(int lane, int type, EyeScanResult result);
     // Eye scanner - check for cancel signal:
     void eyeScanCheckForCancel();
+    // Eye scanner - run queued scan requests:
+    void eyeScanQueueService();
 
     // *** Lists of settings with lookups: ***
-    static const QList<int> PG_OUTPUT_SWING_LOOKUP;
+    static const ConstArray<int> PG_OUTPUT_SWING_LOOKUP;
     static const QStringList PG_OUTPUT_SWING_LIST;
 
     static const QStringList PG_PATTERN_LIST;
@@ -216,20 +279,20 @@ private:
 
     static const QStringList PG_EQ_CURSOR_LIST;
 
-    static const QList<int> PG_CROSS_POINT_LOOKUP;
+    static const ConstArray<int> PG_CROSS_POINT_LOOKUP;
     static const QStringList PG_CROSS_POINT_LIST;
 
     static const QStringList ED_PATTERN_LIST;
     static const int ED_PATTERN_DEFAULT;
 
-    static const QList<int> ED_EQ_BOOST_LOOKUP;
+    static const ConstArray<int> ED_EQ_BOOST_LOOKUP;
     static const QStringList ED_EQ_BOOST_LIST;
 
-    static const QList<int> EYESCAN_VHSTEP_LOOKUP;
+    static const ConstArray<int> EYESCAN_VHSTEP_LOOKUP;
     static const QStringList EYESCAN_VHSTEP_LIST;
     static const int EYESCAN_VHSTEP_DEFAULT;
 
-    static const QList<int>  EYESCAN_VOFF_LOOKUP;
+    static const ConstArray<int> EYESCAN_VOFF_LOOKUP;
     static const QStringList EYESCAN_VOFF_LIST;
     static const int EYESCAN_VOFF_DEFAULT;
 
@@ -268,6 +331,35 @@ private:
     EyeMonitor *eyeMonitor01;     // Eye Monitor modules used for carrying out eye scans on this device's ED lanes
     EyeMonitor *eyeMonitor23;     //  (one instance for each ED lane!)
 
+    /*!
+     \brief Eye Scan Request
+     A scan start or repeat request waiting for the chip's macro engine.
+     Both eye monitors on a chip share the one macro engine, so scans
+     on lane 1 and lane 3 must run one after the other. Requests which
+     arrive while a scan is running (e.g. delivered by processEvents
+     during eyeScanCheckForCancel) are queued and run in order when
+     the current scan finishes.
+    */
+    typedef struct EyeScanRequest_t
+    {
+        int  lane;       // ED lane (1 / 3 / 5 / 7 / etc)
+        bool repeat;     // True: repeat previous scan; False: start new scan with parameters below
+        int  type;       //
+        int  hStep;      //
+        int  vStep;      // Parameters for EyeMonitor::startScan
+        int  vOffset;    //
+        int  countRes;   //
+        bool adaptive;   //
+        bool converge;   //
+    } EyeScanRequest_t;
+
+    QList<EyeScanRequest_t> eyeScanQueue;   // Scan requests waiting to run on this chip
+    bool eyeScanBusy = false;               // True while an eye scan is running on this chip
+
+    int        initResult = globals::NOT_INITIALISED;  // Result of last initAsync / initSettingsAsync
+    QSemaphore initFinished;                            // Released when initAsync / initSettingsAsync has finished
+    bool       coldBoot = false;                        // Set by initMacros: Macros were downloaded, so defaults must be set
+
     const uint8_t   i2cAddress;   // I2C Address of this chip (7 bit, i.e. not including R/W bit), supplied by creator
 
     const uint8_t   laneOffset;   // Lane number of 1st lane this chip will implement (e.g. 0 for 1st chip, 4 for 2nd, etc).
@@ -278,11 +370,24 @@ private:
                                   // (Purely for display purposes for users).
                                   // lane 0-3 = Core 1, Lane 4-7 = Core 2, etc.
 
+    // Register shadow: Last value read from or written to each of the lane registers
+    // which the getXXX / setXXX methods read-modify-write (see isShadowedRegister).
+    // getRegister answers from the shadow when it holds a value; setRegister updates it.
+    // Any macro which may reconfigure the chip clears the shadow (see runLongMacro).
+    uint8_t registerShadow[4][256];
+    bool    registerShadowValid[4][256] = {};
+
     int forceCDRBypass0 = CDR_BYPASS_OPTIONS_DEFAULT;  // CDR Bypass setting for Lane 0
     int forceCDRBypass1 = CDR_BYPASS_OPTIONS_DEFAULT;  // CDR Bypass setting for Lane 1 (only used for 4 channel PG mode)
     int forceCDRBypass2 = CDR_BYPASS_OPTIONS_DEFAULT;  // CDR Bypass setting for Lane 2
     int forceCDRBypass3 = CDR_BYPASS_OPTIONS_DEFAULT;  // CDR Bypass setting for Lane 3 (only used for 4 channel PG mode)
 
+    // Last applied PG configuration: pgSetupValid is set once configPG has
+    // routed and powered up the lanes, and cleared by anything which resets the
+    // device configuration; while set, configPG only runs configPGUpdate.
+    bool pgSetupValid = false;
+    int  cdrBypassApplied[4] = { -1, -1, -1, -1 };  // CDR bypass bit last written for each lane (1 = on; -1 = unknown)
+
 
     typedef struct edParameters_t
     {
@@ -298,8 +403,17 @@ private:
     edParameters_t ed01;
     edParameters_t ed23;
 
+    int losLolOpID = 0;   // ID of async LOS / LOL register read in progress (0 = none)
+
+    // Core temperature: Requests arriving within TEMPERATURE_REPEAT_MS of the last good
+    // read (e.g. polls which queued up while the chip was busy) are answered from that read:
+    static const int TEMPERATURE_REPEAT_MS = 1000;
+    QElapsedTimer temperatureTimer;   // Started at last good read; invalid if none yet
+    int temperatureDegrees = 0;       // Result of last good read
+
     // *** Private methods to drive the BERT, load macros, etc: ******
     int     macroCheck(int metaLane);
+    int     loadMacroImage();
     int     downloadHexFile();
     uint8_t hexCharToInt(uint8_t byte);
     bool    hexCharsToInt(uint8_t charHi, uint8_t charLo, uint8_t *result);
@@ -308,6 +422,35 @@ private:
     int     getCurrentSettings(int *pattern);
     bool    checkForceCDRBypass(int forceCDRBypass, double bitRate);
 
+    static bool isShadowedRegister(const uint8_t address);
+    static bool isQueryMacro(const uint8_t code);
+    void    invalidateRegisterShadow();
+    int     verifyRegisterShadow(int &countChecked, int &countMismatch);
+
+    // Macro status polling: Poll interval starts at MACRO_POLL_INITIAL_MS and
+    // doubles after each poll, up to MACRO_POLL_MAX_MS.
+    static const int MACRO_POLL_INITIAL_MS = 2;
+    static const int MACRO_POLL_MAX_MS = 100;
+
+    static QMap<uint8_t, MacroLatencyStats_t> macroLatencyStats;
+    static QMutex macroLatencyStatsMutex;
+
+    // Macro download: The hex file is parsed once into a binary image (see
+    // loadMacroImage), with consecutive records merged into segments.
+    typedef struct MacroSegment_t
+    {
+        uint32_t   address;   // 24 bit start address
+        QByteArray data;
+    } MacroSegment_t;
+
+    static const uint8_t MACRO_ADDRESS_HI = 0xFB;     // Upper address byte for macro memory (hex file has 16 bit addresses)
+    static const size_t  MACRO_WRITE_BLOCK = 480;     // Max bytes per rawWrite24 call during download (10 adaptor frames)
+
+    static QList<MacroSegment_t> macroImage;
+    static size_t macroImageBytes;
+    static QMutex macroImageMutex;
+    static void recordMacroLatency(const uint8_t code, const int result, const qint64 timeUs, const int polls);
+
     // Methods to access GT1724 via I2C, and run macros, set registers, etc.
     static int runMacroStatic(I2CComms      *comms,
                               const uint8_t  i2cAddress,
@@ -345,7 +488,7 @@ private:
                    const uint8_t  addressMid,
                    const uint8_t  addressLow,
                    const uint8_t *data,
-                   const uint8_t  nBytes);
+                   const size_t   nBytes);
 
     int rawRead24(const uint8_t  addressHi,
                   const uint8_t  addressMid,
@@ -12,27 +12,20 @@
 #include <QtSerialPort/QSerialPortInfo>
 
 #include "globals.h"
-#include "Serial.h"
+#include "I2CTransport.h"
+#include "BertLog.h"
+#ifdef BERT_SIMULATOR
+#include "I2CSimulator.h"
+#endif
 
 #include "I2CComms.h"
 
 
-// Debug Macro for Comms:
-// #define BERT_I2C_DEBUG
-// #define BERT_I2C_EXTRA_DEBUG
-#ifdef BERT_I2C_DEBUG
-  #define DEBUG_I2C(MSG) qDebug() << "\t\t\t\t" << MSG;
-  #ifdef BERT_I2C_EXTRA_DEBUG
-    #define DEBUG_I2C_EXTRA(MSG) qDebug() << "\t\t\t\t" << MSG;
-  #endif
-#endif
-
-#ifndef DEBUG_I2C
-  #define DEBUG_I2C(MSG)
-#endif
-#ifndef DEBUG_I2C_EXTRA
-  #define DEBUG_I2C_EXTRA(MSG)
-#endif
+// Debug Macros for Comms: Logged as BertLog::LOG_I2C (debug / trace), so they can
+// be turned on at run time (e.g. "--log i2c=trace"). Building with BERT_I2C_DEBUG or
+// BERT_I2C_EXTRA_DEBUG turns them on by default.
+#define DEBUG_I2C(MSG)       BERT_LOG(LOG_I2C, LEVEL_DEBUG, "\t\t\t\t" << MSG)
+#define DEBUG_I2C_EXTRA(MSG) BERT_LOG(LOG_I2C, LEVEL_TRACE, "\t\t\t\t" << MSG)
 
 
 
@@ -43,7 +36,8 @@
 
 // MACRO to handle comms error:
 #define COMMSERROR_RETRY(ECODE) {                      \
-        emit I2CClearPort();                           \
+        clearPort();                                   \
+        commsWorker->getProfiler().recordRetry(slaveAddress); \
         errorCounter++;                                \
         if (errorCounter >= MAX_RETRIES)               \
         {                                              \
@@ -59,6 +53,10 @@
    http://www.robot-electronics.co.uk/htm/usb_iss_tech.htm
 */
 
+// I2C request priority of each calling thread (see I2CComms::setThreadPriority):
+static thread_local int i2cThreadPriority = I2CComms::PRIORITY_CONTROL;
+
+
 I2CComms::I2CComms()
 {
     DEBUG_I2C("I2CComms: Constructor")
@@ -69,16 +67,19 @@ I2CComms::I2CComms()
     commsWorker = std::unique_ptr<I2CCommsWorker>(new I2CCommsWorker());
     commsWorker.get()->moveToThread(commsWorker.get());
 
-    connect(this, SIGNAL(I2CWorkerConnect(QString)), commsWorker.get(), SLOT(I2CWorkerConnect(QString)), Qt::BlockingQueuedConnection);
+    connect(this, SIGNAL(I2CWorkerConnect(QString, int)), commsWorker.get(), SLOT(I2CWorkerConnect(QString, int)), Qt::BlockingQueuedConnection);
     connect(this, SIGNAL(I2CWorkerDisconnect()),     commsWorker.get(), SLOT(I2CWorkerDisconnect()),     Qt::BlockingQueuedConnection);
-    connect(this, SIGNAL(I2CProbeAdaptor()),         commsWorker.get(), SLOT(I2CProbeAdaptor()),         Qt::BlockingQueuedConnection);
-    connect(this, SIGNAL(I2CConfigureAdaptor()),     commsWorker.get(), SLOT(I2CConfigureAdaptor()),     Qt::BlockingQueuedConnection);
-    connect(this, SIGNAL(I2CWorkerOp(int, const char *, int, char *)),
-                                                     commsWorker.get(), SLOT(I2CWorkerOp(int, const char *, int, char *)),
-                                                                                                         Qt::BlockingQueuedConnection);
     connect(this, SIGNAL(I2CClearPort()),            commsWorker.get(), SLOT(I2CClearPort()),            Qt::BlockingQueuedConnection);
     connect(this, SIGNAL(I2CWorkerExit()),           commsWorker.get(), SLOT(I2CWorkerExit()),           Qt::BlockingQueuedConnection);
 
+    // Async op results: Passed straight on to our clients (direct, so that results are
+    // delivered even while this thread is busy; clients on other threads get them queued):
+    connect(commsWorker.get(), SIGNAL(I2COpFinished(int, int, QByteArray)), this, SIGNAL(I2COpFinished(int, int, QByteArray)), Qt::DirectConnection);
+
+    commsWorker->getProfiler().setClassName(PRIORITY_MEASUREMENT, "Measurement");
+    commsWorker->getProfiler().setClassName(PRIORITY_CONTROL,     "Control");
+    commsWorker->getProfiler().setClassName(PRIORITY_COSMETIC,    "Cosmetic");
+
     commsWorker->start();
 }
 
@@ -112,13 +113,16 @@ std::unique_ptr<QStringList> I2CComms::getPortList()
                         << "systemLocation: '" << portInfo.systemLocation() << "'")
         portList->append(portInfo.portName());
     }
+#ifdef BERT_SIMULATOR
+    portList->append(QString(I2CSimulator::PORT_NAME));
+#endif
     return portList;
 }
 
 
 /*!
  \brief Open comms
- Creates a serial class (Serial.cpp) and calls
+ Creates a transport (see I2CTransport; Serial.cpp for the USB-ISS adaptor) and calls
  the 'open' method to open comms.
 
  Also sets up a QEventLoop to allow comms methods to wait
@@ -129,33 +133,65 @@ std::unique_ptr<QStringList> I2CComms::getPortList()
  After opening the serial port, the I2C adaptor is probed
  to make sure it is responding (see probeAdaptor).
 
- \param port  QString containing the name of the serial port to use
+ \param port           QString containing the name of the serial port to use
+ \param transportType  Type of transport used to reach the adaptor
+                       (default: I2CTransport::TRANSPORT_USB_ISS)
 
  \return globals::OK         Success. Comms open.
  \return globals::GEN_ERROR  Error. Comms not open; calls to
                              read and write will be ignored.
 */
-int I2CComms::open(const QString port)
+int I2CComms::open(const QString port, const int transportType)
 {
     DEBUG_I2C("I2CComms: OPEN")
     isOpen = false;
     commsClose();  // In case the comms were already open.
 
-    emit I2CWorkerConnect(port);
-    if (commsWorker->getLastResult() == globals::OK) emit I2CProbeAdaptor();
+    emit I2CWorkerConnect(port, transportType);
+    int result = commsWorker->getLastResult();
+    if (result == globals::OK) result = commsWorker->queueAdaptorControl(I2CCommsWorker::CONTROL_PROBE);
 
-    if (commsWorker->getLastResult() != globals::OK)
+    if (result != globals::OK)
     {
         DEBUG_I2C("Error: I2C Adaptor didn't respond!")
         commsClose();
         return globals::GEN_ERROR;
     }
-    emit I2CConfigureAdaptor();
+    commsWorker->queueAdaptorControl(I2CCommsWorker::CONTROL_CONFIGURE);
     isOpen = true;
     return globals::OK;
 }
 
 
+/*!
+ \brief Get capabilities of the transport in use (see I2CTransport)
+ Only valid after a successful call to open.
+*/
+I2CTransportCapabilities_t I2CComms::getTransportCapabilities() const
+{
+    return commsWorker->getTransportCapabilities();
+}
+
+
+/*!
+ \brief Largest data block which can be written to a device register in one op
+ Use this to size block writes (e.g. EEPROM) instead of hard-coding the adaptor limit.
+*/
+uint8_t I2CComms::getMaxWriteBlockSize() const
+{
+    return commsWorker->getTransportCapabilities().maxWriteBlockSize;
+}
+
+
+/*!
+ \brief Largest data block which can be read from a device register in one op
+*/
+uint8_t I2CComms::getMaxReadBlockSize() const
+{
+    return commsWorker->getTransportCapabilities().maxReadBlockSize;
+}
+
+
 /*!
  \brief Close comms
  This method closes the comms if open.
@@ -171,15 +207,118 @@ void I2CComms::close()
 
 /*!
  \brief Reset I2C Adaptor
- Used after error
- \return
+ Used after error. The adaptor probes are queued like any other op, so
+ they can't interrupt a transaction started by another thread.
 */
 void I2CComms::reset()
 {
     DEBUG_I2C("I2CComms: RESET")
-    emit I2CClearPort();
-    globals::sleep(600);
-    emit I2CProbeAdaptor(); // Hopefully this will clear the adaptor's serial buffer.
+    clearPort();
+    if (commsWorker->getPacingMode() == I2CCommsWorker::PACING_ADAPTIVE)
+    {
+        // Probe the adaptor at intervals until it responds, up to the
+        // same total delay used in fixed pacing mode:
+        int timeWaited = 0;
+        while (timeWaited < RESET_SLEEP_TIME)
+        {
+            globals::sleep(RESET_PROBE_INTERVAL);
+            timeWaited += RESET_PROBE_INTERVAL;
+            if (commsWorker->queueAdaptorControl(I2CCommsWorker::CONTROL_PROBE) == globals::OK) break;
+        }
+        DEBUG_I2C("I2CComms: Adaptor responded after reset; " << timeWaited << " mS")
+    }
+    else
+    {
+        globals::sleep(RESET_SLEEP_TIME);
+        commsWorker->queueAdaptorControl(I2CCommsWorker::CONTROL_PROBE); // Hopefully this will clear the adaptor's serial buffer.
+    }
+}
+
+
+/*!
+ \brief Get the I2C request priority of the calling thread
+ \return I2CComms::PRIORITY_MEASUREMENT, etc (PRIORITY_CONTROL unless set)
+*/
+int I2CComms::threadPriority()
+  {  return i2cThreadPriority;  }
+
+
+/*!
+ \brief Set the I2C request priority of the calling thread
+ Applies to all ops (blocking or async) queued by this thread from now on.
+ See also I2CPriorityScope.
+ \param priority  I2CComms::PRIORITY_MEASUREMENT, PRIORITY_CONTROL or PRIORITY_COSMETIC
+*/
+void I2CComms::setThreadPriority(const int priority)
+{
+    Q_ASSERT(priority >= 0 && priority < PRIORITY_COUNT);
+    if (priority < 0 || priority >= PRIORITY_COUNT) return;
+    i2cThreadPriority = priority;
+}
+
+
+/*!
+ \brief Set the name shown for a slave address in the bus profile report
+ \param slaveAddress  I2C slave address (7 bits)
+ \param name          Component name, e.g. "GT1724 Core 1"
+*/
+void I2CComms::setProfileSourceName(const uint8_t slaveAddress, const QString &name)
+  {  commsWorker->getProfiler().setSourceName(slaveAddress, name);  }
+
+
+/*!
+ \brief Get the bus profile report (see I2CProfiler::getReport)
+*/
+QString I2CComms::getProfileReport() const
+  {  return commsWorker->getProfiler().getReport();  }
+
+
+/*!
+ \brief Append the bus profile report to a text file
+ \return globals::OK
+ \return globals::FILE_ERROR  Couldn't write the file
+*/
+int I2CComms::writeProfileReport(const QString &fileName) const
+  {  return commsWorker->getProfiler().writeReport(fileName);  }
+
+
+/*!
+ \brief Clear the bus profile statistics
+*/
+void I2CComms::resetProfile()
+  {  commsWorker->getProfiler().reset();  }
+
+
+/*!
+ \brief Set the pacing mode used between adaptor ops
+ \param mode  I2CCommsWorker::PACING_FIXED     Fixed delays after each op and error (original behaviour)
+              I2CCommsWorker::PACING_ADAPTIVE  Post-op delay is reduced while ops succeed with a
+                                               steady turnaround, raised when the turnaround slows,
+                                               and restored (with increasing recovery delays) on errors
+*/
+void I2CComms::setPacingMode(const int mode)
+{
+    commsWorker->waitForQueue();
+    commsWorker->setPacingMode(mode);
+}
+
+
+/*!
+ \brief Get pacing statistics (op counts, errors, turnaround times, delays)
+ \return Copy of current statistics
+*/
+I2CPacingStats_t I2CComms::getPacingStats() const
+{
+    return commsWorker->getPacingStats();
+}
+
+
+/*!
+ \brief Reset pacing statistics counters
+*/
+void I2CComms::resetPacingStats()
+{
+    commsWorker->resetPacingStats();
 }
 
 
@@ -237,6 +376,101 @@ int I2CComms::pingAddress(const uint8_t slaveAddress)
 }
 
 
+/*!
+ \brief Probe a list of I2C Slave Addresses in one sweep
+        Checks for an ACK on each address, as for pingAddress, but the
+        probe commands are packed into as few adaptor frames as possible
+        (see BATCH_FRAME_WRITE_MAX) instead of one round trip per address.
+        If a packed frame fails, the port is cleared and the addresses in
+        that frame are pinged one at a time (pingAddress has its own retry
+        logic).
+ \param addresses  Addresses to probe (7 bit). Duplicates are probed once.
+ \param found      Addresses which responded are appended to this list,
+                   in the order they appear in addresses
+ \return globals::OK             Sweep completed (found may be empty)
+ \return globals::NOT_CONNECTED  Error (comms not open)
+ \return [error code]            Comms error while probing
+*/
+int I2CComms::probeAddresses(const QList<uint8_t> &addresses, QList<uint8_t> &found)
+{
+    DEBUG_I2C("I2CComms: Probe " << addresses.count() << " addresses")
+    if (!isOpen) return globals::NOT_CONNECTED;  // Comms not open!
+
+    QList<uint8_t> probeList;
+    foreach (uint8_t address, addresses)
+    {
+        if (!probeList.contains(address)) probeList.append(address);
+    }
+    const size_t frameOpsMax = qMin(BATCH_FRAME_WRITE_MAX / PROBE_COMMAND_SIZE,
+                                    BATCH_FRAME_TRANSFER_MAX / (PROBE_COMMAND_SIZE + 1));
+    int index = 0;
+    while (index < probeList.count())
+    {
+        uint8_t frame[BATCH_FRAME_WRITE_MAX];
+        uint8_t response[BATCH_FRAME_TRANSFER_MAX];
+        const int frameFirst = index;
+        size_t frameOps = 0;
+        while (index < probeList.count() && frameOps < frameOpsMax)
+        {
+            frame[frameOps * PROBE_COMMAND_SIZE]     = I2C_TST;
+            frame[frameOps * PROBE_COMMAND_SIZE + 1] = I2CWRITE(probeList.at(index));
+            frameOps++;
+            index++;
+        }
+
+        int result = i2cOp(static_cast<uint8_t>(frameOps * PROBE_COMMAND_SIZE),
+                           frame,
+                           static_cast<uint8_t>(frameOps),
+                           response);
+        if (result == globals::OK)
+        {
+            // Adaptor returns 0x00 for No ACK, or non-zero if the device responded:
+            for (size_t i = 0; i < frameOps; i++)
+            {
+                if (response[i] != 0x00) found.append(probeList.at(frameFirst + static_cast<int>(i)));
+            }
+            continue;
+        }
+
+        DEBUG_I2C("   -->Probe frame failed; Pinging addresses individually...")
+        clearPort();
+        for (int i = frameFirst; i < index; i++)
+        {
+            result = pingAddress(probeList.at(i));
+            if (result == globals::OK)                    found.append(probeList.at(i));
+            else if (result != globals::DEVICE_NOT_FOUND) return result;
+        }
+    }
+    return globals::OK;
+}
+
+
+/*!
+ \brief Read the USB-ISS Adaptor Serial Number
+        The serial number is fixed for each adaptor, so it can be used to
+        recognise an instrument which has been connected before.
+ \param serialNumber  Set to the serial number (8 ASCII digits) on success
+ \return globals::OK             Serial number read
+ \return globals::NOT_CONNECTED  Error (comms not open)
+ \return [error code]            Comms error
+*/
+int I2CComms::getAdaptorSerial(QString &serialNumber)
+{
+    DEBUG_I2C("I2CComms: Get adaptor serial number")
+    if (!isOpen) return globals::NOT_CONNECTED;  // Comms not open!
+    const uint8_t command[2] = { ISS_CMD, ISS_GET_SERIAL };
+    uint8_t response[ISS_SERIAL_SIZE];
+    int result = i2cOp(sizeof(command), command, ISS_SERIAL_SIZE, response);
+    if (result != globals::OK)
+    {
+        clearPort();
+        return result;
+    }
+    serialNumber = QString::fromLatin1(reinterpret_cast<const char *>(response), ISS_SERIAL_SIZE);
+    return globals::OK;
+}
+
+
 
 /*!
  \brief Write raw bytes out I2C device
@@ -307,8 +541,8 @@ int I2CComms::write8(const uint8_t slaveAddress,
                      const uint8_t nBytes)
 {
     DEBUG_I2C("I2CComms: WRITE (8 Bit Address)")
-    Q_ASSERT(nBytes <= 59);
-    if (nBytes > 59) return globals::OVERFLOW;       // Transmission buffer is limited to 59 bytes.
+    Q_ASSERT(nBytes <= I2CBatch::WRITE_BYTES_MAX);
+    if (nBytes > I2CBatch::WRITE_BYTES_MAX) return globals::OVERFLOW;   // Transmission buffer is limited to 59 bytes.
     // PROFILING: runTime.start();
     int errorCounter = 0;
     uint8_t i2cData[nBytes+4];  // Buffer for data to be sent, plus header
@@ -370,8 +604,8 @@ int I2CComms::write(const uint8_t slaveAddress,
                     const uint8_t nBytes)
 {
     DEBUG_I2C("I2CComms: WRITE (16 Bit Address)")
-    Q_ASSERT(nBytes <= 59);
-    if (nBytes > 59) return globals::OVERFLOW;       // Transmission buffer is limited to 59 bytes.
+    Q_ASSERT(nBytes <= I2CBatch::WRITE_BYTES_MAX);
+    if (nBytes > I2CBatch::WRITE_BYTES_MAX) return globals::OVERFLOW;   // Transmission buffer is limited to 59 bytes.
     // PROFILING: runTime.start();
     int errorCounter = 0;
     uint8_t i2cData[nBytes+5];  // Buffer for data to be sent, plus header
@@ -450,7 +684,9 @@ int I2CComms::write24(const uint8_t  slaveAddress,
     // we are writing to each time.
     uint8_t  i2cFrame[60];   // Maximum data size the adaptor can handle
     uint32_t writeAddress = regAddress;
+    const uint8_t *writeData = data;
     size_t bytesRemaining = nBytes;
+    size_t bytesThisFrame;
     size_t thisFrameSize;
     size_t bytesThisSubFrame;
     size_t frameBytesRemaining;
@@ -466,6 +702,7 @@ int I2CComms::write24(const uint8_t  slaveAddress,
         i2cFrame[6] = writeAddress;         //
         frameBytesRemaining = (60 - 7);     // Already used 7 bytes above.
         frameWritePtr = 7;                  // Loop below starts adding more sub-commands and data here.
+        bytesThisFrame = 0;
         // 18 bytes is room for one more 'write' sub-command, plus the
         // 'stop bit' command. If there's fewer than 18 bytes left in the
         // buffer, finish the frame and sent it; Otherwise, add another
@@ -477,7 +714,8 @@ int I2CComms::write24(const uint8_t  slaveAddress,
             if (bytesThisSubFrame > 16) bytesThisSubFrame = 16;
             i2cFrame[frameWritePtr] = (0x30 + bytesThisSubFrame) - 1; //   SUB COMMAND: Write next n bytes
             frameWritePtr++;
-            memcpy(i2cFrame + frameWritePtr, data, bytesThisSubFrame);
+            memcpy(i2cFrame + frameWritePtr, writeData + bytesThisFrame, bytesThisSubFrame);
+            bytesThisFrame += bytesThisSubFrame;
             bytesRemaining -= bytesThisSubFrame;
             frameBytesRemaining -= (bytesThisSubFrame + 1);
             frameWritePtr += bytesThisSubFrame;
@@ -496,10 +734,11 @@ int I2CComms::write24(const uint8_t  slaveAddress,
         {
             DEBUG_I2C("   -->NACK (0x00): I2C adaptor reports error!")
             DEBUG_I2C("   -->Error Code: " << adaptorResponse[1])
-            emit I2CClearPort();
+            clearPort();
             return globals::ADAPTOR_WRITE_ERROR;
         }
-        writeAddress += (nBytes - bytesRemaining);  // Advance the write-to address by the number of bytes we just sent.
+        writeAddress += bytesThisFrame;  // Advance the write-to address and data by the number of bytes we just sent.
+        writeData    += bytesThisFrame;
     }
     globals::sleep(5);
     return globals::OK;
@@ -576,8 +815,8 @@ int I2CComms::read8(const uint8_t slaveAddress,
                     const uint8_t nBytes)
 {
     DEBUG_I2C("I2CComms: READ")
-    Q_ASSERT(nBytes <= 64);
-    if (nBytes > 64) return globals::OVERFLOW; // Transmission buffer is limited to 64 bytes.
+    Q_ASSERT(nBytes <= I2CBatch::READ_BYTES_MAX);
+    if (nBytes > I2CBatch::READ_BYTES_MAX) return globals::OVERFLOW;   // Transmission buffer is limited to 64 bytes.
     int errorCounter = 0;
     while (true)
     {
@@ -633,8 +872,8 @@ int I2CComms::read(const uint8_t  slaveAddress,
                    const uint8_t  nBytes)
 {
     DEBUG_I2C("I2CComms: READ")
-    Q_ASSERT(nBytes <= 64);
-    if (nBytes > 64) return globals::OVERFLOW; // Transmission buffer is limited to 64 bytes.
+    Q_ASSERT(nBytes <= I2CBatch::READ_BYTES_MAX);
+    if (nBytes > I2CBatch::READ_BYTES_MAX) return globals::OVERFLOW;   // Transmission buffer is limited to 64 bytes.
     int errorCounter = 0;
     while (true)
     {
@@ -704,8 +943,10 @@ int I2CComms::read24(const uint8_t  slaveAddress,
     size_t bytesRequestedThisRead;
 
     int errorCounter = 0;
-    uint8_t adaptorResponse[18] = { 0 };
-    // Nb: Max data per read is 16 bytes, plus 2 byte header from adaptor
+    uint8_t adaptorHeader[2] = { 0 };
+    // Nb: Max data per read is 16 bytes, plus 2 byte header from adaptor.
+    // The header is received into adaptorHeader and the data goes straight
+    // into the caller's buffer.
     while (bytesTotalRead < nBytes)
     {
         bytesRemaining = nBytes - bytesTotalRead;
@@ -748,18 +989,19 @@ int I2CComms::read24(const uint8_t  slaveAddress,
         int result = i2cOp(thisFrameSize,
                            i2cFrame,
                            bytesRequestedThisRead + 2,
-                           adaptorResponse);
+                           data + bytesTotalRead,
+                           sizeof(adaptorHeader),
+                           adaptorHeader);
         if (result != globals::OK)
         {
             COMMSERROR_RETRY(result)
         }
-        if (adaptorResponse[0] == 0x00)
+        if (adaptorHeader[0] == 0x00)
         {
             DEBUG_I2C("   -->NACK (0x00): I2C adaptor reports error!")
-            DEBUG_I2C("   -->Error Code: " << adaptorResponse[1])
+            DEBUG_I2C("   -->Error Code: " << adaptorHeader[1])
             COMMSERROR_RETRY(globals::ADAPTOR_WRITE_ERROR)
         }
-        memcpy(data + bytesTotalRead, adaptorResponse + 2, bytesRequestedThisRead);
         bytesTotalRead += bytesRequestedThisRead;
         errorCounter = 0;
     }
@@ -768,6 +1010,327 @@ int I2CComms::read24(const uint8_t  slaveAddress,
 
 
 
+/*!
+ \brief Run a batch of I2C operations
+ Ops from the batch are packed into as few adaptor frames as possible
+ (see BATCH_FRAME_WRITE_MAX and BATCH_FRAME_TRANSFER_MAX); each frame
+ is sent with a single serial write and the responses for all ops in
+ the frame are read back together.
+
+ If a packed frame fails (comms error, or the adaptor reports a failed
+ write for any op in the frame), the port is cleared and the ops in that
+ frame are re-sent one at a time using the normal methods (writeRaw,
+ write8, read8, etc) which have their own retry logic.
+
+ Ops are always run in the order they were added to the batch.
+ Processing stops at the first op which fails after retries.
+
+ \param batch  Batch of ops to run. On return, the result of each op
+               can be checked with batch.getResult(index). Ops which
+               were not run (because an earlier op failed) are left
+               with result globals::NOT_INITIALISED.
+
+ \return globals::OK             All ops completed successfully
+ \return globals::NOT_CONNECTED  Error (comms not open)
+ \return [error code]            Result of the first op which failed
+*/
+int I2CComms::runBatch(I2CBatch &batch)
+{
+    DEBUG_I2C("I2CComms: RUN BATCH (" << batch.count() << " ops)")
+    if (!isOpen) return globals::NOT_CONNECTED;  // Comms not open!
+
+    const int opCount = batch.ops.count();
+    int opIndex = 0;
+    while (opIndex < opCount)
+    {
+        uint8_t frame[BATCH_FRAME_WRITE_MAX];
+        uint8_t response[BATCH_FRAME_TRANSFER_MAX];
+        size_t  frameSize = 0;
+        size_t  responseSize = 0;
+        const int frameFirstOp = opIndex;
+
+        // Pack as many ops as will fit into the next frame:
+        while (opIndex < opCount)
+        {
+            uint8_t command[BATCH_COMMAND_MAX];
+            size_t  commandResponseSize = 0;
+            size_t  commandSize = batchOpCommand(batch.ops[opIndex], command, &commandResponseSize);
+            if ( (frameSize + commandSize > BATCH_FRAME_WRITE_MAX)
+              || (frameSize + commandSize + responseSize + commandResponseSize > BATCH_FRAME_TRANSFER_MAX) )
+            {
+                if (opIndex == frameFirstOp) opIndex++;  // Op is too big to pack: It will be run on its own (below).
+                break;
+            }
+            memcpy(frame + frameSize, command, commandSize);
+            frameSize    += commandSize;
+            responseSize += commandResponseSize;
+            opIndex++;
+        }
+
+        bool frameOK = false;
+        if (opIndex - frameFirstOp > 1)
+        {
+            DEBUG_I2C_EXTRA("   Batch frame: " << (opIndex - frameFirstOp) << " ops; "
+                            << frameSize << " bytes out; " << responseSize << " bytes back")
+            int result = i2cOp(static_cast<uint8_t>(frameSize),
+                               frame,
+                               static_cast<uint8_t>(responseSize),
+                               response);
+            if (result == globals::OK)
+            {
+                // Unpack responses: Each write op returns one status byte
+                // (0x00 = failed); Read ops return the data read.
+                frameOK = true;
+                size_t responsePtr = 0;
+                for (int i = frameFirstOp; i < opIndex; i++)
+                {
+                    I2CBatch::I2CBatchOp_t &op = batch.ops[i];
+                    switch (op.type)
+                    {
+                    case I2CBatch::OP_READ_RAW:
+                    case I2CBatch::OP_READ8:
+                    case I2CBatch::OP_READ16:
+                        memcpy(op.dataRead, response + responsePtr, op.nBytes);
+                        responsePtr += op.nBytes;
+                        op.result = globals::OK;
+                        break;
+                    default:
+                        if (response[responsePtr] == 0x00) frameOK = false;
+                        else                               op.result = globals::OK;
+                        responsePtr++;
+                    }
+                }
+            }
+            if (!frameOK)
+            {
+                DEBUG_I2C("   -->Batch frame failed; Re-sending ops individually...")
+                clearPort();
+            }
+        }
+
+        if (!frameOK)
+        {
+            // Single op in this frame, or packed frame failed: Run each op on its own:
+            for (int i = frameFirstOp; i < opIndex; i++)
+            {
+                int result = batchOpSingle(batch.ops[i]);
+                if (result != globals::OK) return result;
+            }
+        }
+    }
+    return globals::OK;
+}
+
+
+
+
+/*!
+ \brief Write data to I2C Device (16 bit address) - Asynchronous
+ The op is queued and this method returns immediately. When the op
+ has been carried out, I2COpFinished is emitted with the op ID and
+ the result (data is empty for write ops).
+ Nb: Async ops are not retried on error.
+ \param slaveAddress  I2C Slave address of the device (7 bits)
+ \param regAddress    16 bit address of register or memory to write to
+ \param data          Pointer to data to write (copied; need not remain valid)
+ \param nBytes        Number of bytes to write (<= 59)
+ \return [op ID]                 Op ID (> 0): Op queued
+ \return globals::NOT_CONNECTED  Error (comms not open)
+ \return globals::OVERFLOW       Data too big (nBytes > 59)
+*/
+int I2CComms::writeAsync(const uint8_t slaveAddress, const uint16_t regAddress, const uint8_t *data, const uint8_t nBytes)
+{
+    I2CBatch op;
+    int result = op.addWrite(slaveAddress, regAddress, data, nBytes);
+    if (result != globals::OK) return result;
+    return batchOpAsync(op);
+}
+
+
+/*!
+ \brief Write data to I2C Device (8 bit address) - Asynchronous
+ See writeAsync.
+ \return [op ID]                 Op ID (> 0): Op queued
+ \return globals::NOT_CONNECTED  Error (comms not open)
+ \return globals::OVERFLOW       Data too big (nBytes > 59)
+*/
+int I2CComms::write8Async(const uint8_t slaveAddress, const uint8_t regAddress, const uint8_t *data, const uint8_t nBytes)
+{
+    I2CBatch op;
+    int result = op.addWrite8(slaveAddress, regAddress, data, nBytes);
+    if (result != globals::OK) return result;
+    return batchOpAsync(op);
+}
+
+
+/*!
+ \brief Read data from I2C Device (16 bit address) - Asynchronous
+ The op is queued and this method returns immediately. When the op
+ has been carried out, I2COpFinished is emitted with the op ID, the
+ result, and the data read from the device.
+ Nb: Async ops are not retried on error.
+ \param slaveAddress  I2C Slave address of the device (7 bits)
+ \param regAddress    16 bit address of register or memory to read from
+ \param nBytes        Number of bytes to read (<= 64)
+ \return [op ID]                 Op ID (> 0): Op queued
+ \return globals::NOT_CONNECTED  Error (comms not open)
+ \return globals::OVERFLOW       Data too big (nBytes > 64)
+*/
+int I2CComms::readAsync(const uint8_t slaveAddress, const uint16_t regAddress, const uint8_t nBytes)
+{
+    I2CBatch op;
+    int result = op.addRead(slaveAddress, regAddress, nullptr, nBytes);
+    if (result != globals::OK) return result;
+    return batchOpAsync(op);
+}
+
+
+/*!
+ \brief Read data from I2C Device (8 bit address) - Asynchronous
+ See readAsync.
+ \return [op ID]                 Op ID (> 0): Op queued
+ \return globals::NOT_CONNECTED  Error (comms not open)
+ \return globals::OVERFLOW       Data too big (nBytes > 64)
+*/
+int I2CComms::read8Async(const uint8_t slaveAddress, const uint8_t regAddress, const uint8_t nBytes)
+{
+    I2CBatch op;
+    int result = op.addRead8(slaveAddress, regAddress, nullptr, nBytes);
+    if (result != globals::OK) return result;
+    return batchOpAsync(op);
+}
+
+
+
+
+// ////////////////////////////////////////////////////////////////////////
+//   I2C Batch
+// ////////////////////////////////////////////////////////////////////////
+
+/*!
+ \brief Add a raw write op (device without internal address) to the batch
+ \param slaveAddress  I2C Slave address of the device (7 bits)
+ \param data          Data to write (copied into the batch)
+ \param nBytes        Number of bytes to write (<= 59)
+ \return globals::OK        Op added
+ \return globals::OVERFLOW  Data too big (nBytes > 59)
+*/
+int I2CBatch::addWriteRaw(const uint8_t slaveAddress, const uint8_t *data, const uint8_t nBytes)
+{
+    return addOp(OP_WRITE_RAW, slaveAddress, 0, data, nullptr, nBytes);
+}
+
+/*!
+ \brief Add a write op (8 bit register address) to the batch
+ \param slaveAddress  I2C Slave address of the device (7 bits)
+ \param regAddress    8 bit address of register or memory to write to
+ \param data          Data to write (copied into the batch)
+ \param nBytes        Number of bytes to write (<= 59)
+ \return globals::OK        Op added
+ \return globals::OVERFLOW  Data too big (nBytes > 59)
+*/
+int I2CBatch::addWrite8(const uint8_t slaveAddress, const uint8_t regAddress, const uint8_t *data, const uint8_t nBytes)
+{
+    return addOp(OP_WRITE8, slaveAddress, regAddress, data, nullptr, nBytes);
+}
+
+/*!
+ \brief Add a write op (16 bit register address) to the batch
+ \param slaveAddress  I2C Slave address of the device (7 bits)
+ \param regAddress    16 bit address of register or memory to write to
+ \param data          Data to write (copied into the batch)
+ \param nBytes        Number of bytes to write (<= 59)
+ \return globals::OK        Op added
+ \return globals::OVERFLOW  Data too big (nBytes > 59)
+*/
+int I2CBatch::addWrite(const uint8_t slaveAddress, const uint16_t regAddress, const uint8_t *data, const uint8_t nBytes)
+{
+    return addOp(OP_WRITE16, slaveAddress, regAddress, data, nullptr, nBytes);
+}
+
+/*!
+ \brief Add a raw read op (device without internal address) to the batch
+ \param slaveAddress  I2C Slave address of the device (7 bits)
+ \param data          Destination for data; Must remain valid until runBatch returns
+ \param nBytes        Number of bytes to read (<= 64)
+ \return globals::OK        Op added
+ \return globals::OVERFLOW  Data too big (nBytes > 64)
+*/
+int I2CBatch::addReadRaw(const uint8_t slaveAddress, uint8_t *data, const uint8_t nBytes)
+{
+    return addOp(OP_READ_RAW, slaveAddress, 0, nullptr, data, nBytes);
+}
+
+/*!
+ \brief Add a read op (8 bit register address) to the batch
+ \param slaveAddress  I2C Slave address of the device (7 bits)
+ \param regAddress    8 bit address of register or memory to read from
+ \param data          Destination for data; Must remain valid until runBatch returns
+ \param nBytes        Number of bytes to read (<= 64)
+ \return globals::OK        Op added
+ \return globals::OVERFLOW  Data too big (nBytes > 64)
+*/
+int I2CBatch::addRead8(const uint8_t slaveAddress, const uint8_t regAddress, uint8_t *data, const uint8_t nBytes)
+{
+    return addOp(OP_READ8, slaveAddress, regAddress, nullptr, data, nBytes);
+}
+
+/*!
+ \brief Add a read op (16 bit register address) to the batch
+ \param slaveAddress  I2C Slave address of the device (7 bits)
+ \param regAddress    16 bit address of register or memory to read from
+ \param data          Destination for data; Must remain valid until runBatch returns
+ \param nBytes        Number of bytes to read (<= 64)
+ \return globals::OK        Op added
+ \return globals::OVERFLOW  Data too big (nBytes > 64)
+*/
+int I2CBatch::addRead(const uint8_t slaveAddress, const uint16_t regAddress, uint8_t *data, const uint8_t nBytes)
+{
+    return addOp(OP_READ16, slaveAddress, regAddress, nullptr, data, nBytes);
+}
+
+/*!
+ \brief Get the result of an op in the batch (after I2CComms::runBatch)
+ \param index  Index of op (in the order added; 0 is first)
+ \return globals::OK               Op completed successfully
+ \return globals::NOT_INITIALISED  Op hasn't been run (or batch not submitted yet)
+ \return globals::OVERFLOW         Invalid index
+ \return [error code]              Error from I2C op
+*/
+int I2CBatch::getResult(const int index) const
+{
+    if (index < 0 || index >= ops.count()) return globals::OVERFLOW;
+    return ops.at(index).result;
+}
+
+/*!
+ \brief Add an op to the batch (see addWrite8, addRead8, etc)
+*/
+int I2CBatch::addOp(const I2CBatchOpType_t type,
+                    const uint8_t  slaveAddress,
+                    const uint16_t regAddress,
+                    const uint8_t *dataWrite,
+                    uint8_t       *dataRead,
+                    const uint8_t  nBytes)
+{
+    const bool isRead = (type == OP_READ_RAW || type == OP_READ8 || type == OP_READ16);
+    const uint8_t nBytesMax = isRead ? READ_BYTES_MAX : WRITE_BYTES_MAX;
+    Q_ASSERT(nBytes <= nBytesMax);
+    if (nBytes > nBytesMax) return globals::OVERFLOW;
+    I2CBatchOp_t op;
+    op.type = type;
+    op.slaveAddress = slaveAddress;
+    op.regAddress = regAddress;
+    op.nBytes = nBytes;
+    if (dataWrite && nBytes > 0) memcpy(op.dataWrite, dataWrite, nBytes);
+    op.dataRead = dataRead;
+    op.result = globals::NOT_INITIALISED;
+    ops.append(op);
+    return globals::OK;
+}
+
+
+
 ////////////////////////////////////////////////////////////////////////////
 //// PRIVATE Methods ///////////////////////////////////////////////////////
 ////////////////////////////////////////////////////////////////////////////
@@ -779,12 +1342,26 @@ int I2CComms::read24(const uint8_t  slaveAddress,
 */
 void I2CComms::commsClose()
 {
+    commsWorker->waitForQueue();  // Let any outstanding async ops finish first
     emit I2CWorkerDisconnect();
     isOpen = false;
 }
 
 
 
+/*!
+ \brief Clear the comms port (after error)
+ Waits for any outstanding async ops to finish, so the
+ port isn't cleared in the middle of another transaction.
+*/
+void I2CComms::clearPort()
+{
+    commsWorker->waitForQueue();
+    emit I2CClearPort();
+}
+
+
+
 /*!
  \brief Carry out I2C operation with USB-ISS Module
 
@@ -792,17 +1369,14 @@ void I2CComms::commsClose()
  and data to send - see:
   http://www.robot-electronics.co.uk/htm/usb_iss_tech.htm
 
- This method writes the output data to the module via the serial
- class.
-
- It then waits for the "transactionFinished" signal from the
- serial class, which indicates that the expected response data
- has been received. The wait operation is also broken by
- the "commsTimeout" signal. The commsStatus flag is checked
- to see which of these conditions occurred.
+ The operation is added to the comms worker's op queue, and this
+ method blocks until the worker has carried it out (see
+ I2CCommsWorker::queueOp). Ops are carried out in the order they
+ are queued within each priority class (see I2CComms::setThreadPriority),
+ so blocking and async ops may be mixed.
 
- If the comms were successful, the method makes a copy of the
- recieved data and stores it to the buffer supplied by dataRead.
+ If the comms were successful, the recieved data is stored to the
+ buffer supplied by dataRead.
 
  \param nBytesToWrite  Number of bytes to write from dataWrite
  \param dataWrite      Pointer to output data
@@ -812,8 +1386,14 @@ void I2CComms::commsClose()
                       least one response byte.
 
  \param dataRead      Pointer to input data buffer. Must be at least
-                      nBytesToRead bytes in size. Should be NULL if
-                      nBytesToRead is 0.
+                      nBytesToRead bytes in size (less nBytesHeader).
+                      Should be NULL if nBytesToRead is 0. Response
+                      data is received straight into this buffer.
+
+ \param nBytesHeader  Optional: Number of response bytes to store in
+                      dataHeader instead of dataRead (e.g. adaptor
+                      status bytes which precede the read data)
+ \param dataHeader    Optional: Buffer for response header
 
  \return globals::OK               Operation completed successfully.
                                    Nb: This means the data was written out to
@@ -828,22 +1408,167 @@ void I2CComms::commsClose()
 int I2CComms::i2cOp(const uint8_t  nBytesToWrite,
                     const uint8_t *dataWrite,
                     const uint8_t  nBytesToRead,
-                    uint8_t *dataRead)
+                    uint8_t *dataRead,
+                    const uint8_t  nBytesHeader,
+                    uint8_t *dataHeader)
 {
     if (!isOpen) return globals::NOT_CONNECTED;  // Comms not open!
 
-    DEBUG_I2C("I2CComms: Emitting I2CWorkerOp signal")
+    DEBUG_I2C("I2CComms: Queueing I2C op")
     DEBUG_I2C("vvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvvv")
 
-    emit I2CWorkerOp((int)nBytesToWrite,
-                     (const char *)dataWrite,
-                     (int)nBytesToRead,
-                     (char *)dataRead);
+    int result = commsWorker->queueOp(dataWrite,
+                                      (int)nBytesToWrite,
+                                      (int)nBytesToRead,
+                                      dataRead,
+                                      (int)nBytesHeader,
+                                      dataHeader,
+                                      commandSource(dataWrite, nBytesToWrite));
 
     DEBUG_I2C("^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^^")
-    DEBUG_I2C("I2CComms: I2CWorkerOp signal returned.")
+    DEBUG_I2C("I2CComms: I2C op finished.")
+
+    return result;
+}
+
 
-    return commsWorker->getLastResult();
+
+/*!
+ \brief Build the adaptor command for one batch op
+ The command bytes are the same as those used by the matching single op
+ method (writeRaw, write8, write, readRaw, read8, read).
+ \param op            Batch op
+ \param command       Buffer for command; must be at least BATCH_COMMAND_MAX bytes
+ \param responseSize  Set to the number of response bytes the adaptor will return
+ \return Size of command (bytes)
+*/
+size_t I2CComms::batchOpCommand(const I2CBatch::I2CBatchOp_t &op, uint8_t *command, size_t *responseSize)
+{
+    size_t headerSize = 0;
+    switch (op.type)
+    {
+    case I2CBatch::OP_WRITE_RAW:
+        command[0] = I2C_AD0;
+        command[1] = I2CWRITE(op.slaveAddress);
+        command[2] = op.nBytes;
+        headerSize = 3;
+        break;
+    case I2CBatch::OP_WRITE8:
+        command[0] = I2C_AD1;
+        command[1] = I2CWRITE(op.slaveAddress);
+        command[2] = static_cast<uint8_t>(op.regAddress);
+        command[3] = op.nBytes;
+        headerSize = 4;
+        break;
+    case I2CBatch::OP_WRITE16:
+        command[0] = I2C_AD2;
+        command[1] = I2CWRITE(op.slaveAddress);
+        command[2] = static_cast<uint8_t>(op.regAddress >> 8);
+        command[3] = static_cast<uint8_t>(op.regAddress);
+        command[4] = op.nBytes;
+        headerSize = 5;
+        break;
+    case I2CBatch::OP_READ_RAW:
+        command[0] = I2C_AD0;
+        command[1] = I2CREAD(op.slaveAddress);
+        command[2] = op.nBytes;
+        *responseSize = op.nBytes;
+        return 3;
+    case I2CBatch::OP_READ8:
+        command[0] = I2C_AD1;
+        command[1] = I2CREAD(op.slaveAddress);
+        command[2] = static_cast<uint8_t>(op.regAddress);
+        command[3] = op.nBytes;
+        *responseSize = op.nBytes;
+        return 4;
+    case I2CBatch::OP_READ16:
+        command[0] = I2C_AD2;
+        command[1] = I2CREAD(op.slaveAddress);
+        command[2] = static_cast<uint8_t>(op.regAddress >> 8);
+        command[3] = static_cast<uint8_t>(op.regAddress);
+        command[4] = op.nBytes;
+        *responseSize = op.nBytes;
+        return 5;
+    }
+    // Write ops: Header followed by data; Adaptor returns one status byte:
+    memcpy(command + headerSize, op.dataWrite, op.nBytes);
+    *responseSize = 1;
+    return headerSize + op.nBytes;
+}
+
+
+
+/*!
+ \brief Queue the first op from a batch as an async op
+ \param batch  Batch containing the op (see writeAsync, readAsync, etc)
+ \return [op ID]                 Op ID (> 0): Op queued
+ \return globals::NOT_CONNECTED  Error (comms not open)
+*/
+int I2CComms::batchOpAsync(const I2CBatch &batch)
+{
+    if (!isOpen) return globals::NOT_CONNECTED;  // Comms not open!
+    Q_ASSERT(batch.ops.count() == 1);
+    const I2CBatch::I2CBatchOp_t &op = batch.ops.first();
+    uint8_t command[BATCH_COMMAND_MAX];
+    size_t  responseSize = 0;
+    size_t  commandSize = batchOpCommand(op, command, &responseSize);
+    bool isWriteOp = (op.type == I2CBatch::OP_WRITE_RAW
+                   || op.type == I2CBatch::OP_WRITE8
+                   || op.type == I2CBatch::OP_WRITE16);
+    return commsWorker->queueOpAsync(command,
+                                     static_cast<int>(commandSize),
+                                     static_cast<int>(responseSize),
+                                     isWriteOp,
+                                     op.slaveAddress);
+}
+
+
+/*!
+ \brief Find the slave address an adaptor command is sent to (for the profiler)
+ For packed frames (see runBatch, probeAddresses), the address of the first op is used.
+ \param command  Adaptor command
+ \param nBytes   Size of command
+ \return [address]                    7 bit slave address
+ \return I2CProfiler::SOURCE_ADAPTOR  Adaptor command, or no address found
+*/
+int I2CComms::commandSource(const uint8_t *command, const size_t nBytes)
+{
+    if (!command || nBytes < 2) return I2CProfiler::SOURCE_ADAPTOR;
+    switch (command[0])
+    {
+    case I2C_SGL:
+    case I2C_AD0:
+    case I2C_AD1:
+    case I2C_AD2:
+    case I2C_TST:
+        return command[1] >> 1;
+    case I2C_DIR:
+        // I2C Start, Write n bytes, then the address byte (see write24, read24):
+        if (nBytes >= 4) return command[3] >> 1;
+        break;
+    }
+    return I2CProfiler::SOURCE_ADAPTOR;
+}
+
+
+
+/*!
+ \brief Run one batch op on its own, using the normal single op method
+ \param op  Batch op; op.result is updated.
+ \return [result]  Result from writeRaw, write8, read8, etc.
+*/
+int I2CComms::batchOpSingle(I2CBatch::I2CBatchOp_t &op)
+{
+    switch (op.type)
+    {
+    case I2CBatch::OP_WRITE_RAW: op.result = writeRaw(op.slaveAddress, op.dataWrite, op.nBytes);                                         break;
+    case I2CBatch::OP_WRITE8:    op.result = write8(op.slaveAddress, static_cast<uint8_t>(op.regAddress), op.dataWrite, op.nBytes);      break;
+    case I2CBatch::OP_WRITE16:   op.result = write(op.slaveAddress, op.regAddress, op.dataWrite, op.nBytes);                             break;
+    case I2CBatch::OP_READ_RAW:  op.result = readRaw(op.slaveAddress, op.dataRead, op.nBytes);                                           break;
+    case I2CBatch::OP_READ8:     op.result = read8(op.slaveAddress, static_cast<uint8_t>(op.regAddress), op.dataRead, op.nBytes);        break;
+    case I2CBatch::OP_READ16:    op.result = read(op.slaveAddress, op.regAddress, op.dataRead, op.nBytes);                               break;
+    }
+    return op.result;
 }
 
 
@@ -891,12 +1616,205 @@ const uint8_t I2CCommsWorker::I2C_OP_SET_MODE_SIZE = sizeof(I2C_OP_SET_MODE);
 
 
 I2CCommsWorker::I2CCommsWorker()
-{}
+{
+    pacingStats.pacingMode = pacingMode;
+    pacingStats.opSleepTimeMs = pacingOpSleepTime;
+    queueClock.start();
+}
 
 I2CCommsWorker::~I2CCommsWorker()
 {}
 
 
+
+/*!
+ \brief Queue an I2C op and wait for it to finish (blocking)
+ Called from the I2CComms thread (NOT the worker thread). The op is
+ added to the op queue, and the calling thread waits until the worker
+ has carried it out.
+ \param dataWrite      Pointer to output data (must remain valid until op finishes)
+ \param nBytesToWrite  Number of bytes to write from dataWrite
+ \param nBytesToRead   Number of bytes expected in the response
+ \param dataRead       Buffer for the response (at least nBytesToRead - nBytesHeader)
+ \param nBytesHeader   Number of response bytes to store in dataHeader
+ \param dataHeader     Buffer for response header (may be null if nBytesHeader is 0)
+ \param source         Slave address, for the profiler
+ \return globals::OK          Op completed
+ \return globals::READ_ERROR  Timeout or comms error (see I2CWorkerOp)
+*/
+int I2CCommsWorker::queueOp(const uint8_t *dataWrite, const int nBytesToWrite, const int nBytesToRead, uint8_t *dataRead,
+                            const int nBytesHeader, uint8_t *dataHeader, const int source)
+{
+    Q_ASSERT(QThread::currentThread() != this);
+    int result = globals::OK;
+    QSemaphore finished;
+    I2CQueuedOp_t op;
+    op.opID = 0;
+    op.dataWrite = dataWrite;
+    op.nBytesToWrite = nBytesToWrite;
+    op.nBytesToRead = nBytesToRead;
+    op.checkWriteAck = false;
+    op.dataRead = dataRead;
+    op.nBytesHeader = nBytesHeader;
+    op.dataHeader = dataHeader;
+    op.result = &result;
+    op.finished = &finished;
+    op.source = source;
+    op.control = CONTROL_NONE;
+    op.priority = I2CComms::threadPriority();
+    // waitForQueue marker: Lowest class, so that it follows all ops queued so far:
+    if (!dataWrite) op.priority = I2CComms::PRIORITY_COUNT - 1;
+    enqueueOp(op);
+    QMetaObject::invokeMethod(this, "I2CWorkerProcessQueue", Qt::QueuedConnection);
+    finished.acquire();
+    return result;
+}
+
+
+/*!
+ \brief Queue an I2C op without waiting (async)
+ Called from the I2CComms thread. The command is copied, so the caller's
+ buffer need not remain valid. When the op has been carried out,
+ I2COpFinished is emitted with the op ID, result and response data.
+ \param dataWrite      Pointer to output data (max 64 bytes)
+ \param nBytesToWrite  Number of bytes to write from dataWrite
+ \param nBytesToRead   Number of bytes expected in the response
+ \param checkWriteAck  If true, the response is a write status byte: The
+                       result is set to globals::ADAPTOR_WRITE_ERROR if the
+                       adaptor reports a failed write, and no data is returned.
+ \param source         Slave address, for the profiler
+ \return [op ID]            Op ID (> 0): Op queued
+ \return globals::OVERFLOW  Command too big
+*/
+int I2CCommsWorker::queueOpAsync(const uint8_t *dataWrite, const int nBytesToWrite, const int nBytesToRead, const bool checkWriteAck,
+                                 const int source)
+{
+    I2CQueuedOp_t op;
+    Q_ASSERT(nBytesToWrite > 0 && static_cast<size_t>(nBytesToWrite) <= sizeof(op.asyncCommand));
+    if (nBytesToWrite <= 0 || static_cast<size_t>(nBytesToWrite) > sizeof(op.asyncCommand)) return globals::OVERFLOW;
+    memcpy(op.asyncCommand, dataWrite, static_cast<size_t>(nBytesToWrite));
+    op.dataWrite = nullptr;
+    op.nBytesToWrite = nBytesToWrite;
+    op.nBytesToRead = nBytesToRead;
+    op.checkWriteAck = checkWriteAck;
+    op.dataRead = nullptr;
+    op.nBytesHeader = 0;
+    op.dataHeader = nullptr;
+    op.result = nullptr;
+    op.finished = nullptr;
+    op.source = source;
+    op.control = CONTROL_NONE;
+    op.priority = I2CComms::threadPriority();
+    int opID;
+    {
+        QMutexLocker locker(&opQueueMutex);
+        opID = nextOpID;
+        nextOpID = (nextOpID >= 0x7FFFFFFF) ? 1 : nextOpID + 1;
+    }
+    op.opID = opID;
+    enqueueOp(op);
+    QMetaObject::invokeMethod(this, "I2CWorkerProcessQueue", Qt::QueuedConnection);
+    return opID;
+}
+
+
+/*!
+ \brief Wait until all ops which are already queued have finished
+ Called from the I2CComms thread before adaptor control operations
+ (clear port, disconnect) so that they don't interrupt a transaction.
+*/
+void I2CCommsWorker::waitForQueue()
+{
+    queueOp(nullptr, 0, 0, nullptr);
+}
+
+
+/*!
+ \brief Queue an adaptor control op and wait for it to finish (blocking)
+ Called from the I2CComms thread. Probing or configuring the adaptor is
+ an adaptor transaction like any other, so it goes through the op queue
+ (at the calling thread's priority) rather than being run directly on the
+ worker, where it could interrupt an op in progress.
+ \param control  CONTROL_PROBE or CONTROL_CONFIGURE
+ \return globals::OK             Adaptor responded as expected
+ \return globals::NOT_CONNECTED  Port not open
+ \return [other]                 Error from the adaptor op (see I2CProbeAdaptor)
+*/
+int I2CCommsWorker::queueAdaptorControl(const int control)
+{
+    Q_ASSERT(QThread::currentThread() != this);
+    Q_ASSERT(control == CONTROL_PROBE || control == CONTROL_CONFIGURE);
+    int result = globals::OK;
+    QSemaphore finished;
+    I2CQueuedOp_t op;
+    op.opID = 0;
+    op.dataWrite = nullptr;
+    op.nBytesToWrite = 0;
+    op.nBytesToRead = 0;
+    op.checkWriteAck = false;
+    op.dataRead = nullptr;
+    op.nBytesHeader = 0;
+    op.dataHeader = nullptr;
+    op.result = &result;
+    op.finished = &finished;
+    op.source = I2CProfiler::SOURCE_ADAPTOR;
+    op.control = control;
+    op.priority = I2CComms::threadPriority();
+    enqueueOp(op);
+    QMetaObject::invokeMethod(this, "I2CWorkerProcessQueue", Qt::QueuedConnection);
+    finished.acquire();
+    return result;
+}
+
+
+/*!
+ \brief Add an op to the queue for its priority class
+ Thread-safe. op.priority must be set; the queue time is set here.
+*/
+void I2CCommsWorker::enqueueOp(I2CQueuedOp_t &op)
+{
+    Q_ASSERT(op.priority >= 0 && op.priority < I2CComms::PRIORITY_COUNT);
+    if (op.priority < 0 || op.priority >= I2CComms::PRIORITY_COUNT) op.priority = I2CComms::PRIORITY_CONTROL;
+    QMutexLocker locker(&opQueueMutex);
+    op.queuedUs = queueClock.nsecsElapsed() / 1000;
+    opQueues[op.priority].enqueue(op);
+}
+
+
+/*!
+ \brief Take the next op to carry out from the queues
+ Ops are served highest class first, in order of arrival within a class.
+ Starvation protection: If any op has waited QUEUE_STARVATION_MS or more,
+ the oldest such op is served next regardless of class. A measurement op
+ is therefore never held up by more than the op in progress plus any
+ starved ops (one each), however busy the lower classes are.
+ Nb: Caller must hold opQueueMutex.
+ \param op        Set to the op taken from the queue
+ \param promoted  Set true if the op was served ahead of a higher class
+ \return true     Op taken
+ \return false    All queues empty
+*/
+bool I2CCommsWorker::takeNextOp(I2CQueuedOp_t &op, bool *promoted)
+{
+    const qint64 nowUs = queueClock.nsecsElapsed() / 1000;
+    int next = -1;
+    int highest = -1;
+    for (int priority = 0; priority < I2CComms::PRIORITY_COUNT; priority++)
+    {
+        if (opQueues[priority].isEmpty()) continue;
+        if (highest < 0) highest = priority;
+        const qint64 queuedUs = opQueues[priority].head().queuedUs;
+        if ((nowUs - queuedUs) < QUEUE_STARVATION_MS * 1000) continue;
+        if (next < 0 || queuedUs < opQueues[next].head().queuedUs) next = priority;
+    }
+    if (highest < 0) return false;
+    if (next < 0) next = highest;
+    *promoted = (next != highest);
+    op = opQueues[next].dequeue();
+    return true;
+}
+
+
 void I2CCommsWorker::run()
 {
     DEBUG_I2C("------- I2CCommsWorker Start on thread: " << currentThreadId() << "-------------")
@@ -919,10 +1837,95 @@ void I2CCommsWorker::run()
 
 // SLOTS //////////////////////////////////////////////
 
-void I2CCommsWorker::I2CWorkerConnect(QString port)
+/*!
+ \brief Slot: Carry out queued I2C ops
+ Ops are taken from the queues (by priority; see takeNextOp) and
+ carried out until the queues are empty. Nb: I2CWorkerOp runs a nested event loop while
+ waiting for the serial port, which may deliver further calls to
+ this slot; these return immediately and the outer call carries
+ on with the queue.
+*/
+void I2CCommsWorker::I2CWorkerProcessQueue()
 {
-    DEBUG_I2C("I2CCommsWorker: Open serial port " << port)
-    serial = std::unique_ptr<Serial>(new Serial(this));
+    if (opQueueBusy) return;
+    opQueueBusy = true;
+    while (true)
+    {
+        I2CQueuedOp_t op;
+        bool promoted = false;
+        {
+            QMutexLocker locker(&opQueueMutex);
+            if (!takeNextOp(op, &promoted)) break;
+        }
+        if (promoted)
+        {
+            QMutexLocker locker(&pacingStatsMutex);
+            pacingStats.promotedCount++;
+        }
+
+        int opResult = globals::OK;
+        QByteArray response;
+        if (op.nBytesToWrite > 0)
+        {
+            uint8_t *responseBuffer = op.dataRead;
+            if (!op.finished)
+            {
+                // Async op: Response is returned with I2COpFinished signal:
+                response.resize(op.nBytesToRead);
+                responseBuffer = reinterpret_cast<uint8_t *>(response.data());
+            }
+            const qint64 queueWaitUs = (queueClock.nsecsElapsed() / 1000) - op.queuedUs;
+            I2CWorkerOp(op.nBytesToWrite,
+                        reinterpret_cast<const char *>(op.finished ? op.dataWrite : op.asyncCommand),
+                        op.nBytesToRead,
+                        reinterpret_cast<char *>(responseBuffer),
+                        op.finished ? op.nBytesHeader : 0,
+                        reinterpret_cast<char *>(op.finished ? op.dataHeader : nullptr));
+            opResult = lastResult;
+            profiler.recordOp(op.source, op.priority, queueWaitUs, lastTurnaroundUs,
+                              op.nBytesToWrite, op.nBytesToRead,
+                              (opResult == globals::OK) ? I2CProfiler::OP_OK
+                                : (lastOpTimedOut ? I2CProfiler::OP_TIMEOUT : I2CProfiler::OP_ERROR));
+            if (clearPortPending) I2CClearPort();
+        }
+        else if (op.control != CONTROL_NONE)
+        {
+            if (op.control == CONTROL_PROBE) I2CProbeAdaptor();
+            else                             I2CConfigureAdaptor();
+            opResult = lastResult;
+            if (clearPortPending) I2CClearPort();
+        }
+
+        if (op.finished)
+        {
+            // Blocking op: Caller is waiting for the result:
+            *op.result = opResult;
+            op.finished->release();
+        }
+        else
+        {
+            if (op.checkWriteAck)
+            {
+                if (opResult == globals::OK && response.size() > 0 && response.at(0) == 0x00) opResult = globals::ADAPTOR_WRITE_ERROR;
+                response.clear();
+            }
+            emit I2COpFinished(op.opID, opResult, response);
+        }
+    }
+    opQueueBusy = false;
+}
+
+
+void I2CCommsWorker::I2CWorkerConnect(QString port, int transportType)
+{
+    DEBUG_I2C("I2CCommsWorker: Open port " << port << " (transport type " << transportType << ")")
+    serial = std::unique_ptr<I2CTransport>(I2CTransport::create(transportType, this));
+    if (!serial.get())
+    {
+        lastResult = globals::GEN_ERROR;
+        return;
+    }
+    transportCaps = serial->getCapabilities();
     connect(serial.get(), SIGNAL(transactionFinished()), this, SLOT(transactionFinished()));
     lastResult = serial->open(port);
     if (lastResult != globals::OK)
@@ -941,6 +1944,11 @@ void I2CCommsWorker::I2CWorkerDisconnect()
 {
     if (serial.get())
     {
+        I2CPacingStats_t stats = getPacingStats();
+        qDebug() << "I2C Comms: " << stats.opCount << " ops; " << stats.errorCount << " errors; "
+                 << stats.clearCount << " port clears; Turnaround mean/max: "
+                 << static_cast<int>(stats.meanTurnaroundUs) << "/" << stats.maxTurnaroundUs << " uS; "
+                 << stats.totalSleepTimeMs << " mS in delays";
         DEBUG_I2C("I2CCommsWorker: Close serial port")
         serial->close();
         disconnect(serial.get(), SIGNAL(transactionFinished()), this, SLOT(transactionFinished()));
@@ -951,37 +1959,43 @@ void I2CCommsWorker::I2CWorkerDisconnect()
 void I2CCommsWorker::I2CWorkerOp(int nBytesToWrite,
                                  const char *dataWrite,
                                  int nBytesToRead,
-                                 char *dataRead)
+                                 char *dataRead,
+                                 int nBytesHeader,
+                                 char *dataHeader)
 {
 
     DEBUG_I2C_EXTRA("I2CWorkerOp: Starting comms timer on thread: " << QThread::currentThreadId())
 
     commsStatus = COMMS_BUSY;
     serialTimer->start(COMMS_TIMEOUT);
+    opTimer.start();
 
     DEBUG_I2C_EXTRA("I2CWorkerOp: Emitting transactionStart signal")
-    emit serial->transactionStart((const uint8_t *)dataWrite, nBytesToWrite, nBytesToRead );
+    emit serial->transactionStart((const uint8_t *)dataWrite, nBytesToWrite,
+                                  nBytesToRead, (uint8_t *)dataRead,
+                                  nBytesHeader, (uint8_t *)dataHeader );
 
     DEBUG_I2C_EXTRA("I2CWorkerOp: ** Start WAIT event loop... **")
     exec();
     DEBUG_I2C_EXTRA("I2CWorkerOp: ** WAIT event loop finished **")
+    lastTurnaroundUs = opTimer.nsecsElapsed() / 1000;
+    lastOpTimedOut = (commsStatus == COMMS_ERROR);
 
-    size_t nBytes = 0;
-    uint8_t *data = serial->getData( &nBytes );
+    // Response data has been received directly into the caller's buffers:
+    size_t nBytes = serial->getBytesReceived();
 
     if ( (commsStatus == COMMS_OK) &&
          (nBytes == (size_t)nBytesToRead) )
     {
-        memcpy(dataRead, data, nBytes);
-        DEBUG_I2C("** Got back data: " << nBytes << " bytes; " << " [" << QString( (const char *)data) << "]")
+        DEBUG_I2C("** Got back data: " << nBytes << " bytes")
         lastResult = globals::OK;
-        globals::sleep(I2COP_SLEEP_TIME);
+        pacingOpGood(lastTurnaroundUs);
         return;
     }
     else
     {
         DEBUG_I2C("  I2C Op: TIMEOUT or Comms Error!")
-        globals::sleep(I2COP_ERR_RECOVERY_TIME);
+        pacingOpError();
         emit serial->transactionCancel();
         lastResult = globals::READ_ERROR;
         return;
@@ -990,7 +2004,8 @@ void I2CCommsWorker::I2CWorkerOp(int nBytesToWrite,
 
 
 /*!
- \brief Slot: Probe the USB to I2C Adaptor
+ \brief Probe the USB to I2C Adaptor
+ Carried out from the op queue (see queueAdaptorControl).
  If a suitable response is detected, lastResult is set to globals::OK.
 */
 void I2CCommsWorker::I2CProbeAdaptor()
@@ -1024,7 +2039,8 @@ void I2CCommsWorker::I2CProbeAdaptor()
 }
 
 /*!
- \brief Slot: Configure I2C Adaptor
+ \brief Configure I2C Adaptor
+ Carried out from the op queue (see queueAdaptorControl).
  Loads the adaptor settings pre-configured in I2C_OP_SET_MODE (see defn above)
 */
 void I2CCommsWorker::I2CConfigureAdaptor()
@@ -1061,6 +2077,24 @@ void I2CCommsWorker::I2CConfigureAdaptor()
 */
 void I2CCommsWorker::I2CClearPort()
 {
+    if (commsStatus == COMMS_BUSY)
+    {
+        // Called during an op (from nested event loop): Clear port once the op has finished.
+        clearPortPending = true;
+        return;
+    }
+    clearPortPending = false;
+    {
+        QMutexLocker locker(&pacingStatsMutex);
+        pacingStats.clearCount++;
+    }
+    if (pacingMode == PACING_ADAPTIVE)
+    {
+        // Port is cleared after an error reported by the adaptor (e.g. NACK);
+        // go back to the standard post-op delay:
+        pacingGoodRun = 0;
+        pacingOpSleepTime = I2COP_SLEEP_TIME;
+    }
     emit serial->transactionCancel();
     globals::sleep(50);
     lastResult = globals::OK;
@@ -1080,6 +2114,153 @@ void I2CCommsWorker::I2CWorkerExit()
 
 
 
+// Pacing ///////////////////////////////////////////////////
+
+/*!
+ \brief Set pacing mode (see I2CComms::setPacingMode)
+*/
+void I2CCommsWorker::setPacingMode(const int mode)
+{
+    Q_ASSERT(mode == PACING_FIXED || mode == PACING_ADAPTIVE);
+    pacingMode = mode;
+    pacingGoodRun = 0;
+    pacingOpSleepTime = I2COP_SLEEP_TIME;
+    QMutexLocker locker(&pacingStatsMutex);
+    pacingStats.pacingMode = pacingMode;
+    pacingStats.opSleepTimeMs = pacingOpSleepTime;
+}
+
+
+/*!
+ \brief Get a copy of the pacing statistics (thread-safe)
+*/
+I2CPacingStats_t I2CCommsWorker::getPacingStats()
+{
+    QMutexLocker locker(&pacingStatsMutex);
+    return pacingStats;
+}
+
+
+/*!
+ \brief Reset pacing statistics counters (thread-safe)
+*/
+void I2CCommsWorker::resetPacingStats()
+{
+    QMutexLocker locker(&pacingStatsMutex);
+    pacingStats = I2CPacingStats_t();
+    pacingStats.pacingMode = pacingMode;
+    pacingStats.opSleepTimeMs = pacingOpSleepTime;
+}
+
+
+/*!
+ \brief Update pacing after a good op, and sleep for the post-op delay
+ In adaptive mode, the post-op delay is paced from the measured turnaround:
+ It is reduced by 1 mS after each run of I2COP_ADAPTIVE_GOOD_RUN consecutive
+ good ops, down to 0. A good op which took more than
+ I2COP_ADAPTIVE_SLOW_FACTOR times the mean turnaround (the adaptor is
+ struggling to keep up) raises it by 1 mS, up to I2COP_SLEEP_TIME, and
+ starts the run again.
+ \param turnaroundUs  Time from start of op to response received (uS)
+*/
+void I2CCommsWorker::pacingOpGood(const qint64 turnaroundUs)
+{
+    double meanTurnaroundUs;
+    quint64 goodOps;
+    {
+        QMutexLocker locker(&pacingStatsMutex);
+        meanTurnaroundUs = pacingStats.meanTurnaroundUs;   // Mean before this op
+        pacingStats.opCount++;
+        pacingStats.consecutiveErrors = 0;
+        pacingStats.lastTurnaroundUs = turnaroundUs;
+        if (turnaroundUs > pacingStats.maxTurnaroundUs) pacingStats.maxTurnaroundUs = turnaroundUs;
+        goodOps = pacingStats.opCount - pacingStats.errorCount;
+        pacingStats.meanTurnaroundUs += (static_cast<double>(turnaroundUs) - pacingStats.meanTurnaroundUs) / static_cast<double>(goodOps);
+    }
+    if (pacingMode == PACING_ADAPTIVE)
+    {
+        const bool slowOp = (goodOps > static_cast<quint64>(I2COP_ADAPTIVE_GOOD_RUN))
+                         && (static_cast<double>(turnaroundUs) > meanTurnaroundUs * I2COP_ADAPTIVE_SLOW_FACTOR);
+        if (slowOp)
+        {
+            pacingGoodRun = 0;
+            if (pacingOpSleepTime < I2COP_SLEEP_TIME)
+            {
+                pacingOpSleepTime++;
+                DEBUG_I2C("I2CCommsWorker: Adaptive pacing: Slow turnaround (" << turnaroundUs << " uS); Post-op delay raised to " << pacingOpSleepTime << " mS")
+            }
+        }
+        else
+        {
+            pacingGoodRun++;
+            if (pacingGoodRun >= I2COP_ADAPTIVE_GOOD_RUN && pacingOpSleepTime > 0)
+            {
+                pacingOpSleepTime--;
+                pacingGoodRun = 0;
+                DEBUG_I2C("I2CCommsWorker: Adaptive pacing: Post-op delay reduced to " << pacingOpSleepTime << " mS")
+            }
+        }
+    }
+    else
+    {
+        pacingOpSleepTime = I2COP_SLEEP_TIME;
+    }
+    {
+        QMutexLocker locker(&pacingStatsMutex);
+        pacingStats.opSleepTimeMs = pacingOpSleepTime;
+    }
+    pacingSleep(pacingOpSleepTime);
+}
+
+
+/*!
+ \brief Update pacing after a failed op, and sleep for the error recovery delay
+ In adaptive mode, the post-op delay goes back to I2COP_SLEEP_TIME, and the
+ recovery delay starts at I2COP_ADAPTIVE_ERR_RECOVERY_MIN, doubling with each
+ consecutive error up to I2COP_ERR_RECOVERY_TIME.
+*/
+void I2CCommsWorker::pacingOpError()
+{
+    int recoveryTime = I2COP_ERR_RECOVERY_TIME;
+    int consecutiveErrors;
+    {
+        QMutexLocker locker(&pacingStatsMutex);
+        pacingStats.opCount++;
+        pacingStats.errorCount++;
+        pacingStats.consecutiveErrors++;
+        consecutiveErrors = pacingStats.consecutiveErrors;
+    }
+    if (pacingMode == PACING_ADAPTIVE)
+    {
+        pacingGoodRun = 0;
+        pacingOpSleepTime = I2COP_SLEEP_TIME;
+        recoveryTime = I2COP_ADAPTIVE_ERR_RECOVERY_MIN;
+        for (int i = 1; i < consecutiveErrors && recoveryTime < I2COP_ERR_RECOVERY_TIME; i++) recoveryTime *= 2;
+        if (recoveryTime > I2COP_ERR_RECOVERY_TIME) recoveryTime = I2COP_ERR_RECOVERY_TIME;
+        DEBUG_I2C("I2CCommsWorker: Adaptive pacing: Error " << consecutiveErrors << "; Recovery delay " << recoveryTime << " mS")
+    }
+    {
+        QMutexLocker locker(&pacingStatsMutex);
+        pacingStats.opSleepTimeMs = pacingOpSleepTime;
+    }
+    pacingSleep(recoveryTime);
+}
+
+
+/*!
+ \brief Sleep (if ms > 0) and add the delay to the pacing stats
+*/
+void I2CCommsWorker::pacingSleep(const int ms)
+{
+    if (ms <= 0) return;
+    globals::sleep(ms);
+    QMutexLocker locker(&pacingStatsMutex);
+    pacingStats.totalSleepTimeMs += static_cast<quint64>(ms);
+}
+
+
+
+
 // PRIVATE Slots ////////////////////////////////////////////
 
 void I2CCommsWorker::transactionFinished()
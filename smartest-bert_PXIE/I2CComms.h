@@ -15,14 +15,120 @@
 #include <memory>
 #include <QObject>
 #include <QTimer>
+#include <QList>
+#include <QQueue>
+#include <QMutex>
+#include <QSemaphore>
+#include <QByteArray>
+#include <QElapsedTimer>
 #include <QStringList>
 #include <QThread>
 
 #include "globals.h"
-#include "Serial.h"
+#include "I2CTransport.h"
+#include "I2CProfiler.h"
 
 class I2CCommsWorker;
 
+
+/*!
+ \brief I2C Pacing Statistics
+ Counters kept by the comms worker to show how the adaptor is
+ performing and how much time is spent in inter-op delays
+ (see I2CComms::getPacingStats).
+*/
+typedef struct I2CPacingStats_t
+{
+    int     pacingMode = 0;             // I2CCommsWorker::PACING_FIXED or PACING_ADAPTIVE
+    quint64 opCount = 0;                // Total adaptor ops carried out
+    quint64 errorCount = 0;             // Ops which timed out or returned the wrong amount of data
+    quint64 clearCount = 0;             // Number of port clears (retries after adaptor NACK, etc)
+    int     consecutiveErrors = 0;      // Errors since last good op
+    int     opSleepTimeMs = 0;          // Current delay after a good op (mS)
+    quint64 totalSleepTimeMs = 0;       // Total time spent in post-op and error recovery delays (mS)
+    qint64  lastTurnaroundUs = 0;       // Turnaround of last good op (write to response received; uS)
+    qint64  maxTurnaroundUs = 0;        // Slowest good op (uS)
+    double  meanTurnaroundUs = 0.0;     // Mean turnaround of good ops (uS)
+    quint64 promotedCount = 0;          // Ops served ahead of a higher priority class because they had waited too long
+} I2CPacingStats_t;
+
+
+/*!
+ \brief I2C Batch Class
+
+ Holds a list of simple I2C operations (raw, 8 bit or 16 bit address
+ register reads and writes) which are submitted to the adaptor together
+ using I2CComms::runBatch. Where the adaptor frame size allows, several
+ ops are packed into a single serial write and all of the responses are
+ collected with one read, instead of one blocking round trip per op.
+
+ Ops in a batch should be safe to repeat (i.e. plain register reads and
+ writes): if a packed frame fails, its ops are re-sent one at a time
+ using the normal retry logic.
+
+ Read ops store their data to the destination buffer supplied when the
+ op was added; the buffer must remain valid until runBatch returns.
+ The result of each op is available from getResult after runBatch.
+*/
+class I2CBatch
+{
+  public:
+    I2CBatch() {}
+
+    // Op size limits, as for the single op methods (I2CComms::write8, read8, etc).
+    // Writes are limited by the adaptor's 64 byte command buffer (5 byte header for
+    // a 16 bit address); reads by its 64 byte response buffer. A batch read too big
+    // to pack with other ops (see I2CComms::BATCH_FRAME_TRANSFER_MAX) runs on its own.
+    static const uint8_t WRITE_BYTES_MAX = 59;
+    static const uint8_t READ_BYTES_MAX  = 64;
+
+    int  addWriteRaw(const uint8_t slaveAddress, const uint8_t *data, const uint8_t nBytes);
+    int  addWrite8(const uint8_t slaveAddress, const uint8_t regAddress, const uint8_t *data, const uint8_t nBytes);
+    int  addWrite(const uint8_t slaveAddress, const uint16_t regAddress, const uint8_t *data, const uint8_t nBytes);
+
+    int  addReadRaw(const uint8_t slaveAddress, uint8_t *data, const uint8_t nBytes);
+    int  addRead8(const uint8_t slaveAddress, const uint8_t regAddress, uint8_t *data, const uint8_t nBytes);
+    int  addRead(const uint8_t slaveAddress, const uint16_t regAddress, uint8_t *data, const uint8_t nBytes);
+
+    int  count() const { return ops.count(); }
+    int  getResult(const int index) const;
+    void clear() { ops.clear(); }
+
+  private:
+    friend class I2CComms;
+
+    enum I2CBatchOpType_t
+    {
+        OP_WRITE_RAW,
+        OP_WRITE8,
+        OP_WRITE16,
+        OP_READ_RAW,
+        OP_READ8,
+        OP_READ16
+    };
+
+    typedef struct I2CBatchOp_t
+    {
+        I2CBatchOpType_t type;
+        uint8_t  slaveAddress;
+        uint16_t regAddress;
+        uint8_t  nBytes;
+        uint8_t  dataWrite[WRITE_BYTES_MAX];   // Data for write ops
+        uint8_t *dataRead;         // Destination for read ops (caller's buffer)
+        int      result;
+    } I2CBatchOp_t;
+
+    int addOp(const I2CBatchOpType_t type,
+              const uint8_t  slaveAddress,
+              const uint16_t regAddress,
+              const uint8_t *dataWrite,
+              uint8_t       *dataRead,
+              const uint8_t  nBytes);
+
+    QList<I2CBatchOp_t> ops;
+};
+
+
 /*!
  \brief I2C Comms Class
 */
@@ -34,13 +140,32 @@ class I2CComms : public QObject
     I2CComms();
     virtual ~I2CComms();
 
+    // Request priority classes: Queued ops are carried out highest class first
+    // (see I2CCommsWorker::takeNextOp). The class is set per calling thread,
+    // normally with an I2CPriorityScope around a request.
+    // Nb: Ops queued from one thread at different priorities may be reordered,
+    //     so only use separate classes for independent requests.
+    static const int PRIORITY_MEASUREMENT = 0;   // ED counters, eye scan readback (timing sensitive)
+    static const int PRIORITY_CONTROL     = 1;   // Settings, status / lock polls (default)
+    static const int PRIORITY_COSMETIC    = 2;   // LEDs, temperature display
+    static const int PRIORITY_COUNT       = 3;
+
+    static int  threadPriority();
+    static void setThreadPriority(const int priority);
+
     static std::unique_ptr<QStringList> getPortList();
 
-    int   open(const QString port);  // E.g.: "COM1"
+    int   open(const QString port, const int transportType = I2CTransport::TRANSPORT_USB_ISS);  // E.g.: "COM1"
     void  close();
     void  reset();
     bool  portIsOpen();
     int   pingAddress(const uint8_t slaveAddress);
+    int   probeAddresses(const QList<uint8_t> &addresses, QList<uint8_t> &found);
+    int   getAdaptorSerial(QString &serialNumber);
+
+    I2CTransportCapabilities_t getTransportCapabilities() const;
+    uint8_t getMaxWriteBlockSize() const;
+    uint8_t getMaxReadBlockSize() const;
 
     int   writeRaw(const uint8_t slaveAddress,
                    const uint8_t *data,
@@ -81,27 +206,77 @@ class I2CComms : public QObject
                  uint8_t *data,
                  const size_t nBytes);
 
+    int   runBatch(I2CBatch &batch);
+
+    void  setPacingMode(const int mode);
+    I2CPacingStats_t getPacingStats() const;
+    void  resetPacingStats();
+
+    // Bus profiler (see I2CProfiler):
+    void    setProfileSourceName(const uint8_t slaveAddress, const QString &name);
+    QString getProfileReport() const;
+    int     writeProfileReport(const QString &fileName) const;
+    void    resetProfile();
+
+    // Asynchronous ops: These return an op ID (> 0) immediately, or an error code (< 0)
+    // if the op couldn't be queued. The I2COpFinished signal is emitted with the op ID
+    // once the op has been carried out. Nb: Async ops are NOT retried on error.
+    int   writeAsync(const uint8_t slaveAddress,
+                     const uint16_t regAddress,
+                     const uint8_t *data,
+                     const uint8_t nBytes);
+
+    int   write8Async(const uint8_t slaveAddress,
+                      const uint8_t regAddress,
+                      const uint8_t *data,
+                      const uint8_t nBytes);
+
+    int   readAsync(const uint8_t slaveAddress,
+                    const uint16_t regAddress,
+                    const uint8_t nBytes);
+
+    int   read8Async(const uint8_t slaveAddress,
+                     const uint8_t regAddress,
+                     const uint8_t nBytes);
+
 signals:
-    void I2CWorkerConnect(QString port);
+    void I2COpFinished(int opID, int result, QByteArray data);
+
+    void I2CWorkerConnect(QString port, int transportType);
     void I2CWorkerDisconnect();
-    void I2CProbeAdaptor();
-    void I2CConfigureAdaptor();
-    void I2CWorkerOp(int nBytesToWrite,
-                     const char *dataWrite,
-                     int nBytesToRead,
-                     char *dataRead);
     void I2CClearPort();
     void I2CWorkerExit();
 
 private:
     void commsClose();
+    void clearPort();
     int  i2cOp(const uint8_t  nBytesToWrite,
                const uint8_t *dataWrite,
                const uint8_t  nBytesToRead,
-                     uint8_t *dataRead);
+                     uint8_t *dataRead,
+               const uint8_t  nBytesHeader = 0,
+                     uint8_t *dataHeader = nullptr);
+
+    static int    commandSource(const uint8_t *command, const size_t nBytes);
+    static size_t batchOpCommand(const I2CBatch::I2CBatchOp_t &op, uint8_t *command, size_t *responseSize);
+    int  batchOpSingle(I2CBatch::I2CBatchOp_t &op);
+    int  batchOpAsync(const I2CBatch &batch);
 
     static const int MAX_RETRIES   = 5;    // Maximum number of times to retry on I2C Error
 
+    static const int RESET_SLEEP_TIME = 600;        // Delay (mS) after clearing port during reset (PACING_FIXED)
+    static const int RESET_PROBE_INTERVAL = 100;    // PACING_ADAPTIVE: Interval (mS) between adaptor probes during reset
+
+    // Batch frame limits: Packed batch frames are kept within the size of the
+    // largest single adaptor op (see write24) so the normal comms timeout still applies:
+    static const size_t BATCH_FRAME_WRITE_MAX    = 60;   // Max bytes written to the adaptor per packed frame
+    static const size_t BATCH_FRAME_TRANSFER_MAX = 62;   // Max bytes written + read back per packed frame
+    static const size_t BATCH_COMMAND_MAX        = 64;   // Max size of the adaptor command for one batch op (5 byte header + I2CBatch::WRITE_BYTES_MAX)
+    static const size_t PROBE_COMMAND_SIZE       = 2;    // Size of one I2C_TST command (see pingAddress); adaptor returns 1 status byte
+
+    static const uint8_t ISS_GET_SERIAL  = 0x03;   // ISS_CMD sub-command: Read the adaptor serial number
+    static const uint8_t ISS_SERIAL_SIZE = 8;      // Serial number is returned as 8 ASCII digits
+
     // Adaptor Command Bytes:
     static const uint8_t I2C_SGL = 0x53;   // Read/Write single byte for non-registered devices
     static const uint8_t I2C_AD0 = 0x54;   // Read/Write multiple bytes without address
@@ -117,6 +292,27 @@ private:
 };
 
 
+/*!
+ \brief I2C Priority Scope
+ Sets the I2C request priority for the calling thread (see
+ I2CComms::PRIORITY_MEASUREMENT, etc) for the lifetime of this object,
+ then restores the previous priority. E.g.:
+   I2CPriorityScope priority(I2CComms::PRIORITY_MEASUREMENT);
+*/
+class I2CPriorityScope
+{
+  public:
+    explicit I2CPriorityScope(const int priority)
+     : previous(I2CComms::threadPriority())
+      { I2CComms::setThreadPriority(priority); }
+    ~I2CPriorityScope()
+      { I2CComms::setThreadPriority(previous); }
+
+  private:
+    const int previous;
+};
+
+
 class I2CCommsWorker : public QThread
 {
     Q_OBJECT
@@ -127,36 +323,113 @@ public:
 
     int getStatus() const { return commsStatus; }
     int getLastResult() const { return lastResult; }
+    I2CTransportCapabilities_t getTransportCapabilities() const { return transportCaps; }
+
+    // Op queue: Thread-safe; called from the I2CComms thread.
+    int  queueOp(const uint8_t *dataWrite, const int nBytesToWrite, const int nBytesToRead, uint8_t *dataRead,
+                 const int nBytesHeader = 0, uint8_t *dataHeader = nullptr,
+                 const int source = I2CProfiler::SOURCE_ADAPTOR);
+    int  queueOpAsync(const uint8_t *dataWrite, const int nBytesToWrite, const int nBytesToRead, const bool checkWriteAck,
+                      const int source = I2CProfiler::SOURCE_ADAPTOR);
+    void waitForQueue();
+    int  queueAdaptorControl(const int control);
+
+    // Adaptor control ops (queueAdaptorControl):
+    static const int CONTROL_NONE      = 0;   // Normal I2C op
+    static const int CONTROL_PROBE     = 1;   // Probe the adaptor (see I2CProbeAdaptor)
+    static const int CONTROL_CONFIGURE = 2;   // Load adaptor settings (see I2CConfigureAdaptor)
 
     // Comms Status:
     static const int COMMS_OK    =  0;
     static const int COMMS_ERROR = -1;
     static const int COMMS_BUSY  = -2;
 
+    // Pacing Modes:
+    static const int PACING_FIXED    = 0;   // Fixed delay after every op; fixed recovery delay after errors
+    static const int PACING_ADAPTIVE = 1;   // Post-op delay dropped while ops succeed; backs off on errors
+
+    void setPacingMode(const int mode);
+    int  getPacingMode() const { return pacingMode; }
+    I2CPacingStats_t getPacingStats();
+    void resetPacingStats();
+
+    I2CProfiler &getProfiler() { return profiler; }
+
 public slots:
-    void I2CWorkerConnect(QString port);
+    void I2CWorkerConnect(QString port, int transportType);
     void I2CWorkerDisconnect();
-    void I2CProbeAdaptor();
-    void I2CConfigureAdaptor();
-    void I2CWorkerOp(int nBytesToWrite,
-                     const char *dataWrite,
-                     int nBytesToRead,
-                     char *dataRead);
     void I2CClearPort();
     void I2CWorkerExit();
 
     void transactionFinished();
 
+signals:
+    void I2COpFinished(int opID, int result, QByteArray data);
+
 private slots:
 
+    void I2CWorkerProcessQueue();
     void serialTimeout();
 
 private:
+    /*!
+     \brief Queued I2C Op
+     Blocking ops (queueOp) point to the caller's buffers and release
+     'finished' once done; Async ops (queueOpAsync) carry a copy of the
+     command and report back via the I2COpFinished signal.
+     An op with no data to write is a marker used by waitForQueue.
+     Adaptor control ops (queueAdaptorControl) are blocking ops with
+     no data, carried out in turn with the other ops.
+    */
+    typedef struct I2CQueuedOp_t
+    {
+        int            opID;              // Async op ID; 0 for blocking ops
+        int            priority;          // I2CComms::PRIORITY_MEASUREMENT, etc
+        int            source;            // Slave address for profiler (see I2CComms::commandSource)
+        qint64         queuedUs;          // Time op was queued (queueClock; uS)
+        const uint8_t *dataWrite;         // Blocking ops: Caller's command buffer
+        uint8_t        asyncCommand[64];  // Async ops: Copy of command
+        int            nBytesToWrite;
+        int            nBytesToRead;
+        bool           checkWriteAck;     // Async write ops: Check adaptor status byte (0x00 = failed)
+        uint8_t       *dataRead;          // Blocking ops: Caller's buffer for response (after header)
+        int            nBytesHeader;      // Blocking ops: Number of response bytes to store in dataHeader
+        uint8_t       *dataHeader;        // Blocking ops: Caller's buffer for response header (may be null)
+        int           *result;            // Blocking ops: Set to the op result
+        QSemaphore    *finished;          // Blocking ops: Released when op has finished
+        int            control;           // CONTROL_NONE, or adaptor control op (CONTROL_PROBE, etc)
+    } I2CQueuedOp_t;
+
+    void I2CWorkerOp(int nBytesToWrite,
+                     const char *dataWrite,
+                     int nBytesToRead,
+                     char *dataRead,
+                     int nBytesHeader = 0,
+                     char *dataHeader = nullptr);
+
+    void I2CProbeAdaptor();
+    void I2CConfigureAdaptor();
+
+    void enqueueOp(I2CQueuedOp_t &op);
+    bool takeNextOp(I2CQueuedOp_t &op, bool *promoted);
+
     static const int COMMS_TIMEOUT = 50;   // Maximum time when reading data back from serial transaction (mS)
 
-    static const int I2COP_SLEEP_TIME = 3;           // Delay (mS) after I2C op to allow adaptor to reset: 5 found to be reliable.
+    // Starvation protection: An op which has waited this long is carried out next, whatever its class:
+    static const int QUEUE_STARVATION_MS = 50;
+
+    static const int I2COP_SLEEP_TIME = 3;           // Delay (mS) after I2C op to allow adaptor to reset. Always used in fixed pacing; adaptive pacing starts here (see pacingOpGood).
     static const int I2COP_ERR_RECOVERY_TIME = 100;  // Delay (mS) after I2C error condition
 
+    // Adaptive pacing (PACING_ADAPTIVE):
+    static const int I2COP_ADAPTIVE_GOOD_RUN = 32;         // Consecutive good ops before the post-op delay is reduced by 1 mS
+    static const int I2COP_ADAPTIVE_ERR_RECOVERY_MIN = 10; // Recovery delay (mS) after first error; doubles with each consecutive error up to I2COP_ERR_RECOVERY_TIME
+    static const int I2COP_ADAPTIVE_SLOW_FACTOR = 3;       // An op whose turnaround is more than this times the mean raises the post-op delay by 1 mS
+
+    void pacingOpGood(const qint64 turnaroundUs);
+    void pacingOpError();
+    void pacingSleep(const int ms);
+
     // Pre-defined I2C adaptor ops:
     static const uint8_t ISS_CMD = 0x5A;   // Custom commands for the USB-ISS adaptor
     static const uint8_t I2C_OP_GET_VERSION[];
@@ -178,8 +451,27 @@ private:
     int lastResult = globals::OK;
     bool flagStop;
 
-    std::unique_ptr<Serial> serial;
+    QQueue<I2CQueuedOp_t> opQueues[I2CComms::PRIORITY_COUNT];   // One FIFO per priority class
+    QMutex opQueueMutex;
+    QElapsedTimer queueClock;        // Time base for op queue waits
+    int  nextOpID = 1;
+    bool opQueueBusy = false;        // Set while I2CWorkerProcessQueue is running (guards against re-entry from nested event loop)
+    bool clearPortPending = false;   // I2CClearPort was called during an op; carry out when the op has finished
+
+    int pacingMode = PACING_ADAPTIVE;
+    int pacingGoodRun = 0;           // Consecutive good ops at current post-op delay
+    int pacingOpSleepTime = I2COP_SLEEP_TIME;
+    I2CPacingStats_t pacingStats;
+    QMutex pacingStatsMutex;
+    QElapsedTimer opTimer;
+    qint64 lastTurnaroundUs = 0;     // Set by I2CWorkerOp (good or failed op)
+    bool   lastOpTimedOut = false;   // Set by I2CWorkerOp: No response within COMMS_TIMEOUT
+
+    I2CProfiler profiler;
+
+    std::unique_ptr<I2CTransport> serial;
     std::unique_ptr<QTimer> serialTimer;
+    I2CTransportCapabilities_t transportCaps;  // Set when transport is created (I2CWorkerConnect); all limits 0 until then
 
 
 };
@@ -0,0 +1,277 @@
+/*!
+ \file   I2CProfiler.cpp
+ \brief  I2C Bus Profiler - Latency histograms and op counts for the I2C comms layer
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <QFile>
+#include <QTextStream>
+#include <QDateTime>
+#include <QStringList>
+
+#include "globals.h"
+#include "I2CProfiler.h"
+
+
+I2CProfiler::I2CProfiler()
+{
+    clock.start();
+}
+
+
+/*!
+ \brief Record one adaptor op
+ \param source        Slave address the op was sent to (or SOURCE_ADAPTOR)
+ \param priority      Priority class of the op
+ \param queueWaitUs   Time from queueing the op to starting it (uS)
+ \param turnaroundUs  Time from writing the op to the adaptor to the response (or timeout) (uS)
+ \param bytesWritten  Bytes written to the adaptor
+ \param bytesRead     Bytes expected back from the adaptor
+ \param outcome       OP_OK, OP_ERROR or OP_TIMEOUT
+*/
+void I2CProfiler::recordOp(const int source, const int priority,
+                           const qint64 queueWaitUs, const qint64 turnaroundUs,
+                           const int bytesWritten, const int bytesRead,
+                           const int outcome)
+{
+    QMutexLocker locker(&mutex);
+    addOp(totals,               queueWaitUs, turnaroundUs, bytesWritten, bytesRead, outcome);
+    addOp(sourceStats[source],  queueWaitUs, turnaroundUs, bytesWritten, bytesRead, outcome);
+    addOp(classStats[priority], queueWaitUs, turnaroundUs, bytesWritten, bytesRead, outcome);
+}
+
+
+/*!
+ \brief Record a retry (op repeated after an error)
+ \param source  Slave address of the op
+*/
+void I2CProfiler::recordRetry(const int source)
+{
+    QMutexLocker locker(&mutex);
+    totals.retries++;
+    sourceStats[source].retries++;
+}
+
+
+/*!
+ \brief Set the name used for a source in the report (e.g. "GT1724 Core 1")
+*/
+void I2CProfiler::setSourceName(const int source, const QString &name)
+{
+    QMutexLocker locker(&mutex);
+    sourceNames[source] = name;
+}
+
+
+/*!
+ \brief Set the name used for a priority class in the report
+*/
+void I2CProfiler::setClassName(const int priority, const QString &name)
+{
+    QMutexLocker locker(&mutex);
+    classNames[priority] = name;
+}
+
+
+/*!
+ \brief Clear all statistics (names are kept)
+*/
+void I2CProfiler::reset()
+{
+    QMutexLocker locker(&mutex);
+    totals = I2CProfileStats_t();
+    sourceStats.clear();
+    classStats.clear();
+    clock.start();
+}
+
+
+qint64 I2CProfiler::getElapsedMs() const
+{
+    QMutexLocker locker(&mutex);
+    return clock.elapsed();
+}
+
+I2CProfiler::I2CProfileStats_t I2CProfiler::getTotals() const
+{
+    QMutexLocker locker(&mutex);
+    return totals;
+}
+
+QMap<int, I2CProfiler::I2CProfileStats_t> I2CProfiler::getSourceStats() const
+{
+    QMutexLocker locker(&mutex);
+    return sourceStats;
+}
+
+QMap<int, I2CProfiler::I2CProfileStats_t> I2CProfiler::getClassStats() const
+{
+    QMutexLocker locker(&mutex);
+    return classStats;
+}
+
+
+/*!
+ \brief Make a text report of the statistics
+ One line per source and per priority class (ops, ops / second, bytes,
+ retries, errors, timeouts, mean / max turnaround and queue wait), then
+ the turnaround and queue wait histograms.
+ \return Report text (multiple lines)
+*/
+QString I2CProfiler::getReport() const
+{
+    I2CProfileStats_t totalsCopy;
+    QMap<int, I2CProfileStats_t> sourceCopy;
+    QMap<int, I2CProfileStats_t> classCopy;
+    QMap<int, QString> sourceNamesCopy;
+    QMap<int, QString> classNamesCopy;
+    double seconds;
+    {
+        QMutexLocker locker(&mutex);
+        totalsCopy = totals;
+        sourceCopy = sourceStats;
+        classCopy = classStats;
+        sourceNamesCopy = sourceNames;
+        classNamesCopy = classNames;
+        seconds = static_cast<double>(clock.elapsed()) / 1000.0;
+    }
+
+    QStringList lines;
+    lines << QString("I2C Bus Profile: %1 ops in %2 s (%3 ops/s)")
+             .arg(totalsCopy.ops)
+             .arg(seconds, 0, 'f', 1)
+             .arg((seconds > 0.0) ? static_cast<double>(totalsCopy.ops) / seconds : 0.0, 0, 'f', 1);
+    const QString header = QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12")
+            .arg("Source", -20).arg("Ops", 10).arg("Ops/s", 8).arg("Wr Bytes", 10).arg("Rd Bytes", 10)
+            .arg("Retries", 8).arg("Errors", 7).arg("T/Outs", 7)
+            .arg("Mean uS", 9).arg("Max uS", 9).arg("Wait uS", 9).arg("WaitMax", 9);
+
+    lines << "" << header;
+    QMapIterator<int, I2CProfileStats_t> iSource(sourceCopy);
+    while (iSource.hasNext())
+    {
+        iSource.next();
+        lines << statsLine(sourceLabel(iSource.key(), sourceNamesCopy), iSource.value(), seconds);
+    }
+    lines << statsLine("Total", totalsCopy, seconds);
+
+    lines << "" << QString(header).replace(0, 6, "Class ");
+    QMapIterator<int, I2CProfileStats_t> iClass(classCopy);
+    while (iClass.hasNext())
+    {
+        iClass.next();
+        QString name = classNamesCopy.value(iClass.key(), QString("Class %1").arg(iClass.key()));
+        lines << statsLine(name, iClass.value(), seconds);
+    }
+
+    QString bucketHeader = QString("%1").arg("Histogram (uS >=)", -20);
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) bucketHeader += QString(" %1").arg(1 << bucket, 7);
+    lines << "" << "Turnaround:" << bucketHeader;
+    iSource.toFront();
+    while (iSource.hasNext())
+    {
+        iSource.next();
+        lines << histogramLine(sourceLabel(iSource.key(), sourceNamesCopy), iSource.value().turnaroundHistogram);
+    }
+    lines << histogramLine("Total", totalsCopy.turnaroundHistogram);
+    lines << "" << "Queue wait:" << bucketHeader;
+    iClass.toFront();
+    while (iClass.hasNext())
+    {
+        iClass.next();
+        lines << histogramLine(classNamesCopy.value(iClass.key(), QString("Class %1").arg(iClass.key())),
+                               iClass.value().queueWaitHistogram);
+    }
+    return lines.join("\n") + "\n";
+}
+
+
+/*!
+ \brief Append the report to a text file (with a time stamp)
+ \param fileName  File to write; created if it doesn't exist
+ \return globals::OK
+ \return globals::FILE_ERROR  Couldn't open or write the file
+*/
+int I2CProfiler::writeReport(const QString &fileName) const
+{
+    QFile file(fileName);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Append | QIODevice::Text)) return globals::FILE_ERROR;
+    QTextStream stream(&file);
+    stream << "==== " << QDateTime::currentDateTime().toString("yyyy-MM-dd hh:mm:ss") << " ====\n";
+    stream << getReport() << "\n";
+    stream.flush();
+    if (stream.status() != QTextStream::Ok) return globals::FILE_ERROR;
+    return globals::OK;
+}
+
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+int I2CProfiler::histogramBucket(const qint64 us)
+{
+    int bucket = 0;
+    qint64 value = us;
+    while (value > 1 && bucket < (HISTOGRAM_BUCKETS - 1))
+    {
+        value >>= 1;
+        bucket++;
+    }
+    return bucket;
+}
+
+
+void I2CProfiler::addOp(I2CProfileStats_t &stats,
+                        const qint64 queueWaitUs, const qint64 turnaroundUs,
+                        const int bytesWritten, const int bytesRead,
+                        const int outcome)
+{
+    stats.ops++;
+    stats.bytesWritten += static_cast<quint64>(bytesWritten);
+    stats.bytesRead    += static_cast<quint64>(bytesRead);
+    if (outcome == OP_ERROR)   stats.errors++;
+    if (outcome == OP_TIMEOUT) stats.timeouts++;
+    stats.totalTurnaroundUs += turnaroundUs;
+    if (turnaroundUs > stats.maxTurnaroundUs) stats.maxTurnaroundUs = turnaroundUs;
+    stats.totalQueueWaitUs += queueWaitUs;
+    if (queueWaitUs > stats.maxQueueWaitUs) stats.maxQueueWaitUs = queueWaitUs;
+    stats.turnaroundHistogram[histogramBucket(turnaroundUs)]++;
+    stats.queueWaitHistogram[histogramBucket(queueWaitUs)]++;
+}
+
+
+QString I2CProfiler::sourceLabel(const int source, const QMap<int, QString> &names)
+{
+    if (names.contains(source)) return names.value(source);
+    if (source == SOURCE_ADAPTOR) return QString("Adaptor");
+    return QString("I2C 0x%1").arg(source, 2, 16, QChar('0'));
+}
+
+
+QString I2CProfiler::statsLine(const QString &name, const I2CProfileStats_t &stats, const double seconds)
+{
+    const double ops = static_cast<double>(stats.ops);
+    return QString("%1 %2 %3 %4 %5 %6 %7 %8 %9 %10 %11 %12")
+            .arg(name.left(20), -20)
+            .arg(stats.ops, 10)
+            .arg((seconds > 0.0) ? ops / seconds : 0.0, 8, 'f', 1)
+            .arg(stats.bytesWritten, 10)
+            .arg(stats.bytesRead, 10)
+            .arg(stats.retries, 8)
+            .arg(stats.errors, 7)
+            .arg(stats.timeouts, 7)
+            .arg((stats.ops > 0) ? static_cast<double>(stats.totalTurnaroundUs) / ops : 0.0, 9, 'f', 0)
+            .arg(stats.maxTurnaroundUs, 9)
+            .arg((stats.ops > 0) ? static_cast<double>(stats.totalQueueWaitUs) / ops : 0.0, 9, 'f', 0)
+            .arg(stats.maxQueueWaitUs, 9);
+}
+
+
+QString I2CProfiler::histogramLine(const QString &name, const quint64 histogram[HISTOGRAM_BUCKETS])
+{
+    QString line = QString("%1").arg(name.left(20), -20);
+    for (int bucket = 0; bucket < HISTOGRAM_BUCKETS; bucket++) line += QString(" %1").arg(histogram[bucket], 7);
+    return line;
+}
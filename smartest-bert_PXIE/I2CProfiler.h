@@ -0,0 +1,102 @@
+/*!
+ \file   I2CProfiler.h
+ \brief  I2C Bus Profiler - Latency histograms and op counts for the I2C comms layer
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#ifndef I2CPROFILER_H
+#define I2CPROFILER_H
+
+#include <QString>
+#include <QMap>
+#include <QMutex>
+#include <QElapsedTimer>
+
+/*!
+ \brief I2C Bus Profiler
+
+ Always-on statistics for the I2C comms layer. The comms worker records
+ every adaptor op it carries out (queue wait, turnaround, bytes written
+ and read, and whether the op failed or timed out); I2CComms records
+ retries. Ops are counted against their source (the I2C slave address
+ the op was sent to; adaptor commands use SOURCE_ADAPTOR) and against
+ their priority class (see I2CComms::PRIORITY_MEASUREMENT, etc).
+
+ Latencies are kept as log2 histograms: bucket n counts ops which took
+ [2^n, 2^(n+1)) uS (bucket 0 also counts ops under 1 uS; the last bucket
+ counts everything slower). Recording an op is a few additions under a
+ mutex, so the profiler stays on all the time.
+
+ Names for sources and classes are set by the client (setSourceName,
+ setClassName) and are only used in the report; they may be set at any
+ time, before or after ops are recorded. Thread-safe.
+*/
+class I2CProfiler
+{
+public:
+    I2CProfiler();
+
+    static const int HISTOGRAM_BUCKETS = 21;       // 1 uS to ~1 S (and more)
+    static const int SOURCE_ADAPTOR    = 0x80;     // Adaptor commands (no slave address; 7 bit addresses are < 0x80)
+
+    // Op outcome (recordOp):
+    static const int OP_OK      = 0;
+    static const int OP_ERROR   = 1;   // Wrong amount of data returned, or other comms error
+    static const int OP_TIMEOUT = 2;   // No response within the comms timeout
+
+    typedef struct I2CProfileStats_t
+    {
+        quint64 ops = 0;
+        quint64 bytesWritten = 0;
+        quint64 bytesRead = 0;
+        quint64 errors = 0;                 // OP_ERROR
+        quint64 timeouts = 0;               // OP_TIMEOUT
+        quint64 retries = 0;                // Ops repeated by I2CComms after an error
+        qint64  totalTurnaroundUs = 0;
+        qint64  maxTurnaroundUs = 0;
+        qint64  totalQueueWaitUs = 0;
+        qint64  maxQueueWaitUs = 0;
+        quint64 turnaroundHistogram[HISTOGRAM_BUCKETS] = {};
+        quint64 queueWaitHistogram[HISTOGRAM_BUCKETS] = {};
+    } I2CProfileStats_t;
+
+    void recordOp(const int source, const int priority,
+                  const qint64 queueWaitUs, const qint64 turnaroundUs,
+                  const int bytesWritten, const int bytesRead,
+                  const int outcome);
+    void recordRetry(const int source);
+
+    void setSourceName(const int source, const QString &name);
+    void setClassName(const int priority, const QString &name);
+
+    void reset();
+
+    qint64 getElapsedMs() const;
+    I2CProfileStats_t getTotals() const;
+    QMap<int, I2CProfileStats_t> getSourceStats() const;
+    QMap<int, I2CProfileStats_t> getClassStats() const;
+
+    QString getReport() const;
+    int     writeReport(const QString &fileName) const;
+
+private:
+    static int  histogramBucket(const qint64 us);
+    static void addOp(I2CProfileStats_t &stats,
+                      const qint64 queueWaitUs, const qint64 turnaroundUs,
+                      const int bytesWritten, const int bytesRead,
+                      const int outcome);
+    static QString sourceLabel(const int source, const QMap<int, QString> &names);
+    static QString statsLine(const QString &name, const I2CProfileStats_t &stats, const double seconds);
+    static QString histogramLine(const QString &name, const quint64 histogram[HISTOGRAM_BUCKETS]);
+
+    mutable QMutex mutex;
+    QElapsedTimer clock;                        // Time since reset (for ops / second)
+    I2CProfileStats_t totals;
+    QMap<int, I2CProfileStats_t> sourceStats;   // By source (slave address or SOURCE_ADAPTOR)
+    QMap<int, I2CProfileStats_t> classStats;    // By priority class
+    QMap<int, QString> sourceNames;
+    QMap<int, QString> classNames;
+};
+
+#endif // I2CPROFILER_H
@@ -0,0 +1,1041 @@
+/*!
+ \file   I2CSimulator.cpp
+ \brief  Simulated I2C Adaptor Transport
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <cmath>
+#include <cstring>
+#include <QStringList>
+#include <QDebug>
+
+#include "globals.h"
+#include "BertModel.h"
+#include "Serial.h"
+#include "I2CSimulator.h"
+
+
+// USB-ISS adaptor commands (see I2CComms):
+#define SIM_I2C_SGL  0x53
+#define SIM_I2C_AD0  0x54
+#define SIM_I2C_AD1  0x55
+#define SIM_I2C_AD2  0x56
+#define SIM_I2C_DIR  0x57
+#define SIM_I2C_TST  0x58
+#define SIM_ISS_CMD  0x5A
+
+#define SIM_ADDRESS(ADDRESS_RW)  static_cast<uint8_t>((ADDRESS_RW) >> 1)
+#define SIM_IS_READ(ADDRESS_RW)  (((ADDRESS_RW) & 0x01) != 0)
+
+const char I2CSimulator::PORT_NAME[] = "SIM";
+
+
+/*!
+ \brief Simulated I2C Device
+ Base class for the component models. Register accesses carry the width
+ of the register address used by the adaptor command (1 for I2C_AD1, 2 for
+ I2C_AD2, 3 for the I2C_DIR sequences used by write24 / read24). Raw
+ accesses (I2C_AD0) treat the first byte written as a register pointer
+ (as for the SI5340) unless the device overrides them.
+*/
+class I2CSimDevice
+{
+public:
+    virtual ~I2CSimDevice() {}
+
+    virtual bool isBusy(const qint64 nowUs) const  { Q_UNUSED(nowUs) return false; }   // Busy devices don't ACK
+
+    virtual void writeRegisters(const uint32_t address, const int addressBytes,
+                                const uint8_t *data, const size_t nBytes, const qint64 nowUs) = 0;
+    virtual void readRegisters(const uint32_t address, const int addressBytes,
+                               uint8_t *data, const size_t nBytes, const qint64 nowUs) = 0;
+
+    virtual void writeRaw(const uint8_t *data, const size_t nBytes, const qint64 nowUs)
+    {
+        if (nBytes == 0) return;
+        pointer = data[0];
+        if (nBytes > 1) writeRegisters(pointer, 1, data + 1, nBytes - 1, nowUs);
+    }
+    virtual void readRaw(uint8_t *data, const size_t nBytes, const qint64 nowUs)
+    {
+        readRegisters(pointer, 1, data, nBytes, nowUs);
+        pointer = (pointer + static_cast<uint32_t>(nBytes)) & 0xFF;
+    }
+
+protected:
+    uint32_t pointer = 0;
+};
+
+
+/*!
+ \brief Plain 8 bit register device (PCA9557A, PCA9557B, TLC59108)
+ \param addressMask  Mask applied to register addresses (e.g. to drop the
+                     TLC59108 auto-increment flags)
+*/
+class SimRegisterDevice : public I2CSimDevice
+{
+public:
+    explicit SimRegisterDevice(const uint8_t addressMask) : addressMask(addressMask) {}
+
+    void writeRegisters(const uint32_t address, const int addressBytes,
+                        const uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        Q_UNUSED(addressBytes) Q_UNUSED(nowUs)
+        for (size_t i = 0; i < nBytes; i++) registers[(address + i) & addressMask] = data[i];
+    }
+    void readRegisters(const uint32_t address, const int addressBytes,
+                       uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        Q_UNUSED(addressBytes) Q_UNUSED(nowUs)
+        for (size_t i = 0; i < nBytes; i++) data[i] = registers[(address + i) & addressMask];
+    }
+
+private:
+    const uint8_t addressMask;
+    uint8_t registers[256] = {};
+};
+
+
+/*!
+ \brief SI5340 Clock Generator: Paged registers
+ Register 0x01 (on every page) selects the page.
+*/
+class SimSI5340 : public I2CSimDevice
+{
+public:
+    void writeRegisters(const uint32_t address, const int addressBytes,
+                        const uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        Q_UNUSED(addressBytes) Q_UNUSED(nowUs)
+        for (size_t i = 0; i < nBytes; i++)
+        {
+            const uint8_t regAddress = static_cast<uint8_t>(address + i);
+            if (regAddress == PAGE_REGISTER) page = data[i];
+            else                             registers[(page << 8) | regAddress] = data[i];
+        }
+    }
+    void readRegisters(const uint32_t address, const int addressBytes,
+                       uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        Q_UNUSED(addressBytes) Q_UNUSED(nowUs)
+        for (size_t i = 0; i < nBytes; i++)
+        {
+            const uint8_t regAddress = static_cast<uint8_t>(address + i);
+            data[i] = (regAddress == PAGE_REGISTER) ? page : registers[(page << 8) | regAddress];
+        }
+    }
+
+private:
+    static const uint8_t PAGE_REGISTER = 0x01;
+    uint8_t page = 0;
+    QByteArray registers = QByteArray(65536, 0);
+};
+
+
+/*!
+ \brief LMX2594 behind the SC18IS602B I2C to SPI bridge
+ A write with function ID 0x01 - 0x0F is an SPI transfer (3 bytes per LMX
+ register: R/W + address, then 16 bits of data); the bytes clocked out by
+ the LMX are read back with a raw read. Other function IDs (configure,
+ GPIO) are accepted and ignored.
+*/
+class SimLMX2594 : public I2CSimDevice
+{
+public:
+    void writeRaw(const uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        Q_UNUSED(nowUs)
+        if (nBytes < 1 || data[0] < 0x01 || data[0] > 0x0F) return;
+        spiOut = QByteArray(static_cast<int>(nBytes - 1), 0);
+        for (size_t i = 1; i + 2 < nBytes; i += 3)
+        {
+            const uint8_t regAddress = data[i] & 0x7F;
+            if (data[i] & 0x80)
+            {
+                uint16_t value = registers[regAddress];
+                if (regAddress == 110) value = (value & ~R110_LD_VTUNE_MASK) | R110_LD_VTUNE_LOCKED;
+                spiOut[static_cast<int>(i)]     = static_cast<char>(value >> 8);
+                spiOut[static_cast<int>(i) + 1] = static_cast<char>(value);
+            }
+            else
+            {
+                registers[regAddress] = static_cast<uint16_t>((data[i + 1] << 8) | data[i + 2]);
+            }
+        }
+    }
+    void readRaw(uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        Q_UNUSED(nowUs)
+        for (size_t i = 0; i < nBytes; i++)
+        {
+            data[i] = (static_cast<int>(i) < spiOut.size()) ? static_cast<uint8_t>(spiOut.at(static_cast<int>(i))) : 0;
+        }
+    }
+    void writeRegisters(const uint32_t address, const int addressBytes,
+                        const uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        Q_UNUSED(addressBytes)
+        QByteArray raw(1, static_cast<char>(address));
+        raw.append(reinterpret_cast<const char *>(data), static_cast<int>(nBytes));
+        writeRaw(reinterpret_cast<const uint8_t *>(raw.constData()), static_cast<size_t>(raw.size()), nowUs);
+    }
+    void readRegisters(const uint32_t address, const int addressBytes,
+                       uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        Q_UNUSED(address) Q_UNUSED(addressBytes)
+        readRaw(data, nBytes, nowUs);
+    }
+
+private:
+    static const uint16_t R110_LD_VTUNE_MASK   = 0x0600;
+    static const uint16_t R110_LD_VTUNE_LOCKED = 0x0400;   // rb_LD_VTUNE = 2: Locked
+    uint16_t   registers[128] = {};
+    QByteArray spiOut;
+};
+
+
+/*!
+ \brief M24M02 EEPROM (shared by the four page addresses)
+ Writes wrap within a 256 byte write page and start a write cycle, during
+ which none of the page addresses ACK.
+*/
+class SimM24M02Memory
+{
+public:
+    static const int PAGE_SIZE         = 65536;  // Bytes per I2C address
+    static const int WRITE_PAGE_SIZE   = 256;
+    static const int WRITE_CYCLE_US    = 5000;
+
+    QByteArray memory = QByteArray(4 * PAGE_SIZE, static_cast<char>(0xFF));
+    qint64     busyUntilUs = 0;
+
+    void seed(const QString &modelCode);
+
+private:
+    void storeString(const int address, const int maxLength, const QString &text);
+    int  storeProfile(const int address, const float frequency, const int registerCount);
+};
+
+class SimM24M02Page : public I2CSimDevice
+{
+public:
+    SimM24M02Page(SimM24M02Memory *memory, const int page) : memory(memory), page(page) {}
+
+    bool isBusy(const qint64 nowUs) const override  { return nowUs < memory->busyUntilUs; }
+
+    void writeRegisters(const uint32_t address, const int addressBytes,
+                        const uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        Q_UNUSED(addressBytes)
+        pointer = address & 0xFFFF;
+        if (nBytes == 0) return;   // Address only (start of a read)
+        const int base = (page * SimM24M02Memory::PAGE_SIZE) + static_cast<int>(pointer & ~(SimM24M02Memory::WRITE_PAGE_SIZE - 1));
+        for (size_t i = 0; i < nBytes; i++)
+        {
+            const int offset = (static_cast<int>(pointer) + static_cast<int>(i)) & (SimM24M02Memory::WRITE_PAGE_SIZE - 1);
+            memory->memory[base + offset] = static_cast<char>(data[i]);
+        }
+        memory->busyUntilUs = nowUs + SimM24M02Memory::WRITE_CYCLE_US;
+    }
+    void readRegisters(const uint32_t address, const int addressBytes,
+                       uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        Q_UNUSED(addressBytes) Q_UNUSED(nowUs)
+        const int base = page * SimM24M02Memory::PAGE_SIZE;
+        for (size_t i = 0; i < nBytes; i++)
+        {
+            const int index = (base + static_cast<int>(address & 0xFFFF) + static_cast<int>(i)) % memory->memory.size();
+            data[i] = static_cast<uint8_t>(memory->memory.at(index));
+        }
+        pointer = (address + static_cast<uint32_t>(nBytes)) & 0xFFFF;
+    }
+    void writeRaw(const uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        if (nBytes < 2) return;
+        writeRegisters(static_cast<uint32_t>((data[0] << 8) | data[1]), 2, data + 2, nBytes - 2, nowUs);
+    }
+    void readRaw(uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        readRegisters(pointer, 2, data, nBytes, nowUs);
+    }
+
+private:
+    SimM24M02Memory *memory;
+    const int page;
+};
+
+
+/*!
+ \brief Seed the EEPROM with a model code and frequency profiles
+ Layout as used by M24M02: strings from address 0 of page 0 (model code
+ first, then serial number); profile count then one profile per 256 byte
+ slot in page 2.
+*/
+void SimM24M02Memory::seed(const QString &modelCode)
+{
+    const int MODEL_LENGTH = 20;
+    storeString(0,            MODEL_LENGTH, modelCode);
+    storeString(MODEL_LENGTH, 50,           QString("SIMULATOR"));
+
+    const float frequencies[] = { 5000.0f, 10000.0f, 12890.625f, 14062.5f };   // MHz
+    const int profileCount = sizeof(frequencies) / sizeof(frequencies[0]);
+    const int profilePage = 2 * PAGE_SIZE;
+    memory[profilePage]     = static_cast<char>(profileCount & 0xFF);
+    memory[profilePage + 1] = static_cast<char>(profileCount >> 8);
+    for (int i = 0; i < profileCount; i++) storeProfile(profilePage + ((i + 1) * WRITE_PAGE_SIZE), frequencies[i], 113);
+}
+
+void SimM24M02Memory::storeString(const int address, const int maxLength, const QString &text)
+{
+    const QByteArray bytes = text.toLatin1().left(maxLength - 1);
+    for (int i = 0; i < bytes.size(); i++) memory[address + i] = bytes.at(i);
+    memory[address + bytes.size()] = 0x00;
+}
+
+/*!
+ \brief Store one frequency profile record (see M24M02::encodeFrequencyProfile)
+ Frequency (4 byte float), register count, register values (all zero),
+ then a checksum of the preceding bytes. All values little endian.
+ \return Size of the record (bytes)
+*/
+int SimM24M02Memory::storeProfile(const int address, const float frequency, const int registerCount)
+{
+    QByteArray record(4, 0);
+    memcpy(record.data(), &frequency, 4);
+    record.append(static_cast<char>(registerCount & 0xFF));
+    record.append(static_cast<char>(registerCount >> 8));
+    record.append(QByteArray(registerCount * 2, 0));
+    uint16_t checkSum = 0;
+    foreach (char byte, record) checkSum = static_cast<uint16_t>(checkSum + static_cast<uint8_t>(byte));
+    record.append(static_cast<char>(checkSum & 0xFF));
+    record.append(static_cast<char>(checkSum >> 8));
+    for (int i = 0; i < record.size(); i++) memory[address + i] = record.at(i);
+    return record.size();
+}
+
+
+/*!
+ \brief GT1724 model
+ 16 bit register space (lane registers at (lane << 8) | address), with the
+ macro interface at 0x0C00 (input), 0x0C10 (code / status) and 0x0C11
+ (output). Writing a code starts the macro; the status register reads
+ back the code until the macro's run time has passed, then 0x00 (OK) or
+ 0x01 (error). 24 bit accesses go to macro memory (0xFBxxxx; any write
+ counts as a macro download) or eye scan memory (0xFCxxxx).
+*/
+class SimGT1724 : public I2CSimDevice
+{
+public:
+    SimGT1724(const I2CSimulator::I2CSimOptions_t &options, QRandomGenerator *random)
+     : options(options), random(random), macrosLoaded(!options.coldBoot) {}
+
+    void writeRegisters(const uint32_t address, const int addressBytes,
+                        const uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        if (addressBytes == 3)
+        {
+            QByteArray *target = memory24(address);
+            if (!target) return;
+            for (size_t i = 0; i < nBytes; i++) (*target)[static_cast<int>((address + i) & 0xFFFF)] = static_cast<char>(data[i]);
+            if ((address >> 16) == MACRO_MEMORY_HI) macrosLoaded = true;
+            return;
+        }
+        for (size_t i = 0; i < nBytes; i++)
+        {
+            const uint16_t regAddress = static_cast<uint16_t>(address + i);
+            registers[regAddress] = data[i];
+            if (regAddress == REG_MACRO_CODE) macroStart(data[i], nowUs);
+        }
+    }
+
+    void readRegisters(const uint32_t address, const int addressBytes,
+                       uint8_t *data, const size_t nBytes, const qint64 nowUs) override
+    {
+        if (addressBytes == 3)
+        {
+            const QByteArray *source = memory24(address);
+            for (size_t i = 0; i < nBytes; i++)
+            {
+                data[i] = (source) ? static_cast<uint8_t>(source->at(static_cast<int>((address + i) & 0xFFFF))) : 0;
+            }
+            return;
+        }
+        for (size_t i = 0; i < nBytes; i++)
+        {
+            const uint16_t regAddress = static_cast<uint16_t>(address + i);
+            if (regAddress == REG_MACRO_CODE) macroPoll(nowUs);
+            data[i] = registers[regAddress];
+        }
+    }
+
+private:
+    static const uint16_t REG_MACRO_INPUT  = 0x0C00;
+    static const uint16_t REG_MACRO_CODE   = 0x0C10;
+    static const uint16_t REG_MACRO_OUTPUT = 0x0C11;
+    static const uint32_t MACRO_MEMORY_HI  = 0xFB;
+    static const uint32_t EYE_MEMORY_HI    = 0xFC;
+    static const int      EYE_MEMORY_SIZE  = 2048;      // Reported by macro 0x41
+    static const uint16_t TEMPERATURE_RAW  = 0x0309;    // About 45 C (see GT1724::GetTemperature)
+
+    typedef struct SimChecker_t
+    {
+        bool   enabled = false;
+        qint64 startUs = 0;
+    } SimChecker_t;
+
+    const I2CSimulator::I2CSimOptions_t options;
+    QRandomGenerator *random;
+    bool macrosLoaded;
+
+    QByteArray registers    = QByteArray(65536, 0);
+    QByteArray macroMemory  = QByteArray(65536, 0);
+    QByteArray eyeMemory    = QByteArray(65536, 0);
+
+    bool    macroRunning = false;
+    uint8_t macroCode = 0;
+    qint64  macroDoneUs = 0;
+    SimChecker_t checkers[2];    // ED 0 (lanes 0/1), ED 1 (lanes 2/3)
+
+    QByteArray *memory24(const uint32_t address)
+    {
+        if ((address >> 16) == MACRO_MEMORY_HI) return &macroMemory;
+        if ((address >> 16) == EYE_MEMORY_HI)   return &eyeMemory;
+        return nullptr;
+    }
+
+    uint8_t input(const int index) const   { return static_cast<uint8_t>(registers.at(REG_MACRO_INPUT + index)); }
+    void    output(const int index, const uint8_t value)  { registers[REG_MACRO_OUTPUT + index] = static_cast<char>(value); }
+
+    void macroStart(const uint8_t code, const qint64 nowUs)
+    {
+        macroCode = code;
+        macroRunning = true;
+        macroDoneUs = nowUs + macroRunTimeUs(code);
+    }
+
+    void macroPoll(const qint64 nowUs)
+    {
+        if (!macroRunning || nowUs < macroDoneUs) return;
+        macroRunning = false;
+        registers[REG_MACRO_CODE] = static_cast<char>(runMacro(macroCode, nowUs) ? 0x00 : 0x01);
+    }
+
+    /*!
+     \brief Approximate macro run time (uS)
+     Nb: Not measured from hardware; close enough to exercise the polling
+     back-off in GT1724::runMacroStatic.
+    */
+    qint64 macroRunTimeUs(const uint8_t code) const
+    {
+        switch (code)
+        {
+        case 0x18: return 200;     // Query macro version
+        case 0x28: return 2000;    // Temperature
+        case 0x41: return 200;     // Eye scan memory attributes
+        case 0x42: return 2000 + (eyeSweepPoints() * 25);  // Eye sweep
+        case 0x50: return 50000;   // Set up PRBS checker (locks to pattern)
+        case 0x53: return 300;     // Read PRBS checker counter
+        case 0x58: return 5000;    // PRBS generator options
+        case 0x61: return 3000;    // Output driver swing
+        default:   return 1000;
+        }
+    }
+
+    int eyeSweepPoints() const
+    {
+        const int phaseStep  = qMax(1, static_cast<int>(input(3)));
+        const int offsetStep = qMax(1, static_cast<int>(input(6)));
+        const int nPhase  = (input(2) >= input(1)) ? ((input(2) - input(1)) / phaseStep) + 1 : 0;
+        const int nOffset = (input(5) >= input(4)) ? ((input(5) - input(4)) / offsetStep) + 1 : 0;
+        return nPhase * nOffset;
+    }
+
+    /*!
+     \brief Carry out a macro (at the end of its run time)
+     Unknown macro codes succeed, with no output.
+     \return true: Macro OK; false: Macro error
+    */
+    bool runMacro(const uint8_t code, const qint64 nowUs)
+    {
+        switch (code)
+        {
+        case 0x18:   // Query macro version: Extension macros, or the ROM version if they haven't been downloaded
+        {
+            const globals::MacroFileInfo &info = globals::MACRO_FILES[globals::N_MACRO_FILES - 1];
+            for (int i = 0; i < 4; i++) output(i, static_cast<uint8_t>(info.macroVersion[i].unicode()));
+            if (!macrosLoaded) output(3, 0x00);
+            return true;
+        }
+        case 0x28:   // Temperature
+            output(0, TEMPERATURE_RAW >> 8);
+            output(1, TEMPERATURE_RAW & 0xFF);
+            return true;
+        case 0x41:   // Eye scan memory attributes: Address, size
+            output(0, 0x00);
+            output(1, 0x00);
+            output(2, static_cast<uint8_t>(EYE_MEMORY_SIZE >> 8));
+            output(3, static_cast<uint8_t>(EYE_MEMORY_SIZE & 0xFF));
+            return true;
+        case 0x42:
+            return eyeSweep();
+        case 0x50:   // PRBS checker options: Restarts the counters
+            registers[REG_MACRO_OUTPUT + 0x10] = static_cast<char>(input(0));   // Kept for 0x51 (past end of output buffer)
+            registers[REG_MACRO_OUTPUT + 0x11] = static_cast<char>(input(1));
+            checkers[0].enabled = (input(0) & 0x01) != 0;
+            checkers[1].enabled = (input(0) & 0x10) != 0;
+            checkers[0].startUs = nowUs;
+            checkers[1].startUs = nowUs;
+            return true;
+        case 0x51:
+            output(0, static_cast<uint8_t>(registers.at(REG_MACRO_OUTPUT + 0x10)));
+            output(1, static_cast<uint8_t>(registers.at(REG_MACRO_OUTPUT + 0x11)));
+            return true;
+        case 0x53:
+            checkerReading(input(0), nowUs);
+            return true;
+        case 0x58:   // PRBS generator options
+            registers[REG_MACRO_OUTPUT + 0x12] = static_cast<char>(input(0));
+            return true;
+        case 0x59:
+            output(0, static_cast<uint8_t>(registers.at(REG_MACRO_OUTPUT + 0x12)));
+            return true;
+        case 0x61:   // Output driver swing
+            for (int i = 0; i < 4; i++) registers[REG_MACRO_OUTPUT + 0x13 + i] = static_cast<char>(input(i));
+            return true;
+        case 0x69:
+            for (int i = 0; i < 4; i++) output(i, static_cast<uint8_t>(registers.at(REG_MACRO_OUTPUT + 0x13 + i)));
+            return true;
+        default:
+            return true;
+        }
+    }
+
+    /*!
+     \brief Query PRBS checker reading (macro 0x53)
+     Counts are totals since the checker was started, for a checker which
+     sees every other bit at the GT1724's nominal rate; errors follow the
+     bitErrorRatio option. Encoded as for GT1724::edBytesToDouble.
+    */
+    void checkerReading(const uint8_t checkerOptions, const qint64 nowUs)
+    {
+        const SimChecker_t &checker = checkers[checkerOptions & 0x01];
+        double value = 0.0;
+        if (checker.enabled)
+        {
+            const double CHECKER_BIT_RATE = 25.78125e9 / 2.0;
+            const double bits = (static_cast<double>(nowUs - checker.startUs) / 1e6) * CHECKER_BIT_RATE;
+            value = (checkerOptions & 0x02) ? bits : std::floor(bits * options.bitErrorRatio);
+        }
+        uint16_t exponent = 0;
+        while (value >= 1024.0 && exponent < 63)
+        {
+            value /= 2.0;
+            exponent++;
+        }
+        const uint16_t mantissa = static_cast<uint16_t>(value);
+        output(0, static_cast<uint8_t>((exponent << 2) | (mantissa >> 8)));
+        output(1, static_cast<uint8_t>(mantissa & 0xFF));
+    }
+
+    /*!
+     \brief Control eye sweep (macro 0x42)
+     Fills eye memory with counts for the requested points (rows of phase
+     steps, one row per offset step), packed MSB first at the requested
+     resolution. The eye is a smooth diamond-ish opening, with a little
+     noise on the edges.
+     \return false if the sweep won't fit in eye memory
+    */
+    bool eyeSweep()
+    {
+        const int nPoints = eyeSweepPoints();
+        const int phaseStep  = qMax(1, static_cast<int>(input(3)));
+        const int offsetStep = qMax(1, static_cast<int>(input(6)));
+        const int nPhase = (nPoints > 0) ? ((input(2) - input(1)) / phaseStep) + 1 : 0;
+        const int bitsPerPoint = 1 << (input(7) & 0x03);
+        const int maxCount = (1 << bitsPerPoint) - 1;
+        const int size = ((nPoints * bitsPerPoint) + 7) / 8;
+        if (nPoints == 0 || size > EYE_MEMORY_SIZE) return false;
+
+        memset(eyeMemory.data(), 0, EYE_MEMORY_SIZE);
+        for (int point = 0; point < nPoints; point++)
+        {
+            const int phase  = input(1) + ((point % nPhase) * phaseStep);
+            const int offset = input(4) + ((point / nPhase) * offsetStep);
+            const int count  = eyeCount(phase, offset, maxCount);
+            const int bit    = point * bitsPerPoint;
+            const int shift  = 8 - bitsPerPoint - (bit % 8);
+            eyeMemory[bit / 8] = static_cast<char>(static_cast<uint8_t>(eyeMemory.at(bit / 8)) | (count << shift));
+        }
+        output(0, static_cast<uint8_t>(size >> 8));
+        output(1, static_cast<uint8_t>(size & 0xFF));
+        return true;
+    }
+
+    int eyeCount(const int phase, const int offset, const int maxCount)
+    {
+        const double EYE_WIDTH  = 0.7;   // Half width (fraction of UI / 2)
+        const double EYE_HEIGHT = 0.6;   // Half height at the centre (fraction of offset range / 2)
+        const double EDGE       = 0.08;  // Width of the transition at the edge of the eye
+        const double x = (static_cast<double>(phase) - 64.0) / 64.0;
+        const double y = (static_cast<double>(offset) - 64.0) / 63.0;
+        const double opening = EYE_HEIGHT * (1.0 - ((x * x) / (EYE_WIDTH * EYE_WIDTH)));
+        const double noise = (random->generateDouble() - 0.5) * EDGE * 0.5;
+        double level = ((std::fabs(y) - opening) + noise + (EDGE / 2.0)) / EDGE;
+        if (level < 0.0) level = 0.0;
+        if (level > 1.0) level = 1.0;
+        return static_cast<int>(std::lround(level * maxCount));
+    }
+};
+
+
+
+
+I2CSimulator::I2CSimulator(QObject *parent)
+ : responseTimer(this)
+{
+    Q_UNUSED(parent)   // Nb: Owned by I2CCommsWorker (as for Serial)
+    responseTimer.setSingleShot(true);
+    responseTimer.setTimerType(Qt::PreciseTimer);
+    connect(&responseTimer, SIGNAL(timeout()), this, SLOT(responseReady()));
+}
+
+I2CSimulator::~I2CSimulator()
+{
+    close();
+}
+
+
+/*!
+ \brief Open the simulator
+ Sets up the component models (fresh state for each open, as for a power
+ cycled board).
+ \param portName  "SIM", optionally followed by options (see class description)
+ \return globals::OK
+ \return globals::INVALID_DATA  Unrecognised option in portName
+*/
+int I2CSimulator::open(const QString portName)
+{
+    if (portOpen) return globals::OK;  // Already open...
+    int result = parseOptions(portName);
+    if (result != globals::OK) return result;
+    random.seed(options.seed);
+    createDevices();
+    clock.start();
+    latencyCarryUs = 0;
+    portOpen = true;
+    qDebug() << "SIM: Simulated adaptor open (" << portName << ")";
+    return globals::OK;
+}
+
+
+void I2CSimulator::close()
+{
+    transactionCancel();
+    deleteDevices();
+    portOpen = false;
+}
+
+
+/*!
+ \brief Get transport capabilities: Same limits as the USB-ISS adaptor
+*/
+I2CTransportCapabilities_t I2CSimulator::getCapabilities() const
+{
+    I2CTransportCapabilities_t caps;
+    caps.name = QString("USB-ISS (Simulated)");
+    caps.baudRate = (options.baudRate > 0) ? options.baudRate : Serial::USB_ISS_BAUD_RATE;
+    caps.supportedBaudRates = QList<qint32>() << caps.baudRate;
+    caps.maxFrameWrite = Serial::USB_ISS_FRAME_WRITE_MAX;
+    caps.maxFrameRead = Serial::USB_ISS_FRAME_READ_MAX;
+    caps.maxWriteBlockSize = Serial::USB_ISS_WRITE_BLOCK_MAX;
+    caps.maxReadBlockSize = Serial::USB_ISS_READ_BLOCK_MAX;
+    return caps;
+}
+
+
+/*!
+ \brief Start a transaction
+ The frame is carried out straight away; the response is delivered
+ (and transactionFinished emitted) after the modelled latency. As with the
+ real adaptor, if the response doesn't match the expected size (or an
+ injected timeout drops the frame), the transaction doesn't finish and the
+ caller's timeout applies.
+ For parameters, see Serial::transactionStart.
+*/
+void I2CSimulator::transactionStart(const uint8_t *data, const size_t nBytesData,
+                                    const size_t nBytesResponseExpected, uint8_t *responseData,
+                                    const size_t nBytesResponseHeader, uint8_t *responseHeader)
+{
+    Q_ASSERT(nBytesResponseHeader <= nBytesResponseExpected);
+    Q_ASSERT(nBytesResponseHeader == 0 || responseHeader);
+    if (transactionActive)
+    {
+        qDebug() << "SIM: Port BUSY!";
+        return;
+    }
+    if (!portOpen) return;
+
+    nBytesReceived = 0;
+    nBytesHeader = (responseHeader) ? nBytesResponseHeader : 0;
+    headerBuffer = responseHeader;
+    responseBuffer = responseData;
+    nBytesExpected = nBytesResponseExpected;
+    transactionActive = true;
+    pendingResponse.clear();
+
+    if (chance(options.timeoutRate)) return;   // Injected timeout: Frame lost
+
+    qint64 busBytes = 0;
+    if (!runFrame(data, nBytesData, pendingResponse, busBytes))
+    {
+        qDebug() << "SIM: Unrecognised or truncated adaptor frame (" << nBytesData << " bytes); No response.";
+        return;
+    }
+    if (static_cast<size_t>(pendingResponse.size()) < nBytesExpected)
+    {
+        qDebug() << "SIM: Response is " << pendingResponse.size() << " bytes; Caller expects " << nBytesExpected;
+        return;
+    }
+    pendingResponse.truncate(static_cast<int>(nBytesExpected));   // Nb: Serial discards extra bytes
+
+    int delayMs = 0;
+    if (!options.instant)
+    {
+        const qint32 baudRate = (options.baudRate > 0) ? options.baudRate : Serial::USB_ISS_BAUD_RATE;
+        const qint64 linkBits = static_cast<qint64>(nBytesData + nBytesExpected) * 10;
+        latencyCarryUs += ADAPTOR_OVERHEAD_US
+                        + ((linkBits * 1000000) / baudRate)
+                        + ((busBytes * 9 * 1000000) / I2C_BUS_SPEED);
+        delayMs = static_cast<int>(latencyCarryUs / 1000);
+        latencyCarryUs -= static_cast<qint64>(delayMs) * 1000;
+    }
+    responseTimer.start(delayMs);
+}
+
+
+void I2CSimulator::transactionCancel()
+{
+    responseTimer.stop();
+    transactionActive = false;
+    nBytesExpected = 0;
+    nBytesReceived = 0;
+    headerBuffer = nullptr;
+    responseBuffer = nullptr;
+}
+
+
+
+
+////////////// PRIVATE: ////////////////////////////////////////////////////////////
+
+/*!
+ \brief Deliver the response for the current transaction
+*/
+void I2CSimulator::responseReady()
+{
+    if (!transactionActive) return;
+    const uint8_t *response = reinterpret_cast<const uint8_t *>(pendingResponse.constData());
+    if (nBytesHeader > 0) memcpy(headerBuffer, response, nBytesHeader);
+    if (responseBuffer) memcpy(responseBuffer, response + nBytesHeader, nBytesExpected - nBytesHeader);
+    nBytesReceived = nBytesExpected;
+    transactionActive = false;
+    nBytesExpected = 0;
+    emit transactionFinished();
+}
+
+
+/*!
+ \brief Read options from the port name (see class description)
+ \return globals::OK
+ \return globals::INVALID_DATA  Unrecognised option or bad value
+*/
+int I2CSimulator::parseOptions(const QString &portName)
+{
+    options = I2CSimOptions_t();
+    const QString optionText = portName.section(':', 1);
+    if (optionText.isEmpty()) return globals::OK;
+    foreach (const QString &option, optionText.split(',', QString::SkipEmptyParts))
+    {
+        const QString name  = option.section('=', 0, 0).trimmed().toLower();
+        const QString value = option.section('=', 1).trimmed();
+        bool ok = true;
+        if      (name == "nack")    options.nackRate = value.toDouble(&ok);
+        else if (name == "timeout") options.timeoutRate = value.toDouble(&ok);
+        else if (name == "ber")     options.bitErrorRatio = value.toDouble(&ok);
+        else if (name == "baud")    options.baudRate = value.toInt(&ok);
+        else if (name == "seed")    options.seed = value.toUInt(&ok);
+        else if (name == "model")   options.modelCode = value;
+        else if (name == "cold")    options.coldBoot = true;
+        else if (name == "instant") options.instant = true;
+        else                        ok = false;
+        if (!ok || (name == "baud" && options.baudRate <= 0))
+        {
+            qDebug() << "SIM: Invalid option: " << option;
+            return globals::INVALID_DATA;
+        }
+    }
+    return globals::OK;
+}
+
+
+/*!
+ \brief Set up the board: One of each component, on the BertModel addresses
+*/
+void I2CSimulator::createDevices()
+{
+    deleteDevices();
+    addDevice(new SimGT1724(options, &random),  BertModel::GetI2CAddresses_GT1724());
+    addDevice(new SimLMX2594(),                 BertModel::GetI2CAddresses_LMX2594());
+    addDevice(new SimSI5340(),                  BertModel::GetI2CAddresses_SI5340());
+    addDevice(new SimRegisterDevice(0xFF),      BertModel::GetI2CAddresses_PCA9557A());
+    addDevice(new SimRegisterDevice(0xFF),      BertModel::GetI2CAddresses_PCA9557B());
+    addDevice(new SimRegisterDevice(0x1F),      BertModel::GetI2CAddresses_TLC59108());   // Nb: Top 3 bits are auto-increment flags
+
+    eeprom.reset(new SimM24M02Memory());
+    eeprom->seed(options.modelCode);
+    foreach (uint8_t address, BertModel::GetI2CAddresses_M24M02())
+    {
+        for (int page = 0; page < 4; page++)
+        {
+            addDevice(new SimM24M02Page(eeprom.get(), page), QList<uint8_t>() << static_cast<uint8_t>(address + page));
+        }
+        break;   // Nb: One EEPROM
+    }
+}
+
+
+void I2CSimulator::deleteDevices()
+{
+    deviceMap.clear();
+    qDeleteAll(devices);
+    devices.clear();
+    eeprom.reset();
+}
+
+
+/*!
+ \brief Add a device on its first address
+ Nb: Only the first address of each list is used (single-core board)
+*/
+void I2CSimulator::addDevice(I2CSimDevice *device, const QList<uint8_t> &addresses)
+{
+    devices.append(device);
+    if (!addresses.isEmpty() && !deviceMap.contains(addresses.first())) deviceMap[addresses.first()] = device;
+}
+
+
+/*!
+ \brief Find the device on an address
+ \return Device, or nullptr if there is no device on the address or it is busy (no ACK)
+*/
+I2CSimDevice *I2CSimulator::findDevice(const uint8_t address, const qint64 nowUs) const
+{
+    I2CSimDevice *device = deviceMap.value(address, nullptr);
+    if (device && device->isBusy(nowUs)) return nullptr;
+    return device;
+}
+
+
+/*!
+ \brief Carry out an adaptor frame (one or more commands)
+ \param data      Frame
+ \param nBytes    Size of frame
+ \param response  Response bytes are appended
+ \param busBytes  Set to the number of bytes which went over the I2C bus
+ \return true: Frame OK; false: Unrecognised command or truncated frame (no response)
+*/
+bool I2CSimulator::runFrame(const uint8_t *data, const size_t nBytes, QByteArray &response, qint64 &busBytes)
+{
+    const qint64 now = nowUs();
+    size_t pos = 0;
+    while (pos < nBytes)
+    {
+        const uint8_t command = data[pos];
+        size_t headerSize;
+        switch (command)
+        {
+        case SIM_ISS_CMD:
+            if (pos + 1 >= nBytes) return false;
+            switch (data[pos + 1])
+            {
+            case 0x01:   // Version: Module ID, firmware version, mode
+                response.append(static_cast<char>(7)).append(static_cast<char>(7)).append(static_cast<char>(64));
+                pos += 2;
+                break;
+            case 0x02:   // Set mode
+                if (pos + 4 > nBytes) return false;
+                response.append(static_cast<char>(0xFF)).append(static_cast<char>(0x00));
+                pos += 4;
+                break;
+            case 0x03:   // Serial number (8 ASCII characters)
+                response.append("SIM00001");
+                pos += 2;
+                break;
+            default:
+                return false;
+            }
+            continue;
+
+        case SIM_I2C_TST:
+            if (pos + 2 > nBytes) return false;
+            response.append(static_cast<char>(findDevice(SIM_ADDRESS(data[pos + 1]), now) ? 0x01 : 0x00));
+            busBytes += 1;
+            pos += 2;
+            continue;
+
+        case SIM_I2C_DIR:
+        {
+            const size_t used = runDirect(data + pos + 1, nBytes - pos - 1, response, busBytes);
+            if (used == 0) return false;
+            pos += 1 + used;
+            continue;
+        }
+
+        case SIM_I2C_SGL:  headerSize = 2;  break;
+        case SIM_I2C_AD0:  headerSize = 3;  break;
+        case SIM_I2C_AD1:  headerSize = 4;  break;
+        case SIM_I2C_AD2:  headerSize = 5;  break;
+        default:
+            return false;
+        }
+
+        // Read / write commands: [Command][Address + R/W]([Register address])([Count])[Data]
+        if (pos + headerSize > nBytes) return false;
+        const uint8_t addressRW = data[pos + 1];
+        const int addressBytes = (command == SIM_I2C_SGL) ? 0 : static_cast<int>(headerSize) - 3;   // AD0: 0; AD1: 1; AD2: 2
+        uint32_t regAddress = 0;
+        for (int i = 0; i < addressBytes; i++) regAddress = (regAddress << 8) | data[pos + 2 + i];
+        const size_t count = (command == SIM_I2C_SGL) ? 1 : data[pos + headerSize - 1];
+        I2CSimDevice *device = findDevice(SIM_ADDRESS(addressRW), now);
+        busBytes += 1 + addressBytes + static_cast<qint64>(count);
+
+        if (SIM_IS_READ(addressRW))
+        {
+            QByteArray readData(static_cast<int>(count), 0);
+            uint8_t *readBuffer = reinterpret_cast<uint8_t *>(readData.data());
+            if (device && addressBytes == 0) device->readRaw(readBuffer, count, now);
+            else if (device)                 device->readRegisters(regAddress, addressBytes, readBuffer, count, now);
+            response.append(readData);
+            pos += headerSize;
+        }
+        else
+        {
+            if (pos + headerSize + count > nBytes) return false;
+            const uint8_t *writeData = data + pos + headerSize;
+            const bool ack = (device != nullptr) && !chance(options.nackRate);
+            if (ack && addressBytes == 0) device->writeRaw(writeData, count, now);
+            else if (ack)                 device->writeRegisters(regAddress, addressBytes, writeData, count, now);
+            response.append(static_cast<char>(ack ? 0x01 : 0x00));
+            pos += headerSize + count;
+        }
+    }
+    return true;
+}
+
+
+/*!
+ \brief Carry out an I2C_DIR sequence (see I2CComms::write24, read24)
+ After a start (or restart), the first byte written is the slave address;
+ further bytes written are the register address (3 bytes) and data. Reads
+ follow a restart, from the register address written before it.
+ Response: Status (0xFF: OK; 0x00: NACK), error code, then the data read.
+ \param data      Sub-commands (after the I2C_DIR command byte)
+ \param nBytes    Bytes left in the frame
+ \param response  Response bytes are appended
+ \param busBytes  Incremented by the number of bytes on the I2C bus
+ \return Number of bytes used (up to and including the stop); 0 if the sequence is invalid
+*/
+size_t I2CSimulator::runDirect(const uint8_t *data, const size_t nBytes, QByteArray &response, qint64 &busBytes)
+{
+    const int DIRECT_ADDRESS_BYTES = 3;
+    const qint64 now = nowUs();
+    const bool nack = chance(options.nackRate);
+    I2CSimDevice *device = nullptr;
+    bool addressPending = false;   // Next byte written is a slave address
+    bool ack = !nack;
+    QByteArray written;            // Register address + data, since the last (re)start
+    QByteArray readData;
+    uint32_t readAddress = 0;
+    bool readAddressSet = false;
+
+    size_t pos = 0;
+    while (pos < nBytes)
+    {
+        const uint8_t sub = data[pos++];
+        if (sub == 0x01 || sub == 0x02)          // Start / restart
+        {
+            addressPending = true;
+        }
+        else if (sub == 0x03)                    // Stop: Complete any write
+        {
+            if (ack && device && !readAddressSet && written.size() > DIRECT_ADDRESS_BYTES)
+            {
+                uint32_t address = 0;
+                for (int i = 0; i < DIRECT_ADDRESS_BYTES; i++) address = (address << 8) | static_cast<uint8_t>(written.at(i));
+                device->writeRegisters(address, DIRECT_ADDRESS_BYTES,
+                                       reinterpret_cast<const uint8_t *>(written.constData()) + DIRECT_ADDRESS_BYTES,
+                                       static_cast<size_t>(written.size() - DIRECT_ADDRESS_BYTES), now);
+            }
+            response.append(static_cast<char>(ack ? 0xFF : 0x00)).append(static_cast<char>(ack ? 0x00 : 0x02));
+            response.append(readData);
+            return pos;
+        }
+        else if (sub == 0x04)                    // NACK before the last read byte
+        {
+        }
+        else if ((sub & 0xF0) == 0x30)           // Write n + 1 bytes
+        {
+            const size_t count = (sub & 0x0F) + 1;
+            if (pos + count > nBytes) return 0;
+            for (size_t i = 0; i < count; i++)
+            {
+                const uint8_t byte = data[pos + i];
+                if (addressPending)
+                {
+                    addressPending = false;
+                    device = findDevice(SIM_ADDRESS(byte), now);
+                    if (!device) ack = false;
+                    if (SIM_IS_READ(byte) && !readAddressSet)
+                    {
+                        for (int a = 0; a < written.size() && a < DIRECT_ADDRESS_BYTES; a++) readAddress = (readAddress << 8) | static_cast<uint8_t>(written.at(a));
+                        readAddressSet = true;
+                    }
+                }
+                else
+                {
+                    written.append(static_cast<char>(byte));
+                }
+            }
+            busBytes += static_cast<qint64>(count);
+            pos += count;
+        }
+        else if ((sub & 0xF0) == 0x20)           // Read n + 1 bytes
+        {
+            const size_t count = (sub & 0x0F) + 1;
+            QByteArray block(static_cast<int>(count), 0);
+            if (ack && device && readAddressSet)
+            {
+                device->readRegisters(readAddress + static_cast<uint32_t>(readData.size()), DIRECT_ADDRESS_BYTES,
+                                      reinterpret_cast<uint8_t *>(block.data()), count, now);
+            }
+            readData.append(block);
+            busBytes += static_cast<qint64>(count);
+        }
+        else
+        {
+            return 0;
+        }
+    }
+    return 0;   // No stop
+}
+
+
+/*!
+ \brief Fault injection: Returns true with the given probability
+*/
+bool I2CSimulator::chance(const double probability)
+{
+    if (probability <= 0.0) return false;
+    return random.generateDouble() < probability;
+}
@@ -0,0 +1,141 @@
+/*!
+ \file   I2CSimulator.h
+ \brief  Simulated I2C Adaptor Transport - Header
+         Stands in for the USB-ISS adaptor and the instrument's I2C
+         components, so that the back end can run (and be timed) without
+         hardware.
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#ifndef I2CSIMULATOR_H
+#define I2CSIMULATOR_H
+
+#include <memory>
+#include <QObject>
+#include <QString>
+#include <QByteArray>
+#include <QList>
+#include <QMap>
+#include <QTimer>
+#include <QElapsedTimer>
+#include <QRandomGenerator>
+
+#include "I2CTransport.h"
+
+class I2CSimDevice;
+class SimM24M02Memory;
+
+/*!
+ \brief Simulated I2C Transport (I2CTransport::TRANSPORT_SIMULATED)
+
+ Accepts the same adaptor command frames as the USB-ISS (I2C_AD0, I2C_AD1,
+ I2C_AD2, I2C_DIR, I2C_TST, I2C_SGL and the ISS_CMD version / mode / serial
+ commands, including several commands packed into one frame) and answers
+ them from models of the components on the board:
+
+   GT1724     Register space, extension macros (version, temperature,
+              PRBS / swing / ED options, ED counters, eye sweep) and
+              macro / eye memory (24 bit addresses)
+   LMX2594    Behind the SC18IS602B I2C to SPI bridge; R110 reports lock
+   SI5340     Paged registers
+   M24M02     Four 64 kB pages; NACKs during the write cycle. Seeded with
+              a model code and a set of frequency profiles.
+   PCA9557A / PCA9557B / TLC59108   Plain 8 bit register devices
+
+ Devices are placed on the default addresses from BertModel, i.e. the
+ single-core board.
+
+ Each response is delivered after the time the real adaptor would take:
+ the frame and response at the link baud rate (10 bits per byte), the
+ I2C bytes at I2C_BUS_SPEED, and ADAPTOR_OVERHEAD_US per frame. Macros
+ take a time which depends on the macro (see SimGT1724::macroRunTimeUs),
+ so status polling behaves as it does on hardware.
+
+ Options are given in the port name:  SIM[:option,option,...]
+   nack=<p>      Probability that a write (or I2C_DIR sequence) is NACKed
+   timeout=<p>   Probability that a frame gets no response at all
+   ber=<r>       Bit error ratio seen by the error detectors (default 1e-12)
+   baud=<n>      Link baud rate (default: USB-ISS rate)
+   model=<code>  Model code stored in the EEPROM (default PPG3204D_PIXIE)
+   seed=<n>      Seed for fault injection and measurement noise
+   cold          GT1724 extension macros are not resident (forces download)
+   instant       No latency model: respond as soon as possible
+ E.g.  SIM:nack=0.001,cold
+*/
+class I2CSimulator : public I2CTransport
+{
+Q_OBJECT
+
+public:
+    I2CSimulator(QObject *parent);
+    ~I2CSimulator() override;
+
+    static const char PORT_NAME[];                  // Port name prefix which selects the simulator ("SIM")
+
+    static const int ADAPTOR_OVERHEAD_US = 250;     // Adaptor processing time per frame
+    static const int I2C_BUS_SPEED       = 100000;  // I2C clock (Hz; see I2CCommsWorker::I2C_OP_SET_MODE)
+
+    int    open(const QString portName) override;
+    void   close() override;
+    bool   isOpen() override { return portOpen; }
+    size_t getBytesReceived() const override { return nBytesReceived; }
+    I2CTransportCapabilities_t getCapabilities() const override;
+
+    // Simulation options (see class description):
+    typedef struct I2CSimOptions_t
+    {
+        double   nackRate = 0.0;
+        double   timeoutRate = 0.0;
+        double   bitErrorRatio = 1e-12;
+        qint32   baudRate = 0;          // 0: Use the USB-ISS rate
+        QString  modelCode = QString("PPG3204D_PIXIE");
+        quint32  seed = 1;
+        bool     coldBoot = false;
+        bool     instant = false;
+    } I2CSimOptions_t;
+
+public slots:
+    void transactionStart(const uint8_t *data, const size_t nBytesData,
+                          const size_t nBytesResponseExpected, uint8_t *responseData,
+                          const size_t nBytesResponseHeader = 0, uint8_t *responseHeader = nullptr) override;
+    void transactionCancel() override;
+
+private slots:
+    void responseReady();
+
+private:
+    int    parseOptions(const QString &portName);
+    void   createDevices();
+    void   deleteDevices();
+    void   addDevice(I2CSimDevice *device, const QList<uint8_t> &addresses);
+    I2CSimDevice *findDevice(const uint8_t address, const qint64 nowUs) const;
+
+    bool   runFrame(const uint8_t *data, const size_t nBytes, QByteArray &response, qint64 &busBytes);
+    size_t runDirect(const uint8_t *data, const size_t nBytes, QByteArray &response, qint64 &busBytes);
+    bool   chance(const double probability);
+    qint64 nowUs() const { return clock.nsecsElapsed() / 1000; }
+
+    I2CSimOptions_t options;
+    bool portOpen = false;
+
+    QList<I2CSimDevice *> devices;               // Owned
+    QMap<uint8_t, I2CSimDevice *> deviceMap;     // By 7 bit address (one device may have several addresses)
+    std::unique_ptr<SimM24M02Memory> eeprom;     // Shared by the EEPROM's page addresses
+
+    QElapsedTimer    clock;                      // Time base for device models
+    QRandomGenerator random;
+    QTimer           responseTimer;              // Delivers the response after the modelled latency
+    qint64           latencyCarryUs = 0;         // Part of a mS not yet used by responseTimer (keeps the mean latency right)
+
+    // Transaction in progress:
+    QByteArray pendingResponse;
+    bool       transactionActive = false;
+    size_t     nBytesExpected = 0;
+    size_t     nBytesReceived = 0;
+    size_t     nBytesHeader = 0;
+    uint8_t   *headerBuffer = nullptr;
+    uint8_t   *responseBuffer = nullptr;
+};
+
+#endif // I2CSIMULATOR_H
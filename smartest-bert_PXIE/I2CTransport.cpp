@@ -0,0 +1,48 @@
+/*!
+ \file   I2CTransport.cpp
+ \brief  I2C Adaptor Transport Interface
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#include <QDebug>
+
+#include "globals.h"
+#include "I2CTransport.h"
+#include "Serial.h"
+#include "I2CSimulator.h"
+
+
+/*!
+ \brief Create a transport
+ \param transportType  Type of transport (e.g. I2CTransport::TRANSPORT_USB_ISS)
+ \param parent         Parent object for the transport
+ \return Pointer to new transport (owned by caller), or nullptr if the type is unknown
+*/
+I2CTransport *I2CTransport::create(const int transportType, QObject *parent)
+{
+    switch (transportType)
+    {
+    case TRANSPORT_USB_ISS:
+        return new Serial(parent);
+    case TRANSPORT_SIMULATED:
+        return new I2CSimulator(parent);
+    default:
+        qDebug() << "I2CTransport: Unknown transport type " << transportType;
+        return nullptr;
+    }
+}
+
+
+/*!
+ \brief Get the transport type for a port name
+ \param portName  Port name, e.g. "COM3", or "SIM" (with or without
+                  simulator options, e.g. "SIM:nack=0.01")
+ \return I2CTransport::TRANSPORT_SIMULATED if the port name selects the
+         simulator; otherwise I2CTransport::TRANSPORT_USB_ISS
+*/
+int I2CTransport::portTransportType(const QString &portName)
+{
+    if (portName.section(':', 0, 0).compare(I2CSimulator::PORT_NAME, Qt::CaseInsensitive) == 0) return TRANSPORT_SIMULATED;
+    return TRANSPORT_USB_ISS;
+}
@@ -0,0 +1,83 @@
+/*!
+ \file   I2CTransport.h
+ \brief  I2C Adaptor Transport Interface - Header
+         Abstract link between I2CComms and the adaptor hardware. I2CComms
+         (via I2CCommsWorker) builds adaptor command frames and hands them to
+         a transport, which writes them out and collects the response.
+ \author Smartest BERT software team
+ \date   Oct 2026
+*/
+
+#ifndef I2CTRANSPORT_H
+#define I2CTRANSPORT_H
+
+#include <QObject>
+#include <QString>
+#include <QList>
+
+/*!
+ \brief Transport Capabilities
+ Limits and settings of a transport; I2CComms and device classes query
+ these instead of hard-coding adaptor limits.
+*/
+typedef struct I2CTransportCapabilities_t
+{
+    QString        name;                      // Description of the transport (for logging)
+    qint32         baudRate = 0;              // Link speed used (bits / S; 0 if not applicable)
+    QList<qint32>  supportedBaudRates;        // Link speeds the transport can use (empty if not applicable)
+    size_t         maxFrameWrite = 0;         // Largest command frame which can be written in one transaction (bytes)
+    size_t         maxFrameRead = 0;          // Largest response which can be read in one transaction (bytes)
+    uint8_t        maxWriteBlockSize = 0;     // Largest data block for a single I2C register write (bytes)
+    uint8_t        maxReadBlockSize = 0;      // Largest data block for a single I2C register read (bytes)
+} I2CTransportCapabilities_t;
+
+
+/*!
+ \brief I2C Transport Interface
+
+ A transport carries adaptor command frames (see the USB-ISS command set
+ used by I2CComms) to the hardware and returns the response. Transactions
+ are asynchronous: transactionStart writes the frame, and the transport
+ emits transactionFinished once the expected number of response bytes
+ has been received into the caller's buffer(s).
+
+ Implementations:
+   Serial        USB-ISS adaptor on a virtual serial port (TRANSPORT_USB_ISS)
+   I2CSimulator  Simulated adaptor and board, no hardware (TRANSPORT_SIMULATED)
+
+ Use I2CTransport::create to make a transport of the required type;
+ portTransportType picks the type from a port name.
+*/
+class I2CTransport : public QObject
+{
+Q_OBJECT
+
+public:
+    // Transport Types:
+    static const int TRANSPORT_USB_ISS   = 0;   // USB-ISS USB to I2C adaptor (virtual serial port)
+    static const int TRANSPORT_SIMULATED = 1;   // Simulated adaptor (see I2CSimulator)
+
+    static I2CTransport *create(const int transportType, QObject *parent);
+    static int portTransportType(const QString &portName);
+
+    I2CTransport(QObject *parent = nullptr) : QObject(parent) {}
+    virtual ~I2CTransport() {}
+
+    virtual int    open(const QString portName) = 0;
+    virtual void   close() = 0;
+    virtual bool   isOpen() = 0;
+    virtual size_t getBytesReceived() const = 0;
+    virtual I2CTransportCapabilities_t getCapabilities() const = 0;
+
+public slots:
+    virtual void transactionStart(const uint8_t *data, const size_t nBytesData,
+                                  const size_t nBytesResponseExpected, uint8_t *responseData,
+                                  const size_t nBytesResponseHeader = 0, uint8_t *responseHeader = nullptr) = 0;
+    virtual void transactionCancel() = 0;
+
+signals:
+    void transactionFinished();
+
+};
+
+#endif // I2CTRANSPORT_H
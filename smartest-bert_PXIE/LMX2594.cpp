@@ -11,18 +11,14 @@
 #include "BertFile.h"
 
 #include "LMX2594.h"
+#include "BertLog.h"
 
 
-// Debug macro for general debug mesages from LMX
+// Debug macros for LMX: General messages, and frequency profile details
+// (BertLog::LOG_LMX debug / trace; e.g. "--log lmx=trace" to see profiles)
 // #define LMX_REGISTER_DEBUG
-// #define LMX_PROFILE_DEBUG
-#define DEBUG_LMX(MSG) qDebug() << "\t" << MSG;
-
-#ifdef LMX_PROFILE_DEBUG
-  #define DEBUG_LMX_PROFILES(MSG) qDebug() << "\t" << MSG;
-#else
-  #define DEBUG_LMX_PROFILES(MSG)
-#endif
+#define DEBUG_LMX(MSG)          BERT_LOG(LOG_LMX, LEVEL_DEBUG, "\t" << MSG)
+#define DEBUG_LMX_PROFILES(MSG) BERT_LOG(LOG_LMX, LEVEL_TRACE, "\t" << MSG)
 
 // Enable Lock Detect Pin: Define the following to set up MUXout pin as Lock Detect;
 // If not defined, MUXout will be set up as MISO serial out. Pin MUST be set up as
@@ -60,9 +56,6 @@ const size_t LMX2594::DEFAULT_FOUT_POWER_INDEX = 0;    // Default power setting
 const size_t LMX2594::DEFAULT_TRIG_POWER_INDEX = 1;    // Default power setting for trigger out (5 DBM)
 
 
-QList<LMXFrequencyProfile> LMX2594::frequencyProfiles = QList<LMXFrequencyProfile>();
-QStringList LMX2594::frequencyList = QStringList();
-uint16_t LMX2594::profileIndexDefault = 0;    // Index of default start-up frequency profile
 // DEPRECATED int LMX2594::instanceCount = 0;
 // DEPRECATED bool LMX2594::frequencyProfilesOK = false;
 
@@ -320,7 +313,7 @@ int LMX2594::init()
     // Nb: We assume the profiles were already sorted in ascending order
     // of frequency when stored to EEPROM!
     int index = 0;
-    foreach (LMXFrequencyProfile profile, frequencyProfiles)
+    foreach (const LMXFrequencyProfile &profile, frequencyProfiles)
     {
         float thisFrequency = profile.getFrequency();
         frequencyList.append(
@@ -535,10 +528,12 @@ void LMX2594::LMXEEPROMWriteFrequencyProfiles()
 
 /*!
  \brief Verify Frequency Profiles
- Check whether frequencies read from TCS files match those read from EEPROM.
+ Check whether frequency profiles read from TCS files match those stored in EEPROM.
  This should be TRUE once frequencies have been written to EEPROM with
- LMXEEPROMWriteFrequencyProfiles signal, then the profiles have been reloaded
- from EEPROM by disconnect followed by reconnect (with same TCS files in clockdefs dir).
+ LMXEEPROMWriteFrequencyProfiles signal.
+ Uses the fast check in M24M02::verifyFrequencyProfiles (compares the checksum
+ stored with each profile); only profiles which fail that are read back in full
+ and compared register by register (see compareFrequencyProfile).
 */
 void LMX2594::LMXVerifyFrequencyProfiles()
 {
@@ -546,79 +541,38 @@ void LMX2594::LMXVerifyFrequencyProfiles()
     qDebug() << "===================================";
     qDebug() << " Verify LMX Frequency Profiles:";
     qDebug() << "===================================";
-    qDebug() << "Check Count: " << frequencyProfilesFromFiles.count() << " from FILES; "
-                                << frequencyProfiles.count() << " from EEPROM";
-    if (frequencyProfilesFromFiles.count() == frequencyProfiles.count())
-    {
-        qDebug() << "--OK.";
-    }
-    else
+
+    QMap<int, LMXFrequencyProfile> mismatchedProfiles;
+    int storedCount = 0;
+    int result = eeprom->verifyFrequencyProfiles(0, frequencyProfilesFromFiles, mismatchedProfiles, &storedCount);
+
+    if (result == globals::INVALID_DATA)
     {
         qDebug() << "--Count of frequencies not the same!";
         emit ShowMessage(QString("Verify FAILED: Number of profiles is different (%1 in FILES; %2 in EEPROM)")
                          .arg(frequencyProfilesFromFiles.count())
-                         .arg(frequencyProfiles.count()));
+                         .arg(storedCount));
         emit Result(globals::GEN_ERROR, globals::ALL_LANES);
         return;
     }
-
-    for (int index = 0; index < frequencyProfilesFromFiles.count(); index++)
+    if (result == globals::BAD_CHECKSUM && !mismatchedProfiles.isEmpty())
     {
-        qDebug() << "Check Profile " << index
-                 << ": Freq from FILE = " << frequencyProfilesFromFiles[index].getFrequency()
-                 << "; Freq from EEPROM = " << frequencyProfiles[index].getFrequency();
-
-        if (static_cast<int>(frequencyProfilesFromFiles[index].getFrequency())
-         == static_cast<int>(frequencyProfiles[index].getFrequency()))
-        {
-            qDebug() << "--Frequencies match.";
-        }
-        else
-        {
-            qDebug() << "--Frequencies not the same!";
-            emit ShowMessage(QString("Verify FAILED: Profile frequency is different at profile %1 (%2 in FILES; %3 in EEPROM)")
-                             .arg(index)
-                             .arg(static_cast<double>(frequencyProfilesFromFiles[index].getFrequency()))
-                             .arg(static_cast<double>(frequencyProfiles[index].getFrequency())));
-            emit Result(globals::GEN_ERROR, globals::ALL_LANES);
-            return;
-        }
-
-        if (frequencyProfilesFromFiles[index].getRegisterCount()
-         == frequencyProfiles[index].getRegisterCount())
-        {
-            qDebug() << "--Register counts match.";
-        }
-        else
-        {
-            qDebug() << "--Different number of registers!";
-            emit ShowMessage(QString("Verify FAILED: Number of registers is different at profile %1 (%2 in FILES; %3 in EEPROM)")
-                             .arg(index)
-                             .arg(frequencyProfilesFromFiles[index].getRegisterCount())
-                             .arg(frequencyProfiles[index].getRegisterCount()));
-            emit Result(globals::GEN_ERROR, globals::ALL_LANES);
-            return;
-        }
-        qDebug() << "Compare register values for Profile " << index << "...";
-        for (int regAddr = 0; regAddr < frequencyProfilesFromFiles[index].getRegisterCount(); regAddr++)
+        // Report the first profile which is different:
+        const int index = mismatchedProfiles.firstKey();
+        if (compareFrequencyProfile(index, frequencyProfilesFromFiles[index], mismatchedProfiles.first()))
         {
-            bool regFound;
-            uint16_t regValueFile = frequencyProfilesFromFiles[index].getRegisterValue(static_cast<uint8_t>(regAddr), &regFound);
-            uint16_t regValueEEPROM = frequencyProfiles[index].getRegisterValue(static_cast<uint8_t>(regAddr), &regFound);
-            if (regValueFile != regValueEEPROM)
-            {
-                qDebug() << "--Different register values at address " << regAddr
-                         << ": FILE = " << regValueFile << "; EEPROM = " << regValueEEPROM;
-                emit ShowMessage(QString("Verify FAILED: Register value is different at profile %1, reg %2 (%3 in FILES; %4 in EEPROM)")
-                                 .arg(index)
-                                 .arg(regAddr)
-                                 .arg(regValueFile)
-                                 .arg(regValueEEPROM));
-                emit Result(globals::GEN_ERROR, globals::ALL_LANES);
-                return;
-            }
+            // Registers all match, but the record doesn't (e.g. stored checksum is corrupt):
+            emit ShowMessage(QString("Verify FAILED: EEPROM record is corrupt at profile %1").arg(index));
         }
-        qDebug() << "--Register values match.";
+        emit Result(globals::GEN_ERROR, globals::ALL_LANES);
+        return;
+    }
+    if (result != globals::OK)
+    {
+        qDebug() << "--Error reading profiles from EEPROM: " << result;
+        emit ShowMessage(QString("Verify FAILED: Error reading profiles from EEPROM (%1)").arg(result));
+        emit Result(result, globals::ALL_LANES);
+        return;
     }
 
     qDebug() << "===================================";
@@ -629,6 +583,73 @@ void LMX2594::LMXVerifyFrequencyProfiles()
 }
 
 
+/*!
+ \brief Compare a Frequency Profile from TCS files with one read from EEPROM
+ Emits ShowMessage describing the first difference found (if any).
+ \param index          Index of the profile (for messages)
+ \param profileFile    Profile read from TCS files
+ \param profileEEPROM  Profile read from EEPROM
+ \return true   Frequency, register count and register values all match
+ \return false  Profiles are different
+*/
+bool LMX2594::compareFrequencyProfile(int index, const LMXFrequencyProfile &profileFile, const LMXFrequencyProfile &profileEEPROM)
+{
+    qDebug() << "Check Profile " << index
+             << ": Freq from FILE = " << profileFile.getFrequency()
+             << "; Freq from EEPROM = " << profileEEPROM.getFrequency();
+
+    if (static_cast<int>(profileFile.getFrequency())
+     == static_cast<int>(profileEEPROM.getFrequency()))
+    {
+        qDebug() << "--Frequencies match.";
+    }
+    else
+    {
+        qDebug() << "--Frequencies not the same!";
+        emit ShowMessage(QString("Verify FAILED: Profile frequency is different at profile %1 (%2 in FILES; %3 in EEPROM)")
+                         .arg(index)
+                         .arg(static_cast<double>(profileFile.getFrequency()))
+                         .arg(static_cast<double>(profileEEPROM.getFrequency())));
+        return false;
+    }
+
+    if (profileFile.getRegisterCount()
+     == profileEEPROM.getRegisterCount())
+    {
+        qDebug() << "--Register counts match.";
+    }
+    else
+    {
+        qDebug() << "--Different number of registers!";
+        emit ShowMessage(QString("Verify FAILED: Number of registers is different at profile %1 (%2 in FILES; %3 in EEPROM)")
+                         .arg(index)
+                         .arg(profileFile.getRegisterCount())
+                         .arg(profileEEPROM.getRegisterCount()));
+        return false;
+    }
+    qDebug() << "Compare register values for Profile " << index << "...";
+    for (int regAddr = 0; regAddr < profileFile.getRegisterCount(); regAddr++)
+    {
+        bool regFound;
+        uint16_t regValueFile = profileFile.getRegisterValue(static_cast<uint8_t>(regAddr), &regFound);
+        uint16_t regValueEEPROM = profileEEPROM.getRegisterValue(static_cast<uint8_t>(regAddr), &regFound);
+        if (regValueFile != regValueEEPROM)
+        {
+            qDebug() << "--Different register values at address " << regAddr
+                     << ": FILE = " << regValueFile << "; EEPROM = " << regValueEEPROM;
+            emit ShowMessage(QString("Verify FAILED: Register value is different at profile %1, reg %2 (%3 in FILES; %4 in EEPROM)")
+                             .arg(index)
+                             .arg(regAddr)
+                             .arg(regValueFile)
+                             .arg(regValueEEPROM));
+            return false;
+        }
+    }
+    qDebug() << "--Register values match.";
+    return true;
+}
+
+
 /*!
  \brief Slot: Reset LMX Device to Defaults
 */
@@ -771,7 +792,7 @@ int LMX2594::getProfilesFromRegisterFiles(const QString registerFilePath, QStrin
     DEBUG_LMX_PROFILES(frequencyProfilesFromFiles.count() << " frequency profiles found.")
     if (frequencyProfilesFromFiles.count() > 0)
     {
-        DEBUG_LMX_PROFILES("Default profile: " << profileIndexDefault << " (" << frequencyProfilesFromFiles.at(profileIndexDefault).getFrequency() << " MHz)")
+        DEBUG_LMX_PROFILES("First profile: " << frequencyProfilesFromFiles.at(0).getFrequency() << " MHz")
     }
     DEBUG_LMX_PROFILES("-----------------------------")
 
@@ -927,12 +948,12 @@ int LMX2594::parseTcsFrequencyProfile(QStringList &fileContent, const QString pa
  \param index               Index of profile to get frequency from - 0 is first
  \param frequency           Pointer to a float; set to the frequency on success (MHz)
  \return globals::OK        Item found for requested index.
- \return globals::OVERFLOW  Index was larger than the list of frequency profiles
+ \return globals::OVERFLOW  Index was negative, or larger than the list of frequency profiles
 */
 int LMX2594::getFrequency(int index, float *frequency) const
 {
-    Q_ASSERT(index < (size_t)frequencyProfiles.count());
-    if (index >= frequencyProfiles.count()) return globals::OVERFLOW;
+    Q_ASSERT(index >= 0 && index < frequencyProfiles.count());
+    if (index < 0 || index >= frequencyProfiles.count()) return globals::OVERFLOW;
     if (frequency) *frequency = frequencyProfiles.at(index).getFrequency();
     return globals::OK;
 }
@@ -940,48 +961,79 @@ int LMX2594::getFrequency(int index, float *frequency) const
 
 /*!
  \brief Select Frequency Profile by Index
+ If the register shadow holds a valid value for every register in the new
+ profile, only the registers which differ from the shadow are written, and no
+ reset is needed. Otherwise (first load, or after a write error) the part is
+ reset and all of the profile registers are written. The part is also reset
+ if an earlier write set a register which the new profile doesn't write, so
+ that register goes back to its reset default (as it would with a reset). Frequency calibration
+ is skipped if no registers had to be changed.
  \param index               Index of profile to get frequency from - 0 is first
+ \param fullReload          Force a reset and write of all registers
  \return globals::OK        Item found for requested index.
- \return globals::OVERFLOW  Index was larger than the list of frequency profiles
+ \return globals::OVERFLOW  Index was negative, or larger than the list of frequency profiles
  \return [Error Code]       Error from derived class implementation (selectProfilePart)
 */
-int LMX2594::selectProfile(int index)
+int LMX2594::selectProfile(int index, bool fullReload)
 {
-    Q_ASSERT(index < (size_t)frequencyProfiles.count());
-    if (index >= frequencyProfiles.count()) return globals::OVERFLOW;
+    Q_ASSERT(index >= 0 && index < frequencyProfiles.count());
+    if (index < 0 || index >= frequencyProfiles.count()) return globals::OVERFLOW;
     DEBUG_LMX("LMX2594: Select frequency profile " << index << ": " << frequencyProfiles.at(index).getFrequency() << " MHz")
 
-    uint8_t registerAddress;
-    uint16_t registerValue;
+    const QVector<LMXFrequencyProfile::RegisterWrite_t> &writeList = frequencyProfiles.at(index).getWriteList();
     bool registerFound;
+    bool registerWritten;
+    int registersWritten = 0;
     int result;
 
-    resetDevice();
+    // Can we switch by writing only the registers which have changed?
+    bool covered[REGISTER_COUNT] = {};
+    foreach (const LMXFrequencyProfile::RegisterWrite_t &registerWrite, writeList)
+    {
+        if (fullReload) break;
+        if (registerWrite.address >= REGISTER_COUNT || !shadowValid[registerWrite.address]) fullReload = true;
+        else covered[registerWrite.address] = true;
+    }
+    // R0 (FCal), R44 and R45 (outputs) are always rewritten below, so they don't need a reset:
+    covered[0] = covered[44] = covered[45] = true;
+    for (int address = 0; address < REGISTER_COUNT && !fullReload; address++)
+    {
+        if (shadowValid[address] && !covered[address])
+        {
+            DEBUG_LMX("LMX2594: R" << address << " isn't in the new profile; Full reload")
+            fullReload = true;
+        }
+    }
+    if (fullReload)
+    {
+        if (!shadowAfterReset) resetDevice();
+        invalidateShadow();   // Write every register below, even if it matches a reset default
+    }
 
-    // Load registers in REVERSE ORDER; Don't load R0 (power control)
-    for (registerAddress = 112; registerAddress > 0; registerAddress--)
+    // Load registers in REVERSE ORDER; Don't load R0 (power control). See LMXFrequencyProfile::getWriteList.
+    foreach (const LMXFrequencyProfile::RegisterWrite_t &registerWrite, writeList)
     {
-        registerValue = frequencyProfiles.at(index).getRegisterValue(registerAddress, &registerFound);
-        if (registerFound)
+        // DEBUG_LMX("LMX2594: Write " << QString().sprintf("0x%04X", registerWrite.value) << " to register " << registerWrite.address;
+        result = writeRegisterIfChanged(registerWrite.address, registerWrite.value, &registerWritten);
+        if (result != globals::OK)
         {
-            // DEBUG_LMX("LMX2594: Write " << QString().sprintf("0x%04X", registerValue) << " to register " << registerAddress;
-            result = writeRegister(registerAddress, registerValue);
-            if (result != globals::OK)
-            {
-                DEBUG_LMX("LMX2594: ERROR writing register! (" << result << ")")
-                return globals::WRITE_ERROR;
-            }
+            DEBUG_LMX("LMX2594: ERROR writing register! (" << result << ")")
+            return globals::WRITE_ERROR;
         }
+        if (registerWritten) registersWritten++;
     }
+    DEBUG_LMX("LMX2594: " << registersWritten << " registers written" << (fullReload ? " (full reload)" : ""))
     selectedProfileIndex = static_cast<uint16_t>(index);
+    shadowAfterReset = false;
 
     // Restore the previous power and divider settings
     // and turn outputs on:
     flagOutputsOn = true;
     configureOutputs();
 
-    // Calibrate: Required after changing PLL settings
-    runFCal();
+    // Calibrate: Required after changing PLL settings (R0 is written by runFCal)
+    uint16_t newR0 = frequencyProfiles.at(index).getRegisterValue(0, &registerFound);
+    if (registersWritten > 0 || !registerFound || !shadowValid[0] || shadowRegisters[0] != newR0) runFCal();
 
     DEBUG_LMX("LMX2594: Registers set for profile!")
     return globals::OK;
@@ -1218,6 +1270,15 @@ int LMX2594::resetPart(uint16_t defaultR0)
 
     result = writeRegister(0, defaultR0);                 // Reset bit = Low.
     globals::sleep(LMX2594_RESET_POST_SLEEP);
+
+    // Registers are back to their reset defaults, which aren't in the shadow:
+    invalidateShadow();
+    if (result == globals::OK)
+    {
+        shadowRegisters[0] = defaultR0;
+        shadowValid[0] = true;
+        shadowAfterReset = true;
+    }
     DEBUG_LMX(" -OK.")
     return result;
 }
@@ -1252,8 +1313,8 @@ int LMX2594::configureOutputs()
            POWER_CONSTS[selectedTrigOutputPowerIndex];  // Set OUTB_POW
 
     DEBUG_LMX("Set R44 to " << R44 << "; R45 to " << R45)
-    int result                        = writeRegister(44, R44);
-    if (result == globals::OK) result = writeRegister(45, R45);
+    int result                        = writeRegisterIfChanged(44, R44);
+    if (result == globals::OK) result = writeRegisterIfChanged(45, R45);
     DEBUG_LMX("Result: " << result)
     return result;
 
@@ -1442,10 +1503,43 @@ int LMX2594::writeRegister(const uint8_t regAddress, const uint16_t regValue)
 #ifdef LMX_REGISTER_DEBUG
      DEBUG_LMX("[LMX Register WRITE] Addr: " << regAddress << " Data: " << QString().sprintf("0x%04X", regValue) << " Result: " << result)
 #endif
+     // Update the shadow; After an error, we no longer know what the register holds:
+     shadowRegisters[regAddress] = regValue;
+     shadowValid[regAddress] = (result == globals::OK);
      return result;
 }
 
 
+/*!
+ \brief Write value to LMX register, unless the shadow shows it already holds that value
+ \param regAddress  Register number to write to
+ \param regValue    Value to write
+ \param written     OPTIONAL: Set to true if the register was written
+ \return globals::OK  Register written, or already held regValue
+ \return [error code] See writeRegister
+*/
+int LMX2594::writeRegisterIfChanged(const uint8_t regAddress, const uint16_t regValue, bool *written)
+{
+    if (written) *written = false;
+    if (regAddress < REGISTER_COUNT
+     && shadowValid[regAddress]
+     && shadowRegisters[regAddress] == regValue) return globals::OK;
+    if (written) *written = true;
+    return writeRegister(regAddress, regValue);
+}
+
+
+/*!
+ \brief Mark all entries in the register shadow as unknown
+        The next selectProfile will write every register.
+*/
+void LMX2594::invalidateShadow()
+{
+    for (int i = 0; i < REGISTER_COUNT; i++) shadowValid[i] = false;
+    shadowAfterReset = false;
+}
+
+
 
 /*!
  \brief Set specific bits in a register value, leaving other bits unchanged
@@ -154,10 +154,19 @@ class LMX2594 : public BertComponent
     uint16_t   selectedTrigDivideIndex = 0;
     bool       flagOutputsOn = false;
 
+    // Shadow copy of the register values last written to the part (see writeRegister).
+    // Used by selectProfile to write only the registers which differ between the
+    // current and new profiles. Entries are invalid until written, and after a reset
+    // or a write error; shadowAfterReset is set while the part holds its reset defaults.
+    uint16_t   shadowRegisters[REGISTER_COUNT] = {};
+    bool       shadowValid[REGISTER_COUNT] = {};
+    bool       shadowAfterReset = false;
+
     // Main Frequency Profiles: These are read from EEPROM
-    static QList<LMXFrequencyProfile> frequencyProfiles;
-    static QStringList frequencyList;
-    static uint16_t profileIndexDefault;    // Index of default start-up frequency profile
+    // Nb: Per instance, as each instrument has its own EEPROM (several may be connected at once).
+    QList<LMXFrequencyProfile> frequencyProfiles;
+    QStringList frequencyList;
+    uint16_t profileIndexDefault = 0;    // Index of default start-up frequency profile
     // DEPRECATED static bool frequencyProfilesOK;
 
 
@@ -188,13 +197,16 @@ class LMX2594 : public BertComponent
 
     int initPart();                                                      // Part-specific Initialisation
     int getFrequency(int index, float *frequency) const;                 // Find the frequency (MHz) of the frequency profile at the specificed index
-    int selectProfile(int index);                                        // Switch to the frequency profile specified by index
+    int selectProfile(int index, bool fullReload = false);               // Switch to the frequency profile specified by index
     int runFCal();                                                       // Run frequency calibration
     int resetDevice();                                                   // Reset the part to default settings
     int configureOutputs();                                              // Output driver setup
     void setSafeDefaults();                                              // Set safe default settings
     int resetPart(uint16_t defaultR0);                                   // Part-specific reset function: Implemented by derived versions
 
+    bool compareFrequencyProfile(int index, const LMXFrequencyProfile &profileFile,
+                                 const LMXFrequencyProfile &profileEEPROM); // Compare profiles register by register (for verify)
+
 
     // LMX Enable / Disable:
     int setLMXEnable(bool enabled);
@@ -202,6 +214,8 @@ class LMX2594 : public BertComponent
     // Register writing:
 
     int writeRegister(const uint8_t regAddress, const uint16_t regValue);
+    int writeRegisterIfChanged(const uint8_t regAddress, const uint16_t regValue, bool *written = nullptr);
+    void invalidateShadow();
 
     uint16_t setRegisterBits(const uint16_t registerInputValue,
                              const uint8_t  nBits,
@@ -6,6 +6,7 @@
 */
 
 #include <QDebug>
+#include <algorithm>
 
 #include "LMXFrequencyProfile.h"
 
@@ -15,13 +16,26 @@ LMXFrequencyProfile::LMXFrequencyProfile()
 
 LMXFrequencyProfile::LMXFrequencyProfile(const int registerCount)
 {
-     this->registerCount = registerCount;
+     setRegisterCount(registerCount);
 }
 
 LMXFrequencyProfile::~LMXFrequencyProfile()
 {}
 
 
+/*!
+ \brief Set the maximum number of registers (see registerCount)
+ \param registerCount  Number of registers (limited to MAX_REGISTER_COUNT)
+*/
+void LMXFrequencyProfile::setRegisterCount(int registerCount)
+{
+    Q_ASSERT(registerCount <= MAX_REGISTER_COUNT);
+    if (registerCount > MAX_REGISTER_COUNT) registerCount = MAX_REGISTER_COUNT;
+    this->registerCount = registerCount;
+    updateWriteList();
+}
+
+
 /*!
  \brief Set register value
  Sets a profile register to a specified value. If the register
@@ -34,10 +48,17 @@ LMXFrequencyProfile::~LMXFrequencyProfile()
 int LMXFrequencyProfile::setRegisterValue(const uint8_t address, const uint16_t value)
 {
     Q_ASSERT(address < registerCount);
-    if (address > registerCount) return globals::OVERFLOW;
-    registers.insert(address, value);
+    if (address >= registerCount) return globals::OVERFLOW;
+    if (isPresent(address) && registerValues[address] == value) return globals::OK;  // No change
+    if (!isPresent(address))
+    {
+        registerPresent[address / 32] |= (1u << (address % 32));
+        usedRegisterCount++;
+    }
+    registerValues[address] = value;
+    updateWriteListEntry(address);
     return globals::OK;
- }
+}
 
 
 /*!
@@ -59,10 +80,10 @@ uint16_t LMXFrequencyProfile::getRegisterValue(const uint8_t address, bool *regi
 {
     Q_ASSERT(address < registerCount);
 
-    if (registers.contains(address))
+    if (isPresent(address))
     {
         if (registerFound) *registerFound = true;
-        return registers.value(address);
+        return registerValues[address];
     }
     else
     {
@@ -72,4 +93,64 @@ uint16_t LMXFrequencyProfile::getRegisterValue(const uint8_t address, bool *regi
 }
 
 
+/*!
+ \brief Remove all register values from the profile
+ Register count, frequency and valid flag are unchanged.
+*/
+void LMXFrequencyProfile::clear()
+{
+    for (int i = 0; i < MAX_REGISTER_COUNT; i++) registerValues[i] = 0;
+    for (int i = 0; i < MAX_REGISTER_COUNT / 32; i++) registerPresent[i] = 0;
+    usedRegisterCount = 0;
+    writeList.clear();
+}
+
+
+/*!
+ \brief Rebuild the write list from the register values
+ Registers are listed from the highest address down to R1. R0 (power
+ control, FCAL) isn't included; it is written separately by LMX2594.
+*/
+void LMXFrequencyProfile::updateWriteList()
+{
+    writeList.clear();
+    writeList.reserve(usedRegisterCount);
+    for (int address = registerCount - 1; address > 0; address--)
+    {
+        if (!isPresent(address)) continue;
+        RegisterWrite_t registerWrite;
+        registerWrite.address = static_cast<uint8_t>(address);
+        registerWrite.value = registerValues[address];
+        writeList.append(registerWrite);
+    }
+}
+
+
+/*!
+ \brief Update the write list entry for one register
+ Adds the register to the write list, keeping the list in order (highest
+ address first), or updates its value if it is already listed.
+ \param address  Register address which has been set (R0 is ignored)
+*/
+void LMXFrequencyProfile::updateWriteListEntry(const uint8_t address)
+{
+    if (address == 0) return;  // R0 isn't in the write list (see updateWriteList)
+    QVector<RegisterWrite_t>::iterator entry =
+        std::lower_bound(writeList.begin(), writeList.end(), address,
+                         [](const RegisterWrite_t &registerWrite, const uint8_t findAddress)
+                           { return registerWrite.address > findAddress; });
+    if (entry != writeList.end() && entry->address == address)
+    {
+        entry->value = registerValues[address];
+    }
+    else
+    {
+        RegisterWrite_t registerWrite;
+        registerWrite.address = address;
+        registerWrite.value = registerValues[address];
+        writeList.insert(entry, registerWrite);
+    }
+}
+
+
 
@@ -9,7 +9,7 @@
 #ifndef LMXFREQUENCYPROFILE_H
 #define LMXFREQUENCYPROFILE_H
 
-#include <QMap>
+#include <QVector>
 #include <stdint.h>
 
 #include "globals.h"
@@ -17,16 +17,32 @@
 /*!
   \brief LMX Frequency Profile Class
   Stores the register values for a frequency setting
+
+  Register values are held in a fixed size array indexed by address, with a
+  bit mask to show which registers have been set. The profile also keeps a
+  write list: the registers which have been set, in the order they are loaded
+  into the part (highest address first, excluding R0). Setting a register value
+  updates only that register's entry in the write list, so loading a profile is
+  linear in the number of registers, and applying a profile is a single pass
+  through the list (see LMX2594::selectProfile).
 */
 class LMXFrequencyProfile
 {
 public:
 
+    static const int MAX_REGISTER_COUNT = 256;   // Register address is uint8_t
+
+    typedef struct RegisterWrite_t
+    {
+        uint8_t  address;
+        uint16_t value;
+    } RegisterWrite_t;
+
     LMXFrequencyProfile();
     explicit LMXFrequencyProfile(const int registerCount);
     ~LMXFrequencyProfile();
 
-    void setRegisterCount(int registerCount) { this->registerCount = registerCount; }
+    void setRegisterCount(int registerCount);
     int getRegisterCount() const { return registerCount; }
 
     void setValid()            { valid = true;       }
@@ -38,7 +54,9 @@ public:
     int setRegisterValue(const uint8_t address, const uint16_t value);
     uint16_t getRegisterValue(const uint8_t address, bool *registerFound) const;
 
-    int getUsedRegisterCount() const { return registers.count(); }
+    int getUsedRegisterCount() const { return usedRegisterCount; }
+
+    const QVector<RegisterWrite_t> &getWriteList() const { return writeList; }
 
     void clear();
 
@@ -55,7 +73,15 @@ private:
     bool valid = false;
     float frequency = 0.0;
 
-    QMap<uint8_t, uint16_t> registers;
+    uint16_t registerValues[MAX_REGISTER_COUNT] = {};
+    uint32_t registerPresent[MAX_REGISTER_COUNT / 32] = {};   // Bit set for each register which has a value
+    int usedRegisterCount = 0;
+
+    QVector<RegisterWrite_t> writeList;
+
+    bool isPresent(const int address) const { return (registerPresent[address / 32] >> (address % 32)) & 1u; }
+    void updateWriteList();
+    void updateWriteListEntry(const uint8_t address);
 
 };
 
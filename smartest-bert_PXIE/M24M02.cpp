@@ -15,19 +15,16 @@
 #include <QMap>
 #include <cstdlib>
 #include <BertFile.h>
+#include <QElapsedTimer>
 #include <QTime>  // For testing / profiling
 
 
 #include "M24M02.h"
+#include "BertLog.h"
 
-// Debug Macro for EEPROM Read / Write:
-// #define BERT_EEPROM_DEBUG
-#ifdef BERT_EEPROM_DEBUG
-  #define DEBUG_EEPROM(MSG) qDebug() << "\t\t" << MSG;
-#endif
-#ifndef DEBUG_EEPROM
-  #define DEBUG_EEPROM(MSG)
-#endif
+// Debug Macro for EEPROM Read / Write: BertLog::LOG_EEPROM (debug); on by default
+// if the build defines BERT_EEPROM_DEBUG
+#define DEBUG_EEPROM(MSG) BERT_LOG(LOG_EEPROM, LEVEL_DEBUG, "\t\t" << MSG)
 
 // For EXTRA debug:
 #define DEBUG_EEPROM_EXTRA(MSG)
@@ -60,7 +57,7 @@ const QMap<M24M02::StringID, uint16_t> M24M02::STRING_LENGTHS =
  *                    starting from 0.
  */
 M24M02::M24M02(I2CComms *comms, const uint8_t i2cAddress, const int deviceID)
- : comms(comms), i2cAddress(i2cAddress), deviceID(deviceID)
+ : comms(comms), i2cAddress(i2cAddress), deviceID(deviceID), storePending(false)
 {
     uint16_t address = 0;
     foreach(StringID stringID, STRING_LENGTHS.keys())
@@ -158,6 +155,11 @@ QString M24M02::ReadModelCode()
 
 /*!
  \brief Read Frequency Profiles from M24M02 EEPROM
+ Profiles are cached on the host (see BertFile::readProfileCache), keyed by
+ the EEPROM serial number. If the cache matches the EEPROM (see
+ readCachedFrequencyProfiles), the cached profiles are used and the full
+ profile read is skipped. Otherwise the profiles are read from the EEPROM
+ and the cache is updated.
  \param   deviceID           Device ID check: If ths doesn't match the device, INVALID_BOARD is returned.
  \param   frequencyProfiles  Reference to list of frequency profiles. Any existing profiles are deleted;
                              Used to return the NEW profiles read from EEPROM (if any)
@@ -179,8 +181,6 @@ int M24M02::readFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &freq
     uint16_t address = 0;
     int result = globals::OK;
 
-    static const int MAX_PROFILES = 255;  // For sanity check... Max number of profiles which will fit in one page.
-
     // -- Read profile count from first 2 bytes: --
     uint16_t profileCount = 0;
     address = 0;
@@ -191,37 +191,67 @@ int M24M02::readFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &freq
         return globals::INVALID_DATA;
     }
     DEBUG_EEPROM("M24M02: Found " << profileCount << " frequency profiles in EEPROM")
-    if (profileCount > MAX_PROFILES)  // Sanity check; should pick up invalid EEPROM data.
+    if (profileCount > MAX_FREQ_PROFILES)  // Sanity check; should pick up invalid EEPROM data.
     {
-        DEBUG_EEPROM("M24M02: ERROR: Unrealistic number of frequency profiles! (shouldn't be more than " << MAX_PROFILES << "). EEPROM probably contains stale or invalid data.")
+        DEBUG_EEPROM("M24M02: ERROR: Unrealistic number of frequency profiles! (shouldn't be more than " << MAX_FREQ_PROFILES << "). EEPROM probably contains stale or invalid data.")
         return globals::INVALID_DATA;
     }
 
+    // -- Try the host cache first: --
+    QString cacheFileName;
+    QString synthConfigVersion;
+    if (readCachedFrequencyProfiles(profileCount, frequencyProfiles, cacheFileName, synthConfigVersion) == globals::OK)
+    {
+        DEBUG_EEPROM("M24M02: EEPROM Read time elapsed: " << t.elapsed() << " ms (profiles from cache)")
+        return globals::OK;
+    }
+
     // Profiles are stored one per 256 byte sub-page, starting at sub-page 1
     // Sub-page 0 stores number of profiles.
-    int profilePageIndex = 1;
+    // Read the whole profile region in one sequential pass, then parse it in memory:
+    QByteArray profileData(profileCount * PROFILE_SLOT_SIZE, static_cast<char>(0xFF));
+    address = PROFILE_SLOT_SIZE;
+    result = loadBlock(PAGE_FREQ_PROFILES, &address,
+                       reinterpret_cast<uint8_t *>(profileData.data()),
+                       static_cast<uint16_t>(profileData.size()));
+    if (result != globals::OK)
+    {
+        DEBUG_EEPROM("M24M02: Error reading frequency profile data (" << result << ")")
+        return globals::INVALID_DATA;
+    }
+
+    QList<quint16> checkSums;
+    bool allProfilesOK = true;
 
     for (int profileIndex = 0; profileIndex < profileCount; profileIndex++)
     {
         LMXFrequencyProfile newProfile;
-        address = static_cast<uint16_t>(profilePageIndex * 256);
-        result = loadFrequencyProfile(&address, newProfile);
+        uint16_t checkSum = 0;
+        const uint8_t *slotData = reinterpret_cast<const uint8_t *>(profileData.constData()) + (profileIndex * PROFILE_SLOT_SIZE);
+        result = decodeFrequencyProfile(slotData, PROFILE_SLOT_SIZE, newProfile, &checkSum);
         if (result == globals::OK)
         {
             frequencyProfiles.append(newProfile);
+            checkSums.append(checkSum);
         }
         else
         {
-            DEBUG_EEPROM("M24M02: Error reading frequency profile at address " << address << " (" << result << ")");
+            DEBUG_EEPROM("M24M02: Error reading frequency profile " << profileIndex << " (" << result << ")");
             if (result != globals::BAD_CHECKSUM) return globals::INVALID_DATA;
               // If we got a bad checksum, other profiles are probably OK so Keep going.
               // Other errors are probably more fatal, so give up.
+            allProfilesOK = false;
         }
-        profilePageIndex++;
+    }
+
+    // Update the cache (only if every profile was read OK, so the cache always matches the EEPROM):
+    if (allProfilesOK && !cacheFileName.isEmpty())
+    {
+        BertFile::writeProfileCache(cacheFileName, synthConfigVersion, frequencyProfiles, checkSums);
     }
 
     //##############################################
-    qDebug("EEPROM Read time elapsed: %d ms", t.elapsed());
+    DEBUG_EEPROM("M24M02: EEPROM Read time elapsed: " << t.elapsed() << " ms")
     //##############################################
 
     DEBUG_EEPROM("M24M02: Frequency profiles read OK")
@@ -239,15 +269,25 @@ int M24M02::readFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &freq
 int M24M02::writeFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &frequencyProfiles)
 {
     if (deviceID != this->deviceID) return globals::INVALID_BOARD;  // Not for us!
-    if (frequencyProfiles.count() > 255)
+    int profileCount = frequencyProfiles.count();
+    if (profileCount > MAX_FREQ_PROFILES)
     {
-        DEBUG_EEPROM("M24M02: WARNING: Maximum of 255 frequency profiles can be stored! (have " << frequencyProfiles.count() << "; extras will be dropped.");
+        DEBUG_EEPROM("M24M02: WARNING: Maximum of " << MAX_FREQ_PROFILES << " frequency profiles can be stored! (have " << profileCount << "; extras will be dropped.");
+        profileCount = MAX_FREQ_PROFILES;
     }
 
     DEBUG_EEPROM("M24M02: EEPROM Write " << frequencyProfiles.length() << " Frequency Profiles - Device " << deviceID);
 
     uint16_t address = 0;
     int result = globals::OK;
+
+    // Profiles are about to change: Remove any host cache for this EEPROM:
+    QString serial;
+    if (loadString(SERIAL, serial) == globals::OK)
+    {
+        QString cacheFileName = BertFile::profileCacheFileName(serial);
+        if (!cacheFileName.isEmpty()) QFile::remove(cacheFileName);
+    }
 /*
     result = clearPROFILES();
     if (result != globals::OK)
@@ -261,8 +301,35 @@ int M24M02::writeFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &fre
     t.start();
     //##############################################
 
+    // -- Lay out each record in host memory first: --
+    // Profiles are written one per 256 byte sub-page, starting at sub-page 1
+    // Sub-page 0 stores number of profiles.
+    // Encoding everything up front means a bad profile is caught before the EEPROM
+    // is touched, and the records can then be streamed out back to back.
+    QVector<QByteArray> records;
+    records.reserve(profileCount);
+    for (int profileIndex = 0; profileIndex < profileCount; profileIndex++)
+    {
+        QByteArray record(PROFILE_SLOT_SIZE, static_cast<char>(0xFF));
+        uint16_t recordSize = 0;
+        result = encodeFrequencyProfile(frequencyProfiles[profileIndex],
+                                        reinterpret_cast<uint8_t *>(record.data()),
+                                        PROFILE_SLOT_SIZE, &recordSize);
+        if (result != globals::OK)
+        {
+            DEBUG_EEPROM("M24M02: Error encoding Frequency Profile for frequency " << frequencyProfiles[profileIndex].getFrequency() << " (" << result << ")")
+            return result;
+        }
+        record.truncate(recordSize);
+        records.append(record);
+    }
+
     // -- Write profile count as first 2 bytes: --
-    result = storeUInt16(PAGE_FREQ_PROFILES, &address, static_cast<uint16_t>(frequencyProfiles.length()), nullptr);
+    uint8_t countData[2];
+    countData[0] = static_cast<uint8_t>(profileCount & 0x00FF);  // Little endian format.
+    countData[1] = static_cast<uint8_t>(profileCount >> 8);      //
+    address = 0;
+    result = storeBlock(PAGE_FREQ_PROFILES, &address, countData, 2);
     if (result != globals::OK)
     {
         DEBUG_EEPROM("M24M02: Error writing Frequency Profile count (" << result << ")")
@@ -270,23 +337,21 @@ int M24M02::writeFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &fre
     }
 
     // -- Write each profile: --
-    // Profiles are written one per 256 byte sub-page, starting at sub-page 1
-    // Sub-page 0 stores number of profiles.
-    int profilePageIndex = 1;
-    foreach(LMXFrequencyProfile profile, frequencyProfiles)
+    for (int profileIndex = 0; profileIndex < records.count(); profileIndex++)
     {
-        address = static_cast<uint16_t>(profilePageIndex * 256);
-        result = storeFrequencyProfile(&address, profile);
+        address = static_cast<uint16_t>((profileIndex + 1) * PROFILE_SLOT_SIZE);
+        result = storeBlock(PAGE_FREQ_PROFILES, &address,
+                            reinterpret_cast<uint8_t *>(records[profileIndex].data()),
+                            static_cast<uint16_t>(records[profileIndex].size()));
         if (result != globals::OK)
         {
-            DEBUG_EEPROM("M24M02: Error writing Frequency Profile for frequency " << profile.getFrequency() << " at address " << address << "(" << result << ")")
+            DEBUG_EEPROM("M24M02: Error writing Frequency Profile for frequency " << frequencyProfiles[profileIndex].getFrequency() << " at address " << address << "(" << result << ")")
             return result;
         }
-        profilePageIndex++;
     }
 
     //##############################################
-    qDebug("EEPROM Write time elapsed: %d ms", t.elapsed());
+    DEBUG_EEPROM("M24M02: EEPROM Write time elapsed: " << t.elapsed() << " ms")
     //##############################################
 
     DEBUG_EEPROM("M24M02: Frequency profiles written OK")
@@ -295,12 +360,120 @@ int M24M02::writeFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &fre
 
 
 
+/*!
+ \brief Verify Frequency Profiles in M24M02 EEPROM against a list of profiles
+ Fast check: Each profile in the list is encoded on the host, and only the
+ checksum stored at the end of each EEPROM record (plus the profile count)
+ is read back. These small reads are packed into as few adaptor frames as
+ possible (see I2CComms::runBatch). A profile is read back in full only if
+ its stored checksum doesn't match; the full record is then compared byte
+ for byte, and decoded into mismatchedProfiles so the caller can report
+ the difference.
+ NB: The checksum is a 16 bit sum, so (e.g.) swapped bytes within a record
+ won't be detected. It is intended to catch failed or incomplete writes.
+ \param   deviceID            Device ID check: If ths doesn't match the device, INVALID_BOARD is returned.
+ \param   frequencyProfiles   Profiles which are expected to be in the EEPROM
+ \param   mismatchedProfiles  Cleared, then receives (profile index -> profile as read from EEPROM)
+                              for each profile which doesn't match. Profiles which couldn't be
+                              decoded are included, but not marked as valid.
+ \param   storedCount         OPTIONAL: Set to the number of profiles recorded in the EEPROM
+ \return globals::OK            All profiles match
+ \return globals::INVALID_DATA  Number of profiles in EEPROM is different
+ \return globals::BAD_CHECKSUM  One or more profiles are different (see mismatchedProfiles)
+ \return [error code]
+*/
+int M24M02::verifyFrequencyProfiles(int deviceID, const QList<LMXFrequencyProfile> &frequencyProfiles,
+                                    QMap<int, LMXFrequencyProfile> &mismatchedProfiles, int *storedCount)
+{
+    if (deviceID != this->deviceID) return globals::INVALID_BOARD;  // Not for us!
+    mismatchedProfiles.clear();
+
+    int profileCount = frequencyProfiles.count();
+    if (profileCount > MAX_FREQ_PROFILES) profileCount = MAX_FREQ_PROFILES;  // Extras are dropped when written
+
+    //###### Time Recording - for testing ##########
+    QTime t;
+    t.start();
+    //##############################################
+
+    int result = waitStoreAck();  // Make sure the last write has finished
+    if (result != globals::OK) return result;
+
+    // -- Encode the expected records, and queue a read of each stored checksum: --
+    QVector<QByteArray> records;
+    records.reserve(profileCount);
+    QByteArray storedData((profileCount + 1) * 2, 0);   // Count, then one checksum per profile
+    uint8_t *storedBytes = reinterpret_cast<uint8_t *>(storedData.data());
+    I2CBatch batch;
+    batch.addRead(i2cAddress + PAGE_FREQ_PROFILES, 0, storedBytes, 2);
+    for (int profileIndex = 0; profileIndex < profileCount; profileIndex++)
+    {
+        QByteArray record(PROFILE_SLOT_SIZE, static_cast<char>(0xFF));
+        uint16_t recordSize = 0;
+        result = encodeFrequencyProfile(frequencyProfiles[profileIndex],
+                                        reinterpret_cast<uint8_t *>(record.data()),
+                                        PROFILE_SLOT_SIZE, &recordSize);
+        if (result != globals::OK) return result;
+        record.truncate(recordSize);
+        records.append(record);
+
+        const uint16_t checkSumAddress = static_cast<uint16_t>(((profileIndex + 1) * PROFILE_SLOT_SIZE) + recordSize - 2);
+        batch.addRead(i2cAddress + PAGE_FREQ_PROFILES, checkSumAddress, storedBytes + ((profileIndex + 1) * 2), 2);
+    }
+    result = comms->runBatch(batch);
+    if (result != globals::OK)
+    {
+        DEBUG_EEPROM("M24M02: Error reading Frequency Profile checksums (" << result << ")")
+        return result;
+    }
+
+    // -- Check the count: --
+    const int countStored = static_cast<int>(static_cast<uint16_t>(storedBytes[1] << 8) | storedBytes[0]);
+    if (storedCount) *storedCount = countStored;
+    if (countStored != profileCount)
+    {
+        DEBUG_EEPROM("M24M02: Verify: Profile count is different (" << countStored << " in EEPROM; expected " << profileCount << ")")
+        return globals::INVALID_DATA;
+    }
+
+    // -- Check each checksum; Full readback only for profiles which don't match: --
+    for (int profileIndex = 0; profileIndex < profileCount; profileIndex++)
+    {
+        const QByteArray &record = records[profileIndex];
+        const uint8_t *stored = storedBytes + ((profileIndex + 1) * 2);
+        if (stored[0] == static_cast<uint8_t>(record[record.size() - 2])
+         && stored[1] == static_cast<uint8_t>(record[record.size() - 1])) continue;  // Checksum matches.
+
+        DEBUG_EEPROM("M24M02: Verify: Checksum mismatch for profile " << profileIndex << "; reading back in full")
+        QByteArray readBack(PROFILE_SLOT_SIZE, 0);
+        uint16_t address = static_cast<uint16_t>((profileIndex + 1) * PROFILE_SLOT_SIZE);
+        result = loadBlock(PAGE_FREQ_PROFILES, &address,
+                           reinterpret_cast<uint8_t *>(readBack.data()),
+                           static_cast<uint16_t>(readBack.size()));
+        if (result != globals::OK) return result;
+        if (readBack.left(record.size()) == record) continue;  // Checksum read was bad, but record is OK.
+
+        LMXFrequencyProfile storedProfile;
+        decodeFrequencyProfile(reinterpret_cast<const uint8_t *>(readBack.constData()), PROFILE_SLOT_SIZE, storedProfile);
+        mismatchedProfiles.insert(profileIndex, storedProfile);
+    }
+
+    //##############################################
+    DEBUG_EEPROM("M24M02: EEPROM Verify time elapsed: " << t.elapsed() << " ms")
+    //##############################################
+
+    return (mismatchedProfiles.isEmpty()) ? globals::OK : globals::BAD_CHECKSUM;
+}
+
+
+
 /*!
  \brief Write Firmware to M24M02 EEPROM
  \param   deviceID           Device ID check: If ths doesn't match the device, INVALID_BOARD is returned.
- \param   firmware           Reference to a firmware to write to EEPROM
- \return globals::OK
- \return [error code]
+ Reads the firmware image from the app directory, writes it to the
+ firmware page and verifies it.
+ EMITS Result: globals::OK, globals::FILE_ERROR (no firmware file),
+       globals::INVALID_DATA (bad file size or verify failed), or [error code]
  */
 
 
@@ -308,85 +481,74 @@ void M24M02::WriteFirmware(int deviceID)
 {
     if (deviceID != this->deviceID)
     {
-        DEBUG_EEPROM("M24M02: Wrong device ID" << device ID);
+        DEBUG_EEPROM("M24M02: Wrong device ID " << deviceID);
         return;
     }
 
     QString firmwarePath = globals::getAppPath() + QString("/firmwares/GT1706-rev-3-5-2-B.bin");
     QFile firmwareFile(firmwarePath);
-
-    if(firmwareFile.open(QIODevice::ReadOnly))
+    if (!firmwareFile.open(QIODevice::ReadOnly))
     {
-       qDebug() <<" Firmware found!"<<firmwareFile.size();
-    };
-
-    const uint16_t firmwareLength = firmwareFile.size();
-
-
-    uint8_t *dataBuffer = new uint8_t[firmwareLength];
-    uint16_t i = 0;
+        DEBUG_EEPROM("M24M02: Firmware file not found: " << firmwarePath)
+        emit Result(globals::FILE_ERROR, globals::ALL_LANES);
+        return;
+    }
+    QByteArray firmware = firmwareFile.readAll();
+    firmwareFile.close();
 
-    QDataStream in(&firmwareFile);
-    while(i < firmwareLength)
+    // storeBlock can write at most 65535 bytes (one EEPROM page, less one byte):
+    if (firmware.isEmpty() || firmware.size() > 65535)
     {
-        in >> dataBuffer[i];
-        qDebug() <<" Firmware data address is " << i <<"data value is " <<INT_AS_HEX(dataBuffer[i],2);
-        i ++;
-    };
-
-
-    qDebug() <<" Firmware data is ready";
+        DEBUG_EEPROM("M24M02: Invalid firmware file size: " << firmware.size())
+        emit Result(globals::INVALID_DATA, globals::ALL_LANES);
+        return;
+    }
+    const uint16_t firmwareLength = static_cast<uint16_t>(firmware.size());
+    DEBUG_EEPROM("M24M02: Firmware found (" << firmwareLength << " bytes)")
 
     //###### Time Recording - for testing ##########
     QTime t;
     t.start();
     //##############################################
-/*
-    uint16_t dataAddress = 0;
-    int result = storeBlock(PAGE_Firmware, &dataAddress, dataBuffer, firmwareLength);
-
 
-    if(result!=globals::OK)
+    uint16_t dataAddress = 0;
+    int result = storeBlock(PAGE_Firmware, &dataAddress,
+                            reinterpret_cast<uint8_t *>(firmware.data()), firmwareLength);
+    if (result != globals::OK)
     {
-         qDebug()<<"M24M02: Firmware written failed!";
-         return;
+        DEBUG_EEPROM("M24M02: Firmware write failed! (" << result << ")")
+        emit Result(result, globals::ALL_LANES);
+        return;
     }
-    else
-    {
-         qDebug() <<"M24M02: Firmware written OK";
-
-    };
-*/
-    //Generate ramdon_addresses to read back the data from EEPROM, then compare them with dataBuffer.
- //   globals::sleep(3000);
-    uint16_t readAddress=0;
-    uint8_t readData = 0;
 
-    for(int j=0; j < firmwareLength; j++)
+    // Read back the whole image in one sequential pass and compare:
+    QByteArray readBack(firmwareLength, 0);
+    dataAddress = 0;
+    result = loadBlock(PAGE_Firmware, &dataAddress,
+                       reinterpret_cast<uint8_t *>(readBack.data()), firmwareLength);
+    if (result != globals::OK)
     {
-        int result = loadBytes(PAGE_Firmware, &readAddress, &readData, 1);
-        if(result==globals::OK)
+        DEBUG_EEPROM("M24M02: Firmware readback failed! (" << result << ")")
+        emit Result(result, globals::ALL_LANES);
+        return;
+    }
+    for (int i = 0; i < firmwareLength; i++)
+    {
+        if (readBack[i] != firmware[i])
         {
-           qDebug()<<"Read data from EEPROM address"<< readAddress<< "data value" << INT_AS_HEX(readData,2) << "OK!";
+            DEBUG_EEPROM("M24M02: Firmware verify failed at address " << INT_AS_HEX(i, 4)
+                         << ": wrote " << INT_AS_HEX(static_cast<uint8_t>(firmware[i]), 2)
+                         << "; read " << INT_AS_HEX(static_cast<uint8_t>(readBack[i]), 2))
+            emit Result(globals::INVALID_DATA, globals::ALL_LANES);
+            return;
         }
-        else
-        {
-            qDebug() <<"Data readback from EEPROM is wrong!!!";
-        };
-
-    };
-
-    firmwareFile.close();
-    delete [] dataBuffer;
-
+    }
+    DEBUG_EEPROM("M24M02: Firmware written and verified OK")
 
     //##############################################
-    qDebug("EEPROM Write time elapsed: %d ms", t.elapsed());
+    DEBUG_EEPROM("M24M02: EEPROM Write time elapsed: " << t.elapsed() << " ms")
     //##############################################
-
-
-    return;
-
+    emit Result(globals::OK, globals::ALL_LANES);
 }
 
 
@@ -428,7 +590,7 @@ void M24M02::EEPROMReadStrings(int deviceID)
     if (result == globals::OK) result = loadString( SYNTH_CONFIG_VERSION, synthConfigVersion );
 
     //##############################################
-    qDebug("EEPROM Read time elapsed: %d ms", t.elapsed());
+    DEBUG_EEPROM("M24M02: EEPROM Read time elapsed: " << t.elapsed() << " ms")
     //##############################################
 
     if (result == globals::OK) emit EEPROMStringData(this->deviceID, model, serial, productionDate, calibrationDate, warrantyStart, warrantyEnd, synthConfigVersion);
@@ -475,7 +637,7 @@ void M24M02::EEPROMWriteStrings(int deviceID,
     if (result == globals::OK) result = storeString( SYNTH_CONFIG_VERSION, synthConfigVersion );
 
     //##############################################
-    qDebug("EEPROM Write time elapsed: %d ms", t.elapsed());
+    DEBUG_EEPROM("M24M02: EEPROM Write time elapsed: " << t.elapsed() << " ms")
     //##############################################
 
     emit Result(result, globals::ALL_LANES);
@@ -508,6 +670,11 @@ void M24M02::EEPROMWriteStrings(int deviceID,
 //  * Error in raw I2C transaction? (Examine with protocol analyser!)
 //  * EEPROM timing weirdness?
 //
+// UPDATE: The split write in storeBytes below used to send the start of the source
+// buffer for the second part, rather than the bytes following the split. This
+// would explain the corruption above. Fixed; storeBlock now keeps each write inside
+// one sub-page anyway, so block transfers don't need to be split.
+//
 // Jeremy Cole-Baker 18-Nov-2018
 
 
@@ -516,6 +683,9 @@ void M24M02::EEPROMWriteStrings(int deviceID,
  * Multple bytes may be sent (up to 59); however, the EEPROM does not allow sequential
  * writes past the end of one page. If (address + nBytes) > 64kB, address will wrap
  * and remaining bytes will be written at the start of the same page!
+ * The write is not waited for: the EEPROM is polled for an ACK (see waitStoreAck)
+ * before the next operation, so the caller can prepare more data while the
+ * EEPROM is busy programming its memory cells.
  * \param page     Page number (0 - 3)
  * \param address  EEPROM address to store to (lower 16 bits; i.e. address within page)
  *                 On SUCCESS, address is automatically incremented by the number of bytes stored.
@@ -530,18 +700,19 @@ int M24M02::storeBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t n
     Q_ASSERT(page <= 3);
     if (nBytes < 1 || page > 3) return globals::OVERFLOW;
 
-    int result = globals::OK;
+    int result = waitStoreAck();  // Previous write must have finished
+    if (result != globals::OK) return result;
+
     int offsetInPageA = (*address) % 256;
     int offsetInPageB = ((*address) + nBytes - 1) % 256;
     if (offsetInPageA <= offsetInPageB)
     {
         // This write DOESN'T cross 256 byte sub-page. Single write OK!
-        qDebug() << "NORMAL WRITE! Start @ " << INT_AS_HEX(*address, 4);
         result = comms->write(i2cAddress + page, *address, data, nBytes);
         if (result == globals::OK)
         {
             *address += nBytes;
-            waitStoreAck();
+            storePending = true;
         }
     }
     else
@@ -550,21 +721,22 @@ int M24M02::storeBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t n
         uint8_t nBytesA = static_cast<uint8_t>(256 - offsetInPageA);
         uint8_t nBytesB = nBytes - nBytesA;
 
-        qDebug() << "CROSS-SUBPAGE WRITE! Start @ " << INT_AS_HEX(*address, 4) << "(" << offsetInPageA << ")"
-                 << "; Last Byte At: " << INT_AS_HEX((*address) + nBytes - 1, 4) << "(" << offsetInPageB << ")"
-                 << "; Split after: " << INT_AS_HEX((*address) + nBytesA - 1, 4)
-                 << " leaving " << nBytesB << " bytes @ " << INT_AS_HEX((*address) + nBytesA, 4);
+        DEBUG_EEPROM("CROSS-SUBPAGE WRITE! Start @ " << INT_AS_HEX(*address, 4) << "(" << offsetInPageA << ")"
+                     << "; Last Byte At: " << INT_AS_HEX((*address) + nBytes - 1, 4) << "(" << offsetInPageB << ")"
+                     << "; Split after: " << INT_AS_HEX((*address) + nBytesA - 1, 4)
+                     << " leaving " << nBytesB << " bytes @ " << INT_AS_HEX((*address) + nBytesA, 4))
 
         result = comms->write(i2cAddress + page, *address, data, nBytesA);
         if (result == globals::OK)
         {
             *address += nBytesA;
-            waitStoreAck();
-            result = comms->write(i2cAddress + page, *address, data, nBytesB);
+            storePending = true;
+            result = waitStoreAck();
+            if (result == globals::OK) result = comms->write(i2cAddress + page, *address, data + nBytesA, nBytesB);
             if (result == globals::OK)
             {
                 *address += nBytesB;
-                waitStoreAck();
+                storePending = true;
             }
         }
     }
@@ -593,13 +765,15 @@ int M24M02::loadBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t nB
     Q_ASSERT(page <= 3);
     if (nBytes < 1 || page > 3) return globals::OVERFLOW;
 
-    int result = globals::OK;
+    int result = waitStoreAck();  // EEPROM ignores reads until a previous write has finished
+    if (result != globals::OK) return result;
+
     int offsetInPageA = (*address) % 256;
     int offsetInPageB = ((*address) + nBytes - 1) % 256;
     if (offsetInPageA <= offsetInPageB)
     {
         // This read DOESN'T cross 256 byte sub-page. Single read OK!
-        int result = comms->read(i2cAddress + page, *address, data, nBytes);
+        result = comms->read(i2cAddress + page, *address, data, nBytes);
         if (result == globals::OK) *address += nBytes;
     }
     else
@@ -617,7 +791,7 @@ int M24M02::loadBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t nB
         if (result == globals::OK)
         {
             *address += nBytesA;
-            result = comms->read(i2cAddress + page, *address, data, nBytesB);
+            result = comms->read(i2cAddress + page, *address, data + nBytesA, nBytesB);
             if (result == globals::OK) *address += nBytesB;
         }
     }
@@ -631,36 +805,38 @@ int M24M02::loadBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t nB
  * \brief Wait for store operation to finish
  * The EEPROM takes some time (up to 10 ms) after a write operation,
  * for the data to be written to the memory cells. During this time
- * it ignores I2C requests. This method repeatedly sends a request
- * with no data, until it receives an ACK (indicating the write
- * has finished).
+ * it ignores I2C requests. This method repeatedly pings the EEPROM
+ * address until it receives an ACK (indicating the write has finished),
+ * or STORE_ACK_TIMEOUT_MS expires. There is no sleep between polls:
+ * each ping is a round trip through the I2C adaptor, so the next write
+ * goes out as soon as the EEPROM is ready.
+ * Does nothing if no write is pending (see storePending).
  * \return globals::OK  Success - store has completed
  * \return [error code]
  */
 int M24M02::waitStoreAck()
 {
+    if (!storePending) return globals::OK;
     DEBUG_EEPROM("EEPROM Write: Wait for ACK...")
+
+    QElapsedTimer timer;
+    timer.start();
     int result = globals::OK;
-    int retryCount = 0;
-    while (retryCount < 5)
+    while (true)
     {
-        DEBUG_EEPROM("-Try " << retryCount << "...")
-        result = comms->writeRaw(i2cAddress, 0, 0);
+        result = comms->pingAddress(i2cAddress);
         if (result == globals::OK)
         {
-            DEBUG_EEPROM("--ACK!")
+            DEBUG_EEPROM("--ACK after " << timer.elapsed() << " ms")
             break;
         }
-        else
-        {
-            DEBUG_EEPROM("--No ACK (" << result << "). Waiting...")
-        }
-        retryCount++;
-        globals::sleep(2);
+        if (result != globals::DEVICE_NOT_FOUND) break;  // Comms error: Not just a busy EEPROM.
+        if (timer.elapsed() > STORE_ACK_TIMEOUT_MS) break;
     }
+    storePending = false;
     if (result != globals::OK)
     {
-        DEBUG_EEPROM("--WARNING: TIMED OUT without ACK!")
+        DEBUG_EEPROM("--WARNING: TIMED OUT without ACK! (" << result << ")")
     }
 
     return result;
@@ -723,8 +899,39 @@ int M24M02::loadUInt16(uint8_t page, uint16_t *address, uint16_t *value, uint16_
 
 
 
+/*!
+ \brief Block size for writes to EEPROM (bytes)
+ Limited by the comms transport (see I2CComms::getMaxWriteBlockSize) and by
+ the size of the temp buffers used in this class (WRITE_BLK_SIZE).
+*/
+int M24M02::writeBlockSize() const
+{
+    int blkSize = static_cast<int>(comms->getMaxWriteBlockSize());
+    if (blkSize <= 0 || blkSize > WRITE_BLK_SIZE) blkSize = WRITE_BLK_SIZE;
+    return blkSize;
+}
+
+
+/*!
+ \brief Block size for reads from EEPROM (bytes)
+ Limited by the comms transport (see I2CComms::getMaxReadBlockSize) and by
+ the size of the temp buffers used in this class (READ_BLK_SIZE).
+*/
+int M24M02::readBlockSize() const
+{
+    int blkSize = static_cast<int>(comms->getMaxReadBlockSize());
+    if (blkSize <= 0 || blkSize > READ_BLK_SIZE) blkSize = READ_BLK_SIZE;
+    return blkSize;
+}
+
+
+
 /*!
  \brief Store a block of byte data to M24M02 EEPROM
+ The block is streamed as a series of writes which are aligned so that none
+ crosses a 256 byte sub-page (see note above). The ACK poll for each write
+ is done just before the next one is sent (see storeBytes), so no time is
+ lost sleeping between chunks.
  \param page      Page to use (0 - 3)
  \param address   Starting address for write (0 = start of page)
                   On SUCCESS, address is automatically incremented by the number of bytes stored.
@@ -745,10 +952,13 @@ int M24M02::storeBlock(uint8_t page, uint16_t *address, uint8_t *data, uint16_t
     int bytesLeftToWrite = nBytes; // Number of bytes left to write
     int srcOffset = 0;
     int result = globals::OK;
+    const int blkSize = writeBlockSize();
 
     while (bytesLeftToWrite > 0)
     {
-        int bytesThisWrite = (bytesLeftToWrite <= WRITE_BLK_SIZE) ? bytesLeftToWrite : WRITE_BLK_SIZE;
+        int bytesThisWrite = (bytesLeftToWrite <= blkSize) ? bytesLeftToWrite : blkSize;
+        const int bytesToSubPageEnd = 256 - ((*address) % 256);
+        if (bytesThisWrite > bytesToSubPageEnd) bytesThisWrite = bytesToSubPageEnd;
 
         result = storeBytes(page, address, data + srcOffset, static_cast<uint8_t>(bytesThisWrite));
         if (result != globals::OK) return result;   // EEPROM write error!
@@ -762,6 +972,10 @@ int M24M02::storeBlock(uint8_t page, uint16_t *address, uint8_t *data, uint16_t
 
 /*!
  \brief Load a block of byte data from M24M02 EEPROM
+ The block is read as one sequential pass of back-to-back reads (each limited
+ by readBlockSize, and aligned so none crosses a 256 byte sub-page). Callers
+ should read a whole region at once and parse it in memory, rather than
+ reading individual fields.
  \param page      Page to use (0 - 3)
  \param address   Starting address for read (0 = start of page)
                   On SUCCESS, address is automatically incremented by the number of bytes stored.
@@ -782,10 +996,13 @@ int M24M02::loadBlock(uint8_t page, uint16_t *address, uint8_t *data, uint16_t n
     int bytesLeftToRead = nBytes;
     int destOffset = 0;
     int result = globals::OK;
+    const int blkSize = readBlockSize();
 
     while (bytesLeftToRead > 0)
     {
-        int bytesThisRead = (bytesLeftToRead <= READ_BLK_SIZE) ? bytesLeftToRead : READ_BLK_SIZE;
+        int bytesThisRead = (bytesLeftToRead <= blkSize) ? bytesLeftToRead : blkSize;
+        const int bytesToSubPageEnd = 256 - ((*address) % 256);
+        if (bytesThisRead > bytesToSubPageEnd) bytesThisRead = bytesToSubPageEnd;
 
         result = loadBytes(page, address, data + destOffset, static_cast<uint8_t>(bytesThisRead));
         if (result != globals::OK) return result;   // EEPROM read error!
@@ -822,6 +1039,7 @@ int M24M02::storeString(StringID stringID, const QString &stringData)
     DEBUG_EEPROM("EEPROM: Storing string " << stringID << " at " << address << ": '" << stringData << "'")
 
     uint8_t data[WRITE_BLK_SIZE];  // Temp buffer for reading blocks from eeprom; Max 59 bytes per write (I2C adaptor limit)
+    const int blkSize = writeBlockSize();
 
     int bytesLeftToWrite = (stringData.length() <= stringInfo.maxLength) ? stringData.length() : stringInfo.maxLength;
       // Number of bytes left to write; If string is longer than max length for this location, truncate.
@@ -829,7 +1047,7 @@ int M24M02::storeString(StringID stringID, const QString &stringData)
     int srcOffset = 0;
     while (bytesLeftToWrite > 0)
     {
-        int bytesThisWrite = (bytesLeftToWrite <= WRITE_BLK_SIZE) ? bytesLeftToWrite : WRITE_BLK_SIZE;
+        int bytesThisWrite = (bytesLeftToWrite <= blkSize) ? bytesLeftToWrite : blkSize;
 
         // Add characters to the temp buffer, stopping if we get to the end of the string:
         for (int i = 0; i < bytesThisWrite; i++)
@@ -871,17 +1089,18 @@ int M24M02::loadString(StringID stringID, QString &stringData)
     DEBUG_EEPROM("EEPROM: Loading string " << stringID << " from " << stringInfo.address)
 
     uint8_t data[READ_BLK_SIZE];  // Temp buffer for reading blocks from eeprom; Max 64 bytes per read (I2C adaptor limit)
+    const int blkSize = readBlockSize();
     uint16_t address = stringInfo.address;
     int bytesLeftToRead = stringInfo.maxLength;
     while (true)
     {
-        int bytesThisRead = (bytesLeftToRead <= READ_BLK_SIZE) ? bytesLeftToRead : READ_BLK_SIZE;
+        int bytesThisRead = (bytesLeftToRead <= blkSize) ? bytesLeftToRead : blkSize;
 
         result = loadBytes(PAGE_STRINGS, &address, data, static_cast<uint8_t>(bytesThisRead));
         if (result != globals::OK) return result;   // EEPROM read error!
 
         // Add characters to the returned string, stopping if we get a NUL:
-        for (int i = 0; i < READ_BLK_SIZE; i++)
+        for (int i = 0; i < bytesThisRead; i++)
         {
             if (data[i] == 0x00 || data[i] == 0xFF) return globals::OK;
               // NUL terminator or no data: End of string reached (C-style string).
@@ -897,48 +1116,50 @@ int M24M02::loadString(StringID stringID, QString &stringData)
 
 
 /*!
- \brief Store an LMX Frequency Profile
- \param address  Address to store to
-                 On SUCCESS, address is automatically incremented by the number of bytes stored.
- \param profile  Profile to store
- \return globals::OK  Stored OK
+ \brief Encode an LMX Frequency Profile into a host buffer
+ Record layout: Frequency (4 byte float), register count (UInt16), register
+ values (UInt16 each), checksum (UInt16 sum of all preceding bytes).
+ All values little endian.
+ \param profile   Profile to encode
+ \param data      Buffer to receive the record (created by caller)
+ \param maxBytes  Size of data. Records which won't fit aren't encoded.
+ \param nBytes    Set to the size of the encoded record
+ \return globals::OK        Encoded OK
+ \return globals::OVERFLOW  Record would not fit in maxBytes
  \return [Error code]
 */
-int M24M02::storeFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile)
+int M24M02::encodeFrequencyProfile(const LMXFrequencyProfile &profile, uint8_t *data, int maxBytes, uint16_t *nBytes)
 {
-    int result;
     uint16_t checkSum = 0;
     uint16_t value = 0;
     uint8_t registerAddress = 0;
 
-    DEBUG_EEPROM_EXTRA("storeFrequencyProfile: Address: " << *address << "; Frequency: " << profile.getFrequency())
+    DEBUG_EEPROM_EXTRA("encodeFrequencyProfile: Frequency: " << profile.getFrequency())
 
     // -- Frequency, converted to array of 4 bytes: --
     float frequency = profile.getFrequency();
     Q_ASSERT(sizeof frequency == 4);
     if (sizeof frequency != 4) return globals::GEN_ERROR; // Paranoid.
 
-    // Create a temp buffer in memory, to make writing to EEPROM faster:
-    uint16_t profileSize = 4    // Frequency
-                         + 2    // Register Count
-                         + static_cast<uint16_t>(profile.getRegisterCount() * 2)  // Register Values
-                         + 2;   // Checksum
-    uint8_t *dataBuffer = new uint8_t[profileSize];
-    if (!dataBuffer) return globals::MALLOC_ERROR;
+    const int profileSize = 4    // Frequency
+                          + 2    // Register Count
+                          + (profile.getRegisterCount() * 2)  // Register Values
+                          + 2;   // Checksum
+    if (profileSize > maxBytes) return globals::OVERFLOW;
     int bufferAddress = 0;
 
     DEBUG_EEPROM_EXTRA("-N Registers:  " << profile.getRegisterCount() << "; N Bytes: " << profileSize)
     DEBUG_EEPROM_EXTRA("Checksum:++0:" << checkSum)
-    memcpy(dataBuffer + bufferAddress, &frequency, 4);
-    checkSum += dataBuffer[0] + dataBuffer[1] + dataBuffer[2] + dataBuffer[3];
+    memcpy(data + bufferAddress, &frequency, 4);
+    checkSum += data[0] + data[1] + data[2] + data[3];
     bufferAddress += 4;
     DEBUG_EEPROM_EXTRA("Checksum:++C:" << checkSum)
 
     // -- Number of registers: --
     value = static_cast<uint16_t>(profile.getRegisterCount());
-    dataBuffer[bufferAddress]   = static_cast<uint8_t>(value & 0x00FF);
-    dataBuffer[bufferAddress+1] = static_cast<uint8_t>(value >> 8);
-    checkSum += dataBuffer[bufferAddress] + dataBuffer[bufferAddress+1];
+    data[bufferAddress]   = static_cast<uint8_t>(value & 0x00FF);
+    data[bufferAddress+1] = static_cast<uint8_t>(value >> 8);
+    checkSum += data[bufferAddress] + data[bufferAddress+1];
     bufferAddress += 2;
 
     DEBUG_EEPROM_EXTRA("Checksum:++N:" << checkSum)
@@ -947,46 +1168,50 @@ int M24M02::storeFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profil
     for (registerAddress = 0; registerAddress < profile.getRegisterCount(); registerAddress++)
     {
         value = static_cast<uint16_t>(profile.getRegisterValue(registerAddress, nullptr));
-        dataBuffer[bufferAddress]   = static_cast<uint8_t>(value & 0x00FF);
-        dataBuffer[bufferAddress+1] = static_cast<uint8_t>(value >> 8);
-        DEBUG_EEPROM_EXTRA("  ->Write:" << INT_AS_HEX(dataBuffer[bufferAddress],2) << INT_AS_HEX(dataBuffer[bufferAddress + 1],2) << ": " << value)
-        checkSum += dataBuffer[bufferAddress] + dataBuffer[bufferAddress + 1];
+        data[bufferAddress]   = static_cast<uint8_t>(value & 0x00FF);
+        data[bufferAddress+1] = static_cast<uint8_t>(value >> 8);
+        DEBUG_EEPROM_EXTRA("  ->Write:" << INT_AS_HEX(data[bufferAddress],2) << INT_AS_HEX(data[bufferAddress + 1],2) << ": " << value)
+        checkSum += data[bufferAddress] + data[bufferAddress + 1];
         bufferAddress += 2;
         DEBUG_EEPROM_EXTRA("Checksum:  ++R:" << checkSum)
     }
 
     DEBUG_EEPROM_EXTRA("Checksum Final: " << checkSum)
     // -- Checksum: --
-    dataBuffer[bufferAddress]   = static_cast<uint8_t>(checkSum & 0x00FF);
-    dataBuffer[bufferAddress+1] = static_cast<uint8_t>(checkSum >> 8);
+    data[bufferAddress]   = static_cast<uint8_t>(checkSum & 0x00FF);
+    data[bufferAddress+1] = static_cast<uint8_t>(checkSum >> 8);
     bufferAddress += 2;
 
-    result = storeBlock(PAGE_FREQ_PROFILES, address, dataBuffer, profileSize);
-
-    delete [] dataBuffer;
-    DEBUG_EEPROM_EXTRA("-Result:  " << result << "; Checksum: " << checkSum << "; Address now: " << *address)
-    return result;
+    *nBytes = static_cast<uint16_t>(bufferAddress);
+    return globals::OK;
 }
 
 
 
 
 
-int M24M02::loadFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile)
+/*!
+ \brief Decode an LMX Frequency Profile from a host buffer
+ See encodeFrequencyProfile for the record layout.
+ \param data      Record data (e.g. one 256 byte sub-page read from the EEPROM)
+ \param nBytes    Size of data. Records which claim to be larger are rejected.
+ \param profile   Profile to fill
+ \param checkSum  OPTIONAL: Set to the checksum stored with the profile
+ \return globals::OK            Decoded OK
+ \return globals::END_OF_DATA   Record is blank (unused EEPROM)
+ \return globals::INVALID_DATA  Record is malformed
+ \return globals::BAD_CHECKSUM  Profile data didn't match stored checksum
+ \return [Error code]
+*/
+int M24M02::decodeFrequencyProfile(const uint8_t *data, int nBytes, LMXFrequencyProfile &profile, uint16_t *checkSum)
 {
-    int result = globals::OK;
     uint16_t checksumCalculated = 0;
+    if (nBytes < 6) return globals::INVALID_DATA;
 
-    DEBUG_EEPROM_EXTRA("loadFrequencyProfile: From Address: " << *address)
-
-    uint8_t frequencyData[4] = { 0 };  // Frequency as a byte array
-    result = loadBlock(PAGE_FREQ_PROFILES, address, frequencyData, 4);
-    if (result != globals::OK) return result;
-
-    if (frequencyData[0] == 0xFF
-     && frequencyData[1] == 0xFF
-     && frequencyData[2] == 0xFF
-     && frequencyData[3] == 0xFF)
+    if (data[0] == 0xFF
+     && data[1] == 0xFF
+     && data[2] == 0xFF
+     && data[3] == 0xFF)
     {
         // End of data marker!
         // NB: This system is deprecated in favour of having a profile count at the start of the data.
@@ -996,79 +1221,121 @@ int M24M02::loadFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile
         return globals::END_OF_DATA;
     }
 
-    DEBUG_EEPROM_EXTRA("Checksum:--0:" << checksumCalculated)
-
     float frequency = 0.0f;
     Q_ASSERT(sizeof frequency == 4);
     if (sizeof frequency != 4) return globals::GEN_ERROR;  // Paranoid.
-    memcpy(&frequency, frequencyData, 4);
+    memcpy(&frequency, data, 4);
     profile.setFrequency(frequency);
-    checksumCalculated += frequencyData[0] + frequencyData[1] + frequencyData[2] + frequencyData[3];
+    checksumCalculated += data[0] + data[1] + data[2] + data[3];
 
-    DEBUG_EEPROM_EXTRA("-Found Frequency: " << frequency << "; Address now: " << *address)
+    DEBUG_EEPROM_EXTRA("-Found Frequency: " << frequency)
     DEBUG_EEPROM_EXTRA("Checksum:--C:" << checksumCalculated)
 
     // -- Number of Registers: --
-    uint16_t registerCount = 0;
-    result = loadUInt16(PAGE_FREQ_PROFILES, address, &registerCount, &checksumCalculated);
-    if (result != globals::OK) return result;
+    const uint16_t registerCount = static_cast<uint16_t>(data[5] << 8) | data[4];
+    checksumCalculated += data[4] + data[5];
     if (registerCount > 255) return globals::INVALID_DATA;  // Sanity check
+    if (6 + (registerCount * 2) + 2 > nBytes) return globals::INVALID_DATA;
     profile.setRegisterCount(registerCount);
-    uint16_t readSize = (registerCount * 2) + 2;   // Data for registers, plus checksum
 
-    DEBUG_EEPROM_EXTRA("-Found Register Count: " << registerCount << "; Address now: " << *address << "; Reading " << readSize << " more bytes.")
+    DEBUG_EEPROM_EXTRA("-Found Register Count: " << registerCount)
     DEBUG_EEPROM_EXTRA("Checksum:--N:" << checksumCalculated)
 
-    // -- Register data and checksum: --
-    uint8_t *dataBuffer = new uint8_t[readSize];
-    if (!dataBuffer) return globals::MALLOC_ERROR;
-
-    uint16_t bufferAddress = 0;
-    uint16_t checkSumStored = 0;
-
-    result = loadBlock(PAGE_FREQ_PROFILES, address, dataBuffer, readSize);
-    if (result != globals::OK) goto cleanup;
-
-    DEBUG_EEPROM_EXTRA("-Data read. Address now: " << *address)
-
     // Add registers to the profile, and calculate the checksum:
+    int bufferAddress = 6;
     for (uint8_t registerAddress = 0; registerAddress < registerCount; registerAddress++)
     {
-        uint16_t value = static_cast<uint16_t>(dataBuffer[bufferAddress + 1] << 8) | dataBuffer[bufferAddress];
+        uint16_t value = static_cast<uint16_t>(data[bufferAddress + 1] << 8) | data[bufferAddress];
         profile.setRegisterValue(registerAddress, value);
-        DEBUG_EEPROM_EXTRA("  ->Read:" << INT_AS_HEX(dataBuffer[bufferAddress],2) << INT_AS_HEX(dataBuffer[bufferAddress + 1],2) << ": " << value)
-        checksumCalculated += dataBuffer[bufferAddress] + dataBuffer[bufferAddress + 1];
+        DEBUG_EEPROM_EXTRA("  ->Read:" << INT_AS_HEX(data[bufferAddress],2) << INT_AS_HEX(data[bufferAddress + 1],2) << ": " << value)
+        checksumCalculated += data[bufferAddress] + data[bufferAddress + 1];
         bufferAddress += 2;
         DEBUG_EEPROM_EXTRA("Checksum:  --R:" << checksumCalculated)
     }
 
     DEBUG_EEPROM_EXTRA("Checksum Final: " << checksumCalculated)
     // Extract the stored checksum:
-    checkSumStored = static_cast<uint16_t>(dataBuffer[bufferAddress + 1] << 8) | dataBuffer[bufferAddress];
+    const uint16_t checkSumStored = static_cast<uint16_t>(data[bufferAddress + 1] << 8) | data[bufferAddress];
+    if (checkSum) *checkSum = checkSumStored;
 
     DEBUG_EEPROM_EXTRA("-Extracted Checksum from read data. Checksum test: Stored = " << checkSumStored << "; Calculated = " << checksumCalculated)
 
-    if (checkSumStored == checksumCalculated)
+    if (checkSumStored != checksumCalculated)
     {
-        DEBUG_EEPROM_EXTRA("-Checksum Match.")
-        profile.setValid();
+        DEBUG_EEPROM("WARNING: decodeFrequencyProfile: Checksum Mismatch!")
+        return globals::BAD_CHECKSUM;
     }
-    else
+    DEBUG_EEPROM_EXTRA("-Checksum Match.")
+    profile.setValid();
+    return globals::OK;
+}
+
+
+
+
+
+/*!
+ \brief Read Frequency Profiles from the host cache, if it matches the EEPROM
+ The cache is found using the EEPROM serial number. It is used only if the
+ synth config version string, the profile count, and the checksum stored in
+ the EEPROM for each profile all match the cache. Only the checksums are read
+ from the profile data (2 bytes per profile, at the position given by the
+ cached register count), instead of the whole profile.
+ \param profileCount        Number of profiles stored in the EEPROM
+ \param frequencyProfiles   Set to the cached profiles if the cache is valid
+ \param cacheFileName       Set to the cache file for this EEPROM (empty if no serial number)
+ \param synthConfigVersion  Set to synth config version string read from the EEPROM
+ \return globals::OK            Cache valid; frequencyProfiles filled
+ \return globals::FILE_ERROR    No cache for this EEPROM
+ \return globals::INVALID_DATA  Cache doesn't match EEPROM
+ \return [Error code]           Error reading EEPROM
+*/
+int M24M02::readCachedFrequencyProfiles(uint16_t profileCount, QList<LMXFrequencyProfile> &frequencyProfiles,
+                                        QString &cacheFileName, QString &synthConfigVersion)
+{
+    cacheFileName.clear();
+    synthConfigVersion.clear();
+
+    QString serial;
+    int result = loadString(SERIAL, serial);
+    if (result != globals::OK) return result;
+    cacheFileName = BertFile::profileCacheFileName(serial);
+    if (cacheFileName.isEmpty()) return globals::FILE_ERROR;
+    result = loadString(SYNTH_CONFIG_VERSION, synthConfigVersion);
+    if (result != globals::OK) return result;
+
+    QString cachedVersion;
+    QList<LMXFrequencyProfile> cachedProfiles;
+    QList<quint16> cachedCheckSums;
+    result = BertFile::readProfileCache(cacheFileName, cachedVersion, cachedProfiles, cachedCheckSums);
+    if (result != globals::OK) return result;
+    if (cachedVersion != synthConfigVersion || cachedProfiles.count() != profileCount)
     {
-        DEBUG_EEPROM("WARNING: loadFrequencyProfile: Checksum Match!")
-        result = globals::BAD_CHECKSUM;
+        DEBUG_EEPROM("M24M02: Profile cache doesn't match EEPROM (version / count)")
+        return globals::INVALID_DATA;
     }
 
-  cleanup:
-    delete [] dataBuffer;
-    DEBUG_EEPROM_EXTRA("-Result:  " << result << "; Address now: " << *address)
-    return result;
+    for (int profileIndex = 0; profileIndex < profileCount; profileIndex++)
+    {
+        // Profile layout: Frequency (4), Register count (2), Registers (2 x count), Checksum (2):
+        uint16_t address = static_cast<uint16_t>((profileIndex + 1) * 256 + 6
+                                               + cachedProfiles.at(profileIndex).getRegisterCount() * 2);
+        uint16_t checkSum = 0;
+        result = loadUInt16(PAGE_FREQ_PROFILES, &address, &checkSum, nullptr);
+        if (result != globals::OK) return result;
+        if (checkSum != cachedCheckSums.at(profileIndex))
+        {
+            DEBUG_EEPROM("M24M02: Profile cache doesn't match EEPROM (checksum, profile " << profileIndex << ")")
+            return globals::INVALID_DATA;
+        }
+    }
+    DEBUG_EEPROM("M24M02: Using " << profileCount << " cached frequency profiles")
+    frequencyProfiles = cachedProfiles;
+    return globals::OK;
 }
 
 
 
-
-
 /*!
  * \brief Clear EEPROM Memory
  * This method resets the contents of the string table to 0xFF (factory default).
@@ -1079,19 +1346,14 @@ int M24M02::loadFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile
 int M24M02::clearEEPROM()
 {
     int result;
-    uint8_t BLANK = 0xFF;
     foreach(StringID id, strings.keys())
     {
-        const uint16_t startAddr = strings[id].address;
-        const uint16_t endAddr = startAddr + static_cast<uint16_t>(strings[id].maxLength);
-        DEBUG_EEPROM("CLEAR String " << id << ": Addr " << startAddr << " to " << endAddr-1)
-        for (uint16_t address = startAddr;
-                      address < endAddr;
-                      address++)
-        {
-            result = storeBytes(PAGE_STRINGS, &address, &BLANK, 1);
-            if (result != globals::OK) return result;
-        }
+        uint16_t address = strings[id].address;
+        const uint16_t length = static_cast<uint16_t>(strings[id].maxLength);
+        QByteArray blank(length, static_cast<char>(0xFF));
+        DEBUG_EEPROM("CLEAR String " << id << ": Addr " << address << " to " << address + length - 1)
+        result = storeBlock(PAGE_STRINGS, &address, reinterpret_cast<uint8_t *>(blank.data()), length);
+        if (result != globals::OK) return result;
     }
     return globals::OK;
 }
@@ -1105,20 +1367,10 @@ int M24M02::clearEEPROM()
  */
 int M24M02::clearPROFILES()
 {
-    int result;
-    uint8_t BLANK = 0xFF;
-    const uint16_t startAddr = 0x0000;
-    const uint16_t endAddr = 0xFFFF;
-    DEBUG_EEPROM("CLEAR Freq Profiles: Addr " << startAddr << " to " << endAddr-1)
-    for (uint16_t address = startAddr;
-                      address < endAddr;
-                      address++)
-        {
-            result = storeBytes(PAGE_FREQ_PROFILES, &address, &BLANK, 1);
-            if (result != globals::OK) return result;
-        }
-
-    return globals::OK;
+    QByteArray blank(65535, static_cast<char>(0xFF));
+    uint16_t address = 0x0000;
+    DEBUG_EEPROM("CLEAR Freq Profiles: Addr " << address << " to " << blank.size() - 1)
+    return storeBlock(PAGE_FREQ_PROFILES, &address, reinterpret_cast<uint8_t *>(blank.data()), static_cast<uint16_t>(blank.size()));
 }
 
 
@@ -69,6 +69,8 @@ public:
 
     int readFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &frequencyProfiles);
     int writeFrequencyProfiles(int deviceID, QList<LMXFrequencyProfile> &frequencyProfiles);
+    int verifyFrequencyProfiles(int deviceID, const QList<LMXFrequencyProfile> &frequencyProfiles,
+                                QMap<int, LMXFrequencyProfile> &mismatchedProfiles, int *storedCount = nullptr);
   //  void WriteFirmare(int deviceID);
 
 
@@ -132,14 +134,26 @@ private:
     static const uint8_t PAGE_Firmware      = 3;
 
 
-    // Max block sizes
+    // Max block sizes: Actual block size is limited by the comms transport (see writeBlockSize / readBlockSize).
+    // These are upper limits, used to size temp buffers.
     static const int WRITE_BLK_SIZE = 59;  // Limit of USB-I2C Adaptor write buffer
     static const int READ_BLK_SIZE = 64;   // Limit of USB-I2C Adaptor read buffer
 
+    // Frequency profiles: One per 256 byte sub-page, starting at sub-page 1 (sub-page 0 holds the count)
+    static const int PROFILE_SLOT_SIZE = 256;
+    static const int MAX_FREQ_PROFILES = 255;  // Max number of profiles which will fit in one page
+
+    static const int STORE_ACK_TIMEOUT_MS = 20;  // Max time to wait for a write cycle (datasheet max is 10 ms)
+
+    int writeBlockSize() const;
+    int readBlockSize() const;
+
     I2CComms *comms;
     const uint8_t i2cAddress;
     const int deviceID;
 
+    bool storePending;  // A write has been sent, and the EEPROM may still be busy storing it (see waitStoreAck)
+
     int storeBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t nBytes);
     int loadBytes(uint8_t page, uint16_t *address, uint8_t *data, uint8_t nBytes);
 
@@ -154,8 +168,11 @@ private:
     int storeString(StringID stringID, const QString &stringData);
     int loadString(StringID stringID, QString &stringData);
 
-    int storeFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile);
-    int loadFrequencyProfile(uint16_t *address, LMXFrequencyProfile &profile);
+    int encodeFrequencyProfile(const LMXFrequencyProfile &profile, uint8_t *data, int maxBytes, uint16_t *nBytes);
+    int decodeFrequencyProfile(const uint8_t *data, int nBytes, LMXFrequencyProfile &profile, uint16_t *checkSum = nullptr);
+
+    int readCachedFrequencyProfiles(uint16_t profileCount, QList<LMXFrequencyProfile> &frequencyProfiles,
+                                    QString &cacheFileName, QString &synthConfigVersion);
 
 
     int clearEEPROM();
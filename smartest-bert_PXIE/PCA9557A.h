@@ -119,6 +119,8 @@ private:
     // Default values reflect power-on defaults for device registers.
     uint8_t regInput    = 0x00;  // Input buffer; One bit per I/O pin
     uint8_t regOutput   = 0x00;  // Output buffer; One bit per I/O pin
+    uint8_t regOutputWritten = 0x00;  // Last value written to the device output register
+    bool outputValid    = false; // regOutputWritten matches the device (false until first write)
     uint8_t regPolarity = 0xF0;  // Polarity Inversion Register; One bit per I/O pin, inverts INPUT value; 0 = Normal; 1 = Inverted
     uint8_t regConfig   = 0xFF;  // Configuration Register; One bit per I/O pin; 0 = Output; 1 = Input
 
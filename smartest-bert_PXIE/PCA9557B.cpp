@@ -143,7 +143,8 @@ int PCA9557B::init()
         return result;
     }
 
-    // Set safe default settings:
+    // Set safe default settings (always written; device may have been reset):
+    outputValid = false;
     //  - Default trigger divide ratio
     //  - Default master divide ratio
     result = setPins(TRIGGER_DIVIDE_LOOKUP[TRIGGER_DIVIDE_DEFAULT_INDEX]
@@ -371,20 +372,25 @@ int PCA9557B::updatePins(const uint8_t mask, const uint8_t value)
 /*!
  * \brief Write latest values to PCA9557B pins
  *        This method updates the hardware adaptor with the latest set of
- *        pin values set by calls to setPin.
+ *        pin values set by calls to setPin. The write is skipped if the
+ *        output register already holds these values.
  * \return globals::OK   IO expander output register set OK
  * \return [Error code]  Error occurred (comms not connected, etc).
  */
 int PCA9557B::writePins()
 {
     if (!comms->portIsOpen()) return globals::NOT_CONNECTED;
+    if (outputValid && regOutput == regOutputWritten) return globals::OK;  // No change
     // Write the output register:
     int result = comms->write8(i2cAddress, REG_OUPUT, &regOutput, 1);
     if (result != globals::OK)
     {
         qDebug() << "Error writing to PCA9557B output register: " << result;
+        outputValid = false;
         return result;
     }
+    regOutputWritten = regOutput;
+    outputValid = true;
     // OK!
     return globals::OK;
 }
@@ -439,6 +445,7 @@ int PCA9557B::readPins()
 int PCA9557B::test(bool loopBackTest)
 {
     if (!comms->portIsOpen()) return globals::NOT_CONNECTED;
+    outputValid = false;  // Test writes the output register directly
     qDebug() << "Starting PCA9557B Interface Tests...";
     int result;
 
@@ -37,12 +37,24 @@ SOURCES += main.cpp\
            mainwindow.cpp \
            globals.cpp \
            BertWorker.cpp \
+           BertPoller.cpp \
+           BertHeadless.cpp \
+           BertInstrument.cpp \
+           BertLog.cpp \
            Serial.cpp \
+           I2CTransport.cpp \
+           I2CProfiler.cpp \
+           I2CSimulator.cpp \
            I2CComms.cpp \
            GT1724.cpp \
            BertComponent.cpp \
            LMX2594.cpp \
            EyeMonitor.cpp \
+           EyeScanResult.cpp \
+           BathtubFit.cpp \
+           BERHistory.cpp \
+           EDConfidence.cpp \
+           BertTestPlan.cpp \
            BertFile.cpp \
            BertChannel.cpp \
     tlc59108.cpp \
@@ -80,12 +92,24 @@ HEADERS += mainwindow.h \
     PCA9557B.h \
            globals.h \
            BertWorker.h \
+           BertPoller.h \
+           BertHeadless.h \
+           BertInstrument.h \
+           BertLog.h \
            Serial.h \
+           I2CTransport.h \
+           I2CProfiler.h \
+           I2CSimulator.h \
            I2CComms.h \
            GT1724.h \
            BertComponent.h \
            LMX2594.h \
            EyeMonitor.h \
+           EyeScanResult.h \
+           BathtubFit.h \
+           BERHistory.h \
+           EDConfidence.h \
+           BertTestPlan.h \
            BertFile.h \
            BertChannel.h \
     tlc59108.h \
@@ -125,6 +149,20 @@ RC_FILE = resources\PG3204.rc
 
 RESOURCES = resources\PG3204.qrc
 
+# List the simulated I2C adaptor (I2CSimulator) as a port (works without hardware):
+#DEFINES  += BERT_SIMULATOR
+
+# Back end benchmark (see benchmark.txt): "make benchmark" builds the app, then
+# runs the benchmark script on the simulated adaptor and writes benchmark.json:
+win32 {
+    benchmark.depends  = $(DESTDIR_TARGET)
+    benchmark.commands = $(DESTDIR_TARGET) --headless $$shell_path($$PWD/benchmark.txt) > benchmark.json
+} else {
+    benchmark.depends  = $(TARGET)
+    benchmark.commands = ./$(TARGET) --headless $$PWD/benchmark.txt > benchmark.json
+}
+QMAKE_EXTRA_TARGETS += benchmark
+
 # For Release:
 #DEFINES  += QT_NO_DEBUG_OUTPUT QT_NO_WARNING_OUTPUT
 
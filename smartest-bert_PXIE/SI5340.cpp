@@ -153,54 +153,33 @@ void SI5340::RefClockSelectProfile(int indexProfile, bool triggerResync)
 
 int SI5340::selectProfile(int index)
 {
-    Q_ASSERT(CONFIG_PROFILES.contains(index));
-    if (!CONFIG_PROFILES.contains(index)) return globals::OVERFLOW;
+    Q_ASSERT(index >= 0 && index < CONFIG_PROFILES.size());
+    if (index < 0 || index >= CONFIG_PROFILES.size()) return globals::OVERFLOW;
 
     DEBUG_SI5340("SI5340: Select Profile " << index)
 
-    // Get a reference to the register values for the new profile:
-    const QList<SI5340Register_t> newProfile = CONFIG_PROFILES[index];
+    // Get a reference to the register bursts for the new profile:
+    const QList<SI5340Burst_t> &newProfile = PROFILE_BURSTS.at(index);
 
     int result = globals::OK;
 
     // PREAMBLE: Load preamble registers:
     DEBUG_SI5340("SI5340: -Load Preamble Registers...")
-    foreach (SI5340Register_t preambleRegister, CONFIG_PREAMBLE)
-    {
-        // Extract 8-bit page and 8-bit address from 16 bit address:
-        uint8_t page = static_cast<uint8_t>(preambleRegister.address >> 8);
-        uint8_t address = static_cast<uint8_t>(preambleRegister.address & 0xFF);
-
-        result = writeRegister(page, address, preambleRegister.value);
-        if (result != globals::OK) return result;
-    }
+    result = writeBurstList(PREAMBLE_BURSTS);
+    if (result != globals::OK) return result;
 
     // SLEEP after preamble (See data sheet!):
     globals::sleep(PREAMBLE_SLEEP_MS);
 
     // Load Registers:
     DEBUG_SI5340("SI5340: -Load Profile Registers...")
-    foreach (SI5340Register_t profileRegister, newProfile)
-    {
-        // Extract 8-bit page and 8-bit address from 16 bit address:
-        uint8_t page = static_cast<uint8_t>(profileRegister.address >> 8);
-        uint8_t address = static_cast<uint8_t>(profileRegister.address & 0xFF);
-
-        result = writeRegister(page, address, profileRegister.value);
-        if (result != globals::OK) return result;
-    }
+    result = writeBurstList(newProfile);
+    if (result != globals::OK) return result;
 
     // POSTAMBLE: Load postamble registers:
     DEBUG_SI5340("SI5340: -Load Postamble Registers...")
-    foreach (SI5340Register_t postambleRegister, CONFIG_POSTAMBLE)
-    {
-        // Extract 8-bit page and 8-bit address from 16 bit address:
-        uint8_t page = static_cast<uint8_t>(postambleRegister.address >> 8);
-        uint8_t address = static_cast<uint8_t>(postambleRegister.address & 0xFF);
-
-        result = writeRegister(page, address, postambleRegister.value);
-        if (result != globals::OK) return result;
-    }
+    result = writeBurstList(POSTAMBLE_BURSTS);
+    if (result != globals::OK) return result;
 
     // Profile selected. Update frequency info and descriptions:
     // HACKY: This hard-coded look-up has been created for testing as we're not yet sure
@@ -321,6 +300,129 @@ int SI5340::writeRegister(uint8_t page, uint8_t address, uint8_t data)
 }
 
 
+/*!
+ \brief Write a list of register values to the SI5340
+ The list is grouped into burst writes (see makeBursts), then written with
+ writeBurstList. Nb: The fixed register tables are grouped once at start up
+ (see PREAMBLE_BURSTS etc); this is for other lists.
+ \param registers  List of registers to write (in order)
+ \return globals::OK  Success
+ \return [error code]
+*/
+int SI5340::writeRegisterList(const ConstArray<SI5340Register_t> &registers)
+{
+    return writeBurstList(makeBursts(registers));
+}
+
+
+/*!
+ \brief Write a list of register bursts to the SI5340
+ Each burst is one multi-byte write: The SI5340 auto-increments the register
+ address after each byte (see SI5341 datasheet Section 9.1). The writes (and
+ any page changes required) are sent as a single I2C batch (see
+ I2CComms::runBatch), so several writes are packed into each adaptor
+ transaction.
+ \param bursts  List of bursts to write (in order)
+ \return globals::OK  Success
+ \return [error code]
+*/
+int SI5340::writeBurstList(const QList<SI5340Burst_t> &bursts)
+{
+    I2CBatch batch;
+    uint8_t batchPage = previousPage;
+    bool batchPageValid = pageValid;
+    foreach (const SI5340Burst_t &burst, bursts)
+    {
+        DEBUG_SI5340_EXTRA("SI5340: Register Write (Burst)"
+                           << ": Page=" << INT_AS_HEX(burst.page,2)
+                           << "; Address=" << INT_AS_HEX(burst.address,2)
+                           << "; Count=" << burst.count
+                           << "; Data=" << INT_AS_HEX(burst.values[0],2) << "...")
+
+        if (!batchPageValid || burst.page != batchPage)
+        {
+            // Register Address 0x01 on each page is the "Set Page Address" register:
+            batch.addWrite8(i2cAddress, 0x01, &burst.page, 1);
+            batchPage = burst.page;
+            batchPageValid = true;
+        }
+        batch.addWrite8(i2cAddress, burst.address, burst.values, burst.count);
+    }
+
+    int result = comms->runBatch(batch);
+    if (result == globals::OK)
+    {
+        previousPage = batchPage;
+        pageValid = batchPageValid;
+    }
+    else
+    {
+        // Error: We're not sure which page is selected now.
+        DEBUG_SI5340("SI5340: Comms error writing register list: " << result)
+        pageValid = false;
+    }
+    return result;
+}
+
+
+/*!
+ \brief Group a list of register values into burst writes
+ Registers which follow each other in the list, are on the same page, and
+ have consecutive addresses are merged into a single burst (up to
+ MAX_BURST_SIZE registers). The order of writes is preserved. The page
+ address register (0x01) is never merged into a burst.
+ \param registers  List of registers (in write order)
+ \return List of bursts
+*/
+QList<SI5340::SI5340Burst_t> SI5340::makeBursts(const ConstArray<SI5340Register_t> &registers)
+{
+    QList<SI5340Burst_t> bursts;
+    for (const SI5340Register_t &thisRegister : registers)
+    {
+        // Extract 8-bit page and 8-bit address from 16 bit address:
+        uint8_t page = static_cast<uint8_t>(thisRegister.address >> 8);
+        uint8_t address = static_cast<uint8_t>(thisRegister.address & 0xFF);
+
+        if (!bursts.isEmpty() && address != 0x01)
+        {
+            SI5340Burst_t &lastBurst = bursts.last();
+            if (lastBurst.page == page
+             && lastBurst.address != 0x01
+             && lastBurst.count < MAX_BURST_SIZE
+             && static_cast<int>(lastBurst.address) + lastBurst.count == address)
+            {
+                lastBurst.values[lastBurst.count] = thisRegister.value;
+                lastBurst.count++;
+                continue;
+            }
+        }
+        SI5340Burst_t newBurst;
+        newBurst.page = page;
+        newBurst.address = address;
+        newBurst.count = 1;
+        newBurst.values[0] = thisRegister.value;
+        bursts.append(newBurst);
+    }
+    return bursts;
+}
+
+
+/*!
+ \brief Group the register list for every profile into burst writes
+ Used to build PROFILE_BURSTS from CONFIG_PROFILES.
+ \return List of bursts for each profile, by profile index
+*/
+QList<QList<SI5340::SI5340Burst_t>> SI5340::makeProfileBursts()
+{
+    QList<QList<SI5340Burst_t>> profileBursts;
+    for (const ConstArray<SI5340Register_t> &profile : CONFIG_PROFILES)
+    {
+        profileBursts.append(makeBursts(profile));
+    }
+    return profileBursts;
+}
+
+
 /*!
  \brief Read from SI5340 register
  \param page      Register page
@@ -374,6 +476,8 @@ int SI5340::readRegister(uint8_t page, uint8_t address, uint8_t *data)
 //  Register Config Profiles
 //  These are just hard-coded with three profiles generated using the
 //  Silicon Labs software tool.
+//  Tables are constant arrays with ConstArray views (see globals.h), so
+//  they need no static initialisation.
 // ***************************************************************************
 
 const QStringList SI5340::PROFILE_LIST =
@@ -386,7 +490,7 @@ const QStringList SI5340::PROFILE_LIST =
 };
 
 
-const QList<SI5340::SI5340Register_t> SI5340::CONFIG_PREAMBLE =
+const SI5340::SI5340Register_t SI5340::CONFIG_PREAMBLE_REGISTERS[] =
 {
     /* Start configuration preamble */
     { 0x0B24, 0xC0 },
@@ -398,9 +502,10 @@ const QList<SI5340::SI5340Register_t> SI5340::CONFIG_PREAMBLE =
     { 0x0B4E, 0x1A }
     /* End configuration preamble */
 };
+const ConstArray<SI5340::SI5340Register_t> SI5340::CONFIG_PREAMBLE(SI5340::CONFIG_PREAMBLE_REGISTERS);
 
 
-const QList<SI5340::SI5340Register_t> SI5340::CONFIG_POSTAMBLE =
+const SI5340::SI5340Register_t SI5340::CONFIG_POSTAMBLE_REGISTERS[] =
 {
     /* Start configuration postamble */
     { 0x001C, 0x01 },
@@ -408,16 +513,12 @@ const QList<SI5340::SI5340Register_t> SI5340::CONFIG_POSTAMBLE =
     { 0x0B25, 0x02 }
     /* End configuration postamble */
 };
+const ConstArray<SI5340::SI5340Register_t> SI5340::CONFIG_POSTAMBLE(SI5340::CONFIG_POSTAMBLE_REGISTERS);
 
 
-const QMap<int, QList<SI5340::SI5340Register_t>> SI5340::CONFIG_PROFILES =
-  QMap<int, QList<SI5340::SI5340Register_t>>
-  (
-    {
-            // "On Board Oscillator - 100.00M":
-            {
-              0,  // Profile Index
-              {
+// "On Board Oscillator - 100.00M" (Profile Index 0):
+const SI5340::SI5340Register_t SI5340::CONFIG_PROFILE_0_REGISTERS[] =
+{
                           /* Start configuration registers */
                     { 0x0006, 0x00 },
                     { 0x0007, 0x00 },
@@ -737,8 +838,7 @@ const QMap<int, QList<SI5340::SI5340Register_t>> SI5340::CONFIG_PROFILES =
                     { 0x0B57, 0x0E },
                     { 0x0B58, 0x01 },
                           /* End configuration registers */
-              }
-            },
+};
 
             /*
             // "On Board Oscillator - 156.25M":
@@ -1393,10 +1493,10 @@ const QMap<int, QList<SI5340::SI5340Register_t>> SI5340::CONFIG_PROFILES =
               }
             },
         */
-      // "EXT. 10 MHz":
-      {
-        1,  // Profile Index
-        {
+
+// "EXT. 10 MHz" (Profile Index 1):
+const SI5340::SI5340Register_t SI5340::CONFIG_PROFILE_1_REGISTERS[] =
+{
                     /* Start configuration registers */
                     { 0x0006, 0x00 },
                     { 0x0007, 0x00 },
@@ -1716,13 +1816,11 @@ const QMap<int, QList<SI5340::SI5340Register_t>> SI5340::CONFIG_PROFILES =
                     { 0x0B57, 0x10 },
                     { 0x0B58, 0x05 },
                     /* End configuration registers */
-        }
-      },
+};
 
-      // "EXT. 100 MHz":
-      {
-        2,  // Profile Index
-        {
+// "EXT. 100 MHz" (Profile Index 2):
+const SI5340::SI5340Register_t SI5340::CONFIG_PROFILE_2_REGISTERS[] =
+{
                     /* Start configuration registers */
                     { 0x0006, 0x00 },
                     { 0x0007, 0x00 },
@@ -2042,11 +2140,25 @@ const QMap<int, QList<SI5340::SI5340Register_t>> SI5340::CONFIG_PROFILES =
                     { 0x0B57, 0x81 },
                     { 0x0B58, 0x00 },
                     /* End configuration registers */
-        }
-      }
+};
 
-    }
-  );
+
+// Profile table: Maps a profile index to the register list for that profile.
+const ConstArray<SI5340::SI5340Register_t> SI5340::CONFIG_PROFILE_LIST[] =
+{
+    ConstArray<SI5340::SI5340Register_t>(SI5340::CONFIG_PROFILE_0_REGISTERS),
+    ConstArray<SI5340::SI5340Register_t>(SI5340::CONFIG_PROFILE_1_REGISTERS),
+    ConstArray<SI5340::SI5340Register_t>(SI5340::CONFIG_PROFILE_2_REGISTERS)
+};
+const ConstArray<ConstArray<SI5340::SI5340Register_t>> SI5340::CONFIG_PROFILES(SI5340::CONFIG_PROFILE_LIST);
+
+
+// Burst versions of the tables above, built once at start up (a C++11 constexpr
+// function can't build them at compile time). Nb: These must be defined AFTER
+// the register tables; the tables are constant-initialised, so they are ready.
+const QList<SI5340::SI5340Burst_t> SI5340::PREAMBLE_BURSTS = SI5340::makeBursts(SI5340::CONFIG_PREAMBLE);
+const QList<SI5340::SI5340Burst_t> SI5340::POSTAMBLE_BURSTS = SI5340::makeBursts(SI5340::CONFIG_POSTAMBLE);
+const QList<QList<SI5340::SI5340Burst_t>> SI5340::PROFILE_BURSTS = SI5340::makeProfileBursts();
 
 
 
@@ -63,32 +63,66 @@ private:
         // SI5340Register_t(uint16_t address, uint8_t value) : address(address), value(value) {}
     } SI5340Register_t;
 
+    static const int MAX_BURST_SIZE = 26;
+      // Max number of registers in one auto-increment burst write. Small enough
+      // that two bursts still pack into one adaptor frame (see I2CComms::runBatch):
+      // Each burst is a 4 byte AD1 command header plus data, and 2 x (4 + 26)
+      // is BATCH_FRAME_WRITE_MAX (60).
+
+    typedef struct SI5340Burst_t
+    {
+        uint8_t page;                    // Register page
+        uint8_t address;                 // First register address (within page)
+        uint8_t count;                   // Number of consecutive registers to write
+        uint8_t values[MAX_BURST_SIZE];  // 8-bit register data, in address order
+    } SI5340Burst_t;
+
     static const QStringList PROFILE_LIST;
       // List of 'profiles' the user can select
 
     static const int DEFAULT_PROFILE = 0;
       // Default profiles at startup
 
-    static const QList<SI5340Register_t> CONFIG_PREAMBLE;
+    // Register tables are constant arrays (see ConstArray in globals.h):
+    // No static initialisation, and no copies when a profile is selected.
+    static const SI5340Register_t CONFIG_PREAMBLE_REGISTERS[];
+    static const SI5340Register_t CONFIG_POSTAMBLE_REGISTERS[];
+    static const SI5340Register_t CONFIG_PROFILE_0_REGISTERS[];
+    static const SI5340Register_t CONFIG_PROFILE_1_REGISTERS[];
+    static const SI5340Register_t CONFIG_PROFILE_2_REGISTERS[];
+    static const ConstArray<SI5340Register_t> CONFIG_PROFILE_LIST[];
+
+    static const ConstArray<SI5340Register_t> CONFIG_PREAMBLE;
       // Registers to set first when starting to set up the device for a profile.
       // These are the same for ALL profiles.
 
     static const int PREAMBLE_SLEEP_MS = 300;
       // Sleep this many milliseconds after setting CONFIG_PREAMBLE registers
 
-    static const QMap<int, QList<SI5340Register_t>> CONFIG_PROFILES;
-      // Maps a profile index to a list of register settings for that profile.
+    static const ConstArray<ConstArray<SI5340Register_t>> CONFIG_PROFILES;
+      // List of register settings for each profile, by profile index.
       // Must be one profile index for each profile in PROFILE_LIST.
 
-    static const QList<SI5340Register_t> CONFIG_POSTAMBLE;
+    static const ConstArray<SI5340Register_t> CONFIG_POSTAMBLE;
       // Registers to set after loading config regusters for a profile.
       // These are the same for ALL profiles.
 
+    // Register tables above, grouped into runs of consecutive addresses within
+    // a page (see makeBursts). Built once at start up:
+    static const QList<SI5340Burst_t> PREAMBLE_BURSTS;
+    static const QList<SI5340Burst_t> POSTAMBLE_BURSTS;
+    static const QList<QList<SI5340Burst_t>> PROFILE_BURSTS;
+
+    static QList<SI5340Burst_t> makeBursts(const ConstArray<SI5340Register_t> &registers);
+    static QList<QList<SI5340Burst_t>> makeProfileBursts();
+
 
     int selectProfile(int index);
 
     int selectPage(uint8_t page);
     int writeRegister(uint8_t page, uint8_t address, uint8_t data);
+    int writeRegisterList(const ConstArray<SI5340Register_t> &registers);
+    int writeBurstList(const QList<SI5340Burst_t> &bursts);
     int readRegister(uint8_t page, uint8_t address, uint8_t *data);
 
     I2CComms *comms;
@@ -58,7 +58,7 @@ int Serial::open(const QString portName)
         // qDebug() << "SERIAL: Port Open; Setting options...";
         // Options required for USB-ISS adaptor:
         //      19200 baud, 8 data bits, no parity and one stop bit.
-        bResult = serialPort->setBaudRate(QSerialPort::Baud19200) &
+        bResult = serialPort->setBaudRate(USB_ISS_BAUD_RATE) &
                   serialPort->setDataBits(QSerialPort::Data8) &
                   serialPort->setParity(QSerialPort::NoParity) &
                   serialPort->setStopBits(QSerialPort::OneStop) &
@@ -92,33 +92,53 @@ void Serial::close()
 
 
 /*!
-\brief Return a reference to data buffer
-
- Note: This method is not thread-safe and should
- only be called AFTER transactionFinished signal is
- emitted, and BEFORE another transactionStart signal
- is sent. At other times the contents and size of
- the buffer are unpredictable.
-
- The buffer is NOT copied by this call; the caller
- must make sure they are finished with the data
- before issuing another transactionStart signal.
-
- \param nBytes    Set to the number of bytes
-                  in the buffer
- \return pointer  Pointer to the buffer data
+ \brief Get transport capabilities (USB-ISS adaptor limits)
 */
-uint8_t *Serial::getData( size_t *nBytes )
+I2CTransportCapabilities_t Serial::getCapabilities() const
 {
-    *nBytes = (size_t)inputBuffer.size();
-    return (uint8_t *)inputBuffer.data();
+    I2CTransportCapabilities_t caps;
+    caps.name = QString("USB-ISS (Serial)");
+    caps.baudRate = USB_ISS_BAUD_RATE;
+    caps.supportedBaudRates.append(static_cast<qint32>(USB_ISS_BAUD_RATE));
+    caps.maxFrameWrite = USB_ISS_FRAME_WRITE_MAX;
+    caps.maxFrameRead = USB_ISS_FRAME_READ_MAX;
+    caps.maxWriteBlockSize = USB_ISS_WRITE_BLOCK_MAX;
+    caps.maxReadBlockSize = USB_ISS_READ_BLOCK_MAX;
+    return caps;
 }
 
 
 ////// SLOTS /////////////////////////////////////////////////////////////////
 
-void Serial::transactionStart( const uint8_t *data, const size_t nBytesData, const size_t nBytesResponseExpected )
+/*!
+ \brief Start a transaction: Write data and wait for a response
+
+ Response bytes are read from the serial port straight into the buffer(s)
+ supplied by the caller; no copy is made and no memory is allocated.
+ Optionally the response can be split: the first nBytesResponseHeader
+ bytes go into responseHeader and the rest into responseData (used where
+ an adaptor status header precedes the data, so the data can be placed
+ directly in the final destination).
+
+ The caller's buffers must remain valid until transactionFinished is
+ emitted or transactionCancel is called. Use getBytesReceived to find
+ out how many bytes were received (total, including header).
+
+ \param data                   Data to write
+ \param nBytesData             Number of bytes to write
+ \param nBytesResponseExpected Total size of expected response (including header)
+ \param responseData           Buffer for response (after header). Must be at least
+                               nBytesResponseExpected - nBytesResponseHeader bytes.
+                               If null, the response is read and discarded.
+ \param nBytesResponseHeader   Number of response bytes to store in responseHeader
+ \param responseHeader         Buffer for response header (may be null if nBytesResponseHeader is 0)
+*/
+void Serial::transactionStart( const uint8_t *data, const size_t nBytesData,
+                               const size_t nBytesResponseExpected, uint8_t *responseData,
+                               const size_t nBytesResponseHeader, uint8_t *responseHeader )
 {
+    Q_ASSERT(nBytesResponseHeader <= nBytesResponseExpected);
+    Q_ASSERT(nBytesResponseHeader == 0 || responseHeader);
     if (nBytesExpected > 0)
     {
         // Transaction already in progress!
@@ -129,7 +149,10 @@ void Serial::transactionStart( const uint8_t *data, const size_t nBytesData, con
 #ifdef BERT_SERIAL_DEBUG
         qDebug() << "SERIAL: -->Data Write " << nBytesData << " bytes; Expecting " << nBytesResponseExpected << " bytes in response";
 #endif
-        inputBuffer.truncate(0);
+        nBytesReceived = 0;
+        nBytesHeader = (responseHeader) ? nBytesResponseHeader : 0;
+        headerBuffer = responseHeader;
+        responseBuffer = responseData;
         nBytesExpected = nBytesResponseExpected;
         serialPort->write( (const char *)data, nBytesData );
 #ifdef BERT_SERIAL_DEBUG
@@ -144,8 +167,10 @@ void Serial::transactionCancel()
 #ifdef BERT_SERIAL_DEBUG
         qDebug() << "SERIAL: Transaction Cancel";
 #endif
-    inputBuffer.truncate(0);
     nBytesExpected = 0;
+    nBytesReceived = 0;
+    headerBuffer = nullptr;
+    responseBuffer = nullptr;
 }
 
 
@@ -158,44 +183,72 @@ void Serial::transactionCancel()
 void Serial::dataAvailable()
 {
 #ifdef BERT_SERIAL_DEBUG
-    qDebug() << "SERIAL: Data Available.";
-#endif
-    QByteArray data = serialPort->readAll();
-    size_t bytesThisRead = data.size();
-#ifdef BERT_SERIAL_DEBUG
-    qDebug() << "SERIAL: -->Data Read: " << bytesThisRead
-             << " bytes [" << QString(data) << "] ";
+    qDebug() << "SERIAL: Data Available: " << serialPort->bytesAvailable() << " bytes";
 #endif
+    if (nBytesExpected == 0)
+    {
+        // Data arrived, but we weren't expecting any.
+        discardAvailable("UNEXPECTED DATA!");
+        return;
+    }
 
-    if (nBytesExpected > 0)
+    // Read straight into the caller's buffers:
+    while (nBytesReceived < nBytesExpected && serialPort->bytesAvailable() > 0)
     {
-        inputBuffer.append(data);
-        if ((size_t)inputBuffer.size() > nBytesExpected)
+        char  *dest;
+        size_t destSize;
+        if (nBytesReceived < nBytesHeader)
         {
-            size_t overflowSize = inputBuffer.size() - nBytesExpected;
-            inputBuffer.truncate(nBytesExpected);
-            qDebug() << "SERIAL: INPUT BUFFER OVERFLOW! Dropped "
-                     << overflowSize  << " bytes.";
+            dest = reinterpret_cast<char *>(headerBuffer + nBytesReceived);
+            destSize = nBytesHeader - nBytesReceived;
         }
-        if ((size_t)inputBuffer.size() == nBytesExpected)
+        else if (responseBuffer)
         {
-            // We now have the expected amount of data!
-            //qDebug() << "SERIAL: Read Finished!";
-            emit transactionFinished();
-            nBytesExpected = 0;
+            dest = reinterpret_cast<char *>(responseBuffer + (nBytesReceived - nBytesHeader));
+            destSize = nBytesExpected - nBytesReceived;
         }
         else
         {
-            // Still waiting for more data...
-            //qDebug() << "SERIAL: Still waiting for " << (nBytesExpected - inputBuffer.size()) << " bytes.";
+            dest = reinterpret_cast<char *>(discardBuffer);
+            destSize = nBytesExpected - nBytesReceived;
+            if (destSize > DISCARD_BUFFER_SIZE) destSize = DISCARD_BUFFER_SIZE;
         }
+        qint64 bytesThisRead = serialPort->read(dest, static_cast<qint64>(destSize));
+        if (bytesThisRead <= 0) break;
+        nBytesReceived += static_cast<size_t>(bytesThisRead);
+#ifdef BERT_SERIAL_DEBUG
+        qDebug() << "SERIAL: -->Data Read: " << bytesThisRead << " bytes";
+#endif
+    }
+
+    if (nBytesReceived == nBytesExpected)
+    {
+        // We now have the expected amount of data!
+        nBytesExpected = 0;
+        if (serialPort->bytesAvailable() > 0) discardAvailable("INPUT BUFFER OVERFLOW!");
+        emit transactionFinished();
     }
     else
     {
-        // Data arrived, but we weren't expecting any.
-        qDebug() << "SERIAL: UNEXPECTED DATA! Dropped "
-                 << bytesThisRead << " bytes.";
+        // Still waiting for more data...
+    }
+}
+
+
+/*!
+ \brief Read and discard any data waiting at the serial port
+ \param reason  Message for debug log
+*/
+void Serial::discardAvailable(const char *reason)
+{
+    size_t bytesDropped = 0;
+    qint64 bytesThisRead;
+    while ((bytesThisRead = serialPort->read(reinterpret_cast<char *>(discardBuffer), DISCARD_BUFFER_SIZE)) > 0)
+    {
+        bytesDropped += static_cast<size_t>(bytesThisRead);
     }
+    qDebug() << "SERIAL: " << reason << " Dropped "
+             << bytesDropped << " bytes.";
 }
 
 
@@ -12,32 +12,44 @@
 #include <QSerialPort>
 #include <QObject>
 
+#include "I2CTransport.h"
+
 /*!
  \brief Asynchronous Serial Port Class
 
  Manages comms via the serial port, using the
  QT serial port (with signals and slots)
 
+ This is the transport for the USB-ISS adaptor
+ (I2CTransport::TRANSPORT_USB_ISS).
+
 */
-class Serial : public QObject
+class Serial : public I2CTransport
 {
 Q_OBJECT
 
 public:
     Serial(QObject *parent);
-    ~Serial();
+    ~Serial() override;
 
-    int open(const QString portName);
-    void close();
-    uint8_t *getData(size_t *nBytes);
-    bool isOpen() { return serialPort->isOpen(); }
+    int open(const QString portName) override;
+    void close() override;
+    size_t getBytesReceived() const override { return nBytesReceived; }
+    bool isOpen() override { return serialPort->isOpen(); }
+    I2CTransportCapabilities_t getCapabilities() const override;
 
-public slots:
-    void transactionStart(const uint8_t *data, const size_t nBytesData, const size_t nBytesResponseExpected);
-    void transactionCancel();
+    // USB-ISS adaptor limits:
+    static const qint32 USB_ISS_BAUD_RATE = QSerialPort::Baud19200;
+    static const size_t USB_ISS_FRAME_WRITE_MAX = 64;    // Adaptor command buffer
+    static const size_t USB_ISS_FRAME_READ_MAX  = 64;
+    static const uint8_t USB_ISS_WRITE_BLOCK_MAX = 59;   // Data bytes per register write (command buffer less header)
+    static const uint8_t USB_ISS_READ_BLOCK_MAX  = 64;   // Data bytes per register read
 
-signals:
-    void transactionFinished();
+public slots:
+    void transactionStart(const uint8_t *data, const size_t nBytesData,
+                          const size_t nBytesResponseExpected, uint8_t *responseData,
+                          const size_t nBytesResponseHeader = 0, uint8_t *responseHeader = nullptr) override;
+    void transactionCancel() override;
 
 private slots:
     void dataAvailable();
@@ -46,8 +58,16 @@ private slots:
 private:
     std::unique_ptr<QSerialPort> serialPort;
 
-    QByteArray     inputBuffer;
+    static const size_t DISCARD_BUFFER_SIZE = 64;
+
     size_t         nBytesExpected = 0;
+    size_t         nBytesReceived = 0;
+    size_t         nBytesHeader = 0;
+    uint8_t       *headerBuffer = nullptr;      // Caller's buffer for first nBytesHeader bytes of response (may be null if nBytesHeader = 0)
+    uint8_t       *responseBuffer = nullptr;    // Caller's buffer for remainder of response (null: response is discarded)
+    uint8_t        discardBuffer[DISCARD_BUFFER_SIZE];  // Preallocated buffer for unwanted / unexpected data
+
+    void discardAvailable(const char *reason);
 
 };
 
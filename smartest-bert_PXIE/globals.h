@@ -116,6 +116,40 @@ private:
 
 };
 
+/*!
+ \brief Read-only view of a constant array
+ Holds a pointer to a constant (e.g. constexpr) array and its size, with the
+ parts of the QList interface used for lookup tables (size, at, [], indexOf).
+ A ConstArray made from a constant array is itself constant-initialised, so
+ a static lookup table costs no start up code or allocation, and passing one
+ around never copies the data.
+*/
+template <typename T>
+class ConstArray
+{
+public:
+    template <size_t N>
+    constexpr ConstArray(const T (&data)[N]) : items(data), count(static_cast<int>(N)) {}
+
+    constexpr int size() const { return count; }
+    constexpr const T &operator[](int index) const { return items[index]; }
+    const T &at(int index) const { Q_ASSERT(index >= 0 && index < count); return items[index]; }
+
+    int indexOf(const T &value) const
+    {
+        for (int index = 0; index < count; index++) if (items[index] == value) return index;
+        return -1;
+    }
+
+    constexpr const T *begin() const { return items; }
+    constexpr const T *end() const { return items + count; }
+
+private:
+    const T *items;
+    int count;
+};
+
+
 // ****** Debug Output Control: *******************
 // See project file PG3204.pro
 
@@ -1,5 +1,10 @@
 #include "mainwindow.h"
+#include "BertHeadless.h"
+#include "BertLog.h"
 #include <QApplication>
+#include <QCoreApplication>
+#include <QScopedPointer>
+#include <QDebug>
 
 using namespace std;
 
@@ -13,6 +18,13 @@ using namespace std;
 // #define BERT_USBISS_DEBUG          // Output details of low-level read / write operations to the USB-I2C adaptor
 // #define BERT_DEBUG_DIV_RATIOS      // Add additional triger out divide ratios for debugging use
 // #define BERT_ED_DEBUG              // Show extra debug info for the ED system
+// #define BERT_I2C_DEBUG             // Default to showing I2C comms debug (see BertLog; also "--log i2c=debug" at run time)
+// #define BERT_EEPROM_DEBUG          // Default to showing EEPROM read / write debug (also "--log eeprom=debug")
+
+// Logging: All debug output goes through BertLog (written out by a background thread).
+// Command line options:
+//   --log <spec>       Set log levels, e.g. "--log i2c=trace,eyescan=debug" (see BertLog::configure)
+//   --logfile <file>   Also write the log to a file
 
 
 
@@ -100,16 +112,58 @@ int main(int argc, char *argv[])
     /////////////////////////////////////////////////////////////////////////
 #endif
 
-    QApplication a(argc, argv);
+    // Headless mode: "--headless <script>" runs a command script without the UI (see BertHeadless).
+    int headlessArg = -1;
+    QString logSpec;
+    QString logFileName;
+    for (int i = 1; i < argc; i++)
+    {
+        if (QString(argv[i]) == "--headless") headlessArg = i;
+        if (QString(argv[i]) == "--log"     && i + 1 < argc) logSpec = QString(argv[i + 1]);
+        if (QString(argv[i]) == "--logfile" && i + 1 < argc) logFileName = QString(argv[i + 1]);
+    }
+    QScopedPointer<QCoreApplication> app((headlessArg > 0) ? new QCoreApplication(argc, argv)
+                                                           : new QApplication(argc, argv));
+
+    // Start logging once the application exists (the writer thread and log file need it):
+    if (BertLog::configure(logSpec) != globals::OK) qWarning() << "Invalid log levels: " << logSpec;
+    BertLog::start(logFileName);
 
     qRegisterMetaType<QVector<double> >("QVector<double>");
     qRegisterMetaType<QString>("QString");
     qRegisterMetaType<QList<LMXFrequencyProfile> >("QList<LMXFrequencyProfile>");
+    qRegisterMetaType<QList<EDCountReading_t> >("QList<EDCountReading_t>");
+    qRegisterMetaType<QList<BertUIUpdate_t> >("QList<BertUIUpdate_t>");
+    qRegisterMetaType<EyeScanResult>("EyeScanResult");
+    qRegisterMetaType<QList<int> >("QList<int>");
+
+    if (headlessArg > 0)
+    {
+        // Script file name must follow "--headless" ("-" for stdin), not be missing or another option:
+        const QString scriptFileName = (headlessArg + 1 < argc) ? QString(argv[headlessArg + 1]) : QString();
+        if (scriptFileName.isEmpty() || scriptFileName.startsWith("--"))
+        {
+            qCritical() << "Usage: PG3204 --headless <script file | -> [--log <spec>] [--logfile <file>]";
+            BertLog::stop();
+            return 1;
+        }
+        BertHeadless headless;
+        if (headless.start(scriptFileName) != globals::OK)
+        {
+            BertLog::stop();
+            return 1;
+        }
+        const int exitCode = app->exec();
+        BertLog::stop();
+        return exitCode;
+    }
 
     BertWindow *w = new BertWindow(NULL);
     w->show();
     w->enablePageChanges();
 
-    return a.exec();
+    const int exitCode = app->exec();
+    BertLog::stop();
+    return exitCode;
 
 }
@@ -3,22 +3,37 @@
 
 // -- Repeat Count Lookup: ------------
 // This look up table maps the index of items in the eye scan and bathtub plot
-// "repeats" combo box to a number of repeats. -1 = Repeat forever.
-const QList<int> BertWindow::EYESCAN_REPEATS_LOOKUP =
-   { 1, 5, 10, 50, 100, 500, 1000, -1 };
+// "repeats" combo box to a number of repeats. -1 = Repeat forever;
+// -2 (EYESCAN_REPEATS_CONVERGE) = Repeat until the scan converges.
+constexpr int EYESCAN_REPEATS_VALUES[] =
+   { 1, 5, 10, 50, 100, 500, 1000, -1, -2 };
+const ConstArray<int> BertWindow::EYESCAN_REPEATS_LOOKUP(EYESCAN_REPEATS_VALUES);
 
 // List of items for use in the eye scan and bathtub plot 'repeats' combo
 const QStringList BertWindow::EYESCAN_REPEATS_LIST =
-   { "1", "5", "10", "50", "100", "500", "1000", "∞" };
+   { "1", "5", "10", "50", "100", "500", "1000", "∞", "Auto" };
+
+// -- ED Confidence Target Lookup: ----
+// Maps the index of items in the ED "Stop at BER" and "Confidence" combo
+// boxes to a target BER (0 = Off: Run until stopped) and confidence level.
+constexpr double ED_TARGET_BER_VALUES[] =
+   { 0.0, 1e-9, 1e-10, 1e-11, 1e-12, 1e-13, 1e-14, 1e-15 };
+const ConstArray<double> BertWindow::ED_TARGET_BER_LOOKUP(ED_TARGET_BER_VALUES);
+const QStringList BertWindow::ED_TARGET_BER_LIST =
+   { "Off", "1E-9", "1E-10", "1E-11", "1E-12", "1E-13", "1E-14", "1E-15" };
+
+constexpr double ED_TARGET_CONFIDENCE_VALUES[] =
+   { 0.90, 0.95, 0.99, 0.999 };
+const ConstArray<double> BertWindow::ED_TARGET_CONFIDENCE_LOOKUP(ED_TARGET_CONFIDENCE_VALUES);
+const QStringList BertWindow::ED_TARGET_CONFIDENCE_LIST =
+   { "90%", "95%", "99%", "99.9%" };
 
 
 // Convert index in Channel Select list (on CDR Mode tab) to device lane
 #define CDR_CH_SELECT_TO_LANE(i) (i * 2) + 1
 
 BertWindow::BertWindow(QWidget *parent) :
-    QMainWindow(parent),
-    nextEDMaster(edEnabledMasterChannels),
-    nextEDSlave(edEnabledSlaveChannels)
+    QMainWindow(parent)
 {
     globals::setAppPath(QCoreApplication::applicationDirPath());  // qApp->applicationDirPath());
 
@@ -66,9 +81,8 @@ BertWindow::BertWindow(QWidget *parent) :
     connect(uiUpdateTimer, SIGNAL(timeout()), this, SLOT(uiUpdateTimerTick()));
 
     tickCountStatusTextReset = 0;
-    tickCountTempUpdate = 0;
     tickCountTemperatureTextReset = 0;
-    tickCountClockLockUpdate = 0;
+    for (int metric = 0; metric < BertPoller::POLL_METRIC_COUNT; metric++) pollerIntervals[metric] = -1;
 
     // Tracks how long the ED measurement has been running:
     edRunTime = new QTime();
@@ -219,6 +233,97 @@ void BertWindow::PCA9557A_Added(PCA9557A *pca9557a, int deviceID)
     PCA9557A_CONNECT_SIGNALS(this, pca9557a)
 }
 
+void BertWindow::PollerAdded(BertPoller *poller)
+{
+#ifdef BERT_SIGNALS_DEBUG
+    qDebug() << "Received Sig PollerAdded on thread " << QThread::currentThreadId();
+#endif
+    // Connect up signals to configure the status poller:
+    BERT_POLLER_CONNECT_SIGNALS(this, poller)
+    // Make sure the current settings are sent on the next update:
+    for (int metric = 0; metric < BertPoller::POLL_METRIC_COUNT; metric++) pollerIntervals[metric] = -1;
+    pollerBitRate = -1.0;
+}
+
+void BertWindow::I2CProfileReport(int result, QString fileName, QString report)
+{
+#ifdef BERT_SIGNALS_DEBUG
+    qDebug() << "Received Sig I2CProfileReport: Result = " << result << "; File = " << fileName;
+#endif
+    Q_UNUSED(report)   // The report is saved to fileName (and returned to headless clients)
+    if (result == globals::OK) appendStatus(QString("Bus profile saved to %1").arg(fileName));
+    else                       appendStatus(QString("Bus profile ERROR (%1): %2").arg(result).arg(fileName));
+}
+
+void BertWindow::EDLogStatus(int result, QString fileName, quint64 records)
+{
+#ifdef BERT_SIGNALS_DEBUG
+    qDebug() << "Received Sig EDLogStatus: Result = " << result << "; File = " << fileName << "; Records = " << records;
+#endif
+    if (result == globals::OK) appendStatus(QString("ED Log: %1 readings saved to %2").arg(records).arg(fileName));
+    else                       appendStatus(QString("ED Log ERROR (%1): %2").arg(result).arg(fileName));
+}
+
+
+/*!
+ \brief ED confidence update from the status poller
+ Sent for each ED reading while a confidence target is set (see
+ BertPoller::EDSetConfidenceTarget). A lane with a verdict is no longer
+ read by the back end; once every enabled channel has a verdict, the
+ ED is stopped.
+*/
+void BertWindow::EDConfidenceUpdate(int lane, int verdict, double confidence, double bitsTotal, double errorsTotal)
+{
+#ifdef BERT_SIGNALS_DEBUG
+    qDebug() << "Received Sig EDConfidenceUpdate: Lane = " << lane << "; Verdict = " << verdict << "; Confidence = " << confidence
+             << "; Bits = " << bitsTotal << "; Errors = " << errorsTotal;
+#endif
+    if (!edRunning || edTargetBER <= 0.0) return;
+    edTargetVerdicts[lane] = verdict;
+    edTargetConfidences[lane] = confidence;
+    if (verdict != EDConfidence::VERDICT_PENDING)
+    {
+        BertChannel *bertChannel = getChannel(BertChannel::laneToChannel(lane));
+        bertChannel->getED()->setState(BertUIEDChannel::STOPPED);
+    }
+    updateStatus(edTargetSummary());
+
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        if (!bertChannel->getED()->getEDEnabled()) continue;
+        if (edTargetVerdicts.value(bertChannel->getEDLane(), EDConfidence::VERDICT_PENDING) == EDConfidence::VERDICT_PENDING) return;
+    }
+    // All enabled channels have a verdict:
+    if (!flagEDStop) on_buttonEDStop_clicked();
+}
+
+
+/*!
+ \brief Describe the state of each channel against the ED confidence target
+ \return e.g. "BER < 1E-12 at 95%:  Ch 1 PASS;  Ch 2 61.3%"
+*/
+QString BertWindow::edTargetSummary() const
+{
+    QString summary = QString("BER < %1 at %2:")
+            .arg(ED_TARGET_BER_LIST.at(listEDTargetBER->currentIndex()))
+            .arg(ED_TARGET_CONFIDENCE_LIST.at(listEDTargetConfidence->currentIndex()));
+    foreach (BertChannel *bertChannel, bertChannels)
+    {
+        if (!bertChannel->getED()->getEDEnabled()) continue;
+        const int lane = bertChannel->getEDLane();
+        QString state;
+        switch (edTargetVerdicts.value(lane, EDConfidence::VERDICT_PENDING))
+        {
+        case EDConfidence::VERDICT_PASS: state = "PASS"; break;
+        case EDConfidence::VERDICT_FAIL: state = "FAIL"; break;
+        default: state = QString("%1%").arg(edTargetConfidences.value(lane, 0.0) * 100.0, 0, 'f', 1); break;
+        }
+        summary += QString("  Ch %1 %2;").arg(bertChannel->getChannel()).arg(state);
+    }
+    summary.chop(1);
+    return summary;
+}
+
 
 void BertWindow::M24M02Added(M24M02 *m24m02, int deviceID)
 {
@@ -308,28 +413,41 @@ void BertWindow::ListPopulate(QString name, int lane, QStringList items, int def
 }
 
 
-void BertWindow::ListSelect(QString name, int lane, int index)
-{
-#ifdef BERT_SIGNALS_DEBUG
-    qDebug() << "Received Sig ListSelect from component (Name: '" << name << "''; Lane: " << lane << "; Index: " << index << ")";
-#endif
-    QComboBox *target = findItem<QComboBox *>(name, lane);
-    if (!target) return;
-    Q_ASSERT(index >= 0 && index < target->count());
-    eventsEnabled = false;
-    target->setCurrentIndex(index);
-    eventsEnabled = true;
-}
-
-void BertWindow::UpdateBoolean(QString name, int lane, bool value)
+/*!
+ \brief UI Update from a component
+ Updates are batched by the component (see BertComponent::uiQueue), so
+ one signal may update many items. Target widgets are looked up by item
+ and lane (see uiItemWidget) rather than searched for by name each time.
+*/
+void BertWindow::UIUpdate(QList<BertUIUpdate_t> updates)
 {
 #ifdef BERT_SIGNALS_DEBUG
-    qDebug() << "Received Sig UpdateBoolean for '" << name << "', lane " << lane << ", value " << value;
+    qDebug() << "Received Sig UIUpdate from component (" << updates.size() << " updates)";
 #endif
-    QCheckBox *target = findItem<QCheckBox *>(name, lane);
-    if (!target) return;
     eventsEnabled = false;
-    target->setChecked(value);
+    for (const BertUIUpdate_t &update : updates)
+    {
+        QWidget *widget = uiItemWidget(update.item, update.lane);
+        if (!widget) continue;
+        switch (BertComponent::uiItemType(update.item))
+        {
+        case BertComponent::UI_TYPE_SELECT:
+            {
+            QComboBox *target = static_cast<QComboBox *>(widget);
+            Q_ASSERT(update.value >= 0 && update.value < target->count());
+            target->setCurrentIndex(update.value);
+            break;
+            }
+        case BertComponent::UI_TYPE_BOOLEAN:
+            static_cast<QCheckBox *>(widget)->setChecked(update.value != 0);
+            break;
+        default:
+            static_cast<QLabel *>(widget)->setText(update.text);
+            break;
+        }
+        // Special cases:
+        if (update.item == BertComponent::UI_CORE_TEMPERATURE) tickCountTemperatureTextReset = 0;
+    }
     eventsEnabled = true;
 }
 
@@ -344,17 +462,16 @@ void BertWindow::SetPGLedStatus(int lane, bool laneOn)
 
 
 
-void BertWindow::UpdateString(QString name, int lane, QString value)
+/*!
+ \brief Set the text of a label, found by name
+ Used for labels which aren't component UI items (e.g. EEPROM data)
+*/
+void BertWindow::updateString(QString name, int lane, QString value)
 {
-#ifdef BERT_SIGNALS_DEBUG
-    qDebug() << "Received Sig UpdateString for '" << name << "', lane " << lane << ", value " << value;
-#endif
     QLabel *target = findItem<QLabel *>(name, lane);
     if (!target) return;
     eventsEnabled = false;
-    target->setText(QString("%1").arg(value));
-    // Special cases:
-    if (name.left(15) == "CoreTemperature") tickCountTemperatureTextReset = 0;
+    target->setText(value);
     eventsEnabled = true;
 }
 
@@ -397,16 +514,43 @@ void BertWindow::EDCount(int lane,
              << bitsTotal << "; errorsTotal = "
              << errorsTotal;
 #endif
+    edCountUpdate(lane, locked, bits, bitsTotal, errors, errorsTotal);
+}
+
+
+void BertWindow::EDCountSnapshot(int metaLane, qint64 timestamp, QList<EDCountReading_t> readings)
+{
+#ifdef BERT_SIGNALS_DEBUG
+    qDebug() << "Received Sig EDCountSnapshot: Lane = "
+             << metaLane << "; timestamp = "
+             << timestamp << "; readings = "
+             << readings.count();
+#endif
+    Q_UNUSED(timestamp)
+    Q_UNUSED(metaLane)
+    foreach (const EDCountReading_t &reading, readings)
+    {
+        edCountUpdate(reading.lane, reading.locked,
+                      reading.bits, reading.bitsTotal,
+                      reading.errors, reading.errorsTotal);
+    }
+}
+
+
+/*!
+ \brief Update the UI with new ED counts for a lane
+ Used by the EDCount and EDCountSnapshot slots.
+*/
+void BertWindow::edCountUpdate(int lane,
+                               bool locked,
+                               double bits, double bitsTotal,
+                               double errors, double errorsTotal)
+{
     // Note the "BER" we calculate here is best described as the
     // "bit error RATIO" as it is errors per bit, not errors per second.
 
-    // Update the ED requests pending count: Choose the master or slave count based on the board for this lane.
-    if (BertChannel::laneToBoard(lane) == 0) edMasterRequestsPending--;
-    else                                     edSlaveRequestsPending--;
-
     // If this count is for a lane which wasn't locked, IGNORE the count:
-    // The values will be all 0! Note we DO have to decrement the "pending" count
-    // (done above) so that we know that our requests are still being handled.
+    // The values will be all 0!
     if (!locked) return;
 
     double errorRatio;
@@ -439,7 +583,7 @@ void BertWindow::EDCount(int lane,
         bertChannel->getED()->setEDValueErrors(errors);
     }
     bertChannel->getED()->setEDValueBER(errorRatio);
-    bertChannel->getED()->plotAddPoint(errorRatio);
+    edPlotAddPoint(bertChannel, errorRatio);
 }
 
 
@@ -465,7 +609,6 @@ void BertWindow::LMXInfo(int deviceID, int indexProfile, int indexTrigOutputPowe
     valueBitRate_EyeScan->setText( QString("%1").arg( (bitRate/1e9), 0, 'f', 5)  );
     valueBitRate_Bathtub->setText( QString("%1").arg( (bitRate/1e9), 0, 'f', 5)  );
     qDebug() << "Bitrate Updated to " << bitRate;
-    tickCountClockLockUpdate = 0;
     eventsEnabled = true;
 }
 
@@ -555,13 +698,13 @@ void BertWindow::EEPROMStringData(int deviceID,
     qDebug() << "  Warranty End:   " << warrantyEnd;
     qDebug() << "  Synth Config:   " << synthConfigVersion;
 
-    UpdateString("InstrumentModel", 0, model);
-    UpdateString("InstrumentSerial", 0, serial);
-    UpdateString("InstrumentProductionDate", 0, productionDate);
-    UpdateString("InstrumentCalibrationDate", 0, calibrationDate);
-    UpdateString("InstrumentWarrantyStartDate", 0, warrantyStart);
-    UpdateString("InstrumentWarrantyEndDate", 0, warrantyEnd);
-    UpdateString("InstrumentSynthConfigVersion", 0, synthConfigVersion);
+    updateString("InstrumentModel", 0, model);
+    updateString("InstrumentSerial", 0, serial);
+    updateString("InstrumentProductionDate", 0, productionDate);
+    updateString("InstrumentCalibrationDate", 0, calibrationDate);
+    updateString("InstrumentWarrantyStartDate", 0, warrantyStart);
+    updateString("InstrumentWarrantyEndDate", 0, warrantyEnd);
+    updateString("InstrumentSynthConfigVersion", 0, synthConfigVersion);
 
     // Also update contents of the "Write EEPROM Data" panel if it exists (Factory only):
     if (inputModel) inputModel->setText(model);
@@ -679,6 +822,35 @@ template<class T> T BertWindow::findItem(QString name, int suffix)
 }
 
 
+/*!
+ \brief Get the widget for a component UI item
+ The widget is found by name (see BertComponent::uiItemName) the first
+ time, then kept. If the widget is deleted (e.g. channels are rebuilt on
+ connect), it is found again next time.
+ \param item  UI item (BertComponent::UI_xxx)
+ \param lane  Lane, or globals::ALL_LANES for items with no lane
+ \return Widget (QComboBox, QCheckBox or QLabel, by item type), or nullptr if not found
+*/
+QWidget *BertWindow::uiItemWidget(int item, int lane)
+{
+    if (item < 0 || item >= BertComponent::UI_ITEM_COUNT || lane < globals::ALL_LANES) return nullptr;
+    QVector<QPointer<QWidget> > &widgets = uiItemWidgets[item];
+    const int slot = lane + 1;
+    if (slot >= widgets.size()) widgets.resize(slot + 1);
+    if (!widgets[slot])
+    {
+        const QString name = BertComponent::uiItemName(item);
+        switch (BertComponent::uiItemType(item))
+        {
+        case BertComponent::UI_TYPE_SELECT:  widgets[slot] = findItem<QComboBox *>(name, lane); break;
+        case BertComponent::UI_TYPE_BOOLEAN: widgets[slot] = findItem<QCheckBox *>(name, lane); break;
+        default:                             widgets[slot] = findItem<QLabel *>(name, lane);    break;
+        }
+    }
+    return widgets[slot];
+}
+
+
 BertChannel *BertWindow::getChannel(int channel)
 {
     BertChannel *thisChannel = bertChannels.value(channel, nullptr);
@@ -754,6 +926,7 @@ void BertWindow::uiChangeOnConnect(bool connectedStatus)
     if (listEEPROMLMXProfiles) listEEPROMLMXProfiles->setEnabled(connectedStatus);
     if (buttonWriteProfilesToEEPROM) buttonWriteProfilesToEEPROM->setEnabled(connectedStatus);
     if (buttonVerifyLMXProfiles) buttonVerifyLMXProfiles->setEnabled(connectedStatus);
+    if (buttonBusProfile) buttonBusProfile->setEnabled(connectedStatus);
 
     if (listFirmwareVersion) listFirmwareVersion->setEnabled(connectedStatus);
  // if (listEEPROMFirmware) listEEPROMFirmware->setEnabled(connectedStatus);
@@ -1046,6 +1219,16 @@ void BertWindow::on_buttonVerifyLMXProfiles_clicked()
     emit LMXVerifyFrequencyProfiles();
 }
 
+/*!
+ \brief Save I2C Bus Profile
+ Appends the I2C bus statistics (op latency histograms, retries, etc)
+ to BusProfile.txt in the application directory
+*/
+void BertWindow::on_buttonBusProfile_clicked()
+{
+    emit I2CProfileDump(QString());
+}
+
 /*!
  \brief Verify Firmware
  Compares Firmware read from files to Firmware read from EEPROM
@@ -1205,13 +1388,71 @@ void BertWindow::edResetUI(const int8_t channel)
 {
     qDebug() << "ED Reset - Channel: " << channel;
     getChannel(channel)->edErrorflasherOn = false;
-    getChannel(channel)->getED()->plotClear();
+    edPlotClear(getChannel(channel));
     getChannel(channel)->getED()->setEDValueBits(0.0);
     getChannel(channel)->getED()->setEDValueErrors(0.0);
     getChannel(channel)->getED()->setEDValueBER(0.0);
 }
 
 
+/*!
+ \brief Add an error ratio reading to the BER plot for an ED channel
+ Readings go into the channel's history (see BERHistory); the plot shows
+ the finest history level which covers the whole run in no more than
+ ED_PLOT_BUCKETS_MAX buckets. Normally only newly completed buckets are
+ added to the plot. When the run outgrows the level, the plot is redrawn
+ from the next level up (a few hundred points), so the plot stays the
+ same size however long the ED runs.
+ Raw samples are plotted as they are; coarser buckets are plotted as
+ their min and max, so that error bursts still show.
+ \param bertChannel  Channel
+ \param errorRatio   Error ratio (cumulative or instantaneous, as displayed)
+*/
+void BertWindow::edPlotAddPoint(BertChannel *bertChannel, double errorRatio)
+{
+    BERHistory &history = bertChannel->edHistory;
+    BertUIEDChannel *ed = bertChannel->getED();
+    history.addSample(errorRatio);
+
+    const int level = history.levelForBuckets(ED_PLOT_BUCKETS_MAX);
+    if (level != bertChannel->edPlotLevel)
+    {
+        ed->plotClear();
+        bertChannel->edPlotLevel = level;
+        bertChannel->edPlotBuckets = 0;
+    }
+    // Nb: Only the top level can wrap (after LEVEL_FACTOR^11 * LEVEL_CAPACITY readings):
+    bertChannel->edPlotBuckets = qMax(bertChannel->edPlotBuckets, history.getBucketFirst(level));
+
+    BERHistoryBucket_t bucket;
+    while (history.getBucket(level, bertChannel->edPlotBuckets, &bucket))
+    {
+        if (bucket.count == 1)
+        {
+            ed->plotAddPoint(bucket.mean);
+        }
+        else
+        {
+            ed->plotAddPoint(bucket.min);
+            ed->plotAddPoint(bucket.max);
+        }
+        bertChannel->edPlotBuckets++;
+    }
+}
+
+
+/*!
+ \brief Clear the BER plot and history for an ED channel
+*/
+void BertWindow::edPlotClear(BertChannel *bertChannel)
+{
+    bertChannel->edHistory.clear();
+    bertChannel->edPlotLevel = 0;
+    bertChannel->edPlotBuckets = 0;
+    bertChannel->getED()->plotClear();
+}
+
+
 // ------ Select ALL Channels: ----------------
 void BertWindow::on_checkEDEnableAll_clicked(bool checked)
 {
@@ -1254,10 +1495,14 @@ void BertWindow::on_buttonEDStop_clicked()
 /*!
  \brief UI Update Timer Tick
  This timer fires every 250 ms, and is used to carry out ALL
- time-based updates. This is a better approach than using several
+ time-based UI updates. This is a better approach than using several
  different timers, because they all run in the same thread anyway,
  and one timer event can interrupt the call from a previous timer
  event, which is confusing.
+
+ Nb: Hardware reads (ED counts, LOS / LOL, temperature, LMX lock) are
+ issued by the status poller in the back end (see BertPoller); this
+ just tells the poller what to read (pollerUpdate), and renders.
 */
 void BertWindow::uiUpdateTimerTick()
 {
@@ -1292,30 +1537,8 @@ void BertWindow::uiUpdateTimerTick()
         tickCountTemperatureTextReset = 0;
     }
 
-    // Read the chip temperature every 5 seconds - if we're on the
-    // 'Connect' page, and connected.
-    if (tabID == TAB_CONNECT)
-    {
-        tickCountTempUpdate++;
-        if (tickCountTempUpdate >= 20)
-        {
-            // qDebug() << "MainWindow: Chip temperature read Tick...";
-            if (uiLockLevel == 0) emit GetTemperature(globals::ALL_LANES);  // Only update temperatures when UI is active (e.g. don't try to update during init process)
-            tickCountTempUpdate = 0;
-        }
-    }
-
-    // Read the LMX clock lock status every second if we are on the Clock Synth page:
-    if (tabID == TAB_CLOCKSYNTH && eventsEnabled)
-    {
-        tickCountClockLockUpdate++;
-        if (tickCountClockLockUpdate >= 4)
-        {
-            // Read from LMX register: emit GetLMXVTuneLock();
-            emit ReadLMXLockDetect();
-            tickCountClockLockUpdate = 0;
-        }
-    }
+    // Tell the status poller what to read for the current page / state:
+    pollerUpdate(tabID);
 
     // ===========================================================================================================================
     // If on CDR Mode Page: Update LOL indicator every second:
@@ -1371,21 +1594,6 @@ void BertWindow::uiUpdateTimerTick()
                 }
             }
         }
-
-        if (cdrUpdateCounter == 3)
-        {
-            // ----- Read and Updade the LOS / LOL State: -------
-            // LOS / LOL lights are only updated if CDR mode enabled.
-            // We update the LOS / LOL for any GT1724 core which has a CDR Mode UI section.
-            foreach (BertChannel *bertChannel, bertChannels)
-            {
-                if (bertChannel->hasCDRModeChannel())
-                {
-                    // qDebug() << "-Emit Get LOS / LOL for meta lane " << bertChannel->getMetaLane();
-                    emit GetLosLol(bertChannel->getMetaLane());
-                }
-            }
-        }
     }
     cdrUpdateCounter++;
     if (cdrUpdateCounter >= 4) cdrUpdateCounter = 0;
@@ -1427,7 +1635,7 @@ void BertWindow::uiUpdateTimerTick()
     {
         foreach (BertChannel *bertChannel, bertChannels)
         {
-            if (bertChannel->getED()->getEDEnabled()) bertChannel->getED()->plotClear();
+            if (bertChannel->getED()->getEDEnabled()) edPlotClear(bertChannel);
         }
         flagEDDisplayChange = false;
     }
@@ -1441,28 +1649,32 @@ void BertWindow::uiUpdateTimerTick()
         buttonEDStart->setEnabled(false);
         buttonEDStop->setEnabled(true);
         checkEDEnableAll->setEnabled(false);
+        checkEDLog->setEnabled(false);
+        listEDTargetBER->setEnabled(false);
+        listEDTargetConfidence->setEnabled(false);
         // ED Count Update State Management: Reset. ///////////////
-        edEnabledMasterChannels.clear();
-        edMasterRequestsPending = 0;
-        edEnabledSlaveChannels.clear();
-        edSlaveRequestsPending = 0;
+        edEnabledChips.clear();
         // ////////////////////////////////////////////////////////
         foreach (BertChannel *bertChannel, bertChannels)
         {
             bertChannel->edOptionsChanged = false;
             edResetUI(bertChannel->getChannel());
             bertChannel->getED()->setState(BertUIEDChannel::RUNNING);
-            // ED Count Update State Management: Add active master and slave channels: //////
+            // ED Count Update State Management: Add GT1724 chips with active channels: //////
             if (bertChannel->getED()->getEDEnabled())
             {
-                if (bertChannel->getBoard() == 0) edEnabledMasterChannels.append(bertChannel->getED());  // Enabled MASTER channel found
-                else                              edEnabledSlaveChannels.append(bertChannel->getED());   // Enabled SLAVE channel found
+                int chipLane = (bertChannel->getED()->getLane() / 4) * 4;  // Lane offset of GT1724 for this channel
+                if (!edEnabledChips.contains(chipLane)) edEnabledChips.append(chipLane);
             }
         }
-        nextEDMaster = QListIterator<BertUIEDChannel *>(edEnabledMasterChannels);
-        nextEDMaster.toBack();
-        nextEDSlave = QListIterator<BertUIEDChannel *>(edEnabledSlaveChannels);
-        nextEDSlave.toBack();
+
+        // Confidence target: The back end stops each lane when it passes or fails, and
+        // the run stops when all lanes have a verdict (see EDConfidenceUpdate):
+        edTargetBER = ED_TARGET_BER_LOOKUP[listEDTargetBER->currentIndex()];
+        edTargetConfidence = ED_TARGET_CONFIDENCE_LOOKUP[listEDTargetConfidence->currentIndex()];
+        edTargetVerdicts.clear();
+        edTargetConfidences.clear();
+        emit EDSetConfidenceTarget(edTargetBER, edTargetConfidence);
 
         // Set up the PRBS checkers IF the settings have been changed and the channel is enabled:
         updateStatus( QString("Synchronizing Pattern...") );
@@ -1471,6 +1683,17 @@ void BertWindow::uiUpdateTimerTick()
         valueMeasurementTime->setText( QString("00:00:00") );
         edRunTime->start();
 
+        // Log all ED readings to file (written by the status poller in the back end):
+        if (checkEDLog->isChecked())
+        {
+            QString logPath = QString("%1/EDLogs").arg(globals::getAppPath());
+            QDir().mkpath(logPath);
+            QString logFileName = QString("%1/EDLog_%2.bin")
+                    .arg(logPath)
+                    .arg(QDateTime::currentDateTime().toString("yyyyMMddThhmmss"));
+            emit EDLogStart(logFileName);
+        }
+
         updateStatus( QString("ED Started.") );
     }
     // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
@@ -1482,12 +1705,17 @@ void BertWindow::uiUpdateTimerTick()
         buttonEDStart->setEnabled(true);
         buttonEDStop->setEnabled(false);
         checkEDEnableAll->setEnabled(true);
+        checkEDLog->setEnabled(true);
+        listEDTargetBER->setEnabled(true);
+        listEDTargetConfidence->setEnabled(true);
         foreach (BertChannel *bertChannel, bertChannels)
         {
             bertChannel->getED()->setState(BertUIEDChannel::STOPPED);
         }
-        edRunning = false;
+        emit EDLogStop();
         updateStatus( QString("ED Stopped.") );
+        if (edTargetBER > 0.0) appendStatus(edTargetSummary());
+        edRunning = false;
     }
     // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
     if (flagErrorInject)
@@ -1502,6 +1730,8 @@ void BertWindow::uiUpdateTimerTick()
         emit SetEQBoost((eqBoostChannel*2)-1, eqBoostNewIndex);
     }
     // >>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>>
+    // Start / stop ED count polling straight away if the ED state has changed:
+    if (flagStart || flagStop) pollerUpdate(tabID);
 
     if (edUpdateCounter >= 4) edUpdateCounter = 0;
     edUpdateCounter++;
@@ -1524,51 +1754,6 @@ void BertWindow::uiUpdateTimerTick()
         }
     }
 
-    // --- Update LOS / LOL indicators every second (on off-beat): ---
-    if ( (edUpdateCounter == 2) && (commsConnected))
-    {
-        // ----- Read and Updade the LOS / LOL State: -------
-        // LOS / LOL lights are always updated regardless of
-        // whether the ED is running. GetLosLol is issued for each
-        // GT1724 IC, i.e. lanes 0, 4, 8, ...
-        foreach (BertChannel *bertChannel, bertChannels)
-        {
-            if ((bertChannel->getPGLane() % 4) == 0) emit GetLosLol(bertChannel->getPGLane());
-        }
-    }  // [if ( (edUpdateCounter == 2) && (commsConnected))]
-
-    // ---- Update TWO CHANNELS of the error counter every 1/4 second:---
-    // One from the master board, and one from the slave board (if present)
-    if (commsConnected && edRunning)
-    {
-        // MASTER Channels: ////////////////////////////////////////////////////////
-        if (edEnabledMasterChannels.count() > 0 && edMasterRequestsPending < 2)
-        {
-            BertUIEDChannel *thisEDChannel;
-            // There are enabled Master channels, and we don't have more than one outstanding request:
-            // We can request error counts for the next master channel.
-            if (!nextEDMaster.hasNext()) nextEDMaster.toFront();  // End of channel list reached. Go back to the start.
-            thisEDChannel = nextEDMaster.next();
-            // Signal the back end to get ED counts for this channel (by Lane):
-            qDebug() << "Get ED Counts for MASTER lane " << thisEDChannel->getLane();
-            emit GetEDCount(thisEDChannel->getLane(), bitRate);
-            edMasterRequestsPending++;
-        }
-        // SLAVE Channels: ////////////////////////////////////////////////////////
-        if (edEnabledSlaveChannels.count() > 0 && edSlaveRequestsPending < 2)
-        {
-            BertUIEDChannel *thisEDChannel;
-            // There are enabled Master channels, and we don't have more than one outstanding request:
-            // We can request error counts for the next master channel.
-            if (!nextEDSlave.hasNext()) nextEDSlave.toFront();  // End of channel list reached. Go back to the start.
-            thisEDChannel = nextEDSlave.next();
-            // Signal the back end to get ED counts for this channel (by Lane):
-            qDebug() << "Get ED Counts for SLAVE lane " << thisEDChannel->getLane();
-            emit GetEDCount(thisEDChannel->getLane(), bitRate);
-            edSlaveRequestsPending++;
-        }
-    }
-
     // ---- Update run timer, etc, at the end of each second:---
     if ( (edUpdateCounter >= 4) && (commsConnected) )
     {
@@ -1593,6 +1778,96 @@ void BertWindow::uiUpdateTimerTick()
 
 
 
+/*!
+ \brief Update status poller settings
+ Works out which metrics the back end status poller should be reading
+ (and from which chips) for the current page and run state, and sends
+ any settings which have changed since the last update.
+   ED counts:   Every 250 ms while the ED is running (whichever page is shown)
+   LOS / LOL:   Every second on the ED page, or on the CDR page if CDR mode is enabled
+   Temperature: Every 5 seconds on the 'Connect' page, if the UI is active
+   LMX Lock:    Every second on the Clock Synth page
+ \param tabID  ID of the page currently displayed
+*/
+void BertWindow::pollerUpdate(TabID tabID)
+{
+    int        intervals[BertPoller::POLL_METRIC_COUNT] = { 0 };
+    QList<int> targets[BertPoller::POLL_METRIC_COUNT];
+
+    if (commsConnected)
+    {
+        // The ED log records the last LOS / LOL and core temperature read for
+        // each lane, so keep those up to date while logging, whatever the tab:
+        const bool edLogging = edRunning && checkEDLog->isChecked();
+
+        // ---- ED Counts: A counter snapshot is requested from each GT1724 with enabled channels;
+        // each snapshot reads both EDs on the chip against the same time point.
+        if (edRunning)
+        {
+            intervals[BertPoller::POLL_ED_COUNT] = 250;
+            targets[BertPoller::POLL_ED_COUNT] = edEnabledChips;
+        }
+
+        // ---- LOS / LOL State: Issued for each GT1724 IC, i.e. lanes 0, 4, 8, ...
+        // On the ED page, LOS / LOL lights are always updated regardless of whether the
+        // ED is running. On the CDR page, they are only updated if CDR mode is enabled,
+        // for any GT1724 core which has a CDR Mode UI section.
+        if (tabID == TAB_ED || (tabID == TAB_CDR && checkCDRModeEnable->isChecked()))
+        {
+            foreach (BertChannel *bertChannel, bertChannels)
+            {
+                int chipLane;
+                if (tabID == TAB_ED)
+                {
+                    if ((bertChannel->getPGLane() % 4) != 0) continue;
+                    chipLane = bertChannel->getPGLane();
+                }
+                else
+                {
+                    if (!bertChannel->hasCDRModeChannel()) continue;
+                    chipLane = bertChannel->getMetaLane();
+                }
+                if (!targets[BertPoller::POLL_LOS_LOL].contains(chipLane)) targets[BertPoller::POLL_LOS_LOL].append(chipLane);
+            }
+        }
+        if (edLogging)
+        {
+            foreach (int chipLane, edEnabledChips)
+            {
+                if (!targets[BertPoller::POLL_LOS_LOL].contains(chipLane)) targets[BertPoller::POLL_LOS_LOL].append(chipLane);
+            }
+        }
+        if (!targets[BertPoller::POLL_LOS_LOL].isEmpty()) intervals[BertPoller::POLL_LOS_LOL] = 1000;
+
+        // ---- Chip temperature: Only update temperatures when UI is active (e.g. don't try to update during init process)
+        if ((tabID == TAB_CONNECT || edLogging) && uiLockLevel == 0) intervals[BertPoller::POLL_TEMPERATURE] = 5000;
+
+        // ---- LMX clock lock status:
+        if (tabID == TAB_CLOCKSYNTH && eventsEnabled) intervals[BertPoller::POLL_LMX_LOCK] = 1000;
+    }
+
+    // Send changed settings to the poller:
+    if (bitRate != pollerBitRate)
+    {
+        emit PollerSetBitRate(bitRate);
+        pollerBitRate = bitRate;
+    }
+    for (int metric = 0; metric < BertPoller::POLL_METRIC_COUNT; metric++)
+    {
+        if (targets[metric] != pollerTargets[metric])
+        {
+            emit PollerSetTargets(metric, targets[metric]);
+            pollerTargets[metric] = targets[metric];
+        }
+        if (intervals[metric] != pollerIntervals[metric])
+        {
+            emit PollerSetInterval(metric, intervals[metric]);
+            pollerIntervals[metric] = intervals[metric];
+        }
+    }
+}
+
+
 // ------ ED Channels ---------------
 
 /*!
@@ -1723,14 +1998,14 @@ void BertWindow::errorInject(const uint8_t channel)
 */
 void BertWindow::EyeScanProgressUpdate(int lane, int type, int progressPercent)
 {
-    uint8_t eyeScanChannel = (lane + 1) / 2;
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
 
     // Calculate the TOTAL percentage completed, which is the percentage through
     // the current repeat, PLUS the repeats already done:
     uint16_t totalRepeats;
     if (eyeScanRepeatsTotal > 0)  totalRepeats = (uint16_t)eyeScanRepeatsTotal;
     else                          totalRepeats = 0;
-    uint16_t doneRepeats = (uint16_t)eyeScanRepeatsDone;
+    uint16_t doneRepeats = (uint16_t)eyeScanChannelRepeatsDone.value(eyeScanChannel, 0);
 
     int totalPercent = progressPercent;
     if (totalRepeats > 0)
@@ -1778,45 +2053,100 @@ void BertWindow::EyeScanError(int lane, int type, int code)
 }
 
 
-void BertWindow::EyeScanFinished(int lane, int type, QVector<double> data, int xRes, int yRes)
+/*!
+ \brief Eye Scan Partial Result slot
+ Shows the rows scanned so far while a multi-part scan is running, so
+ the operator can see (and cancel) a bad scan before it finishes.
+ \param lane      ED lane
+ \param type      Scan type (eye or bathtub)
+ \param result    Counts so far (see EyeMonitor::emitPartialResult)
+ \param rowsDone  Rows scanned so far in this pass
+*/
+void BertWindow::EyeScanPartial(int lane, int type, EyeScanResult result, int rowsDone)
+{
+    Q_UNUSED(rowsDone)
+    if (!eyeScanRunning && !bathtubRunning) return;  // Late arrival of update AFTER scan cancel?
+    int eyeScanChannel = BertChannel::laneToChannel(lane);
+    QVector<double> data = result.normalised();
+    if (type == GT1724::GT1724_EYE_SCAN) getChannel(eyeScanChannel)->getEyescan()->plotShowData(data, result.getXRes(), result.getYRes());
+    else                                 getChannel(eyeScanChannel)->getBathtub()->plotShowData(data);
+}
+
+
+void BertWindow::EyeScanFinished(int lane, int type, EyeScanResult result)
 {
     if (!eyeScanRunning && !bathtubRunning) return;  // Late arrival of update AFTER scan cancel?
 
     // Plot the results of this scan: Depends whether it is an eye diagram or a bathtub plot.
     int eyeScanChannel = BertChannel::laneToChannel(lane);
     eyeScansDone++;  // Finished one CHANNEL scan (may not be full repeat as there may be other channels to do yet).
+    QVector<double> data = result.normalised();  // Normalised (log10 BER) values for plotting
 
     if (type == GT1724::GT1724_EYE_SCAN)
     {
         ///////// EYE DIAGRAM: //////////////////////////////////////////
-        getChannel(eyeScanChannel)->getEyescan()->plotShowData(data, xRes, yRes);
+        getChannel(eyeScanChannel)->getEyescan()->plotShowData(data, result.getXRes(), result.getYRes());
     }
     else
     {
         //////// BATHTUB PLOT: //////////////////////////////////////
+        if (checkBathtubExtrapolate->isChecked())
+        {
+            // Fast mode: Fit dual-Dirac model to the measured tails and extrapolate to a low error ratio:
+            BathtubFit fit(result);
+            if (fit.isValid())
+            {
+                data = fit.extrapolated();
+                bathtubFitSummary[eyeScanChannel] =
+                        QString("Ch %1: Opening @error ratio %2: %3 UI; RJ %4 UI rms; DJ %5 UI; R2 %6")
+                        .arg(eyeScanChannel)
+                        .arg(fit.getTargetRatio(), 0, 'g', 1)
+                        .arg(fit.getOpening(), 0, 'f', 3)
+                        .arg(fit.getRJ(), 0, 'f', 4)
+                        .arg(fit.getDJ(), 0, 'f', 3)
+                        .arg(fit.getConfidence(), 0, 'f', 2);
+            }
+            else
+            {
+                bathtubFitSummary[eyeScanChannel] = QString("Ch %1: Fit failed (not enough tail data)").arg(eyeScanChannel);
+            }
+        }
         getChannel(eyeScanChannel)->getBathtub()->plotShowData(data);
     }
 
-    // Are there any more lanes to scan during THIS repeat cycle?
-    bool scanStarted = false;
-    if (eyeScanChannel < maxChannel) scanStarted = eyeScanStart(type, eyeScanChannel+1);
-
-    if (!scanStarted)
+    // Each channel repeats independently of the others, so a channel on an
+    // idle chip doesn't have to wait for slower channels to finish:
+    int repeatsDone = eyeScanChannelRepeatsDone.value(eyeScanChannel, 0) + 1;
+    eyeScanChannelRepeatsDone[eyeScanChannel] = repeatsDone;
+    qDebug() << "Finished scan for channel " << eyeScanChannel << ". Repeats Done: " << repeatsDone;
+    bool repeat;
+    if (eyeScanRepeatsTotal == EYESCAN_REPEATS_CONVERGE)
     {
-        // No more channels to scan in THIS repeat.
-        eyeScanRepeatsDone++;
-        qDebug() << "Finished all scans for this repeat. Repeats Done: " << eyeScanRepeatsDone;
-        if (eyeScanRepeatsTotal < 0 ||                    // -1 means repeat forever.
-            eyeScanRepeatsDone < eyeScanRepeatsTotal)     // Repeat until we have done the requested number
-        {
-            scanStarted = eyeScanStart(type, 1);  // Start again from first enabled channel
-        }
+        // Repeat until the eye contour stops changing (the back end only re-scans bands which haven't converged):
+        repeat = !result.isConverged() && repeatsDone < EYESCAN_CONVERGE_REPEATS_MAX;
+        if (!repeat) eyeScanChannelsFinished++;
+    }
+    else
+    {
+        repeat = (eyeScanRepeatsTotal < 0 ||            // -1 means repeat forever.
+                  repeatsDone < eyeScanRepeatsTotal);   // Repeat until we have done the requested number
+    }
+    if (repeat)
+    {
+        emit EyeScanRepeat(lane);
+        return;
     }
 
-    if (!scanStarted)
+    const bool allFinished = (eyeScanRepeatsTotal == EYESCAN_REPEATS_CONVERGE) ? (eyeScanChannelsFinished >= eyeScanChannelCount)
+                                                                               : (eyeScansDone >= eyeScansTotal);
+    if (allFinished)
     {
         qDebug() << "Finished all scans.";
         updateStatus("Eye Scan Finished.");
+        if (type == GT1724::GT1724_BATHTUB_SCAN)
+        {
+            foreach (const QString &summary, bathtubFitSummary) appendStatus(QString(" ") + summary + QString(";"));
+        }
         if (type == GT1724::GT1724_EYE_SCAN) eyeScanUIUpdate(false);
         else                                 bathtubUIUpdate(false);
     }
@@ -1840,6 +2170,7 @@ void BertWindow::eyeScanUIUpdate(bool isRunning)
     listEyeScanHStep->setEnabled(!isRunning);
     listEyeScanCountRes->setEnabled(!isRunning);
     listEyeScanRepeats->setEnabled(!isRunning);
+    checkEyeScanAdaptive->setEnabled(!isRunning);
     checkESEnableAll->setEnabled(!isRunning);
     paneESCheckBoxes->setEnabled(!isRunning);
 }
@@ -1848,23 +2179,22 @@ void BertWindow::eyeScanUIUpdate(bool isRunning)
 
 /*!
  \brief Eye Scan Start
- Reads scan settings, then launches a scan for the first
- channel where eyeScanRepeatsDone is less than eyeScanRepeatsTotal
- (i.e. scans remain to be done).
- If all channels have been done, returns false.
- \param channel  Channel number (1-4)
- \param reset    Reset parameters and start a new scan.
-                 Used on first call to make sure scan is reset.
- \return true  A scan was started
- \return false No scan started - ALL scans have now been finished.
+ Reads scan settings, then launches scans on ALL enabled channels
+ at once. Each GT1724 runs on its own thread and queues requests for
+ its own lanes, so sweeps on different chips overlap with each
+ other's data readback. Further repeats are requested per channel
+ as each scan finishes (see EyeScanFinished).
+ \param type  Type of scan: GT1724::GT1724_EYE_SCAN or GT1724::GT1724_BATHTUB_SCAN
+ \return true  At least one scan was started
+ \return false No scan started - no channels enabled
 */
-bool BertWindow::eyeScanStart(int type, int firstChannel)
+bool BertWindow::eyeScanStart(int type)
 {
-    // Find first enabled channel >= specified first channel:
     bool channelChecked;
+    bool scanStarted = false;
+    const bool converge = (eyeScanRepeatsTotal == EYESCAN_REPEATS_CONVERGE);
     foreach (BertChannel *bertChannel, bertChannels)
     {
-        if (bertChannel->getChannel() < firstChannel) continue;
         if (type == GT1724::GT1724_EYE_SCAN) channelChecked = bertChannel->getEyeScanChannelEnabled();
         else                                 channelChecked = bertChannel->getBathtubChannelEnabled();
         if (channelChecked)
@@ -1885,7 +2215,9 @@ bool BertWindow::eyeScanStart(int type, int firstChannel)
                                       listEyeScanHStep->currentIndex(),      //  hStep
                                       listEyeScanVStep->currentIndex(),      //  vStep
                                       0,                                     //  vOffset: Unused for Eye Plot
-                                      listEyeScanCountRes->currentIndex());  // countRes
+                                      listEyeScanCountRes->currentIndex(),   // countRes
+                                      checkEyeScanAdaptive->isChecked(),     // adaptive (coarse-to-fine)
+                                      converge);                             // converge (skip converged bands on repeats)
                 }
                 else
                 {
@@ -1894,15 +2226,17 @@ bool BertWindow::eyeScanStart(int type, int firstChannel)
                                       0,                                     //  hStep: We always use 1 for Bathtub Plot (no point doing low res scan!)
                                       0,                                     //  vStep: Unused for Bathtub Plot
                                       listBathtubVOffset->currentIndex(),    //  vOffset
-                                      listBathtubCountRes->currentIndex());  // countRes
+                                      listBathtubCountRes->currentIndex(),   // countRes
+                                      checkBathtubAdaptive->isChecked(),     // adaptive (coarse-to-fine)
+                                      converge);                             // converge (stop when the curve settles)
 
                 }
                 bertChannel->eyeScanStartedFlag = true;  // First scan started on this channel!
             }
-            return true;   // Scan started!
+            scanStarted = true;
         }
     }
-    return false;   // No active channels >= firstChannel!
+    return scanStarted;
 }
 
 
@@ -1920,8 +2254,9 @@ void BertWindow::on_buttonEyeScanStart_clicked()
     eyeScanUIUpdate(true);
     bool scanStarted = false;
     eyeScanRepeatsTotal = EYESCAN_REPEATS_LOOKUP[listEyeScanRepeats->currentIndex()];
-    eyeScanRepeatsDone = 0;
+    eyeScanChannelRepeatsDone.clear();
     eyeScanChannelCount = 0;
+    eyeScanChannelsFinished = 0;
 
     qDebug() << "Eye Scan Start Clicked: Running eye scan with " << eyeScanRepeatsTotal << " repeats.";
     // Count the number of enabled eyescan channels:
@@ -1944,7 +2279,7 @@ void BertWindow::on_buttonEyeScanStart_clicked()
     else
     {
         // At least one channel selected! Start scans.
-        scanStarted = eyeScanStart(GT1724::GT1724_EYE_SCAN, 1);  // Start from first enabled channel
+        scanStarted = eyeScanStart(GT1724::GT1724_EYE_SCAN);  // Start all enabled channels
     }
     if (!scanStarted) eyeScanUIUpdate(false);  // No channels to scan...
 }
@@ -1978,6 +2313,8 @@ void BertWindow::bathtubUIUpdate(bool isRunning)
     listBathtubVOffset->setEnabled(!isRunning);
     listBathtubCountRes->setEnabled(!isRunning);
     listBathtubRepeats->setEnabled(!isRunning);
+    checkBathtubAdaptive->setEnabled(!isRunning);
+    checkBathtubExtrapolate->setEnabled(!isRunning);
     checkBPEnableAll->setEnabled(!isRunning);
     paneBPCheckBoxes->setEnabled(!isRunning);
 }
@@ -1997,8 +2334,11 @@ void BertWindow::on_buttonBathtubStart_clicked()
     bathtubUIUpdate(true);
     bool scanStarted = false;
     eyeScanRepeatsTotal = EYESCAN_REPEATS_LOOKUP[listBathtubRepeats->currentIndex()];
-    eyeScanRepeatsDone = 0;
+    if (checkBathtubExtrapolate->isChecked()) eyeScanRepeatsTotal = 1;  // Fast mode: One pass, then extrapolate
+    eyeScanChannelRepeatsDone.clear();
+    bathtubFitSummary.clear();
     eyeScanChannelCount = 0;
+    eyeScanChannelsFinished = 0;
     qDebug() << "Bathtub Scan Start Clicked: Running eye scan with " << eyeScanRepeatsTotal << " repeats.";
     // Count the number of enabled eyescan channels:
     foreach (BertChannel *bertChannel, bertChannels)
@@ -2020,7 +2360,7 @@ void BertWindow::on_buttonBathtubStart_clicked()
     else
     {
         // At least one channel selected! Start scans.
-        scanStarted = eyeScanStart(GT1724::GT1724_BATHTUB_SCAN, 1);  // Start from first enabled channel
+        scanStarted = eyeScanStart(GT1724::GT1724_BATHTUB_SCAN);  // Start all enabled channels
     }
     if (!scanStarted) bathtubUIUpdate(false);  // No channels to scan...
 }
@@ -2316,9 +2656,15 @@ QWidget *BertWindow::makeUI(QWidget *parent)
     valueMeasurementTime = new BertUITextInfo ("valueMeasurementTime", groupEDControls, "00:00:00",         -1,  x+39, y,        70  );
     new                        BertUILabel    ("",                     groupEDControls, "Result Display:",  -1,  x,    y+=vGrid, 111 );
     listEDResultDisplay  = new BertUIList     ("listEDResultDisplay",  groupEDControls, resultDisplayItems, -1,  x,    y+=25,    111 );
+    new                        BertUILabel    ("",                     groupEDControls, "Stop at BER <:",   -1,  x,    y+=vGrid, 111 );
+    listEDTargetBER      = new BertUIList     ("listEDTargetBER",      groupEDControls, ED_TARGET_BER_LIST, -1,  x,    y+=25,    111 );
+    new                        BertUILabel    ("",                     groupEDControls, "Confidence:",      -1,  x,    y+=vGrid, 111 );
+    listEDTargetConfidence = new BertUIList   ("listEDTargetConfidence", groupEDControls, ED_TARGET_CONFIDENCE_LIST, -1, x, y+=25, 111 );
+    listEDTargetConfidence->setCurrentIndex(1);  // 95%
 
     // Channel enable checkboxes:
-    checkEDEnableAll = new BertUICheckBox ("checkEDEnableAll", groupEDControls, "Enable ALL", -1, 12, y+=vGrid+10, 101    );
+    checkEDLog       = new BertUICheckBox ("checkEDLog",       groupEDControls, "Log to File", -1, 12, y+=vGrid+10, 101   );
+    checkEDEnableAll = new BertUICheckBox ("checkEDEnableAll", groupEDControls, "Enable ALL", -1, 12, y+=25, 101          );
     paneEDCheckBoxes = new BertUIPane     ("",                 groupEDControls,               -1, 17, y+=vGrid-4,  110, 0 );
     paneEDCheckBoxes->setMinimumHeight(1);
     paneEDCheckBoxes->setSizePolicy(QSizePolicy::Fixed, QSizePolicy::MinimumExpanding);
@@ -2359,6 +2705,7 @@ QWidget *BertWindow::makeUI(QWidget *parent)
     listEyeScanHStep     = new BertUIList     ("listEyeScanHStep",      groupEyeScanOpts, QStringList(),    -1, x, y+=vGrid, 51 );
     listEyeScanCountRes  = new BertUIList     ("listEyeScanCountRes",   groupEyeScanOpts, QStringList(),    -1, x, y+=vGrid, 51 );
     listEyeScanRepeats   = new BertUIList     ("listEyeScanRepeats",    groupEyeScanOpts, EYESCAN_REPEATS_LIST, -1, x, y+=vGrid, 51 );
+    checkEyeScanAdaptive = new BertUICheckBox ("checkEyeScanAdaptive",  groupEyeScanOpts, "Adaptive",       -1, 12, y+=vGrid, 101 );
     // Channel enable checkboxes:
     checkESEnableAll = new BertUICheckBox ("checkESEnableAll", groupEyeScanOpts, "Scan ALL", -1, 12, y+=vGrid+10, 101    );
     paneESCheckBoxes = new BertUIPane     ("",                 groupEyeScanOpts,             -1, 17, y+=vGrid-4,  110, 0 );
@@ -2400,6 +2747,8 @@ QWidget *BertWindow::makeUI(QWidget *parent)
     listBathtubVOffset   = new BertUIList     ("listBathtubVOffset",    groupBathtubOpts, QStringList(),    -1, x, y,        51 );
     listBathtubCountRes  = new BertUIList     ("listBathtubCountRes",   groupBathtubOpts, QStringList(),    -1, x, y+=vGrid, 51 );
     listBathtubRepeats   = new BertUIList     ("listBathtubRepeats",    groupBathtubOpts, EYESCAN_REPEATS_LIST, -1, x, y+=vGrid, 51 );
+    checkBathtubAdaptive = new BertUICheckBox ("checkBathtubAdaptive",  groupBathtubOpts, "Adaptive",       -1, 12, y+=vGrid, 101 );
+    checkBathtubExtrapolate = new BertUICheckBox ("checkBathtubExtrapolate", groupBathtubOpts, "Extrapolate", -1, 12, y+=vGrid, 101 );
     // Channel enable checkboxes:
     y+=vGrid;
     checkBPEnableAll = new BertUICheckBox ("checkBPEnableAll", groupBathtubOpts, "Scan ALL", -1, 12, y+=vGrid+10, 101    );
@@ -2735,6 +3084,7 @@ void BertWindow::makeUIFactoryOptions(QWidget *parent)
     listEEPROMLMXProfiles       = new BertUIList   ("listEEPROMLMXFreq",           groupFactoryOptions, QStringList(),                  0, x+136, y,        250 );
     buttonWriteProfilesToEEPROM = new BertUIButton ("buttonWriteProfilesToEEPROM", groupFactoryOptions, "Write ALL TCS Defs to EEPROM", 0, x+136, y+=vGrid, 250 );
     buttonVerifyLMXProfiles     = new BertUIButton ("buttonVerifyLMXProfiles",     groupFactoryOptions, "Verify Clock Defs",            0, x+136, y+=vGrid, 250 );
+    buttonBusProfile            = new BertUIButton ("buttonBusProfile",            groupFactoryOptions, "Save Bus Profile",             0, x+136, y+=vGrid, 250 );
 
 //  new                               BertUILabel  ("",                            groupFactoryOptions, "Firmware Download:",           0, x,     y+=vGrid, 135 );
 //  new                               BertUILabel  ("",                            groupFactoryOptions, "Firmware from FILES:",         0, x,     y+=vGrid, 135 );
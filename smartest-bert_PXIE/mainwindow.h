@@ -15,6 +15,9 @@
 #include <QMap>
 #include <QDate>
 #include <QCryptographicHash>
+#include <QDir>
+#include <QPointer>
+#include <QVector>
 
 #include <math.h>
 
@@ -49,6 +52,8 @@
 #include "BertChannel.h"
 #include "BertWorker.h"
 #include "BertFile.h"
+#include "BathtubFit.h"
+#include "EDConfidence.h"
 #include "LMXFrequencyProfile.h"
 
 
@@ -89,6 +94,9 @@ signals:
     // Signals for the TLC59108 LED IC:
     TLC59108_SLOTS
 
+    // Signals for the status poller:
+    BERT_POLLER_SLOTS
+
 private slots:
 
     // Signals from worker:
@@ -106,6 +114,9 @@ private slots:
     // Signals from PCA9557A IC:
     PCA9557A_SIGNALS
 
+    // Signals from status poller:
+    BERT_POLLER_RESULT_SIGNALS
+
 
     // Signals from M24M02 EEPROM IC:
     M24M02_SIGNALS
@@ -158,6 +169,7 @@ private slots:
     void on_buttonWriteProfilesToEEPROM_clicked();
 //    void on_buttonWriteFirmwareToEEPROM_clicked();
     void on_buttonVerifyLMXProfiles_clicked();
+    void on_buttonBusProfile_clicked();
 
     // --- Frequency Synth Page: ---------
     void on_listLMXFreq_currentIndexChanged(int index)             IF_UI_ENABLED(frequencyProfileChanged(index))
@@ -247,9 +259,13 @@ private slots:
     void listPopulate(QString name, int lane, QStringList items, int defaultIndex);
 
     template<class T> T findItem(QString name, int suffix = -1);
+    QWidget *uiItemWidget(int item, int lane);
+    void updateString(QString name, int lane, QString value);
 
     BertChannel *getChannel(int channel);
 
+    void pollerUpdate(TabID tabID);
+
     void lockUI(int timeoutMs, int depth = 1);
     void unlockUI();
     void uiChangeOnConnect(bool connectedStatus);
@@ -263,13 +279,17 @@ private slots:
     void edControlInit();
     void edStartStopReflect();
     void edResetUI(const int8_t channel);
+    void edPlotAddPoint(BertChannel *bertChannel, double errorRatio);
+    void edPlotClear(BertChannel *bertChannel);
+    QString edTargetSummary() const;
+    void edCountUpdate(int lane, bool locked, double bits, double bitsTotal, double errors, double errorsTotal);
     void edChannelEnableChanged(const uint8_t channel);
     void edSetUpAndStart(bool start);
     void eqBoostSet(const uint8_t channel, const uint8_t eqBoostIndex);
     void errorInject(const uint8_t channel);
 
     void eyeScanUIUpdate(bool isRunning);
-    bool eyeScanStart(int type, int firstChannel);
+    bool eyeScanStart(int type);
 
     void bathtubUIUpdate(bool isRunning);
 
@@ -281,7 +301,16 @@ private slots:
     void closeEvent(QCloseEvent *event);
 
     static const QStringList EYESCAN_REPEATS_LIST;     // List of options for "Repeats" list (Eyescan and Bathtub plot)
-    static const QList<int>  EYESCAN_REPEATS_LOOKUP;   // Lookup table of actual values associated with "repeats" list
+    static const ConstArray<int> EYESCAN_REPEATS_LOOKUP;   // Lookup table of actual values associated with "repeats" list
+    static const int EYESCAN_REPEATS_CONVERGE = -2;        // "Repeats" value: Repeat until converged (see EyeMonitor::startScan)
+    static const int EYESCAN_CONVERGE_REPEATS_MAX = 1000;  // Most repeats of a channel in converge mode
+
+    static const QStringList ED_TARGET_BER_LIST;              // List of options for ED "Stop at BER" list
+    static const ConstArray<double> ED_TARGET_BER_LOOKUP;     // Target BER for each "Stop at BER" item (0 = Off)
+    static const QStringList ED_TARGET_CONFIDENCE_LIST;       // List of options for ED "Confidence" list
+    static const ConstArray<double> ED_TARGET_CONFIDENCE_LOOKUP;  // Confidence level for each "Confidence" item
+
+    static const int ED_PLOT_BUCKETS_MAX = 512;  // ED BER plot: Most history buckets to show (see edPlotAddPoint)
 
     static const int HEIGHT_ADD_TEMPS = 30;      // "Temperature" group on connect page: Add this much extra height to box after first row of temperatures
     static const int HEIGHT_ADD_CHECKBOX = 30;   // "Scan Channel" checkboxes on Eyescan / Bathtub pages: Add this much extra height per row
@@ -309,9 +338,11 @@ private slots:
     uint8_t eqBoostNewIndex = 0;
 
     int tickCountStatusTextReset;
-    int tickCountTempUpdate;
     int tickCountTemperatureTextReset;
-    int tickCountClockLockUpdate;
+
+    // Widgets for component UI items (see UIUpdate), by item and [lane + 1].
+    // Found by name the first time they're used; null if not found yet or deleted.
+    QVector<QPointer<QWidget> > uiItemWidgets[BertComponent::UI_ITEM_COUNT];
 
     QTime *edRunTime = NULL;
 
@@ -322,19 +353,27 @@ private slots:
     int maxChannel = 0;  // Highest channel number overall (so far...)
 
     // Error Detector Update State Containers
-    // When the ED is running, these are used to track which Master and Slave channel is due
-    // for the next counter update, and how many requests are outstanding (waiting for the back end).
-    QList<BertUIEDChannel *> edEnabledMasterChannels;  // When the ED is runing, this holds a list of enabled channels on the MASTER board
-    QListIterator<BertUIEDChannel *> nextEDMaster;
-    int edMasterRequestsPending;
-    QList<BertUIEDChannel *> edEnabledSlaveChannels;   // When the ED is runing, this holds a list of enabled channels on the SLAVE board
-    QListIterator<BertUIEDChannel *> nextEDSlave;
-    int edSlaveRequestsPending;
+    // When the ED is running, the status poller (back end) requests a counter snapshot
+    // from each GT1724 with enabled channels (see pollerUpdate).
+    QList<int> edEnabledChips;         // When the ED is runing, this holds the lane offset of each GT1724 with enabled channels
+
+    // ED confidence target for this run (see EDConfidenceUpdate); edTargetBER 0 = Off:
+    double edTargetBER = 0.0;
+    double edTargetConfidence = 0.0;
+    QMap<int, int>    edTargetVerdicts;     // Latest EDConfidence verdict, by ED lane
+    QMap<int, double> edTargetConfidences;  // Latest confidence, by ED lane
+
+    // Status poller settings last sent to the back end, by metric (see pollerUpdate):
+    int        pollerIntervals[BertPoller::POLL_METRIC_COUNT];
+    QList<int> pollerTargets[BertPoller::POLL_METRIC_COUNT];
+    double     pollerBitRate = -1.0;
 
 
     int  eyeScanRepeatsTotal = 1;
-    int  eyeScanRepeatsDone  = 0;
+    QMap<int, int> eyeScanChannelRepeatsDone;  // Repeats finished so far in this run, by channel
+    QMap<int, QString> bathtubFitSummary;      // Bathtub extrapolation results for this run, by channel (for status message)
     int  eyeScanChannelCount = 0;
+    int  eyeScanChannelsFinished = 0;          // Converge mode: Channels which have stopped repeating
 
     int  eyeScansTotal = 0;     // Number of eye scans to do in this run (=[active channels] * [repeats])
     int  eyeScansDone = 0;      // Number of eye scans finished in this run
@@ -404,8 +443,11 @@ private slots:
     BertUIButton        *buttonEDStart;
     BertUIButton        *buttonEDStop;
     BertUIList          *listEDResultDisplay;
+    BertUIList          *listEDTargetBER;
+    BertUIList          *listEDTargetConfidence;
     BertUITextInfo      *valueMeasurementTime;
     BertUICheckBox      *checkEDEnableAll;
+    BertUICheckBox      *checkEDLog;
     BertUIPane          *paneEDCheckBoxes;
     QGridLayout         *layoutEDCheckboxes;
     QGridLayout         *layoutEDChannels;
@@ -418,6 +460,7 @@ private slots:
     BertUIList          *listEyeScanHStep;
     BertUIList          *listEyeScanCountRes;
     BertUIList          *listEyeScanRepeats;
+    BertUICheckBox      *checkEyeScanAdaptive;
     BertUICheckBox      *checkESEnableAll;
     BertUIPane          *paneESCheckBoxes;
     QGridLayout         *layoutESCheckboxes;
@@ -430,6 +473,8 @@ private slots:
     BertUIList          *listBathtubVOffset;
     BertUIList          *listBathtubCountRes;
     BertUIList          *listBathtubRepeats;
+    BertUICheckBox      *checkBathtubAdaptive;
+    BertUICheckBox      *checkBathtubExtrapolate;
     BertUICheckBox      *checkBPEnableAll;
     BertUIPane          *paneBPCheckBoxes;
     QGridLayout         *layoutBPCheckboxes;
@@ -460,6 +505,7 @@ private slots:
 //  BertUIList          *listEEPROMFirmware = nullptr;
     BertUIButton        *buttonWriteProfilesToEEPROM = nullptr;
     BertUIButton        *buttonVerifyLMXProfiles = nullptr;
+    BertUIButton        *buttonBusProfile = nullptr;
 //    BertUIButton        *buttonWriteFirmwareToEEPROM = nullptr;
 //  BertUIButton        *buttonVerifyFirmware = nullptr;
 
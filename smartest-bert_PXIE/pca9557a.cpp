@@ -143,7 +143,8 @@ int PCA9557A::init()
         return result;
     }
 
-    // Set safe default settings:
+    // Set safe default settings (always written; device may have been reset):
+    outputValid = false;
 
     //  - EEPROM Write DISABLED
     result = setPins(EEPROM_WRITE_DISABLE);    // Could bitwise OR other pin values here.
@@ -390,20 +391,25 @@ int PCA9557A::updatePins(const uint8_t mask, const uint8_t value)
 /*!
  * \brief Write latest values to PCA9557A pins
  *        This method updates the hardware adaptor with the latest set of
- *        pin values set by calls to setPin.
+ *        pin values set by calls to setPin. The write is skipped if the
+ *        output register already holds these values.
  * \return globals::OK   IO expander output register set OK
  * \return [Error code]  Error occurred (comms not connected, etc).
  */
 int PCA9557A::writePins()
 {
     if (!comms->portIsOpen()) return globals::NOT_CONNECTED;
+    if (outputValid && regOutput == regOutputWritten) return globals::OK;  // No change
     // Write the output register:
     int result = comms->write8(i2cAddress, REG_OUPUT, &regOutput, 1);
     if (result != globals::OK)
     {
         qDebug() << "Error writing to PCA9557A output register: " << result;
+        outputValid = false;
         return result;
     }
+    regOutputWritten = regOutput;
+    outputValid = true;
     // OK!
     return globals::OK;
 }
@@ -458,6 +464,7 @@ int PCA9557A::readPins()
 int PCA9557A::test(bool loopBackTest)
 {
     if (!comms->portIsOpen()) return globals::NOT_CONNECTED;
+    outputValid = false;  // Test writes the output register directly
     qDebug() << "Starting PCA9557 Interface Tests...";
     int result;
 
@@ -1,4 +1,5 @@
 #include <QDebug>
+#include <QTimer>
 #include "tlc59108.h"
 #include "globals.h"
 #include "I2CComms.h"
@@ -98,9 +99,75 @@ int TLC59108::init()
     ledData0 = 0x00; //
     ledData1 = 0x00; //
 
-    comms->write8(i2cAddress,ledOut0,&ledData0,1); //Lane0&Lane1 turn-off
-    comms->write8(i2cAddress,ledOut1,&ledData1,1); //Lane2&lane3 turn-off
+    return writeLeds(true); // Lane0..Lane3 turn-off
+}
+
+
+
+
+/*!
+\brief Schedule an LED update
+       LED state changes only update ledData0 / ledData1; the registers are written
+       by flushLeds() once per LED_REFRESH_MS, so several lanes changing in the same
+       interval produce a single write.
+*/
+void TLC59108::markLedsDirty()
+{
+    if (ledFlushPending) return;
+    ledFlushPending = true;
+    QTimer::singleShot(LED_REFRESH_MS, this, SLOT(flushLeds()));
+}
+
+
+/*!
+\brief Write pending LED changes (timer slot; see markLedsDirty)
+*/
+void TLC59108::flushLeds()
+{
+    ledFlushPending = false;
+    if (!comms->portIsOpen()) return;
+    I2CPriorityScope priority(I2CComms::PRIORITY_COSMETIC);
+    int result = writeLeds(false);
+    if (result != globals::OK) qDebug() << "TLC59108: Error updating LEDs (" << result << ")";
+}
 
+
+/*!
+\brief Write ledData0 / ledData1 to the LEDOUT registers
+\param force  true:  Write both registers regardless of the cached state
+               false: Only write registers whose value differs from the last write
+\return globals::OK    Success (or nothing to do)
+\return [error code]   Comms error; cached state is invalidated so the next update rewrites both
+*/
+int TLC59108::writeLeds(bool force)
+{
+    bool write0 = force || !ledWrittenValid || (ledData0 != ledWritten0);
+    bool write1 = force || !ledWrittenValid || (ledData1 != ledWritten1);
+    int result = globals::OK;
+
+    if (write0 && write1)
+    {
+        // Both changed: one auto-increment write (control byte bit 7 = AI2) covers LEDOUT0/1:
+        uint8_t data[2] = { ledData0, ledData1 };
+        result = comms->write8(i2cAddress, 0x80 | ledOut0, data, 2);
+    }
+    else if (write0)
+    {
+        result = comms->write8(i2cAddress, ledOut0, &ledData0, 1);
+    }
+    else if (write1)
+    {
+        result = comms->write8(i2cAddress, ledOut1, &ledData1, 1);
+    }
+
+    if (result != globals::OK)
+    {
+        ledWrittenValid = false;
+        return result;
+    }
+    if (write0) ledWritten0 = ledData0;
+    if (write1) ledWritten1 = ledData1;
+    if (write0 && write1) ledWrittenValid = true;
     return globals::OK;
 }
 
@@ -139,7 +206,6 @@ void TLC59108::ChangPGLedStatus(int lane, bool laneOn)
                   {
                        ledData0 = 0x00;
                   }
-                   comms->write8(i2cAddress,ledOut0,&ledData0,1);
             }
             else if(lane == 2 || lane == 3)
             {
@@ -159,8 +225,9 @@ void TLC59108::ChangPGLedStatus(int lane, bool laneOn)
                    {
                         ledData1 = 0x00;
                    }
-                   comms->write8(i2cAddress,ledOut1,&ledData1,1);
              }
+             markLedsDirty();
+             return;
      }
 
     //2CH PG - ledOut0 ->PG1(lane0) and PG2(lane2)
@@ -180,8 +247,7 @@ void TLC59108::ChangPGLedStatus(int lane, bool laneOn)
      {
          ledData0 = 0x00;
      }
-     comms->write8(i2cAddress,ledOut0,&ledData0,1);
-     qDebug()<<"Change LED successfully! PG" <<lane+1<<"Status"<<laneOn;
+     markLedsDirty();
     // return globals::OK;
 
 }
@@ -211,7 +277,7 @@ void TLC59108::EDLedFlash(int lane, bool edRunning, bool edErroflashOn)
         ledOn[1] = false;
         ledOn[3] = false;
         ledData1 = 0x00;
-        comms->write8(i2cAddress,ledOut1,&ledData1,1);
+        markLedsDirty();
     }
     else
     {
@@ -239,7 +305,7 @@ void TLC59108::EDStopLed()
     ledOn[1] = false;
     ledOn[3] = false;
     ledData1 = 0x00;
-    comms->write8(i2cAddress,ledOut1,&ledData1,1);
+    markLedsDirty();
     qDebug() <<" All ED LEDs are off.";
 }
 
@@ -267,9 +333,7 @@ void TLC59108::ChangEDLedStatus()
               else if (Green[1] == false && Green[3] == false) ledData1 = 0x44; //ED1 Red and ED2 Red
               else if(Green[1] == true && Green[3] == true) ledData1 = 0x11; //ED1 Green and ED2 Green
          }
-         comms->write8(i2cAddress,ledOut1,&ledData1,1);
-
-         qDebug() <<"Change the ED's LEDs successfully.";
+         markLedsDirty();
 
 }
 
@@ -25,6 +25,9 @@ public:
 
     int edUpdateCounter[4];
 
+    // LED changes that arrive within this interval are merged into one write per register:
+    static const int LED_REFRESH_MS = 50;
+
 
     TLC59108(I2CComms *comms, const uint8_t i2cAddress, const int deviceID);
 
@@ -54,12 +57,22 @@ public slots:
     TLC59108_SLOTS
 
 
+private slots:
+    void flushLeds();
+
 private:
+    void markLedsDirty();
+    int writeLeds(bool force);
 
         I2CComms *comms;
         const uint8_t i2cAddress;
         const int deviceID;
 
+        bool ledFlushPending = false;   // A flushLeds() call has been scheduled
+        bool ledWrittenValid = false;   // ledWritten0/1 reflect the chip's LEDOUT registers
+        uint8_t ledWritten0 = 0x00;     // Last value written to ledOut0
+        uint8_t ledWritten1 = 0x00;     // Last value written to ledOut1
+
 
 
 